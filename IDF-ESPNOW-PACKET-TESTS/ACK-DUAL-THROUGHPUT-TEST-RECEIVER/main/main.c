@@ -9,35 +9,87 @@
 #include "esp_event.h"
 #include "esp_netif.h"
 #include "esp_timer.h"
+#include "espnow_msg_types.h"
+#include "espnow_timesync.h"
+#include "frame_check.h"
+#include "espnow_secure.h"
 
 #define WIFI_CHANNEL    1
-#define ACK_REQUEST     0x01
-#define ACK_RESPONSE    0x02
+#define ACK_REQUEST     ESPNOW_MSG_ACK_REQUEST
+#define ACK_RESPONSE    ESPNOW_MSG_ACK_RESPONSE
 #define PACKET_SIZE     128
+#define LOG_EVERY_N_ACK 100     // yanıt başına log Wi-Fi task'ını bekletip RTT'yi şişirdiği için her N yanıtta bir
+#define RESPONSE_SEED   0x02    // yanıt dolgusunun PRBS tohumu
+
+/**
+ * ESP-NOW şifrelemesi (göndericideki ESPNOW_ENCRYPT ve ENCRYPT_COMPARE_MODE ile
+ * birlikte). Anahtarlar göndericiyle aynı olmalıdır. ENCRYPT_COMPARE_MODE 1
+ * olduğunda gönderici adımlar arasında peer'ın modunu bu cihazla birlikte değiştirir.
+ */
+#define ESPNOW_ENCRYPT          0
+#define ESPNOW_PMK              "pmk1234567890123"  // ESP_NOW_KEY_LEN (16) karakter
+#define ESPNOW_LMK              "lmk1234567890123"
+#define ENCRYPT_COMPARE_MODE    0
 
 static const char *TAG = "RECEIVER";
 
 static uint8_t broadcast_mac[] = {0xF0, 0x9E, 0x9E, 0x20, 0x9A, 0x68}; //ESP32-S3'ün mac adresi
 
-uint8_t request_payload[PACKET_SIZE];
+/* Göndericideki ack_hdr_t ile aynı olmalıdır */
+typedef struct __attribute__((packed)) {
+    uint8_t type;           // ACK_REQUEST / ACK_RESPONSE
+    uint32_t seq;
+    int64_t send_time_us;
+    int64_t peer_rx_time_us;    // yanıtta: isteğin bu cihaza geliş anı (bu cihazın saatiyle)
+} ack_hdr_t;
+
 uint8_t response_payload[PACKET_SIZE];
 
 int64_t last_send_time = 0;
+int total_ack_ok = 0;
+int total_ack_fail = 0;
+static frame_check_stats_t request_check;   // yalnızca recv_cb'den güncellenir
 
 void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
+    // Saat senkronizasyonu yanıtları (4 Hz) da bu sayaçlara girer
     if (status == ESP_NOW_SEND_SUCCESS) {
-        int64_t now = esp_timer_get_time();
-        int64_t delta_us = now - last_send_time;
-        last_send_time = now;
-        ESP_LOGI(TAG, "ACK Gonderimi basarili. gecen sure: %.2f millis", delta_us / 1000.0);
+        total_ack_ok++;
     }
     else {
+        total_ack_fail++;
         ESP_LOGW(TAG, "ACK Gonderimi basarisiz");
     }
+
+    if ((total_ack_ok + total_ack_fail) % LOG_EVERY_N_ACK == 0) {
+        int64_t now = esp_timer_get_time();
+        int64_t delta_us = now - last_send_time;
+        last_send_time = now;
+        ESP_LOGI(TAG, "ACK Gonderimi basarili: %d, basarisiz: %d. son %d ACK icin gecen sure: %.2f millis",
+                 total_ack_ok, total_ack_fail, LOG_EVERY_N_ACK, delta_us / 1000.0);
+        ESP_LOGI(TAG, "CRC kontrolü: %lu istek, %lu bozuk (yanıtlanmadı)",
+                 (unsigned long)request_check.checked, (unsigned long)request_check.corrupt);
+    }
 }
 
 void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
-    if (len == PACKET_SIZE && memcmp(data, request_payload, PACKET_SIZE) == 0) {
+    int64_t rx_time_us = esp_timer_get_time();
+    if (espnow_timesync_on_recv(recv_info, data, len)) { // göndericinin saat senkronizasyonu isteklerine yanıt
+        return;
+    }
+#if ESPNOW_ENCRYPT || ENCRYPT_COMPARE_MODE
+    if (espnow_secure_on_recv(recv_info, data, len)) {
+        return;
+    }
+#endif
+    // Başlık dahil tüm istek CRC32 ile kontrol edilir; bozuk istek yanıtlanmaz, göndericide zaman aşımı olur
+    if (len == PACKET_SIZE && data[0] == ACK_REQUEST && frame_check_verify(&request_check, data, len)) {
+        // İsteğin seq ve zaman damgası yanıtta aynen geri gönderilir, geliş anı eklenir
+        ack_hdr_t hdr;
+        memcpy(&hdr, data, sizeof(hdr));
+        hdr.type = ACK_RESPONSE;
+        hdr.peer_rx_time_us = rx_time_us;
+        memcpy(response_payload, &hdr, sizeof(hdr));
+        frame_check_seal(response_payload, PACKET_SIZE);
         esp_now_send(broadcast_mac, response_payload, PACKET_SIZE);
     }
 }
@@ -64,7 +116,20 @@ static void esp_now_init_func(void) {
     peer->ifidx = WIFI_IF_STA;  // Karşıdaki cihaz değil, bu cihazın hangi wifi arayüzü ile veri göndereceği (Claude: Hedef cihaza hangi arayüz üzerinden (STA/AP) ulaşacağınız)
     peer->encrypt = false;      // Cihazlar arası veri şifrelemesi olacak mı?
     memcpy(peer->peer_addr, broadcast_mac, ESP_NOW_ETH_ALEN);
+#if ESPNOW_ENCRYPT || ENCRYPT_COMPARE_MODE
+    ESP_ERROR_CHECK(espnow_secure_init((const uint8_t *)ESPNOW_PMK, (const uint8_t *)ESPNOW_LMK));
+    espnow_secure_allow_downgrade(ENCRYPT_COMPARE_MODE); // yalnızca karşılaştırma koşusunda CCMP'den çıkılabilir
+    espnow_secure_peer_t secure_peer = {
+        .peer_addr = peer->peer_addr,
+        .channel = peer->channel,
+        .ifidx = peer->ifidx,
+        .encrypt = ESPNOW_ENCRYPT,
+        .allow_plaintext = false,   // şifreli ölçüm istenirken sessizce şifresiz ölçülmesin
+    };
+    ESP_ERROR_CHECK(espnow_secure_add_peer(&secure_peer, NULL)); // şifreli peer sınırı burada kontrol edilir
+#else
     ESP_ERROR_CHECK(esp_now_add_peer(peer));
+#endif
     free(peer);
 
     ESP_LOGW(TAG, "ESP-NOW baslatildi. Dinlemede.");
@@ -83,8 +148,7 @@ void wifi_init(void) {
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init());
 
-    memset(request_payload, 0x01, PACKET_SIZE); // ACK request filled array
-    memset(response_payload, 0x02, PACKET_SIZE); // ACK response filled array
+    frame_check_fill(response_payload, sizeof(ack_hdr_t), PACKET_SIZE, RESPONSE_SEED); // başlık ve CRC her yanıtta yazılır
 
     wifi_init();
     esp_now_init_func();
@@ -10,56 +10,415 @@
 #include "esp_event.h"
 #include "esp_netif.h"
 #include "esp_timer.h"
+#include "latency_hist.h"
+#include "espnow_msg_types.h"
+#include "espnow_timesync.h"
+#include "frame_check.h"
+#include "espnow_secure.h"
+#include "cpu_idle.h"
 
 #define WIFI_CHANNEL    1
 #define ACK_TIMEOUT_MS  200
-#define ACK_REQUEST     0x01
-#define ACK_RESPONSE    0x02
+#define ACK_REQUEST     ESPNOW_MSG_ACK_REQUEST
+#define ACK_RESPONSE    ESPNOW_MSG_ACK_RESPONSE
 #define PACKET_SIZE     128
+#define REPORT_PERIOD_S 5       // bu aralıkla RTT yüzdelikleri yazdırılır
+#define REQUEST_SEED    0x01    // istek dolgusunun PRBS tohumu
+
+/**
+ * Pipeline modu: aynı anda en fazla MAX_IN_FLIGHT istek havada olabilir.
+ * IN_FLIGHT_STEPS listesindeki her derinlik STEP_DURATION_S boyunca koşturulur
+ * ve sonunda derinlik başına yanıt/s ve RTT yüzdelikleri tablo halinde yazdırılır.
+ * {1} verilirse eski tek istekli (stop-and-wait) ölçüm elde edilir.
+ */
+#define MAX_IN_FLIGHT       16
+#define IN_FLIGHT_STEPS     {1, 2, 4, 8, 16}
+#define STEP_DURATION_S     10
+
+/**
+ * Alıcıyla espnow_timesync üzerinden saat ofseti tahmin edilir. Yanıttaki
+ * peer_rx_time_us yerel saate çevrilerek RTT ileri (istek) ve geri (yanıt,
+ * alıcıdaki dönüş süresi dahil) tek yön gecikmelerine ayrılır.
+ */
+#define TIMESYNC_PERIOD_MS  250
+
+/**
+ * ESP-NOW şifrelemesi (CCMP). ESPNOW_ENCRYPT 1 olduğunda alıcı peer'ı
+ * ESPNOW_PMK ve ESPNOW_LMK ile şifreli eklenir; alıcıda da aynı anahtarlarla
+ * açılmalıdır. Şifreli peer sayısı CONFIG_ESP_WIFI_ESPNOW_MAX_ENCRYPT_NUM ile
+ * sınırlıdır; sınır doluysa gönderici başlamaz.
+ *
+ * ENCRYPT_COMPARE_MODE 1 olduğunda IN_FLIGHT_STEPS'teki her derinlik önce
+ * şifresiz sonra şifreli olarak iki kez koşturulur; adımlar arasında alıcıyla
+ * birlikte mod değiştirilir (alıcıda ENCRYPT_COMPARE_MODE da açılmalıdır).
+ * Tabloya adımın modu ve çekirdek başına CPU yükü eklenir, sonda derinlik
+ * başına şifreli ile şifresiz arasındaki yanıt/s, RTT ve CPU farkları yazdırılır.
+ */
+#define ESPNOW_ENCRYPT          0
+#define ESPNOW_PMK              "pmk1234567890123"  // ESP_NOW_KEY_LEN (16) karakter
+#define ESPNOW_LMK              "lmk1234567890123"
+#define ENCRYPT_COMPARE_MODE    0
+
+#define RUNS_PER_STEP           (ENCRYPT_COMPARE_MODE ? 2 : 1)
+#define CPU_IDLE_CALIBRATION_MS 500
 
 static const char *TAG = "SENDER";
 
 static uint8_t broadcast_mac[] = {0xCC, 0x7B, 0x5C, 0xF8, 0xDE, 0xCC}; // Alıcı ESP32 MAC adresi
 
+/**
+ * İstek ve yanıt paketlerinin başlığı. Alıcı isteğin başlığını type alanı
+ * dışında aynen geri gönderir; RTT, yanıttaki send_time_us ile yanıtın geldiği
+ * an arasındaki farktır ve tamamen göndericinin saatiyle ölçülür.
+ * Alıcıdaki ack_hdr_t ile aynı olmalıdır.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t type;           // ACK_REQUEST / ACK_RESPONSE
+    uint32_t seq;
+    int64_t send_time_us;
+    int64_t peer_rx_time_us;    // yanıtta: isteğin alıcıya geliş anı (alıcının saatiyle)
+} ack_hdr_t;
+
 uint8_t request_payload[PACKET_SIZE];
-uint8_t response_payload[PACKET_SIZE];
 
 int total_ack_sent = 0;
 int total_ack_received = 0;
-SemaphoreHandle_t ack_sem;
+int total_late_ack = 0;         // zaman aşımından sonra gelen ya da bekleyen tabloda olmayan seq'li yanıtlar
+static frame_check_stats_t response_check;  // CRC'si tutmayan yanıtlar eşleştirilmez, istek zaman aşımına düşer
+SemaphoreHandle_t ack_sem;      // boş bekleyen-istek slotları (counting)
 
-int64_t last_send_time = 0;
+/**
+ * Aynı anda havada olan isteklerin tablosu. Yanıtlar seq ile eşleştirilir;
+ * ACK_TIMEOUT_MS içinde yanıtlanmayan istekler zaman aşımı sayılıp slotları
+ * boşaltılır. Tabloya recv_cb (Wi-Fi task) ve gönderici task birlikte eriştiği
+ * için pending_lock ile korunur.
+ */
+typedef struct {
+    bool in_use;
+    uint32_t seq;
+    int64_t send_time_us;
+} pending_req_t;
+
+static pending_req_t pending[MAX_IN_FLIGHT];
+static int pending_count = 0;
+static portMUX_TYPE pending_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static latency_hist_t window_hist;  // son REPORT_PERIOD_S saniyenin RTT'leri, pending_lock ile korunur
+static latency_hist_t step_hist;    // içinde bulunulan derinlik adımının RTT'leri
+static latency_hist_t total_hist;   // test başından beri
+static latency_hist_t fwd_hist;     // son pencerenin ileri tek yön gecikmeleri, pending_lock ile korunur
+static latency_hist_t rev_hist;     // son pencerenin geri tek yön gecikmeleri
+static uint32_t owd_negative = 0;   // saat tahmini hatası yüzünden negatif çıkan tek yön gecikmeler
+
+typedef struct {
+    int in_flight;
+    int sent;
+    int responses;
+    int timeouts;
+    int late;
+    int corrupt;
+    double duration_s;
+    latency_summary_t rtt;
+    bool encrypted;
+    float busy_pct[CPU_IDLE_MAX_CORES];
+} step_result_t;
 
 static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
     // Gerekirse loglanabilir
 }
 
 static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
-    if (len == PACKET_SIZE && memcmp(data, response_payload, PACKET_SIZE) == 0) {
+    int64_t now = esp_timer_get_time();
+    if (espnow_timesync_on_recv(recv_info, data, len)) {
+        return;
+    }
+#if ESPNOW_ENCRYPT || ENCRYPT_COMPARE_MODE
+    if (espnow_secure_on_recv(recv_info, data, len)) {
+        return;
+    }
+#endif
+    if (len != PACKET_SIZE || data[0] != ACK_RESPONSE) {
+        return;
+    }
+    if (!frame_check_verify(&response_check, data, len)) {
+        return;
+    }
+
+    ack_hdr_t hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+
+    int64_t peer_rx_local_us;
+    bool synced = espnow_timesync_remote_to_local(hdr.peer_rx_time_us, &peer_rx_local_us);
+
+    bool matched = false;
+    portENTER_CRITICAL(&pending_lock);
+    for (int i = 0; i < MAX_IN_FLIGHT; i++) {
+        if (pending[i].in_use && pending[i].seq == hdr.seq) {
+            pending[i].in_use = false;
+            pending_count--;
+            latency_hist_record(&window_hist, (uint32_t)(now - pending[i].send_time_us));
+            if (synced && peer_rx_local_us >= pending[i].send_time_us && peer_rx_local_us <= now) {
+                latency_hist_record(&fwd_hist, (uint32_t)(peer_rx_local_us - pending[i].send_time_us));
+                latency_hist_record(&rev_hist, (uint32_t)(now - peer_rx_local_us));
+            }
+            else if (synced) {
+                owd_negative++;
+            }
+            matched = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&pending_lock);
+
+    if (matched) {
+        total_ack_received++;
+        xSemaphoreGive(ack_sem);
+    }
+    else {
+        total_late_ack++; // zaman aşımına uğramış bir isteğin yanıtı
+    }
+}
+
+/* ACK_TIMEOUT_MS'i geçen istekleri zaman aşımı sayar ve slotlarını serbest bırakır */
+static int expire_stale_requests(int64_t now) {
+    int expired = 0;
+    portENTER_CRITICAL(&pending_lock);
+    for (int i = 0; i < MAX_IN_FLIGHT; i++) {
+        if (pending[i].in_use && now - pending[i].send_time_us > ACK_TIMEOUT_MS * 1000LL) {
+            pending[i].in_use = false;
+            pending_count--;
+            latency_hist_record_timeout(&window_hist);
+            expired++;
+        }
+    }
+    portEXIT_CRITICAL(&pending_lock);
+
+    for (int i = 0; i < expired; i++) {
         xSemaphoreGive(ack_sem);
     }
+    return expired;
+}
+
+/* Boş bir slota seq'i yazar; slotun varlığı ack_sem ile garanti edilir */
+static int pending_alloc(uint32_t seq, int64_t send_time_us) {
+    int slot = -1;
+    portENTER_CRITICAL(&pending_lock);
+    for (int i = 0; i < MAX_IN_FLIGHT; i++) {
+        if (!pending[i].in_use) {
+            pending[i].in_use = true;
+            pending[i].seq = seq;
+            pending[i].send_time_us = send_time_us;
+            pending_count++;
+            slot = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&pending_lock);
+    return slot;
+}
+
+static void pending_free(int slot) {
+    portENTER_CRITICAL(&pending_lock);
+    if (pending[slot].in_use) {
+        pending[slot].in_use = false;
+        pending_count--;
+    }
+    portEXIT_CRITICAL(&pending_lock);
 }
 
+static void report_rtt(void) {
+    static latency_hist_t snapshot;
+    static latency_hist_t fwd_snapshot;
+    static latency_hist_t rev_snapshot;
+    uint32_t negative;
+    portENTER_CRITICAL(&pending_lock);
+    snapshot = window_hist;
+    fwd_snapshot = fwd_hist;
+    rev_snapshot = rev_hist;
+    latency_hist_reset(&window_hist);
+    latency_hist_reset(&fwd_hist);
+    latency_hist_reset(&rev_hist);
+    negative = owd_negative;
+    portEXIT_CRITICAL(&pending_lock);
+
+    printf("---\n");
+    latency_hist_log_summary(&snapshot, TAG, "Son pencere RTT:");
+    if (fwd_snapshot.count > 0) {
+        latency_hist_log_summary(&fwd_snapshot, TAG, "İleri tek yön:");
+        latency_hist_log_summary(&rev_snapshot, TAG, "Geri tek yön (dönüş süresi dahil):");
+    }
+    espnow_timesync_log(TAG);
+    if (negative > 0) {
+        ESP_LOGW(TAG, "Saat hatası yüzünden atlanan tek yön örneği: %lu", negative);
+    }
+    latency_hist_merge(&step_hist, &snapshot);
+    latency_hist_log_summary(&step_hist, TAG, "Adım RTT:");
+    ESP_LOGI(TAG, "ACK alındı: %d/%d, geç gelen ACK: %d, bozuk ACK: %lu, havada: %d", total_ack_received, total_ack_sent,
+             total_late_ack, (unsigned long)response_check.corrupt, pending_count);
+    printf("---\n");
+}
+
+static void run_in_flight_step(int in_flight, step_result_t *res) {
+    memset(res, 0, sizeof(step_result_t));
+    res->in_flight = in_flight;
+    latency_hist_reset(&step_hist);
+
+    // Bu adımda kullanılmayacak slotları park et: boşta sadece in_flight kadar slot kalır
+    for (int i = in_flight; i < MAX_IN_FLIGHT; i++) {
+        xSemaphoreTake(ack_sem, portMAX_DELAY);
+    }
+
+    static uint32_t seq = 0;
+    int sent_start = total_ack_sent, recv_start = total_ack_received, late_start = total_late_ack;
+    uint32_t corrupt_start = response_check.corrupt;
+#if ENCRYPT_COMPARE_MODE
+    cpu_idle_sample_t idle;
+    cpu_idle_sample(&idle); // ölçüm penceresini adım başlangıcına hizala
+#endif
+    int64_t start_us = esp_timer_get_time();
+    int64_t last_report_us = start_us;
+    int64_t now = start_us;
+
+    while (now - start_us < STEP_DURATION_S * 1000000LL) {
+        expire_stale_requests(now);
+
+        if (xSemaphoreTake(ack_sem, pdMS_TO_TICKS(10)) != pdTRUE) {
+            now = esp_timer_get_time();
+            continue; // pencere dolu; zaman aşımlarını kontrol etmek için döngüye dön
+        }
+
+        ack_hdr_t hdr = {
+            .type = ACK_REQUEST,
+            .seq = ++seq,
+            .send_time_us = esp_timer_get_time(),
+        };
+        int slot = pending_alloc(hdr.seq, hdr.send_time_us);
+        memcpy(request_payload, &hdr, sizeof(hdr));
+        frame_check_seal(request_payload, PACKET_SIZE);
+        total_ack_sent++;
+        esp_err_t res_send = esp_now_send(broadcast_mac, request_payload, PACKET_SIZE);
+        if (res_send != ESP_OK) {
+            ESP_LOGE(TAG, "esp_now_send hatası: %s", esp_err_to_name(res_send));
+            pending_free(slot);
+            xSemaphoreGive(ack_sem);
+            vTaskDelay(1); // TX kuyruğunun boşalmasına fırsat ver
+        }
+
+        now = esp_timer_get_time();
+        if (now - last_report_us >= REPORT_PERIOD_S * 1000000LL) {
+            report_rtt();
+            last_report_us = now;
+        }
+    }
+
+    // Havadaki tüm istekler yanıtlanana ya da zaman aşımına uğrayana kadar bekle
+    while (pending_count > 0) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        expire_stale_requests(esp_timer_get_time());
+    }
+    int64_t end_us = esp_timer_get_time();
+#if ENCRYPT_COMPARE_MODE
+    cpu_idle_sample(&idle);
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        res->busy_pct[c] = 100.0f - idle.idle_pct[c];
+    }
+    cpu_idle_log(&idle, TAG);
+#endif
+    report_rtt();
+
+    for (int i = in_flight; i < MAX_IN_FLIGHT; i++) {
+        xSemaphoreGive(ack_sem);
+    }
+
+    res->sent = total_ack_sent - sent_start;
+    res->responses = total_ack_received - recv_start;
+    res->late = total_late_ack - late_start;
+    res->corrupt = response_check.corrupt - corrupt_start;
+    res->timeouts = step_hist.timeouts;
+    res->duration_s = (end_us - start_us) / 1000000.0;
+    latency_hist_summarize(&step_hist, &res->rtt);
+    latency_hist_merge(&total_hist, &step_hist);
+}
+
+#if ENCRYPT_COMPARE_MODE
+/* Her derinlik için şifresiz (çift indeks) ve şifreli (tek indeks) adımların farkı */
+static void print_encrypt_deltas(const step_result_t *results, int run_count) {
+    printf("havada | yanıt/s farkı | p50 farkı | p99 farkı (us)");
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        printf(" | CPU%d farkı", c);
+    }
+    printf("\n");
+    for (int i = 0; i + 1 < run_count; i += 2) {
+        const step_result_t *plain = &results[i];
+        const step_result_t *enc = &results[i + 1];
+        if (plain->encrypted || !enc->encrypted) {
+            continue; // mod değişimi başarısız olmuş, karşılaştırılamaz
+        }
+        double plain_rate = plain->responses / plain->duration_s;
+        double enc_rate = enc->responses / enc->duration_s;
+        printf("%6d | %12.1f%% | %9ld | %9ld", plain->in_flight, plain_rate > 0 ? (enc_rate / plain_rate - 1) * 100.0 : 0.0,
+               (long)enc->rtt.p50_us - (long)plain->rtt.p50_us, (long)enc->rtt.p99_us - (long)plain->rtt.p99_us);
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            printf(" | %+8.1f", enc->busy_pct[c] - plain->busy_pct[c]);
+        }
+        printf("\n");
+    }
+}
+#endif
+
 void esp_now_send_ack_loop(void *pvParameters) {
+    static const int in_flight_steps[] = IN_FLIGHT_STEPS;
+    const int step_count = sizeof(in_flight_steps) / sizeof(in_flight_steps[0]);
+    const int run_count = step_count * RUNS_PER_STEP;
+    static step_result_t results[sizeof(in_flight_steps) / sizeof(in_flight_steps[0]) * RUNS_PER_STEP];
+
+    latency_hist_reset(&window_hist);
+    latency_hist_reset(&total_hist);
+    latency_hist_reset(&fwd_hist);
+    latency_hist_reset(&rev_hist);
+
     while (1) {
-        int64_t now = esp_timer_get_time();
-        
-        total_ack_sent++;
-        esp_err_t res = esp_now_send(broadcast_mac, request_payload, PACKET_SIZE);
-        if (res != ESP_OK) {
-            ESP_LOGE(TAG, "esp_now_send hatası: %s", esp_err_to_name(res));
+        for (int i = 0; i < run_count; i++) {
+            int step = in_flight_steps[i / RUNS_PER_STEP];
+            int in_flight = step > MAX_IN_FLIGHT ? MAX_IN_FLIGHT : step;
+#if ENCRYPT_COMPARE_MODE
+            bool encrypt = (i % 2) != 0;
+            if (espnow_secure_switch(broadcast_mac, encrypt, 5000) != ESP_OK) {
+                ESP_LOGE(TAG, "Alıcı %s moda geçmedi, adım mevcut modda koşturuluyor.", encrypt ? "şifreli" : "şifresiz");
+            }
+#endif
+            bool encrypted = espnow_secure_is_encrypted(broadcast_mac);
+            ESP_LOGW(TAG, "Adım %d/%d: aynı anda %d istek, %s", i + 1, run_count, in_flight, encrypted ? "şifreli" : "şifresiz");
+            run_in_flight_step(in_flight, &results[i]);
+            results[i].encrypted = encrypted;
         }
 
-        if (xSemaphoreTake(ack_sem, pdMS_TO_TICKS(ACK_TIMEOUT_MS)) == pdTRUE) {
-            total_ack_received++;
-            int64_t delta_us = now - last_send_time;
-            last_send_time = now;
-            ESP_LOGI(TAG, "ACK alındı (%d/%d) gecen sure: %.2f millis", total_ack_received, total_ack_sent, delta_us / 1000.0);
+        printf("---\n");
+        ESP_LOGI(TAG, "ISTEK/YANIT PIPELINE TARAMASI");
+        printf("havada | şifre | gönderilen | yanıt | timeout |  geç | bozuk |  yanıt/s |  p50 |  p90 |  p99 | p99.9 |   max (us)");
+#if ENCRYPT_COMPARE_MODE
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            printf(" | CPU%d %%", c);
         }
-        else {
-            ESP_LOGW(TAG, "ACK zaman aşımı (%d/%d)", total_ack_received, total_ack_sent);
+#endif
+        printf("\n");
+        for (int i = 0; i < run_count; i++) {
+            const step_result_t *r = &results[i];
+            printf("%6d | %-5s | %10d | %5d | %7d | %4d | %5d | %8.1f | %4lu | %4lu | %4lu | %5lu | %10lu",
+                   r->in_flight, r->encrypted ? "CCMP" : "yok", r->sent, r->responses, r->timeouts, r->late, r->corrupt,
+                   r->responses / r->duration_s, r->rtt.p50_us, r->rtt.p90_us, r->rtt.p99_us, r->rtt.p999_us, r->rtt.max_us);
+#if ENCRYPT_COMPARE_MODE
+            for (int c = 0; c < portNUM_PROCESSORS; c++) {
+                printf(" | %6.1f", r->busy_pct[c]);
+            }
+#endif
+            printf("\n");
         }
-        //vTaskDelay(pdMS_TO_TICKS(200)); //ACK istekleri arasında bekleme
+#if ENCRYPT_COMPARE_MODE
+        print_encrypt_deltas(results, run_count);
+#endif
+        latency_hist_log_summary(&total_hist, TAG, "Toplam RTT:");
+        printf("---\n");
     }
 }
 
@@ -85,9 +444,23 @@ static void esp_now_init_func(void) {
     peer->ifidx = WIFI_IF_STA;  // Karşıdaki cihaz değil, bu cihazın hangi wifi arayüzü ile veri göndereceği (Claude: Hedef cihaza hangi arayüz üzerinden (STA/AP) ulaşacağınız)
     peer->encrypt = false;      // Cihazlar arası veri şifrelemesi olacak mı?
     memcpy(peer->peer_addr, broadcast_mac, ESP_NOW_ETH_ALEN);
+#if ESPNOW_ENCRYPT || ENCRYPT_COMPARE_MODE
+    ESP_ERROR_CHECK(espnow_secure_init((const uint8_t *)ESPNOW_PMK, (const uint8_t *)ESPNOW_LMK));
+    espnow_secure_peer_t secure_peer = {
+        .peer_addr = peer->peer_addr,
+        .channel = peer->channel,
+        .ifidx = peer->ifidx,
+        .encrypt = ESPNOW_ENCRYPT,
+        .allow_plaintext = false,   // şifreli ölçüm istenirken sessizce şifresiz ölçülmesin
+    };
+    ESP_ERROR_CHECK(espnow_secure_add_peer(&secure_peer, NULL)); // şifreli peer sınırı burada kontrol edilir
+#else
     ESP_ERROR_CHECK(esp_now_add_peer(peer));
+#endif
     free(peer);
 
+    ESP_ERROR_CHECK(espnow_timesync_start_client(broadcast_mac, TIMESYNC_PERIOD_MS)); // alıcı sunucu olarak yanıtlar
+
     ESP_LOGW(TAG, "ESP-NOW baslatildi. Dinlemede.");
 }
 
@@ -103,13 +476,15 @@ void wifi_init(void) {
 
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init());
+#if ENCRYPT_COMPARE_MODE
+    ESP_ERROR_CHECK(cpu_idle_init(CPU_IDLE_CALIBRATION_MS)); // Wi-Fi yükü başlamadan %100 boşta hızını ölç
+#endif
 
-    memset(request_payload, 0x01, PACKET_SIZE); // ACK request filled array
-    memset(response_payload, 0x02, PACKET_SIZE); // ACK response filled array
+    frame_check_fill(request_payload, sizeof(ack_hdr_t), PACKET_SIZE, REQUEST_SEED); // başlık ve CRC her istekte yazılır
 
     wifi_init();
     esp_now_init_func();
-    ack_sem = xSemaphoreCreateBinary();
+    ack_sem = xSemaphoreCreateCounting(MAX_IN_FLIGHT, MAX_IN_FLIGHT);
 
     xTaskCreate(esp_now_send_ack_loop, "esp_now_send_ack_loop", 4096, NULL, 5, NULL);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "esp_event.h"
 #include "esp_system.h"
@@ -12,11 +13,83 @@
 #include "esp_now.h"
 #include "esp_timer.h"
 #include "esp_private/wifi.h"
+#include "esp_random.h"
+#include "espnow_msg_types.h"
+#include "espnow_phy_sweep.h"
+#include "cpu_idle.h"
+#include "mac_table.h"
+#include "espnow_fec.h"
+#include "frame_check.h"
+#include "telemetry.h"
 
 #define WIFI_CHANNEL    1
 #define PRINT_DURATION  5
 #define PACKET_SIZE     1024
 #define STRT_REQUEST    0x01
+#define DUMMY_DATA      ESPNOW_MSG_DATA_MARKER  // veri paketinin ilk baytı; ardından 4 baytlık sıra numarası gelir
+#define SEQ_OFFSET      1
+
+#define CPU_IDLE_CALIBRATION_MS 500
+
+/**
+ * Menzil profili modu. Vericideki RANGE_PROFILE_MODE ile birlikte açılır. LR
+ * çerçeveleri yalnızca protokol listesinde WIFI_PROTOCOL_LR olan arayüzde
+ * alınabildiğinden açılışta LR eklenir; kapalıyken alıcı LR hücrelerini
+ * desteklenmiyor diye bildirir ve verici onları atlar.
+ */
+#define RANGE_PROFILE_MODE  0
+
+/* rx_events */
+#define RX_EVT_STARTED  BIT0            // STRT_REQUEST alındı
+
+/**
+ * Fan-in modu. 1 olduğunda veri paketleri gönderen MAC'e göre ayrılır ve her
+ * gönderici için bayt, paket, sıra numarasından kayıp, RSSI ve son görülme
+ * zamanı tutulur. Her raporda toplam ve gönderici başına throughput ile aktif
+ * göndericiler arasındaki adalet (Jain indeksi) yazdırılır. Vericiler her paketin
+ * işaret baytından sonra sıra numarası yazar; birden fazla verici aynı anda çalıştırılarak
+ * gateway'in 2, 5, 10 göndericide nasıl yavaşladığı ölçülür.
+ */
+#define FAN_IN_MODE         0
+#define FAN_IN_IDLE_MS      2000    // bu süredir paket gelmeyen gönderici pasif sayılır
+#define SEQ_RESTART_GAP     1000    // bu kadar geriye giden sıra numarası verici yeniden başladı sayılır
+
+/**
+ * Fan-out modu. Verici her pencerenin sonunda FANOUT_WINDOW_END yayınlar; alıcı
+ * o pencerede aldığı paket sayısını, ortalama RSSI'ı ve en uzun kayıp serisini
+ * FANOUT_REPORT ile vericiye geri yollar. Çok sayıda alıcının yanıtları çakışmasın
+ * diye yanıt 0..FAN_OUT_REPLY_JITTER_MS arası rastgele geciktirilir.
+ */
+#define FAN_OUT_MODE            0
+#define FAN_OUT_REPLY_JITTER_MS 100
+#define FANOUT_WINDOW_END       ESPNOW_MSG_FANOUT_WINDOW_END
+#define FANOUT_REPORT           ESPNOW_MSG_FANOUT_REPORT
+
+/**
+ * FEC modu. Vericideki FEC_MODE ile birlikte açılır. Gruplar espnow_fec ile
+ * çözülür; eksik veri paketleri parity'den yeniden oluşturulur ve her raporda
+ * (K, M) ayarı başına ham kayıp, kurtarılan, kalan kayıp ve etkin goodput
+ * tablosu yazdırılır. Kurtarılan paketlerin içeriği vericinin dummy verisiyle
+ * karşılaştırılır.
+ */
+#define FEC_MODE                0
+
+/**
+ * Telemetri modu. 1 olduğunda istatistikler her TELEMETRY_PERIOD_MS'de bir
+ * components/telemetry ile ayrı bir UART'a (varsayılan UART1, TX GPIO 17,
+ * 2 Mbaud) ikili kayıt olarak yazılır; host'ta tools/telemetry_decode.py ile
+ * çözülüp CSV'ye kaydedilir. Konsoldaki metin rapor yine PRINT_DURATION'da bir
+ * basılır, böylece yüksek frekanslı ölçüm konsol UART'ını beklemez.
+ */
+#define TELEMETRY_MODE          0
+#define TELEMETRY_PERIOD_MS     100
+
+#if TELEMETRY_MODE
+#define REPORT_PERIOD_MS        TELEMETRY_PERIOD_MS
+#else
+#define REPORT_PERIOD_MS        (PRINT_DURATION * 1000)
+#endif
+#define TEXT_REPORT_EVERY       (PRINT_DURATION * 1000 / REPORT_PERIOD_MS)
 
 static const char *TAG = "RECEIVER";
 static const char *ESPNOW_TAG = "ESP_NOW";
@@ -27,42 +100,329 @@ int64_t active_start_us = 0;
 int64_t active_duration_us = 0;
 static bool test_started = false;
 
+static EventGroupHandle_t rx_events = NULL;
+static TaskHandle_t stats_task_handle = NULL;
+static esp_timer_handle_t report_timer = NULL;
+
+#if FAN_OUT_MODE
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t window;
+    uint32_t sent;          // WINDOW_END: vericinin bu pencerede gönderdiği veri paketi sayısı
+    uint32_t received;      // REPORT: alıcının bu pencerede aldığı veri paketi sayısı
+    uint32_t longest_gap;   // REPORT: penceredeki en uzun ardışık kayıp serisi
+    int8_t rssi;            // REPORT: penceredeki ortalama RSSI
+} fanout_msg_t;
+
+static uint32_t win_received = 0;
+static int32_t win_rssi_sum = 0;
+static uint32_t win_longest_gap = 0;
+static uint32_t win_last_seq = 0;
+static bool win_seq_valid = false;
+static int32_t fanout_last_window = -1;     // tekrarlanan WINDOW_END'ler tek rapor üretir
+static fanout_msg_t fanout_pending;
+static uint8_t fanout_sender[ESP_NOW_ETH_ALEN];
+static esp_timer_handle_t fanout_reply_timer = NULL;
+#endif
+
+#if FAN_IN_MODE
+typedef struct {
+    uint64_t bytes;
+    uint32_t frames;
+    uint32_t expected;      // sıra numaralarına göre gelmesi gereken paket sayısı
+    uint32_t max_seq;
+    uint32_t restarts;
+    int64_t rssi_sum;
+    int64_t first_seen_us;
+    int64_t last_seen_us;
+} source_stats_t;
+
+static mac_table_t sources;
+static source_stats_t source_stats[MAC_TABLE_CAPACITY];    // sources ile aynı indeksle
+static uint32_t source_overflow = 0;                        // tablo dolu olduğu için sayılamayan paketler
+static portMUX_TYPE source_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+static frame_check_stats_t frame_check;     // veri paketlerinin CRC kontrolü, yalnızca recv_cb (Wi-Fi task) yazar
+#if FEC_MODE
+static frame_check_stats_t fec_check;       // FEC'in teslim ettiği (kurtarılanlar dahil) yüklerin CRC kontrolü
+#endif
+
 static uint8_t broadcast_mac[] = {0xF0, 0x9E, 0x9E, 0x20, 0x9A, 0x68}; //ESP32-S3'ün mac adresi
 // static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xCC, 0x7B, 0x5C, 0xF8, 0xDE, 0xCC}; //siyah kablolu esp32'nin mac adresi
 
+#if FAN_IN_MODE
+static void fan_in_on_frame(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    uint32_t seq;
+    memcpy(&seq, data + SEQ_OFFSET, sizeof(seq));
+    int64_t now_us = esp_timer_get_time();
+    int rssi = recv_info->rx_ctrl != NULL ? recv_info->rx_ctrl->rssi : 0;
+
+    portENTER_CRITICAL(&source_lock);
+    bool inserted;
+    int slot = mac_table_insert(&sources, recv_info->src_addr, &inserted);
+    if (slot < 0) {
+        source_overflow++;
+        portEXIT_CRITICAL(&source_lock);
+        return;
+    }
+    source_stats_t *st = &source_stats[slot];
+    if (inserted) {
+        memset(st, 0, sizeof(*st));
+        st->first_seen_us = now_us;
+        st->max_seq = seq;
+        st->expected = 1;
+    }
+    else if (seq > st->max_seq) {
+        st->expected += seq - st->max_seq;  // aradaki boşluk kayıp
+        st->max_seq = seq;
+    }
+    else if (seq + SEQ_RESTART_GAP < st->max_seq) {
+        st->restarts++;
+        st->expected++;
+        st->max_seq = seq;
+    }
+    st->bytes += len;
+    st->frames++;
+    st->rssi_sum += rssi;
+    st->last_seen_us = now_us;
+    portEXIT_CRITICAL(&source_lock);
+}
+#endif
+
+#if FAN_OUT_MODE
+static void fanout_on_frame(const esp_now_recv_info_t *recv_info, const uint8_t *data) {
+    uint32_t seq;
+    memcpy(&seq, data + SEQ_OFFSET, sizeof(seq));
+    if (win_seq_valid && seq > win_last_seq + 1) {
+        uint32_t gap = seq - win_last_seq - 1;
+        if (gap > win_longest_gap) {
+            win_longest_gap = gap;
+        }
+    }
+    win_last_seq = seq;
+    win_seq_valid = true;
+    win_received++;
+    win_rssi_sum += recv_info->rx_ctrl != NULL ? recv_info->rx_ctrl->rssi : 0;
+}
+
+static void fanout_reply_timer_cb(void *arg) {
+    if (!esp_now_is_peer_exist(fanout_sender)) {
+        esp_now_peer_info_t peer = {0};
+        peer.channel = 0;  // alıcının o anki kanalı
+        peer.ifidx = WIFI_IF_STA;
+        peer.encrypt = false;
+        memcpy(peer.peer_addr, fanout_sender, ESP_NOW_ETH_ALEN);
+        esp_now_add_peer(&peer);
+    }
+    esp_err_t err = esp_now_send(fanout_sender, (const uint8_t *)&fanout_pending, sizeof(fanout_pending));
+    if (err != ESP_OK) {
+        ESP_LOGE(ESPNOW_TAG, "Fan-out raporu gönderilemedi: %s", esp_err_to_name(err));
+    }
+}
+
+static void fanout_on_window_end(const esp_now_recv_info_t *recv_info, const fanout_msg_t *msg) {
+    if ((int32_t)msg->window == fanout_last_window || esp_timer_is_active(fanout_reply_timer)) {
+        return;
+    }
+    fanout_last_window = msg->window;
+
+    fanout_pending.type = FANOUT_REPORT;
+    fanout_pending.window = msg->window;
+    fanout_pending.sent = msg->sent;
+    fanout_pending.received = win_received;
+    fanout_pending.longest_gap = win_longest_gap;
+    fanout_pending.rssi = win_received > 0 ? (int8_t)(win_rssi_sum / (int32_t)win_received) : 0;
+    memcpy(fanout_sender, recv_info->src_addr, ESP_NOW_ETH_ALEN);
+
+    ESP_LOGI(TAG, "Pencere %u: gönderilen %lu, alınan %lu, en uzun kayıp serisi %lu",
+             msg->window, (unsigned long)msg->sent, (unsigned long)win_received, (unsigned long)win_longest_gap);
+
+    win_received = 0;
+    win_rssi_sum = 0;
+    win_longest_gap = 0;
+    win_last_seq = 0;
+    win_seq_valid = false;  // pencere sınırını aşan bir boşluk sonraki pencereye yazılmasın
+
+    esp_timer_start_once(fanout_reply_timer, (esp_random() % (FAN_OUT_REPLY_JITTER_MS + 1)) * 1000);
+}
+#endif
+
+#if FEC_MODE
+/* Yük: DUMMY_DATA, 4 baytlık sıra numarası, PRBS dolgu ve CRC32 */
+static void fec_deliver(const uint8_t *data, size_t len, uint16_t group, uint8_t index, bool recovered) {
+    frame_check_verify(&fec_check, data, len);
+}
+#endif
+
 static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (espnow_phy_sweep_on_recv(recv_info, data, len)) { // PHY taraması paketleri throughput sayımına katılmaz
+        return;
+    }
+#if FEC_MODE
+    if (espnow_fec_on_recv(recv_info, data, len)) {
+        if (test_started) {
+            total_received_bytes += len; // parity dahil havadan alınan
+        }
+        return;
+    }
+#endif
+
     if (!test_started && len == 1 && data[0] == STRT_REQUEST) {
         ESP_LOGW(ESPNOW_TAG, "Test başlıyor.");
         start_time_us = esp_timer_get_time();
         test_started = true;
+        xEventGroupSetBits(rx_events, RX_EVT_STARTED);
+    }
+
+    bool data_frame = len == PACKET_SIZE && data[0] == DUMMY_DATA;
+    if (data_frame && !frame_check_verify(&frame_check, data, len)) {
+        return; // bozuk paket sayılmaz; fan-in/fan-out'ta sıra numarası boşluğu olarak kayba yansır
     }
 
     if (test_started && len == PACKET_SIZE) {
         total_received_bytes += len;
     }
+#if FAN_OUT_MODE
+    if (data_frame) {
+        fanout_on_frame(recv_info, data);
+    }
+    else if (len == sizeof(fanout_msg_t) && data[0] == FANOUT_WINDOW_END) {
+        fanout_msg_t msg;
+        memcpy(&msg, data, sizeof(msg));
+        fanout_on_window_end(recv_info, &msg);
+    }
+#endif
+#if FAN_IN_MODE
+    if (data_frame) {
+        fan_in_on_frame(recv_info, data, len); // göndericiler STRT'yi farklı zamanlarda yollar, ilk paketten itibaren sayılır
+    }
+#endif
 }
 
-static void esp_now_recv_task() {
-    int64_t last_report_time_us = start_time_us;
+#if FAN_IN_MODE
+static void fan_in_report(uint32_t period_ms) {
+    static mac_table_t snap_sources;
+    static source_stats_t snap_stats[MAC_TABLE_CAPACITY];
+    static uint64_t prev_bytes[MAC_TABLE_CAPACITY];   // slot indeksleri sabit olduğundan indeksle eşleşir
+    uint32_t overflow;
+
+    portENTER_CRITICAL(&source_lock);
+    snap_sources = sources;
+    memcpy(snap_stats, source_stats, sizeof(snap_stats));
+    overflow = source_overflow;
+    portEXIT_CRITICAL(&source_lock);
+
+    int64_t now_us = esp_timer_get_time();
+    double period_s = period_ms / 1000.0;
+    double aggregate_kbs = 0, sum = 0, sum_sq = 0;
+    int active = 0;
+
+    ESP_LOGI(TAG, "FAN-IN: %d gönderici (tabloya sığmayan paket: %lu)", snap_sources.count, (unsigned long)overflow);
+    printf("%-17s | %9s | %9s | %8s | %7s | %5s | %8s\n", "gönderici", "KB/s", "ort KB/s", "paket", "kayıp %", "RSSI", "son (ms)");
+    for (int i = 0; i < MAC_TABLE_CAPACITY; i++) {
+        if (!snap_sources.used[i]) {
+            continue;
+        }
+        const source_stats_t *st = &snap_stats[i];
+        const uint8_t *m = snap_sources.keys[i];
+        double window_kbs = period_s > 0 ? (st->bytes - prev_bytes[i]) / 1024.0 / period_s : 0.0;
+        double lifetime_s = (st->last_seen_us - st->first_seen_us) / 1000000.0;
+        double avg_kbs = lifetime_s > 0 ? st->bytes / 1024.0 / lifetime_s : 0.0;
+        uint32_t lost = st->expected > st->frames ? st->expected - st->frames : 0;
+        double loss = st->expected > 0 ? lost * 100.0 / st->expected : 0.0;
+        int64_t age_ms = (now_us - st->last_seen_us) / 1000;
+        prev_bytes[i] = st->bytes;
+
+        printf("%02x:%02x:%02x:%02x:%02x:%02x | %9.2f | %9.2f | %8lu | %7.2f | %5ld | %8lld%s\n",
+               m[0], m[1], m[2], m[3], m[4], m[5], window_kbs, avg_kbs, (unsigned long)st->frames, loss,
+               st->frames > 0 ? (long)(st->rssi_sum / st->frames) : 0L, age_ms, age_ms > FAN_IN_IDLE_MS ? " (pasif)" : "");
+
+        aggregate_kbs += window_kbs;
+        if (age_ms <= FAN_IN_IDLE_MS) {
+            active++;
+            sum += window_kbs;
+            sum_sq += window_kbs * window_kbs;
+        }
+    }
+    // Jain adalet indeksi: 1 = tüm aktif göndericiler eşit pay alıyor, 1/n = tek gönderici baskın
+    double fairness = (active > 0 && sum_sq > 0) ? (sum * sum) / (active * sum_sq) : 0.0;
+    ESP_LOGI(TAG, "Toplam: %.2f KB/s, aktif gönderici: %d, gönderici başına ort: %.2f KB/s, Jain adalet: %.3f",
+             aggregate_kbs, active, active > 0 ? sum / active : 0.0, fairness);
+}
+#endif
+
+static void report_timer_cb(void *arg) {
+    xTaskNotifyGive(stats_task_handle); // yazdırma işi stats task'ında
+}
+
+/**
+ * esp_timer_get_time() yoklayan döngü yerine test başlangıcını event group'tan,
+ * rapor zamanını periyodik esp_timer bildiriminden bekler; arada bloklu kalır.
+ */
+static void esp_now_stats_task() {
+    cpu_idle_sample_t idle;
+    size_t last_report_bytes = 0;
+    uint32_t text_period_ms = 0;
+    int ticks = 0;
+#if TELEMETRY_MODE
+    telemetry_rx_t rec;
+#endif
+
+    xEventGroupWaitBits(rx_events, RX_EVT_STARTED, pdFALSE, pdTRUE, portMAX_DELAY);
+    cpu_idle_sample(&idle); // ölçüm penceresini test başlangıcına hizala
+    ESP_ERROR_CHECK(esp_timer_start_periodic(report_timer, REPORT_PERIOD_MS * 1000));
 
     while (1) {
-        if (test_started) {
-            int64_t now = esp_timer_get_time();
-            if (now - last_report_time_us >= (PRINT_DURATION * 1000000)) { // PRINT_DURATION saniye geçtiyse
-                int64_t elapsed_us = now - start_time_us;
-                double duration_s = elapsed_us / 1000000.0;
-                double kb_received = total_received_bytes / 1024.0;
-                double throughput = kb_received / duration_s;
-
-                printf("---\n");
-                ESP_LOGI(TAG, "Şimdiye kadar alınan veri: %d byte (%d KB)", total_received_bytes, total_received_bytes / 1024);
-                ESP_LOGI(TAG, "Süre: %.2f saniye", duration_s);
-                ESP_LOGI(TAG, "Throughput: %.2f KB/s", throughput);
-                printf("---\n");
-
-                last_report_time_us = now;
-            }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        size_t bytes = total_received_bytes;
+        cpu_idle_sample(&idle);
+        text_period_ms += idle.period_ms;
+#if TELEMETRY_MODE
+        telemetry_rx_init(&rec);
+        rec.period_ms = idle.period_ms;
+        rec.rx_bytes = bytes;
+        rec.rx_frames = frame_check.checked - frame_check.corrupt;
+        rec.corrupt = frame_check.corrupt;
+        telemetry_rx_set_idle(&rec, idle.idle_pct, CPU_IDLE_MAX_CORES);
+        telemetry_send(&rec, sizeof(rec));
+#endif
+        if (++ticks < TEXT_REPORT_EVERY) {
+            continue;
         }
+        ticks = 0;
+
+        int64_t elapsed_us = esp_timer_get_time() - start_time_us;
+        double duration_s = elapsed_us / 1000000.0;
+        double kb_received = bytes / 1024.0;
+        double throughput = kb_received / duration_s;
+        uint32_t report_period_ms = text_period_ms;
+        double window_kbs = report_period_ms > 0 ? (bytes - last_report_bytes) / 1024.0 / (report_period_ms / 1000.0) : 0.0;
+        last_report_bytes = bytes;
+        text_period_ms = 0;
+
+        printf("---\n");
+        ESP_LOGI(TAG, "Şimdiye kadar alınan veri: %d byte (%d KB)", bytes, bytes / 1024);
+        ESP_LOGI(TAG, "Süre: %.2f saniye", duration_s);
+        ESP_LOGI(TAG, "Throughput: %.2f KB/s (son %d s: %.2f KB/s)", throughput, PRINT_DURATION, window_kbs);
+        ESP_LOGI(TAG, "Bozuk paket (CRC): %lu / %lu", (unsigned long)frame_check.corrupt, (unsigned long)frame_check.checked);
+        cpu_idle_log(&idle, TAG);
+#if TELEMETRY_MODE
+        telemetry_stats_t tstats;
+        telemetry_get_stats(&tstats);
+        ESP_LOGI(TAG, "Telemetri: %lu kayıt gönderildi, %lu düştü", (unsigned long)tstats.sent, (unsigned long)tstats.dropped);
+#endif
+#if FAN_IN_MODE
+        fan_in_report(report_period_ms);
+#endif
+#if FEC_MODE
+        espnow_fec_print_stats(TAG);
+        if (fec_check.corrupt > 0) {
+            ESP_LOGE(TAG, "FEC: CRC'si tutmayan teslim: %lu / %lu", (unsigned long)fec_check.corrupt, (unsigned long)fec_check.checked);
+        }
+#endif
+        printf("---\n");
     }
     vTaskDelete(NULL);
 }
@@ -115,9 +475,39 @@ static void wifi_init(void) {
 
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init()); // NVS başlatma
+    ESP_ERROR_CHECK(cpu_idle_init(CPU_IDLE_CALIBRATION_MS)); // Wi-Fi yükü başlamadan %100 boşta hızını ölç
+#if TELEMETRY_MODE
+    const telemetry_config_t telemetry_cfg = TELEMETRY_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(telemetry_init(&telemetry_cfg));
+#endif
+
+    /* recv_cb event group'a yazmadan önce hazır olmalı */
+    rx_events = xEventGroupCreate();
+#if FEC_MODE
+    ESP_ERROR_CHECK(espnow_fec_decoder_init(fec_deliver));
+#endif
+#if FAN_IN_MODE
+    mac_table_reset(&sources);
+#endif
+#if FAN_OUT_MODE
+    const esp_timer_create_args_t fanout_timer_args = {
+        .callback = fanout_reply_timer_cb,
+        .name = "fanout_reply",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&fanout_timer_args, &fanout_reply_timer));
+#endif
+    const esp_timer_create_args_t report_timer_args = {
+        .callback = report_timer_cb,
+        .name = "rx_report",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&report_timer_args, &report_timer));
+    xTaskCreate(esp_now_stats_task, "esp_now_stats_task", 4096, NULL, 5, &stats_task_handle);
 
     /* WiFi ve ESP-NOW başlatma */
     wifi_init();
+#if RANGE_PROFILE_MODE
+    ESP_ERROR_CHECK(espnow_phy_sweep_enable_lr(WIFI_IF_STA));
+#endif
     esp_now_init_func();
 
     /* MAC adresini yazdır */
@@ -128,5 +518,4 @@ void app_main(void) {
              mac[0], mac[1], mac[2],
              mac[3], mac[4], mac[5]);
     ESP_LOGW("MAC", "Bu cihazin (dinleyici) mac adresi: %s", macStr);
-    xTaskCreate(esp_now_recv_task, "esp_now_recv_task", 4096, NULL, 5, NULL); // dinleyici task'ını başlat
 }
\ No newline at end of file
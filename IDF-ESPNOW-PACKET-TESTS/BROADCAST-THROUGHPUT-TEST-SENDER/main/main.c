@@ -3,6 +3,7 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_event.h"
 #include "esp_system.h"
@@ -11,18 +12,112 @@
 #include "esp_wifi.h"
 #include "esp_now.h"
 #include "esp_timer.h"
+#include "esp_random.h"
 #include "esp_private/wifi.h"
+#include "espnow_msg_types.h"
+#include "espnow_phy_sweep.h"
+#include "mac_table.h"
+#include "espnow_fec.h"
+#include "frame_check.h"
 
 #define WIFI_CHANNEL    1
 #define PRINT_DURATION  5
 #define PACKET_SIZE     1024
 #define STRT_REQUEST    0x01
-#define DUMMY_DATA      0xAA
+#define DUMMY_DATA      ESPNOW_MSG_DATA_MARKER  // veri paketinin ilk baytı; ardından 4 baytlık sıra numarası gelir
+#define SEQ_OFFSET      1
+
+/**
+ * PHY tarama modu. 1 olduğunda normal test yerine espnow_phy_sweep bileşeninin
+ * varsayılan matrisindeki (11B, 11G, HT20 MCS0-7 LGI/SGI) her hücre
+ * PHY_SWEEP_CELL_MS boyunca koşturulur ve sonunda goodput, kayıp ve send_cb
+ * hata oranı tablosu yazdırılır. Alıcı tarafında ayrıca bir ayar gerekmez.
+ */
+#define PHY_SWEEP_MODE      0
+#define PHY_SWEEP_CELL_MS   5000
+
+/**
+ * Paket boyutu tarama modu. 1 olduğunda testin kendi hızında (11B 11M)
+ * SIZE_SWEEP_SIZES listesindeki her boyut PHY_SWEEP_CELL_MS boyunca gönderilir.
+ * Boyut her hücrenin başında alıcıyla anlaşıldığından alıcının PACKET_SIZE'ı
+ * değiştirilip yeniden derlenmesi gerekmez. Sonunda boyut başına pps/goodput ve
+ * paket başına sabit maliyetin baskın olduğu boyut tahmini yazdırılır.
+ */
+#define SIZE_SWEEP_MODE     0
+#define SIZE_SWEEP_SIZES    {16, 32, 64, 128, 250, 512, 768, 1024, 1250, 1470}
+#define SIZE_SWEEP_PHYMODE  WIFI_PHY_MODE_11B
+#define SIZE_SWEEP_RATE     WIFI_PHY_RATE_11M_L
+
+/**
+ * Menzil profili modu. 1 olduğunda phy_sweep_range_cells koşturulur: LR 250K/500K,
+ * HE destekli çiplerde ERSU MCS0/MCS1 (DCM ile ve DCM'siz), karşılaştırma için
+ * 11B/11G/HT20. Tablodaki marj ortalama RSSI ile hücrenin nominal hassasiyeti
+ * arasındaki farktır; en yüksek goodput'lu hücreye göre ek marj ve bunun yol
+ * kaybı modeliyle karşılığı olan menzil çarpanı ayrıca yazdırılır. LR hücreleri
+ * için alıcıda da RANGE_PROFILE_MODE açık olmalıdır.
+ */
+#define RANGE_PROFILE_MODE  0
+
+/**
+ * Fan-out modu. Her PRINT_DURATION penceresinin sonunda gönderim kısa süre durur,
+ * pencerede gönderilen paket sayısıyla FANOUT_WINDOW_END yayınlanır ve alıcıların
+ * FANOUT_REPORT yanıtları FAN_OUT_COLLECT_MS boyunca toplanır. Ardından alıcı
+ * başına teslim oranı ve en kötü alıcı tek tabloda yazdırılır. Alıcılarda da
+ * FAN_OUT_MODE açık olmalıdır.
+ */
+#define FAN_OUT_MODE                0
+#define FAN_OUT_COLLECT_MS          300     // alıcıların yanıt gecikmesinden (100 ms) uzun olmalı
+#define FAN_OUT_WINDOW_END_REPEAT   3       // broadcast'te MAC ACK yok, kontrol paketi tekrarlanır
+#define FANOUT_WINDOW_END           ESPNOW_MSG_FANOUT_WINDOW_END
+#define FANOUT_REPORT               ESPNOW_MSG_FANOUT_REPORT
+
+/**
+ * FEC modu. 1 olduğunda veri paketleri espnow_fec ile K veri + M parity'lik
+ * gruplar halinde gönderilir; her FEC_PHASE_S saniyede FEC_SETTINGS listesindeki
+ * sıradaki (K, M) ayarına geçilir ve liste başa sarar. K+0 FEC'siz karşılaştırma
+ * satırıdır. Çerçeve boyutu PACKET_SIZE ile aynı kalır (yük FEC başlığı kadar
+ * kısalır). Alıcıda da FEC_MODE açık olmalıdır; ham kayıp, kurtarılan, kalan
+ * kayıp ve etkin goodput tablosu alıcıda yazdırılır.
+ */
+#define FEC_MODE            0
+#define FEC_SETTINGS        {{8, 0}, {8, 1}, {4, 1}, {8, 2}, {16, 4}}
+#define FEC_PHASE_S         10
+#define FEC_PAYLOAD_LEN     (PACKET_SIZE - FEC_HEADER_LEN - FEC_LEN_PREFIX)
 
 static const char *TAG = "SENDER";
 static const char *ESPNOW_TAG = "ESP_NOW";
 
 static bool send_done = true;
+static uint32_t tx_seq = 0;    // payload'daki sıra numarası; alıcı gönderici başına kaybı buradan hesaplar
+
+#if FEC_MODE
+#define FEC_SEND_CB_TIMEOUT_MS  100
+static SemaphoreHandle_t fec_send_sem = NULL;  // send_cb verir; fec_send_task bir sonraki çerçeve için bekler
+#endif
+
+#if FAN_OUT_MODE
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t window;
+    uint32_t sent;          // WINDOW_END: bu pencerede gönderilen veri paketi sayısı
+    uint32_t received;      // REPORT: alıcının bu pencerede aldığı veri paketi sayısı
+    uint32_t longest_gap;   // REPORT: penceredeki en uzun ardışık kayıp serisi
+    int8_t rssi;            // REPORT: penceredeki ortalama RSSI
+} fanout_msg_t;
+
+typedef struct {
+    fanout_msg_t last;      // son alınan rapor
+    uint64_t total_sent;
+    uint64_t total_received;
+    uint32_t reports;
+    uint16_t first_window;
+} receiver_stats_t;
+
+static uint16_t fanout_window = 0;
+static mac_table_t receivers;
+static receiver_stats_t receiver_stats[MAC_TABLE_CAPACITY];    // receivers ile aynı indeksle
+static portMUX_TYPE receiver_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
 
 int64_t start_time_us = 0;
 int64_t now = 0;
@@ -39,19 +134,143 @@ static uint8_t broadcast_mac[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}; //broadca
 
 static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
     send_done = true;
+#if FEC_MODE
+    xSemaphoreGive(fec_send_sem);
+#endif
+    espnow_phy_sweep_on_send(status);
 }
 
+#if FAN_OUT_MODE
+static void fanout_on_report(const uint8_t *mac, const fanout_msg_t *msg) {
+    portENTER_CRITICAL(&receiver_lock);
+    bool inserted;
+    int slot = mac_table_insert(&receivers, mac, &inserted);
+    if (slot >= 0) {
+        receiver_stats_t *st = &receiver_stats[slot];
+        if (inserted) {
+            memset(st, 0, sizeof(*st));
+            st->first_window = msg->window;
+        }
+        if (inserted || st->last.window != msg->window) {
+            st->last = *msg;
+            st->total_sent += msg->sent;
+            st->total_received += msg->received;
+            st->reports++;
+        }
+    }
+    portEXIT_CRITICAL(&receiver_lock);
+}
+#endif
+
+static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (espnow_phy_sweep_on_recv(recv_info, data, len)) { // tarama kontrol yanıtları (alıcılar tek tek yanıt verir)
+        return;
+    }
+#if FAN_OUT_MODE
+    if (len == sizeof(fanout_msg_t) && data[0] == FANOUT_REPORT) {
+        fanout_msg_t msg;
+        memcpy(&msg, data, sizeof(msg));
+        fanout_on_report(recv_info->src_addr, &msg);
+    }
+#endif
+}
+
+#if FAN_OUT_MODE
+static void wait_send_done() {
+    while (!send_done) {
+        vTaskDelay(1);
+    }
+}
+
+static void fanout_print_table(uint16_t window) {
+    static mac_table_t snap_receivers;
+    static receiver_stats_t snap_stats[MAC_TABLE_CAPACITY];
+
+    portENTER_CRITICAL(&receiver_lock);
+    snap_receivers = receivers;
+    memcpy(snap_stats, receiver_stats, sizeof(snap_stats));
+    portEXIT_CRITICAL(&receiver_lock);
+
+    int reported = 0, missing = 0, worst = -1;
+    double worst_ratio = 2.0, ratio_sum = 0;
+
+    ESP_LOGI(TAG, "FAN-OUT pencere %u: %d alıcı", window, snap_receivers.count);
+    printf("%-17s | %9s | %9s | %8s | %5s | %9s\n", "alıcı", "pencere %", "toplam %", "kayıp seri", "RSSI", "rapor");
+    for (int i = 0; i < MAC_TABLE_CAPACITY; i++) {
+        if (!snap_receivers.used[i]) {
+            continue;
+        }
+        const receiver_stats_t *st = &snap_stats[i];
+        const uint8_t *m = snap_receivers.keys[i];
+        double total_ratio = st->total_sent > 0 ? (double)st->total_received / st->total_sent : 0.0;
+        uint32_t windows = (uint16_t)(window - st->first_window) + 1;
+
+        if (st->last.window != window) {
+            missing++;
+            printf("%02x:%02x:%02x:%02x:%02x:%02x | %9s | %9.2f | %8s | %5s | %4lu/%-4lu\n",
+                   m[0], m[1], m[2], m[3], m[4], m[5], "yok", total_ratio * 100.0, "-", "-",
+                   (unsigned long)st->reports, (unsigned long)windows);
+            continue;
+        }
+        double ratio = st->last.sent > 0 ? (double)st->last.received / st->last.sent : 0.0;
+        printf("%02x:%02x:%02x:%02x:%02x:%02x | %9.2f | %9.2f | %8lu | %5d | %4lu/%-4lu\n",
+               m[0], m[1], m[2], m[3], m[4], m[5], ratio * 100.0, total_ratio * 100.0,
+               (unsigned long)st->last.longest_gap, st->last.rssi, (unsigned long)st->reports, (unsigned long)windows);
+
+        reported++;
+        ratio_sum += ratio;
+        if (ratio < worst_ratio) {
+            worst_ratio = ratio;
+            worst = i;
+        }
+    }
+
+    if (worst >= 0) {
+        const uint8_t *m = snap_receivers.keys[worst];
+        ESP_LOGW(TAG, "En kötü alıcı: %02x:%02x:%02x:%02x:%02x:%02x, teslim %%%.2f (ortalama %%%.2f, %d alıcı)",
+                 m[0], m[1], m[2], m[3], m[4], m[5], worst_ratio * 100.0, ratio_sum / reported * 100.0, reported);
+    }
+    if (missing > 0) {
+        ESP_LOGW(TAG, "Bu pencere için rapor gelmeyen alıcı: %d", missing);
+    }
+}
+
+/* Gönderimi durdurup pencereyi kapatır, raporları toplar ve tabloyu yazdırır */
+static void fanout_end_window(uint32_t sent_in_window) {
+    fanout_msg_t msg = {
+        .type = FANOUT_WINDOW_END,
+        .window = fanout_window,
+        .sent = sent_in_window,
+    };
+    for (int i = 0; i < FAN_OUT_WINDOW_END_REPEAT; i++) {
+        wait_send_done();
+        send_done = false;
+        if (esp_now_send(broadcast_mac, (const uint8_t *)&msg, sizeof(msg)) != ESP_OK) {
+            send_done = true;
+        }
+    }
+    wait_send_done();
+    vTaskDelay(pdMS_TO_TICKS(FAN_OUT_COLLECT_MS));
+    fanout_print_table(fanout_window);
+    fanout_window++;
+}
+#endif
+
 static void esp_now_send_task() {
     ESP_LOGW(ESPNOW_TAG, "ESP-NOW veri gönderme taskı başladı.");
     ESP_LOGW(ESPNOW_TAG, "Throughput testi başlıyor. Duraklatmak / devam ettirmek için BOOT tuşuna basınız.");
 
     start_time_us = esp_timer_get_time();
     int64_t last_report_time_us = start_time_us;
+    int64_t paused_us = 0;     // fan-out rapor toplama beklemeleri; gönderim süresine sayılmaz
+#if FAN_OUT_MODE
+    int window_start_count = packet_count;
+#endif
 
     while (1) {
         // PRINT_DURATION saniyede bir throughput bilgisi yazdır
         int64_t now_us = esp_timer_get_time();
-        int64_t active_duration_us = now_us - start_time_us;
+        int64_t active_duration_us = now_us - start_time_us - paused_us;
 
         if (active_duration_us >= PRINT_DURATION * 1000000 && now_us - last_report_time_us >= PRINT_DURATION * 1000000) {
             double duration_s = active_duration_us / 1000000.0;
@@ -62,6 +281,13 @@ static void esp_now_send_task() {
             ESP_LOGI(TAG, "Toplam gönderilen: %d byte (%d paket)", total_sent_bytes, packet_count);
             ESP_LOGI(TAG, "Aktif gönderim süresi: %.2f saniye", duration_s);
             ESP_LOGI(TAG, "Throughput: %.2f KB/s", throughput);
+#if FAN_OUT_MODE
+            fanout_end_window(packet_count - window_start_count);
+            window_start_count = packet_count;
+            int64_t resume_us = esp_timer_get_time();
+            paused_us += resume_us - now_us;
+            now_us = resume_us; // toplama beklemesi bir sonraki pencereye sayılmaz
+#endif
             printf("---\n");
 
             last_report_time_us = now_us;
@@ -69,8 +295,11 @@ static void esp_now_send_task() {
 
         if (send_done) {
             send_done = false;
+            memcpy(payload + SEQ_OFFSET, &tx_seq, sizeof(tx_seq));
+            frame_check_seal(payload, PACKET_SIZE);    // sıra numarası değiştiği için CRC her pakette yeniden
             esp_err_t err = esp_now_send(broadcast_mac, payload, PACKET_SIZE);
             if (err == ESP_OK) {
+                tx_seq++;
                 total_sent_bytes += PACKET_SIZE;
                 packet_count++;
             }
@@ -83,9 +312,127 @@ static void esp_now_send_task() {
     vTaskDelete(NULL);
 }
 
+#if FEC_MODE
+static const uint8_t fec_settings[][2] = FEC_SETTINGS;
+static fec_encoder_t fec_enc;
+static uint8_t fec_frame[FEC_FRAME_LEN(FEC_PAYLOAD_LEN)];
+
+/**
+ * Aşama süresince parity bekliyorsa önce parity, yoksa sıradaki veri paketi
+ * gönderilir. Aşama bitince yarım kalan grup son veri paketi işaretlenerek
+ * kapatılır ve parity'leri gönderildikten sonra sıradaki ayara geçilir; alıcı
+ * ayar değişimini çerçeve başlığından görür.
+ */
+static void fec_send_task() {
+    int setting_count = sizeof(fec_settings) / sizeof(fec_settings[0]);
+
+    for (int phase = 0; ; phase = (phase + 1) % setting_count) {
+        uint8_t k = fec_settings[phase][0];
+        uint8_t m = fec_settings[phase][1];
+        ESP_ERROR_CHECK(espnow_fec_encoder_init(&fec_enc, k, m, FEC_PAYLOAD_LEN));
+
+        int64_t phase_start_us = esp_timer_get_time();
+        size_t phase_bytes = 0;
+        bool closing = false;
+        ESP_LOGW(TAG, "FEC aşaması: K=%u M=%u, %d saniye", k, m, FEC_PHASE_S);
+
+        while (1) {
+            size_t len = espnow_fec_next_parity(&fec_enc, fec_frame);
+            if (len == 0) {
+                if (closing) {
+                    break;  // son grubun parity'leri de gitti
+                }
+                bool last = esp_timer_get_time() - phase_start_us >= FEC_PHASE_S * 1000000LL;
+                if (last && fec_enc.data_count == 0) {
+                    break;  // grup sınırında bitti, kapatılacak grup yok
+                }
+                memcpy(payload + SEQ_OFFSET, &tx_seq, sizeof(tx_seq));
+                frame_check_seal(payload, FEC_PAYLOAD_LEN); // CRC yükün sonunda, alıcı kurtarılan yükleri de kontrol eder
+                if (last) {
+                    closing = true;
+                    len = espnow_fec_encode_last(&fec_enc, payload, FEC_PAYLOAD_LEN, fec_frame);
+                }
+                else {
+                    len = espnow_fec_encode_data(&fec_enc, payload, FEC_PAYLOAD_LEN, fec_frame);
+                }
+                tx_seq++;
+            }
+
+            xSemaphoreTake(fec_send_sem, 0);    // önceki zaman aşımından kalmış bildirim
+            esp_err_t err = esp_now_send(broadcast_mac, fec_frame, len);
+            if (err == ESP_OK) {
+                phase_bytes += len;
+                total_sent_bytes += len;
+                packet_count++;
+                // send_cb gelmezse çerçeve gönderilmiş sayılır, alıcı grubu parity ile tamamlamaya çalışır
+                xSemaphoreTake(fec_send_sem, pdMS_TO_TICKS(FEC_SEND_CB_TIMEOUT_MS));
+            }
+            else {
+                // çerçeve kaybolmuş sayılır, alıcı grubu parity ile tamamlamaya çalışır
+                ESP_LOGE(TAG, "ESP-NOW Gönderim hatası: %s", esp_err_to_name(err));
+                vTaskDelay(1);
+            }
+        }
+
+        double duration_s = (esp_timer_get_time() - phase_start_us) / 1000000.0;
+        printf("---\n");
+        ESP_LOGI(TAG, "FEC K=%u M=%u: %lu veri + %lu parity paketi, %.2f saniye", k, m,
+                 (unsigned long)fec_enc.data_frames, (unsigned long)fec_enc.parity_frames, duration_s);
+        ESP_LOGI(TAG, "Hava throughput: %.2f KB/s, yük: %.2f KB/s", phase_bytes / 1024.0 / duration_s,
+                 fec_enc.data_frames * (double)FEC_PAYLOAD_LEN / 1024.0 / duration_s);
+        printf("---\n");
+    }
+    vTaskDelete(NULL);
+}
+#endif
+
+static void phy_sweep_task() {
+    phy_sweep_config_t config = {
+        .peer_addr = broadcast_mac,
+        .cells = phy_sweep_default_cells,
+        .cell_count = phy_sweep_default_cell_count,
+        .cell_duration_ms = PHY_SWEEP_CELL_MS,
+        .payload_len = PACKET_SIZE,
+    };
+#if SIZE_SWEEP_MODE
+    static const uint16_t sizes[] = SIZE_SWEEP_SIZES;
+    static phy_sweep_cell_t size_cells[sizeof(sizes) / sizeof(sizes[0])];
+    espnow_phy_sweep_make_size_cells(sizes, sizeof(sizes) / sizeof(sizes[0]), SIZE_SWEEP_PHYMODE, SIZE_SWEEP_RATE,
+                                     "11B 11M", size_cells);
+    config.cells = size_cells;
+    config.cell_count = sizeof(sizes) / sizeof(sizes[0]);
+#elif RANGE_PROFILE_MODE
+    config.cells = phy_sweep_range_cells;
+    config.cell_count = phy_sweep_range_cell_count;
+#endif
+
+    phy_sweep_result_t *results = calloc(config.cell_count, sizeof(phy_sweep_result_t));
+    if (results == NULL) {
+        ESP_LOGE(TAG, "Tarama sonuçları için malloc başarısız");
+        vTaskDelete(NULL);
+    }
+
+    ESP_LOGW(TAG, "Tarama başlıyor: %d hücre, hücre başına %d ms", config.cell_count, PHY_SWEEP_CELL_MS);
+    esp_err_t err = espnow_phy_sweep_run(&config, results);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Tarama tamamlanamadı: %s", esp_err_to_name(err));
+        free(results);
+        vTaskDelete(NULL);
+    }
+    espnow_phy_sweep_print_results(results, config.cell_count);
+#if SIZE_SWEEP_MODE
+    espnow_phy_sweep_print_size_curve(results, config.cell_count);
+#elif RANGE_PROFILE_MODE
+    espnow_phy_sweep_print_range_tradeoff(results, config.cell_count);
+#endif
+    free(results);
+    vTaskDelete(NULL);
+}
+
 static void esp_now_init_func(void) {
     ESP_ERROR_CHECK(esp_now_init());
     ESP_ERROR_CHECK(esp_now_register_send_cb(esp_now_send_cb));
+    ESP_ERROR_CHECK(esp_now_register_recv_cb(esp_now_recv_cb));
     
     /* Broadcast peer ekleme*/
     esp_now_peer_info_t *peer = malloc(sizeof(esp_now_peer_info_t)); // https://docs.espressif.com/projects/esp-idf/en/stable/esp32/api-reference/network/esp_now.html#_CPPv417esp_now_peer_info
@@ -121,10 +468,19 @@ static void esp_now_init_func(void) {
 
     ESP_LOGW(ESPNOW_TAG, "ESP-NOW başlatıldı.");
 
+#if PHY_SWEEP_MODE || SIZE_SWEEP_MODE || RANGE_PROFILE_MODE
+    xTaskCreate(phy_sweep_task, "phy_sweep_task", 4096, NULL, 5, NULL);
+#else
     uint8_t req = STRT_REQUEST;
     esp_now_send(broadcast_mac, &req, 1);
 
+#if FEC_MODE
+    fec_send_sem = xSemaphoreCreateBinary();
+    xTaskCreate(fec_send_task, "fec_send_task", 4096, NULL, 5, NULL);
+#else
     xTaskCreate(esp_now_send_task, "esp_now_send_task", 4096, NULL, 5, NULL);
+#endif
+#endif
 }
 
 static void wifi_init(void) {
@@ -142,7 +498,11 @@ static void wifi_init(void) {
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init()); // NVS başlatma
 
-    memset(payload, DUMMY_DATA, PACKET_SIZE); // dummy data
+    payload[0] = DUMMY_DATA;
+    frame_check_fill(payload, SEQ_OFFSET + sizeof(tx_seq), PACKET_SIZE, esp_random()); // PRBS dolgu, CRC32 gönderimde yazılır
+#if FAN_OUT_MODE
+    mac_table_reset(&receivers);
+#endif
 
     wifi_init(); // WiFi başlatma
 
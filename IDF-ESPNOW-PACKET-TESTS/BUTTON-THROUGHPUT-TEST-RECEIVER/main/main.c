@@ -12,19 +12,83 @@
 #include "esp_now.h"
 #include "esp_timer.h"
 #include "esp_private/wifi.h"
+#include "espnow_msg_types.h"
+#include "espnow_phy_sweep.h"
+#include "cpu_idle.h"
+#include "espnow_stream.h"
+#include "espnow_compress.h"
+#include "frame_check.h"
+#include "espnow_chan_survey.h"
+#include "telemetry.h"
 
 #define WIFI_CHANNEL    1
 #define TEST_DURATION_S 30
 #define PACKET_SIZE     1024
-#define ACK_REQUEST     0x01
-#define ACK_RESPONSE    0x02
-#define STOP_REQUEST    0x03
-#define CONT_REQUEST    0x04
+#define ACK_REQUEST     ESPNOW_MSG_ACK_REQUEST
+#define ACK_RESPONSE    ESPNOW_MSG_ACK_RESPONSE
+#define STOP_REQUEST    ESPNOW_MSG_STOP_REQUEST
+#define CONT_REQUEST    ESPNOW_MSG_CONT_REQUEST
+
+#define REPORT_PERIOD_MS        1000    // gönderim sürerken ara rapor ve CPU boşta ölçümü periyodu
+#define CPU_IDLE_CALIBRATION_MS 500
+
+/**
+ * Güvenilir akış karşılaştırması (göndericideki STREAM_MODE ile birlikte).
+ * 1 olduğunda espnow_stream başlatılır; stream_read_task akıştan okunan
+ * veriyi göndericinin desenine göre doğrular ve her REPORT_PERIOD_MS'de
+ * okuma hızını, her STREAM_STATS_EVERY raporda bir akış istatistiklerini yazar.
+ * Ham fazdaki paketler normal testteki gibi sayılır.
+ */
+#define STREAM_MODE         0
+#define STREAM_READ_CHUNK   2048
+#define STREAM_STATS_EVERY  10
+
+/**
+ * Sıkıştırma karşılaştırması (göndericideki COMPRESS_MODE ile birlikte).
+ * espnow_compress çerçeveleri recv_cb'de önceden ayrılmış tampona açılır ve
+ * throughput sayımına havadaki değil açılmış veri uzunluğu eklenir. Her raporda
+ * çerçeve başına açma süresi ve açılamayan çerçeve sayısı yazdırılır.
+ */
+#define COMPRESS_MODE       0
+
+/**
+ * Kanal taraması (göndericideki CHAN_SURVEY_MODE ile birlikte). Gönderici
+ * isteyince bu cihaz da kanalları ölçer ve gönderici en sessiz kanalı seçerse
+ * onunla birlikte o kanala geçer; WIFI_CHANNEL yalnızca buluşma kanalıdır.
+ */
+#define CHAN_SURVEY_MODE    0
+
+/**
+ * Telemetri modu. 1 olduğunda gönderim sürerken her TELEMETRY_PERIOD_MS'de bir
+ * istatistik kaydı components/telemetry ile ayrı bir UART'a (varsayılan UART1,
+ * TX GPIO 17, 2 Mbaud) ikili olarak yazılır; host'ta tools/telemetry_decode.py
+ * ile çözülür. Konsoldaki metin rapor yine REPORT_PERIOD_MS'de bir basılır.
+ */
+#define TELEMETRY_MODE      0
+#define TELEMETRY_PERIOD_MS 100
+
+#if TELEMETRY_MODE
+#define SAMPLE_PERIOD_MS    TELEMETRY_PERIOD_MS
+#else
+#define SAMPLE_PERIOD_MS    REPORT_PERIOD_MS
+#endif
+#define TEXT_REPORT_EVERY   (REPORT_PERIOD_MS / SAMPLE_PERIOD_MS)
+
+/**
+ * stats task'ına giden bildirim bitleri. STOP ve CONT kenarları zamanları ve o
+ * anki sayaçlarla birlikte recv_cb'de edge_queue'ya sırayla yazılır; task tek
+ * uyanışta STOP→CONT→STOP görse bile her kenarı ayrı işler, hiçbir duraklama
+ * raporu kaybolmaz ve duraklamada geçen süre aktif süreye eklenmez.
+ */
+#define NOTIFY_EDGE     (1 << 0)        // edge_queue'ya yeni kenar yazıldı
+#define NOTIFY_REPORT   (1 << 1)        // periyodik örnekleme zamanı
+#define EDGE_QUEUE_LEN  8
 
 static const char *TAG = "RECEIVER";
 static const char *ESPNOW_TAG = "ESP_NOW";
 
-static size_t total_received_bytes = 0;
+static size_t total_received_bytes = 0;          // yalnızca CRC'si tutan paketler
+static frame_check_stats_t frame_check;         // yalnızca recv_cb (Wi-Fi task) yazar
 static int64_t start_time_us = 0;
 static bool ack_completed = false;
 static bool stop_received = false;
@@ -32,6 +96,28 @@ int64_t active_start_us = 0;
 int64_t active_duration_us = 0;
 bool currently_receiving = false;
 
+static TaskHandle_t stats_task_handle = NULL;
+
+typedef struct {
+    bool active;                // true: ACK ya da CONT, false: STOP
+    int64_t time_us;
+    size_t bytes;               // kenar anındaki total_received_bytes
+    uint32_t corrupt;
+    uint32_t checked;
+} rx_edge_t;
+
+static portMUX_TYPE edge_lock = portMUX_INITIALIZER_UNLOCKED;
+static rx_edge_t edge_queue[EDGE_QUEUE_LEN];    // edge_lock ile
+static int edge_head = 0;
+static int edge_count = 0;
+static uint32_t edge_dropped = 0;
+static esp_timer_handle_t report_timer = NULL;
+
+#if COMPRESS_MODE
+static compress_ctx_t compress_ctx;                 // yalnızca recv_cb (Wi-Fi task) yazar
+static uint8_t compress_out[PACKET_SIZE];
+#endif
+
 static uint8_t broadcast_mac[] = {0xF0, 0x9E, 0x9E, 0x20, 0x9A, 0x68}; //ESP32-S3'ün mac adresi
 // static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xCC, 0x7B, 0x5C, 0xF8, 0xDE, 0xCC}; //siyah kablolu esp32'nin mac adresi
 
@@ -44,13 +130,61 @@ static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t statu
     }
 }
 
+static void notify_edge(bool active) {
+    rx_edge_t edge = {
+        .active = active,
+        .time_us = esp_timer_get_time(),
+        .bytes = total_received_bytes,      // sayaçlar da recv_cb'de yazıldığı için tutarlı
+        .corrupt = frame_check.corrupt,
+        .checked = frame_check.checked,
+    };
+    portENTER_CRITICAL(&edge_lock);
+    if (edge_count < EDGE_QUEUE_LEN) {
+        edge_queue[(edge_head + edge_count) % EDGE_QUEUE_LEN] = edge;
+        edge_count++;
+    }
+    else {
+        edge_dropped++;
+    }
+    portEXIT_CRITICAL(&edge_lock);
+    xTaskNotify(stats_task_handle, NOTIFY_EDGE, eSetBits);
+}
+
+static bool pop_edge(rx_edge_t *out) {
+    bool ok = false;
+    portENTER_CRITICAL(&edge_lock);
+    if (edge_count > 0) {
+        *out = edge_queue[edge_head];
+        edge_head = (edge_head + 1) % EDGE_QUEUE_LEN;
+        edge_count--;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&edge_lock);
+    return ok;
+}
+
 static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+#if CHAN_SURVEY_MODE
+    if (espnow_chan_survey_on_recv(recv_info, data, len)) {
+        return;
+    }
+#endif
+    if (espnow_phy_sweep_on_recv(recv_info, data, len)) { // PHY taraması paketleri throughput sayımına katılmaz
+        return;
+    }
+#if STREAM_MODE
+    if (espnow_stream_on_recv(recv_info, data, len)) { // akış segmentleri ham sayıma katılmaz
+        return;
+    }
+#endif
+
     if (!stop_received && !ack_completed && len == 1 && data[0] == ACK_REQUEST) {
         ESP_LOGI(ESPNOW_TAG, "ACK isteği alındı, yanıt gönderiliyor...");
         uint8_t ack = ACK_RESPONSE;
         esp_err_t err = esp_now_send(broadcast_mac, &ack, 1);
         if (err == ESP_OK) {
             ack_completed = true;
+            notify_edge(true);
             ESP_LOGW(ESPNOW_TAG, "Throughput testi başlıyor. Duraklatmak / devam ettirmek için vericideki BOOT tuşuna basınız.");
             start_time_us = esp_timer_get_time();
         }
@@ -59,7 +193,17 @@ static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t
         }
     }
 
-    if (!stop_received && ack_completed && len == PACKET_SIZE) {
+#if COMPRESS_MODE
+    if (espnow_compress_is_frame(data, len)) {
+        int out = espnow_decompress_frame(&compress_ctx, data, len, compress_out, sizeof(compress_out));
+        if (!stop_received && ack_completed && out > 0) {
+            total_received_bytes += out;
+        }
+        return;
+    }
+#endif
+
+    if (!stop_received && ack_completed && len == PACKET_SIZE && frame_check_verify(&frame_check, data, len)) {
         total_received_bytes += len;
     }
 
@@ -68,11 +212,13 @@ static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t
             case(STOP_REQUEST):
                 ESP_LOGI(ESPNOW_TAG, "STOP isteği alındı, test duraklatılıyor...\n---");
                 stop_received = true;
+                notify_edge(false);
                 break;
             case(CONT_REQUEST):
                 printf("---\n");
                 ESP_LOGI(ESPNOW_TAG, "CONT isteği alındı, test devam ettiriliyor...");
                 stop_received = false;
+                notify_edge(true);
                 break;
             default:
                 break;
@@ -80,36 +226,162 @@ static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t
     }
 }
 
-static void esp_now_recv_task() {
+static void report_timer_cb(void *arg) {
+    xTaskNotify(stats_task_handle, NOTIFY_REPORT, eSetBits); // yazdırma işi stats task'ında
+}
+
+/**
+ * Busy-wait yerine bildirim bekleyen istatistik task'ı. recv_cb durum değişikliğinde,
+ * report_timer ise her SAMPLE_PERIOD_MS'de bu task'ı uyandırır; arada task bloklu
+ * kaldığı için çekirdek Wi-Fi task'ına ve idle task'a kalır.
+ */
+static void esp_now_stats_task() {
+    size_t last_report_bytes = 0;
+    uint32_t last_report_corrupt = 0;
+    uint32_t text_period_ms = 0;
+    int ticks = 0;
+    cpu_idle_sample_t idle;
+#if TELEMETRY_MODE
+    telemetry_rx_t rec;
+#endif
+
     while (1) {
-        if (ack_completed && !stop_received) {
-            // Yeni bir gönderim süreci başladıysa
-            if (!currently_receiving) {
-                active_start_us = esp_timer_get_time();
+        uint32_t notified = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notified, portMAX_DELAY);
+
+        // Task uyanmadan gelen kenarların hepsi geliş sırasıyla işlenir
+        rx_edge_t edge;
+        while (pop_edge(&edge)) {
+            if (edge.active == currently_receiving) {
+                continue;   // durumla uyuşmayan tekrar kenar (ör. çift STOP)
+            }
+
+            if (edge.active) {
+                // Yeni bir gönderim süreci başladı
+                active_start_us = edge.time_us;
                 currently_receiving = true;
+                last_report_bytes = edge.bytes;
+                last_report_corrupt = edge.corrupt;
+                text_period_ms = 0;
+                ticks = 0;
+                cpu_idle_sample(&idle); // ölçüm penceresini sıfırla
             }
+            else {
+                // Gönderim durdu → STOP anına kadar geçen süreyi ekle
+                active_duration_us += (edge.time_us > active_start_us ? edge.time_us : active_start_us) - active_start_us;
+                currently_receiving = false;
+
+                double duration_s = active_duration_us / 1000000.0;
+                double kb_received = edge.bytes / 1024.0;
+                double throughput = kb_received / duration_s;
+
+                ESP_LOGW(TAG, "TEST DURAKLATILDI");
+                ESP_LOGI(TAG, "Şimdiye kadar alınan veri: %d byte (%d paket)", edge.bytes, edge.bytes / PACKET_SIZE);
+                ESP_LOGI(TAG, "Süre: %.2f saniye", duration_s);
+                ESP_LOGI(TAG, "Throughput: %.2f KB/s", throughput);
+                ESP_LOGI(TAG, "Bozuk paket (CRC): %lu / %lu", (unsigned long)edge.corrupt, (unsigned long)edge.checked);
+            }
+        }
+        portENTER_CRITICAL(&edge_lock);
+        uint32_t dropped = edge_dropped;
+        edge_dropped = 0;
+        portEXIT_CRITICAL(&edge_lock);
+        if (dropped > 0) {
+            ESP_LOGW(TAG, "%lu STOP/CONT kenarı kuyruk dolu olduğu için işlenemedi", (unsigned long)dropped);
         }
-        else if (ack_completed && currently_receiving && stop_received) {  // verici ESP32'nin paket gönderiği süreyi tam kapsayabilmek için gönderim süresinden 0.05 saniye daha fazla dinleme yapıyor
-            // Gönderim durdu → süreyi ekle
-            active_duration_us += esp_timer_get_time() - active_start_us;
-            currently_receiving = false;
-
-            double duration_s = active_duration_us / 1000000.0;
-            double kb_received = total_received_bytes / 1024.0;
-            double throughput = kb_received / duration_s;
-
-            ESP_LOGW(TAG, "TEST DURAKLATILDI");
-            ESP_LOGI(TAG, "Şimdiye kadar alınan veri: %d byte (%d paket)", total_received_bytes, total_received_bytes / 1024);
-            ESP_LOGI(TAG, "Süre: %.2f saniye", duration_s);
-            ESP_LOGI(TAG, "Throughput: %.2f KB/s", throughput);
-            while(stop_received);
-                // vTaskDelay(pdMS_TO_TICKS(1));
+
+        if ((notified & NOTIFY_REPORT) && currently_receiving) {
+            size_t bytes = total_received_bytes;
+            uint32_t corrupt = frame_check.corrupt;
+            cpu_idle_sample(&idle);
+            text_period_ms += idle.period_ms;
+#if TELEMETRY_MODE
+            telemetry_rx_init(&rec);
+            rec.period_ms = idle.period_ms;
+            rec.rx_bytes = bytes;
+            rec.rx_frames = frame_check.checked - corrupt;
+            rec.corrupt = corrupt;
+            telemetry_rx_set_idle(&rec, idle.idle_pct, CPU_IDLE_MAX_CORES);
+            telemetry_send(&rec, sizeof(rec));
+#endif
+            if (++ticks < TEXT_REPORT_EVERY) {
+                continue;
+            }
+            ticks = 0;
+
+            double window_kbs = text_period_ms > 0 ? (bytes - last_report_bytes) / 1024.0 / (text_period_ms / 1000.0) : 0.0;
+            last_report_bytes = bytes;
+            text_period_ms = 0;
+
+            ESP_LOGI(TAG, "Anlık throughput: %.2f KB/s, bozuk paket: %lu", window_kbs, (unsigned long)(corrupt - last_report_corrupt));
+            last_report_corrupt = corrupt;
+            cpu_idle_log(&idle, TAG);
+#if COMPRESS_MODE
+            compress_stats_t snap = compress_ctx.stats; // yalnızca rapor için, kilitsiz kopya
+            espnow_compress_log_stats(&snap, TAG);
+#endif
+#if TELEMETRY_MODE
+            telemetry_stats_t tstats;
+            telemetry_get_stats(&tstats);
+            if (tstats.dropped > 0) {
+                ESP_LOGW(TAG, "Telemetri: %lu kayıt TX tamponu dolu olduğu için düştü", (unsigned long)tstats.dropped);
+            }
+#endif
         }
-        // vTaskDelay(pdMS_TO_TICKS(1));
     }
     vTaskDelete(NULL);
 }
 
+#if STREAM_MODE
+/* Göndericideki stream_pattern ile aynı olmalı */
+static inline uint8_t stream_pattern(uint64_t offset) {
+    return (uint8_t)(offset ^ (offset >> 8) ^ (offset >> 16));
+}
+
+static void stream_read_task() {
+    static uint8_t buf[STREAM_READ_CHUNK];
+    uint64_t offset = 0;
+    uint64_t last_report_offset = 0;
+    uint32_t mismatches = 0;
+    uint32_t session_resets = 0;
+    int reports = 0;
+    int64_t last_report_us = esp_timer_get_time();
+
+    while (1) {
+        size_t n = espnow_stream_read(buf, sizeof(buf), pdMS_TO_TICKS(REPORT_PERIOD_MS));
+
+        stream_stats_t stats;
+        espnow_stream_get_stats(&stats);
+        if (stats.session_resets != session_resets) {
+            // Gönderici yeniden başladı; desen yeniden sıfırdan başlar
+            session_resets = stats.session_resets;
+            offset = 0;
+            last_report_offset = 0;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (buf[i] != stream_pattern(offset + i)) {
+                mismatches++;
+            }
+        }
+        offset += n;
+
+        int64_t now_us = esp_timer_get_time();
+        if (now_us - last_report_us >= REPORT_PERIOD_MS * 1000LL) {
+            if (offset != last_report_offset) {
+                double window_kbs = (offset - last_report_offset) / 1024.0 / ((now_us - last_report_us) / 1000000.0);
+                ESP_LOGI(TAG, "Akış: %.2f KB/s, toplam %llu byte, hatalı byte: %lu", window_kbs, offset, mismatches);
+                if (++reports % STREAM_STATS_EVERY == 0) {
+                    espnow_stream_log_stats(TAG);
+                }
+            }
+            last_report_offset = offset;
+            last_report_us = now_us;
+        }
+    }
+    vTaskDelete(NULL);
+}
+#endif
+
 static void esp_now_init_func(void) {
     ESP_ERROR_CHECK(esp_now_init());
     ESP_ERROR_CHECK(esp_now_register_send_cb(esp_now_send_cb));
@@ -142,6 +414,11 @@ static void esp_now_init_func(void) {
 
     ESP_ERROR_CHECK(esp_now_set_peer_rate_config(broadcast_mac, &rate_cfg));
 
+#if STREAM_MODE
+    ESP_ERROR_CHECK(espnow_stream_init(broadcast_mac)); // ACK'ler göndericiye peer üzerinden gider
+    xTaskCreate(stream_read_task, "stream_read_task", 4096, NULL, 5, NULL);
+#endif
+
     ESP_LOGW(ESPNOW_TAG, "ESP-NOW baslatildi. Dinlemede.");
 }
 
@@ -159,8 +436,29 @@ static void wifi_init(void) {
 
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init()); // NVS başlatma
+    ESP_ERROR_CHECK(cpu_idle_init(CPU_IDLE_CALIBRATION_MS)); // Wi-Fi yükü başlamadan %100 boşta hızını ölç
+#if TELEMETRY_MODE
+    const telemetry_config_t telemetry_cfg = TELEMETRY_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(telemetry_init(&telemetry_cfg));
+#endif
+
+    /* recv_cb bildirim göndermeden önce stats task'ı hazır olmalı */
+#if COMPRESS_MODE
+    espnow_compress_init(&compress_ctx, true);
+#endif
+    xTaskCreate(esp_now_stats_task, "esp_now_stats_task", 4096, NULL, 5, &stats_task_handle);
+
+    const esp_timer_create_args_t report_timer_args = {
+        .callback = report_timer_cb,
+        .name = "rx_report",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&report_timer_args, &report_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(report_timer, SAMPLE_PERIOD_MS * 1000));
 
     /* WiFi ve ESP-NOW başlatma */
+#if CHAN_SURVEY_MODE
+    ESP_ERROR_CHECK(espnow_chan_survey_init()); // recv_cb kaydından önce
+#endif
     wifi_init();
     esp_now_init_func();
 
@@ -172,5 +470,4 @@ void app_main(void) {
              mac[0], mac[1], mac[2],
              mac[3], mac[4], mac[5]);
     ESP_LOGW("MAC", "Bu cihazin (dinleyici) mac adresi: %s", macStr);
-    xTaskCreate(esp_now_recv_task, "esp_now_recv_task", 4096, NULL, 5, NULL); // dinleyici task'ını başlat
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_event.h"
 #include "esp_system.h"
@@ -11,19 +13,103 @@
 #include "esp_wifi.h"
 #include "esp_now.h"
 #include "esp_timer.h"
+#include "esp_random.h"
 #include "driver/gpio.h"
 #include "esp_private/wifi.h"
+#include "espnow_msg_types.h"
+#include "espnow_phy_sweep.h"
+#include "espnow_rate_ctrl.h"
+#include "espnow_stream.h"
+#include "espnow_compress.h"
+#include "frame_check.h"
+#include "espnow_chan_survey.h"
 
 #define WIFI_CHANNEL    1
 #define TEST_DURATION_S 30
 #define PACKET_SIZE     1024
-#define ACK_REQUEST     0x01
-#define ACK_RESPONSE    0x02
-#define STOP_REQUEST    0x03
-#define CONT_REQUEST    0x04
+#define ACK_REQUEST     ESPNOW_MSG_ACK_REQUEST
+#define ACK_RESPONSE    ESPNOW_MSG_ACK_RESPONSE
+#define STOP_REQUEST    ESPNOW_MSG_STOP_REQUEST
+#define CONT_REQUEST    ESPNOW_MSG_CONT_REQUEST
 
 #define BOOT_BUTTON_GPIO GPIO_NUM_0
 
+/**
+ * Kanal taraması. 1 olduğunda test başlamadan önce espnow_chan_survey ile iki
+ * cihaz tüm kanalları birlikte ölçer (pasif tarama + CHAN_SURVEY_DWELL_MS
+ * promiscuous dinleme); en sessiz kanal WIFI_CHANNEL'dan en az
+ * CHAN_SURVEY_MIN_GAIN_PCT daha sessizse iki taraf oraya geçer. WIFI_CHANNEL
+ * bu durumda yalnızca buluşma kanalıdır. Alıcıda da CHAN_SURVEY_MODE açılmalıdır.
+ */
+#define CHAN_SURVEY_MODE            0
+#define CHAN_SURVEY_DWELL_MS        300
+#define CHAN_SURVEY_MIN_GAIN_PCT    20
+#define CHAN_SURVEY_PEER_WAIT_S     10      // alıcının açılmasını bekleme süresi
+
+/**
+ * PHY tarama modu. 1 olduğunda normal test yerine espnow_phy_sweep bileşeninin
+ * varsayılan matrisindeki (11B, 11G, HT20 MCS0-7 LGI/SGI) her hücre
+ * PHY_SWEEP_CELL_MS boyunca koşturulur ve sonunda goodput, kayıp ve send_cb
+ * hata oranı tablosu yazdırılır. Alıcı tarafında ayrıca bir ayar gerekmez.
+ */
+#define PHY_SWEEP_MODE      0
+#define PHY_SWEEP_CELL_MS   5000
+
+/**
+ * Paket boyutu tarama modu. 1 olduğunda testin kendi hızında (HT20 MCS4 SGI)
+ * SIZE_SWEEP_SIZES listesindeki her boyut PHY_SWEEP_CELL_MS boyunca gönderilir.
+ * Boyut her hücrenin başında alıcıyla anlaşıldığından alıcının PACKET_SIZE'ı
+ * değiştirilip yeniden derlenmesi gerekmez. Sonunda boyut başına pps/goodput ve
+ * paket başına sabit maliyetin baskın olduğu boyut tahmini yazdırılır.
+ */
+#define SIZE_SWEEP_MODE     0
+#define SIZE_SWEEP_SIZES    {16, 32, 64, 128, 250, 512, 768, 1024, 1250, 1470}
+#define SIZE_SWEEP_PHYMODE  WIFI_PHY_MODE_HT20
+#define SIZE_SWEEP_RATE     WIFI_PHY_RATE_MCS4_SGI
+
+/**
+ * Uyarlamalı hız kontrolü karşılaştırması. 1 olduğunda gönderim, RATE_CTRL_PHASE_S
+ * süreli sabit hız (RATE_CTRL_FIXED_PHYMODE/RATE_CTRL_FIXED_RATE) ve uyarlamalı
+ * hız (espnow_rate_ctrl) fazları arasında gidip gelir. Uyarlamalı faz da sabit
+ * hızdan başlar; sabit hız espnow_rate_ctrl'ün hız tablosunda olmalıdır. Goodput, MAC ACK'i alınan (send_cb başarılı) paketlerden
+ * hesaplanır; her faz çiftinden sonra karşılaştırma ve hız tablosu yazdırılır.
+ * Bağlantı kalitesinin etkisini görmek için test sırasında cihazlar
+ * uzaklaştırılıp yaklaştırılabilir ya da araya engel konabilir.
+ */
+#define RATE_CTRL_MODE      0
+#define RATE_CTRL_PHASE_S   10
+#define RATE_CTRL_FIXED_PHYMODE WIFI_PHY_MODE_HT20
+#define RATE_CTRL_FIXED_RATE    WIFI_PHY_RATE_MCS4_SGI
+
+/**
+ * Güvenilir akış karşılaştırması. 1 olduğunda gönderim, STREAM_PHASE_S süreli
+ * ham (normal testteki gibi send_cb'yi bekleyerek PACKET_SIZE'lık paketler) ve
+ * espnow_stream üzerinden güvenilir akış fazları arasında gidip gelir. Ham
+ * fazın goodput'u MAC ACK'i alınan paketlerden, akış fazınınki alıcının
+ * kümülatif ACK'lediği baytlardan hesaplanır; akış fazı yazılanların hepsi
+ * ACK'lenene kadar sürer. Alıcıda da STREAM_MODE 1 olmalıdır; alıcı akıştan
+ * okuduğu veriyi doğrular.
+ */
+#define STREAM_MODE         0
+#define STREAM_PHASE_S      10
+#define STREAM_WRITE_CHUNK  4096    // uygulamanın akışa tek seferde yazdığı log parçası
+#define STREAM_STALL_MS     1000    // pencere bu süre hiç boşalmazsa faz hatayla kesilir
+
+/**
+ * Sıkıştırma karşılaştırması. 1 olduğunda her veri türü (JSON telemetri, metin
+ * log, rastgele bayt) için COMPRESS_PHASE_S süreli iki faz koşturulur: veri
+ * espnow_compress ile önce sıkıştırılmadan (yalnızca başlık), sonra LZ4 ile
+ * gönderilir. Her çerçevede send_cb beklenir. Tabloda çerçeve başına
+ * sıkıştırma CPU süresi, esp_now_send'den send_cb'ye geçen süre (havadaki süre
+ * + MAC ACK) ve ACK'li çerçevelerdeki sıkıştırılmamış veriden hesaplanan
+ * goodput yazdırılır; "net kazanç" havada kazanılan süreden CPU süresi
+ * çıkarılınca kalan çerçeve başı süredir, pozitifse sıkıştırma kazandırır.
+ * Alıcıda da COMPRESS_MODE 1 olmalıdır; alıcı çerçeveleri açar.
+ */
+#define COMPRESS_MODE       0
+#define COMPRESS_PHASE_S    5
+#define COMPRESS_INPUT_LEN  (PACKET_SIZE - COMPRESS_HEADER_LEN)    // sıkıştırılamasa da PACKET_SIZE'a sığar
+
 static const char *TAG = "SENDER";
 static const char *ESPNOW_TAG = "ESP_NOW";
 
@@ -40,21 +126,156 @@ int64_t active_start_us = 0;
 int64_t active_duration_us = 0;
 bool currently_sending = false;
 
+#if RATE_CTRL_MODE
+typedef struct {
+    uint32_t sent;
+    uint32_t acked;
+    uint32_t cb_timeouts;
+    double duration_s;
+} rate_phase_result_t;
+
+static rate_ctrl_t rate_ctrl;
+static SemaphoreHandle_t rate_bench_sem = NULL;
+static volatile bool rate_bench_adaptive = false;
+static volatile uint32_t rate_bench_acked = 0;
+
+/**
+ * send_cb'yi beklenen paketle eşleştirmek için, rate_bench_lock ile korunur.
+ * Zaman aşımına uğrayan paketin send_cb'si sonradan gelirse (stale) bir sonraki
+ * paketin sonucu sayılmaz; send_cb'ler gönderim sırasıyla geldiği için önce
+ * bunlar tüketilir.
+ */
+static portMUX_TYPE rate_bench_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool rate_bench_waiting = false;
+static uint32_t rate_bench_stale = 0;
+#endif
+
+#if STREAM_MODE
+typedef struct {
+    uint32_t frames;
+    uint32_t retransmits;
+    uint64_t bytes;         // ham: MAC ACK'li, akış: alıcının kümülatif ACK'lediği
+    double duration_s;
+} stream_phase_result_t;
+
+static SemaphoreHandle_t stream_bench_sem = NULL;
+static volatile uint32_t stream_bench_acked = 0;
+#endif
+
+#if COMPRESS_MODE
+typedef enum {
+    COMPRESS_DATA_JSON,
+    COMPRESS_DATA_LOG,
+    COMPRESS_DATA_RANDOM,
+    COMPRESS_DATA_COUNT,
+} compress_data_t;
+
+static const char *compress_data_names[COMPRESS_DATA_COUNT] = {"json", "log", "rastgele"};
+
+typedef struct {
+    uint32_t frames;
+    uint32_t acked;
+    uint64_t tx_us;             // esp_now_send -> send_cb toplamı
+    compress_stats_t cs;
+    double duration_s;
+} compress_phase_result_t;
+
+static compress_ctx_t compress_ctx;
+static uint8_t compress_input[COMPRESS_INPUT_LEN];
+static uint8_t compress_frame[COMPRESS_FRAME_BOUND(COMPRESS_INPUT_LEN)];
+static SemaphoreHandle_t compress_bench_sem = NULL;
+static volatile bool compress_bench_acked = false;
+static volatile int64_t compress_cb_us = 0;
+#endif
+
 // static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xCC, 0x7B, 0x5C, 0xF8, 0xDE, 0xCC}; //siyah kablolu esp32'nin mac adresi
 static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xCC, 0x7B, 0x5C, 0xF7, 0xB8, 0xF8}; //beyaz kablolu esp32'nin mac adresi
 // static uint8_t broadcast_mac[] = {0xF0, 0x9E, 0x9E, 0x20, 0x9A, 0x68}; //ESP32-S3'ün mac adresi
 
 static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
     send_done = true;
+    espnow_phy_sweep_on_send(status);
+#if RATE_CTRL_MODE
+    if (rate_bench_sem != NULL) {
+        bool current = false;
+        portENTER_CRITICAL(&rate_bench_lock);
+        if (rate_bench_stale > 0) {
+            rate_bench_stale--;     // zaman aşımına uğramış paketin geç gelen sonucu
+        }
+        else if (rate_bench_waiting) {
+            rate_bench_waiting = false;
+            current = true;
+        }
+        portEXIT_CRITICAL(&rate_bench_lock);
+
+        if (status == ESP_NOW_SEND_SUCCESS) {
+            rate_bench_acked++;
+        }
+        if (current) {
+            if (rate_bench_adaptive) {
+                espnow_rate_ctrl_on_send(&rate_ctrl, status);
+            }
+            xSemaphoreGive(rate_bench_sem);
+        }
+    }
+#endif
+#if STREAM_MODE
+    espnow_stream_on_send(status);
+    if (stream_bench_sem != NULL) {
+        if (status == ESP_NOW_SEND_SUCCESS) {
+            stream_bench_acked++;
+        }
+        xSemaphoreGive(stream_bench_sem);
+    }
+#endif
+#if COMPRESS_MODE
+    if (compress_bench_sem != NULL) {
+        compress_cb_us = esp_timer_get_time();
+        compress_bench_acked = status == ESP_NOW_SEND_SUCCESS;
+        xSemaphoreGive(compress_bench_sem);
+    }
+#endif
 }
 
 static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+#if CHAN_SURVEY_MODE
+    if (espnow_chan_survey_on_recv(recv_info, data, len)) {
+        return;
+    }
+#endif
+    if (espnow_phy_sweep_on_recv(recv_info, data, len)) {
+        return;
+    }
+#if STREAM_MODE
+    if (espnow_stream_on_recv(recv_info, data, len)) { // akış ACK'leri
+        return;
+    }
+#endif
     if (len == 1 && data[0] == ACK_RESPONSE) {
         ESP_LOGW(ESPNOW_TAG, "ACK alındı!");
         returned_ack = true;
     }
 }
 
+#if CHAN_SURVEY_MODE
+static void run_channel_survey(void) {
+    static chan_survey_result_t result;
+    chan_survey_config_t config = {
+        .peer_addr = broadcast_mac,
+        .dwell_ms = CHAN_SURVEY_DWELL_MS,
+        .min_gain_pct = CHAN_SURVEY_MIN_GAIN_PCT,
+        .peer_wait_ms = CHAN_SURVEY_PEER_WAIT_S * 1000,
+    };
+    esp_err_t err = espnow_chan_survey_run(&config, &result);
+    if (result.best_channel != 0) { // iki tarafın ölçümü de alındı
+        espnow_chan_survey_print_results(&result);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(ESPNOW_TAG, "Kanal taraması tamamlanamadı (%s), kanal %u ile devam ediliyor.", esp_err_to_name(err), result.channel);
+    }
+}
+#endif
+
 static void esp_now_send_stop() {
     uint8_t data = STOP_REQUEST;  // duraklama isteği
 
@@ -148,6 +369,367 @@ static void esp_now_send_task() {
     vTaskDelete(NULL);
 }
 
+static void phy_sweep_task() {
+    phy_sweep_config_t config = {
+        .peer_addr = broadcast_mac,
+        .cells = phy_sweep_default_cells,
+        .cell_count = phy_sweep_default_cell_count,
+        .cell_duration_ms = PHY_SWEEP_CELL_MS,
+        .payload_len = PACKET_SIZE,
+    };
+#if SIZE_SWEEP_MODE
+    static const uint16_t sizes[] = SIZE_SWEEP_SIZES;
+    static phy_sweep_cell_t size_cells[sizeof(sizes) / sizeof(sizes[0])];
+    espnow_phy_sweep_make_size_cells(sizes, sizeof(sizes) / sizeof(sizes[0]), SIZE_SWEEP_PHYMODE, SIZE_SWEEP_RATE,
+                                     "HT20 MCS4 SGI", size_cells);
+    config.cells = size_cells;
+    config.cell_count = sizeof(sizes) / sizeof(sizes[0]);
+#endif
+
+    phy_sweep_result_t *results = calloc(config.cell_count, sizeof(phy_sweep_result_t));
+    if (results == NULL) {
+        ESP_LOGE(TAG, "Tarama sonuçları için malloc başarısız");
+        vTaskDelete(NULL);
+    }
+
+    ESP_LOGW(TAG, "Tarama başlıyor: %d hücre, hücre başına %d ms", config.cell_count, PHY_SWEEP_CELL_MS);
+    esp_err_t err = espnow_phy_sweep_run(&config, results);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Tarama tamamlanamadı: %s", esp_err_to_name(err));
+        free(results);
+        vTaskDelete(NULL);
+    }
+    espnow_phy_sweep_print_results(results, config.cell_count);
+#if SIZE_SWEEP_MODE
+    espnow_phy_sweep_print_size_curve(results, config.cell_count);
+#endif
+    free(results);
+    vTaskDelete(NULL);
+}
+
+#if RATE_CTRL_MODE
+static void rate_ctrl_run_phase(bool adaptive, rate_phase_result_t *res) {
+    memset(res, 0, sizeof(*res));
+    if (adaptive) {
+        rate_ctrl.applied = -1; // sabit fazdan kalan hız bilinmiyor, ilk pakette yeniden uygulanır
+    }
+    else {
+        esp_now_rate_config_t cfg = {
+            .phymode = RATE_CTRL_FIXED_PHYMODE,
+            .rate = RATE_CTRL_FIXED_RATE,
+            .ersu = false,
+        };
+        ESP_ERROR_CHECK(esp_now_set_peer_rate_config(broadcast_mac, &cfg));
+    }
+    rate_bench_adaptive = adaptive;
+    uint32_t acked_start = rate_bench_acked;
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + RATE_CTRL_PHASE_S * 1000000LL;
+
+    while (esp_timer_get_time() < end_us) {
+        if (adaptive && espnow_rate_ctrl_before_send(&rate_ctrl) != ESP_OK) {
+            vTaskDelay(1);
+            continue;
+        }
+        portENTER_CRITICAL(&rate_bench_lock);
+        rate_bench_waiting = true;  // send_cb esp_now_send dönmeden gelebilir
+        portEXIT_CRITICAL(&rate_bench_lock);
+        esp_err_t err = esp_now_send(broadcast_mac, payload, PACKET_SIZE);
+        if (err != ESP_OK) {
+            portENTER_CRITICAL(&rate_bench_lock);
+            rate_bench_waiting = false;
+            portEXIT_CRITICAL(&rate_bench_lock);
+            if (adaptive) {
+                espnow_rate_ctrl_cancel(&rate_ctrl);
+            }
+            vTaskDelay(1);
+            continue;
+        }
+        res->sent++;
+        if (xSemaphoreTake(rate_bench_sem, pdMS_TO_TICKS(100)) != pdTRUE) {
+            bool timed_out = false;
+            portENTER_CRITICAL(&rate_bench_lock);
+            if (rate_bench_waiting) {
+                rate_bench_waiting = false;
+                rate_bench_stale++;     // geç gelirse bir sonraki paketin yerine sayılmasın
+                timed_out = true;
+            }
+            portEXIT_CRITICAL(&rate_bench_lock);
+
+            if (timed_out) {
+                res->cb_timeouts++;
+                if (adaptive) {
+                    espnow_rate_ctrl_cancel(&rate_ctrl);
+                }
+            }
+            else {
+                xSemaphoreTake(rate_bench_sem, 0); // send_cb tam zaman aşımında geldi, verdiği semaforu tüket
+            }
+        }
+    }
+    res->acked = rate_bench_acked - acked_start;
+    res->duration_s = (esp_timer_get_time() - start_us) / 1000000.0;
+}
+
+static void print_rate_phase(const char *name, const rate_phase_result_t *r) {
+    double goodput = r->duration_s > 0 ? r->acked * (PACKET_SIZE / 1024.0) / r->duration_s : 0.0;
+    double fail = r->sent > 0 ? (1.0 - (double)r->acked / r->sent) * 100.0 : 0.0;
+    printf("%-10s | %10lu | %8lu | %11.2f | %7lu | %12.2f\n",
+           name, (unsigned long)r->sent, (unsigned long)r->acked, fail, (unsigned long)r->cb_timeouts, goodput);
+}
+
+static void rate_ctrl_bench_task() {
+    int initial = -1;
+    for (int i = 0; i < rate_ctrl_default_rate_count; i++) {
+        if (rate_ctrl_default_rates[i].phymode == RATE_CTRL_FIXED_PHYMODE &&
+            rate_ctrl_default_rates[i].rate == RATE_CTRL_FIXED_RATE) {
+            initial = i; // uyarlamalı kontrol sabit hızdan başlar
+        }
+    }
+    if (initial < 0) {
+        ESP_LOGW(TAG, "Sabit hız hız tablosunda yok, uyarlamalı faz en düşük hızdan başlıyor");
+        initial = 0;
+    }
+    ESP_ERROR_CHECK(espnow_rate_ctrl_init(&rate_ctrl, broadcast_mac, rate_ctrl_default_rates, rate_ctrl_default_rate_count,
+                                          PACKET_SIZE, initial));
+    rate_bench_sem = xSemaphoreCreateBinary();
+
+    rate_phase_result_t fixed, adaptive;
+    uint64_t fixed_acked = 0, adaptive_acked = 0;
+    double fixed_s = 0, adaptive_s = 0;
+    int pair = 0;
+
+    while (1) {
+        ESP_LOGW(TAG, "Sabit hız fazı (%s), %d s", rate_ctrl_default_rates[initial].name, RATE_CTRL_PHASE_S);
+        rate_ctrl_run_phase(false, &fixed);
+        ESP_LOGW(TAG, "Uyarlamalı hız fazı, %d s", RATE_CTRL_PHASE_S);
+        rate_ctrl_run_phase(true, &adaptive);
+
+        pair++;
+        fixed_acked += fixed.acked;
+        fixed_s += fixed.duration_s;
+        adaptive_acked += adaptive.acked;
+        adaptive_s += adaptive.duration_s;
+
+        double fixed_kbs = fixed.acked * (PACKET_SIZE / 1024.0) / fixed.duration_s;
+        double adaptive_kbs = adaptive.acked * (PACKET_SIZE / 1024.0) / adaptive.duration_s;
+        double total_fixed_kbs = fixed_acked * (PACKET_SIZE / 1024.0) / fixed_s;
+        double total_adaptive_kbs = adaptive_acked * (PACKET_SIZE / 1024.0) / adaptive_s;
+
+        printf("---\n");
+        ESP_LOGI(TAG, "SABİT / UYARLAMALI HIZ, çift %d", pair);
+        printf("%-10s | %10s | %8s | %11s | %7s | %12s\n", "faz", "gönderilen", "ACK'li", "başarısız %", "cb yok", "goodput KB/s");
+        print_rate_phase("sabit", &fixed);
+        print_rate_phase("uyarlamalı", &adaptive);
+        ESP_LOGI(TAG, "Bu çift: uyarlamalı / sabit = %%%.1f, toplam: %.2f / %.2f KB/s (%%%.1f)",
+                 fixed_kbs > 0 ? adaptive_kbs / fixed_kbs * 100.0 : 0.0, total_adaptive_kbs, total_fixed_kbs,
+                 total_fixed_kbs > 0 ? total_adaptive_kbs / total_fixed_kbs * 100.0 : 0.0);
+        espnow_rate_ctrl_print(&rate_ctrl, TAG);
+        printf("---\n");
+    }
+}
+#endif
+
+#if STREAM_MODE
+/* Alıcıdaki doğrulamayla aynı olmalı; segment boyutu 256'nın katı olmadığı için kayan ya da tekrarlanan veri yakalanır */
+static inline uint8_t stream_pattern(uint64_t offset) {
+    return (uint8_t)(offset ^ (offset >> 8) ^ (offset >> 16));
+}
+
+static void stream_run_raw_phase(stream_phase_result_t *res) {
+    memset(res, 0, sizeof(*res));
+    uint32_t acked_start = stream_bench_acked;
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + STREAM_PHASE_S * 1000000LL;
+
+    while (esp_timer_get_time() < end_us) {
+        xSemaphoreTake(stream_bench_sem, 0);
+        esp_err_t err = esp_now_send(broadcast_mac, payload, PACKET_SIZE);
+        if (err != ESP_OK) {
+            vTaskDelay(1); // normal testteki break yerine kuyruk boşalınca devam
+            continue;
+        }
+        res->frames++;
+        xSemaphoreTake(stream_bench_sem, pdMS_TO_TICKS(100));
+    }
+    res->bytes = (uint64_t)(stream_bench_acked - acked_start) * PACKET_SIZE;
+    res->duration_s = (esp_timer_get_time() - start_us) / 1000000.0;
+}
+
+/**
+ * Yazma fazın kalan süresi kadar (en az STREAM_STALL_MS) bekler; bu sürede
+ * pencereye tek bayt bile kabul edilmezse alıcı ACK'lemiyordur ve faz
+ * ESP_ERR_TIMEOUT ile kesilir. Yarım kalan parçada offset yalnızca kabul edilen
+ * bayt kadar ilerler, böylece sonraki faz desenin kaldığı yerden devam eder.
+ */
+static esp_err_t stream_run_reliable_phase(uint64_t *offset, stream_phase_result_t *res) {
+    static uint8_t chunk[STREAM_WRITE_CHUNK];
+    stream_stats_t before, after;
+    espnow_stream_get_stats(&before);
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + STREAM_PHASE_S * 1000000LL;
+
+    while (esp_timer_get_time() < end_us) {
+        for (int i = 0; i < STREAM_WRITE_CHUNK; i++) {
+            chunk[i] = stream_pattern(*offset + i);
+        }
+        size_t written = 0;
+        while (written < STREAM_WRITE_CHUNK) {
+            int64_t wait_ms = MAX((end_us - esp_timer_get_time()) / 1000, STREAM_STALL_MS);
+            size_t n = espnow_stream_write(chunk + written, STREAM_WRITE_CHUNK - written, pdMS_TO_TICKS(wait_ms));
+            if (n == 0) {
+                *offset += written;
+                ESP_LOGE(TAG, "Akış %lld ms boyunca ilerlemedi, faz kesildi", (long long)wait_ms);
+                return ESP_ERR_TIMEOUT;
+            }
+            written += n;
+        }
+        *offset += STREAM_WRITE_CHUNK;
+    }
+    if (espnow_stream_flush(pdMS_TO_TICKS(5000)) != ESP_OK) {
+        ESP_LOGE(TAG, "Akış 5 s içinde boşaltılamadı, alıcı cevap vermiyor olabilir");
+    }
+    espnow_stream_get_stats(&after);
+    res->frames = (after.segments_sent - before.segments_sent) + (after.retransmits - before.retransmits);
+    res->retransmits = after.retransmits - before.retransmits;
+    res->bytes = after.bytes_acked - before.bytes_acked;
+    res->duration_s = (esp_timer_get_time() - start_us) / 1000000.0;
+    return ESP_OK;
+}
+
+static void print_stream_phase(const char *name, const stream_phase_result_t *r, double raw_kbs) {
+    double goodput = r->duration_s > 0 ? r->bytes / 1024.0 / r->duration_s : 0.0;
+    printf("%-6s | %8lu | %7lu | %12.2f | %7.1f\n", name, (unsigned long)r->frames, (unsigned long)r->retransmits, goodput,
+           raw_kbs > 0 ? goodput / raw_kbs * 100.0 : 0.0);
+}
+
+static void stream_bench_task() {
+    stream_bench_sem = xSemaphoreCreateBinary();
+    ESP_ERROR_CHECK(espnow_stream_init(broadcast_mac));
+
+    stream_phase_result_t raw, reliable;
+    uint64_t offset = 0;
+    int pair = 0;
+
+    while (1) {
+        ESP_LOGW(TAG, "Ham faz, %d s", STREAM_PHASE_S);
+        stream_run_raw_phase(&raw);
+        ESP_LOGW(TAG, "Güvenilir akış fazı, %d s", STREAM_PHASE_S);
+        if (stream_run_reliable_phase(&offset, &reliable) != ESP_OK) {
+            continue; // bu çiftin tablosu anlamsız, alıcı dönünce baştan ölçülür
+        }
+
+        pair++;
+        double raw_kbs = raw.bytes / 1024.0 / raw.duration_s;
+        printf("---\n");
+        ESP_LOGI(TAG, "HAM / GÜVENİLİR AKIŞ, çift %d (akış segmenti %d byte yük)", pair, STREAM_SEGMENT_LEN);
+        printf("%-6s | %8s | %7s | %12s | %7s\n", "faz", "çerçeve", "tekrar", "goodput KB/s", "ham %");
+        print_stream_phase("ham", &raw, raw_kbs);
+        print_stream_phase("akış", &reliable, raw_kbs);
+        espnow_stream_log_stats(TAG);
+        printf("---\n");
+    }
+}
+#endif
+
+#if COMPRESS_MODE
+/* Gerçek yüke benzer veri; her fazın başında bir kez üretilir, çerçeveler arasında yalnızca sıra numarası değişir */
+static void compress_fill_input(compress_data_t kind) {
+    size_t off = 0;
+    int i = 0;
+    while (off < COMPRESS_INPUT_LEN) {
+        char rec[128];
+        int n = 0;
+        if (kind == COMPRESS_DATA_JSON) {
+            n = snprintf(rec, sizeof(rec), "{\"seq\":%08d,\"node\":\"esp32-%02d\",\"temp\":%.2f,\"hum\":%d,\"rssi\":%d},",
+                         i, i % 4, 21.0 + (esp_random() % 400) / 100.0, 40 + (int)(esp_random() % 20), -40 - (int)(esp_random() % 40));
+        }
+        else if (kind == COMPRESS_DATA_LOG) {
+            n = snprintf(rec, sizeof(rec), "I (%08d) SENSOR: okuma tamam, kanal %d, değer %lu\n", i, i % 8,
+                         (unsigned long)(esp_random() % 4096));
+        }
+        else {
+            esp_fill_random(compress_input, COMPRESS_INPUT_LEN);
+            return;
+        }
+        n = MIN(n, (int)(COMPRESS_INPUT_LEN - off));
+        memcpy(compress_input + off, rec, n);
+        off += n;
+        i++;
+    }
+}
+
+static void compress_run_phase(compress_data_t kind, bool enabled, compress_phase_result_t *res) {
+    memset(res, 0, sizeof(*res));
+    espnow_compress_init(&compress_ctx, enabled);
+    compress_fill_input(kind);
+    uint32_t seq = 0;
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + COMPRESS_PHASE_S * 1000000LL;
+
+    while (esp_timer_get_time() < end_us) {
+        memcpy(compress_input, &seq, sizeof(seq)); // her çerçeve farklı, sıkıştırma önceki çerçeveye dayanmaz
+        seq++;
+        size_t len = espnow_compress_frame(&compress_ctx, compress_input, COMPRESS_INPUT_LEN, compress_frame,
+                                           sizeof(compress_frame));
+
+        xSemaphoreTake(compress_bench_sem, 0);
+        int64_t send_us = esp_timer_get_time();
+        esp_err_t err = esp_now_send(broadcast_mac, compress_frame, len);
+        if (err != ESP_OK) {
+            vTaskDelay(1);
+            continue;
+        }
+        res->frames++;
+        if (xSemaphoreTake(compress_bench_sem, pdMS_TO_TICKS(100)) == pdTRUE) {
+            res->tx_us += compress_cb_us - send_us;
+            res->acked += compress_bench_acked;
+        }
+    }
+    res->cs = compress_ctx.stats;
+    res->duration_s = (esp_timer_get_time() - start_us) / 1000000.0;
+}
+
+/* off: aynı veri türünün sıkıştırmasız fazı; net kazanç ona göre hesaplanır */
+static void print_compress_phase(compress_data_t kind, const char *mode, const compress_phase_result_t *r,
+                                 const compress_phase_result_t *off) {
+    double frame_len = r->cs.frames > 0 ? (double)r->cs.wire_bytes / r->cs.frames : 0.0;
+    double cpu_us = r->cs.frames > 0 ? (double)r->cs.cpu_us / r->cs.frames : 0.0;
+    double tx_us = r->frames > 0 ? (double)r->tx_us / r->frames : 0.0;
+    double off_tx_us = off->frames > 0 ? (double)off->tx_us / off->frames : 0.0;
+    double goodput = r->duration_s > 0 ? (double)r->acked * COMPRESS_INPUT_LEN / 1024.0 / r->duration_s : 0.0;
+
+    printf("%-8s | %-6s | %9.1f | %6.1f | %9.1f | %9.1f | %9.2f\n", compress_data_names[kind], mode, frame_len, cpu_us, tx_us,
+           r == off ? 0.0 : off_tx_us - tx_us - cpu_us, goodput);
+}
+
+static void compress_bench_task() {
+    compress_bench_sem = xSemaphoreCreateBinary();
+    compress_phase_result_t off[COMPRESS_DATA_COUNT], on[COMPRESS_DATA_COUNT];
+    int pass = 0;
+
+    while (1) {
+        for (int kind = 0; kind < COMPRESS_DATA_COUNT; kind++) {
+            ESP_LOGW(TAG, "Sıkıştırma karşılaştırması: %s, %d s kapalı + %d s LZ4", compress_data_names[kind],
+                     COMPRESS_PHASE_S, COMPRESS_PHASE_S);
+            compress_run_phase(kind, false, &off[kind]);
+            compress_run_phase(kind, true, &on[kind]);
+        }
+
+        pass++;
+        printf("---\n");
+        ESP_LOGI(TAG, "SIKIŞTIRMA, tur %d (%d byte veri/çerçeve)", pass, COMPRESS_INPUT_LEN);
+        printf("%-8s | %-6s | %9s | %6s | %9s | %9s | %9s\n", "veri", "mod", "çerçeve B", "CPU us", "hava us", "net kazanç",
+               "veri KB/s");
+        for (int kind = 0; kind < COMPRESS_DATA_COUNT; kind++) {
+            print_compress_phase(kind, "kapalı", &off[kind], &off[kind]);
+            print_compress_phase(kind, "LZ4", &on[kind], &off[kind]);
+        }
+        printf("---\n");
+    }
+}
+#endif
+
 static void esp_now_send_ack() {
     uint8_t data = ACK_REQUEST;
 
@@ -195,12 +777,25 @@ static void esp_now_init_func(void) {
     ESP_ERROR_CHECK(esp_now_set_peer_rate_config(broadcast_mac, &rate_cfg));
 
     ESP_LOGW(ESPNOW_TAG, "ESP-NOW başlatıldı.");
+#if CHAN_SURVEY_MODE
+    run_channel_survey();
+#endif
     
     while (!returned_ack) {  //ack dönene kadar sorgu at
         esp_now_send_ack();
         vTaskDelay(pdMS_TO_TICKS(50));
     }
+#if PHY_SWEEP_MODE || SIZE_SWEEP_MODE
+    xTaskCreate(phy_sweep_task, "phy_sweep_task", 4096, NULL, 5, NULL);
+#elif RATE_CTRL_MODE
+    xTaskCreate(rate_ctrl_bench_task, "rate_ctrl_bench_task", 4096, NULL, 5, NULL);
+#elif STREAM_MODE
+    xTaskCreate(stream_bench_task, "stream_bench_task", 4096, NULL, 5, NULL);
+#elif COMPRESS_MODE
+    xTaskCreate(compress_bench_task, "compress_bench_task", 4096, NULL, 5, NULL);
+#else
     xTaskCreate(esp_now_send_task, "esp_now_send_task", 4096, NULL, 5, NULL);
+#endif
 }
 
 static void wifi_init(void) {
@@ -218,7 +813,9 @@ static void wifi_init(void) {
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init()); // NVS başlatma
 
-    memset(payload, 0xAA, PACKET_SIZE); // dummy data
+    payload[0] = ESPNOW_MSG_DATA_MARKER;    // ilk bayt kontrol kodlarıyla (STOP/CONT, PHY tarama, sıkıştırma...) karışmasın diye sabit
+    frame_check_fill(payload, 1, PACKET_SIZE, esp_random()); // PRBS dolgu + CRC32, alıcı bozuk paketleri sayar
+    frame_check_seal(payload, PACKET_SIZE);
 
     /* GPIO ayarı: BOOT tuşu giriş ve pull-up aktif */
     gpio_config_t io_conf = {
@@ -16,17 +16,123 @@
 #include "esp_log.h"
 #include "esp_now.h"
 #include "esp_netif.h"
-#include "freertos/task.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "espnow_rx_ring.h"
+#include "espnow_timesync.h"
+#include "latency_hist.h"
+#include "telemetry.h"
+#include "soak_stats.h"
+#include "espnow_bench.h"
+
+#define ESP_NOW_DATA_LEN    1024
+#define REPORT_PERIOD_MS    1000
+
+/**
+ * Alım işleme karşılaştırması. RX_BENCH_MODE 1 olduğunda alıcı her
+ * RX_BENCH_PHASE_S saniyede bir işleme modunu değiştirir:
+ *  - RX_MODE_INLINE: sayım ve loglama esp_now_recv_cb içinde (Wi-Fi task'ında) yapılır.
+ *  - RX_MODE_RING: callback paketi sadece SPSC halkaya kopyalar, işçi task işler.
+ * Her iki fazın sonunda alınan paket hızı ve kayıp oranı tablo olarak yazdırılır.
+ * Farkın görülebilmesi için göndericide SEND_INTERVAL_MS 0 yapılmalıdır; 10 ms
+ * aralıkla (100 pps) iki mod arasında anlamlı bir fark oluşmaz. 0 iken alıcı
+ * yalnızca halka + işçi modunda çalışır ve diğer ölçümler tek bir alım yolu
+ * üzerinden yapılır.
+ */
+#define RX_BENCH_MODE           0
+#define RX_BENCH_PHASE_S        10
+#define RX_RING_SLOTS           64
+#define INLINE_LOG_PER_FRAME    0   // 1: callback içi modda eski davranış, paket başına bir log satırı
+
+/**
+ * Gönderici saatiyle damgalanan send_time_us'i yerel saate çevirmek için
+ * espnow_timesync istemcisi. Saat tahmini oturduktan sonra her paketin tek yön
+ * gecikmesi owd_hist'e yazılır ve saniyelik raporda yüzdelikleri verilir.
+ */
+#define TIMESYNC_PERIOD_MS      250
+
+/**
+ * Telemetri modu. 1 olduğunda her TELEMETRY_PERIOD_MS'de bir sıra numarası
+ * sayaçları ve o aralığın tek yön gecikme histogramı components/telemetry ile
+ * ayrı bir UART'a (varsayılan UART1, TX GPIO 17, 2 Mbaud) ikili kayıt olarak
+ * yazılır; host'ta tools/telemetry_decode.py yüzdelikleri kovalardan hesaplar.
+ * Konsoldaki metin rapor yine REPORT_PERIOD_MS'de bir, aradaki histogramlar
+ * birleştirilerek basılır.
+ */
+#define TELEMETRY_MODE          0
+#define TELEMETRY_PERIOD_MS     100
+#define TELEMETRY_HIST_OWD      0   // telemetry_latency_t.hist_id
+
+#if TELEMETRY_MODE
+#define SAMPLE_PERIOD_MS        TELEMETRY_PERIOD_MS
+#else
+#define SAMPLE_PERIOD_MS        REPORT_PERIOD_MS
+#endif
+#define TEXT_REPORT_EVERY       (REPORT_PERIOD_MS / SAMPLE_PERIOD_MS)
+
+/**
+ * Dayanıklılık (soak) modu. Günler süren testler için: her saniyelik rapor
+ * soak_stats'a eklenir; 1 sn, 1 dk ve 1 sa'lik pencerelerin en düşük, en
+ * yüksek ve EWMA throughput / kayıp değerleri tutulur ve en fazla
+ * SOAK_CHECKPOINT_S'de bir NVS'e yazılır. Kart resetlenirse sayaçlar
+ * checkpoint'ten devam eder; reset nedeni (brown-out, WDT, panic...) açılışta
+ * kaydedilir ve her dakikalık zaman çizelgesi satırında görülür. Bu modda
+ * gönderici yeniden başlasa da sayaçlar sıfırlanmaz ve alıcı resetten sonra
+ * ACK beklemeden saymaya başlar. En yüksek sıra numarası da checkpoint'e
+ * yazılır, alıcı kapalıyken gönderilen paketler kayıp sayılır. Ölçüm tek bir
+ * alım yolundan (halka + işçi) yapılır, RX_BENCH_MODE ile birlikte açılamaz.
+ * Yeni bir teste başlarken SOAK_CLEAR_ON_BOOT bir kez 1 yapılıp yüklenmelidir.
+ */
+#define SOAK_MODE               0
+#define SOAK_CHECKPOINT_S       300     // flash aşınması: günde ~288 yazım
+#define SOAK_CLEAR_ON_BOOT      0
+#define SOAK_SUMMARY_EVERY_MIN  60
+
+#if SOAK_MODE && RX_BENCH_MODE
+#error "SOAK_MODE alım yolunu değiştiren RX_BENCH_MODE ile birlikte açılamaz"
+#endif
+
+typedef enum {
+    RX_MODE_INLINE = 0,
+    RX_MODE_RING,
+} rx_mode_t;
+
+static const char *rx_mode_names[] = {"callback ici", "halka + isci"};
 
 static const char *ESPNOW_TAG = "ESP_NOW";
+static const char *TAG = "RECEIVER";
 
 static int success_counter = 0;
 static bool ack_completed = false;
 
+#if RX_BENCH_MODE
+static volatile rx_mode_t rx_mode = RX_MODE_INLINE;
+#else
+static volatile rx_mode_t rx_mode = RX_MODE_RING;
+#endif
+static espnow_rx_ring_t rx_ring;
+
+/* Göndericideki counter_hdr_t ile aynı olmalıdır */
+typedef struct __attribute__((packed)) {
+    uint32_t seq;
+    int64_t send_time_us;
+} counter_hdr_t;
+
+/* Sıra numarası takibi; kayıp, sırasız ve kayıp patlaması hesabı espnow_bench'te */
+static bench_seq_tracker_t seq_tracker;
+
+static portMUX_TYPE seq_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static latency_hist_t owd_hist;         // son örnekleme aralığının tek yön gecikmeleri, seq_lock ile korunur
+static uint32_t owd_negative = 0;       // saat tahmini hatası yüzünden negatif çıkan gecikmeler
+
 static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xCC, 0x7B, 0x5C, 0xF8, 0xDE, 0xCC}; //siyah kablolu esp32'nin mac adresi
 
 static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
+    if (status == ESP_NOW_SEND_SUCCESS) {
+        return; // saat senkronizasyonu istekleri de buraya düşer, sadece başarısızlar loglanır
+    }
     char macStr[18];
     snprintf(macStr, sizeof(macStr), "%02x:%02x:%02x:%02x:%02x:%02x",
              mac_addr[0], mac_addr[1], mac_addr[2],
@@ -34,21 +140,254 @@ static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t statu
     ESP_LOGW(ESPNOW_TAG, "MAC: %s, Gonderim durumu: %s", macStr, status == ESP_NOW_SEND_SUCCESS ? "Basarili" : "Basarisiz");
 }
 
+static void process_frame(const uint8_t *data, int64_t rx_time_us) {
+    counter_hdr_t hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+
+    int64_t local_send_us;
+    bool synced = espnow_timesync_remote_to_local(hdr.send_time_us, &local_send_us);
+
+    success_counter++;
+    portENTER_CRITICAL(&seq_lock);
+    espnow_bench_seq_record(&seq_tracker, hdr.seq, hdr.send_time_us, rx_time_us);
+    if (synced) {
+        if (rx_time_us >= local_send_us) {
+            latency_hist_record(&owd_hist, (uint32_t)(rx_time_us - local_send_us));
+        }
+        else {
+            owd_negative++;
+        }
+    }
+    portEXIT_CRITICAL(&seq_lock);
+}
+
 static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
-    if (ack_completed && len == 1024){
-        success_counter++;
-        ESP_LOGI(ESPNOW_TAG, "received chunks: %d", success_counter);
+    if (espnow_timesync_on_recv(recv_info, data, len)) {
+        return;
+    }
+#if SOAK_MODE
+    if (len == 1 && data[0] == 0x01) {
+        // Yeniden başlayan gönderici de yanıt alır; sayaçlar sıfırlanmaz, sıra numarası takibi yeniden başlamayı ayırt eder
+        uint8_t ack = 0x02;
+        esp_now_send(broadcast_mac, &ack, 1);
+        return;
+    }
+#endif
+    if (ack_completed && len == ESP_NOW_DATA_LEN){
+        if (rx_mode == RX_MODE_RING) {
+            espnow_rx_ring_push(&rx_ring, recv_info, data, len); // halka doluysa rx_ring.dropped_full artar
+        }
+        else {
+            process_frame(data, esp_timer_get_time());
+#if INLINE_LOG_PER_FRAME
+            ESP_LOGI(ESPNOW_TAG, "received chunks: %d", success_counter);
+#endif
+        }
     }
     
     if (!ack_completed && len == 1 && data[0] == 0x01) {
         ESP_LOGI(ESPNOW_TAG, "ACK isteği alındı, yanıt gönderiliyor...");
         success_counter = 0; //ack istenmişse verici cihaz resetlenmiş demektir
+        portENTER_CRITICAL(&seq_lock);
+        espnow_bench_seq_reset(&seq_tracker);
+        portEXIT_CRITICAL(&seq_lock);
         uint8_t ack = 0x02;
         esp_now_send(broadcast_mac, &ack, 1);
         ack_completed = true;
     }
 }
 
+static void esp_now_rx_worker_task() {
+    while (1) {
+        espnow_rx_slot_t *slot = espnow_rx_ring_peek(&rx_ring, pdMS_TO_TICKS(100));
+        if (slot == NULL) {
+            continue;
+        }
+        process_frame(slot->data, slot->rx_time_us);
+        espnow_rx_ring_release(&rx_ring);
+    }
+}
+
+#if RX_BENCH_MODE
+typedef struct {
+    rx_mode_t mode;
+    uint32_t received;
+    uint32_t lost;
+    uint32_t ring_dropped;
+    uint32_t ring_high_watermark;
+    double duration_s;
+} rx_phase_result_t;
+
+static void print_rx_bench(const rx_phase_result_t *results, int count) {
+    printf("---\n");
+    ESP_LOGI(TAG, "ALIM ISLEME KARSILASTIRMASI");
+    printf("%-14s | %8s | %8s | %8s | %7s | %11s | %9s\n", "mod", "alinan", "pps", "kayip", "kayip %", "halka dolu", "maks dolu");
+    for (int i = 0; i < count; i++) {
+        const rx_phase_result_t *r = &results[i];
+        uint32_t expected = r->received + r->lost;
+        printf("%-14s | %8lu | %8.1f | %8lu | %7.3f | %11lu | %6lu/%d\n",
+               rx_mode_names[r->mode], r->received, r->received / r->duration_s, r->lost,
+               expected > 0 ? r->lost * 100.0 / expected : 0.0, r->ring_dropped,
+               r->ring_high_watermark, RX_RING_SLOTS);
+    }
+    printf("---\n");
+}
+#endif
+
+static void esp_now_stats_task() {
+    bench_seq_stats_t prev = {0};
+    int second = 0;
+    TickType_t last_wake = xTaskGetTickCount();
+
+#if RX_BENCH_MODE
+    bench_seq_stats_t phase_start = {0};
+    uint32_t phase_ring_dropped = 0;
+    int64_t phase_start_us = 0;
+    rx_phase_result_t phase_results[2];
+    int phase_index = 0;
+#endif
+#if SOAK_MODE
+    int64_t last_soak_us = 0;
+    uint32_t soak_minutes = 0;
+#endif
+#if TELEMETRY_MODE
+    static latency_hist_t owd_text;     // metin rapor aralığı; örnekleme aralıkları birleştirilir
+    static telemetry_latency_t latency_rec;
+    telemetry_rx_t rx_rec;
+    int64_t last_sample_us = esp_timer_get_time();
+    int ticks = 0;
+    latency_hist_reset(&owd_text);
+#endif
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SAMPLE_PERIOD_MS));
+        if (!ack_completed) {
+            continue;
+        }
+#if RX_BENCH_MODE
+        if (phase_start_us == 0) {
+            phase_start_us = esp_timer_get_time();
+        }
+#endif
+
+        bench_seq_stats_t cur;
+        uint32_t highest;
+#if SOAK_MODE
+        bool seq_started;
+#endif
+        static latency_hist_t owd_snapshot;
+        uint32_t negative;
+        portENTER_CRITICAL(&seq_lock);
+        cur = seq_tracker.stats;
+        highest = seq_tracker.highest_seq;
+#if SOAK_MODE
+        seq_started = seq_tracker.started;
+#endif
+        owd_snapshot = owd_hist;
+        latency_hist_reset(&owd_hist);
+        negative = owd_negative;
+        portEXIT_CRITICAL(&seq_lock);
+
+#if TELEMETRY_MODE
+        int64_t sample_us = esp_timer_get_time();
+        telemetry_rx_init(&rx_rec);
+        rx_rec.period_ms = (uint32_t)((sample_us - last_sample_us) / 1000);
+        rx_rec.rx_bytes = (uint64_t)cur.received * ESP_NOW_DATA_LEN;
+        rx_rec.rx_frames = cur.received;
+        rx_rec.lost = cur.lost;
+        rx_rec.duplicates = cur.duplicates;
+        rx_rec.reordered = cur.reordered;
+        rx_rec.longest_gap = cur.longest_burst;
+        rx_rec.ring_dropped = rx_ring.dropped_full;
+        telemetry_send(&rx_rec, sizeof(rx_rec));
+        telemetry_fill_latency(&latency_rec, TELEMETRY_HIST_OWD, &owd_snapshot);
+        telemetry_send(&latency_rec, sizeof(latency_rec));
+        last_sample_us = sample_us;
+
+        latency_hist_merge(&owd_text, &owd_snapshot);
+        if (++ticks < TEXT_REPORT_EVERY) {
+            continue;
+        }
+        ticks = 0;
+        owd_snapshot = owd_text;
+        latency_hist_reset(&owd_text);
+#endif
+
+        /* Geç gelen paketler önceki saniyelerin kaybını düşürebildiği için fark negatif olabilir */
+        int32_t lost_delta = (int32_t)(cur.lost - prev.lost);
+        uint32_t recv_delta = cur.received - prev.received;
+        uint32_t lost_pos = lost_delta > 0 ? lost_delta : 0;
+        double loss_pct = (recv_delta + lost_pos) > 0 ? lost_pos * 100.0 / (recv_delta + lost_pos) : 0.0;
+        uint32_t expected_total = cur.received + cur.lost;
+
+        second++;
+        printf("---\n");
+        ESP_LOGI(TAG, "[%d s] alınan: %lu, kayıp: %ld (%%%.2f), tekrar: %lu, sırasız: %lu",
+                 second, recv_delta, lost_delta, loss_pct,
+                 cur.duplicates - prev.duplicates, cur.reordered - prev.reordered);
+        ESP_LOGI(TAG, "Toplam alınan: %lu, kayıp: %lu (%%%.3f), en yüksek seq: %lu",
+                 cur.received, cur.lost, expected_total > 0 ? cur.lost * 100.0 / expected_total : 0.0, highest);
+        ESP_LOGI(TAG, "Maks. sırasızlık derinliği: %lu, en uzun kayıp patlaması: %lu, pencere dışı: %lu, jitter: %.1f us, yeniden başlama: %lu",
+                 cur.max_reorder_depth, cur.longest_burst, cur.too_old, cur.jitter_us, cur.restarts);
+        if (owd_snapshot.count > 0) {
+            latency_hist_log_summary(&owd_snapshot, TAG, "Tek yön gecikme:");
+            if (negative > 0) {
+                ESP_LOGW(TAG, "Negatif tek yön gecikme (saat hatası): %lu", negative);
+            }
+        }
+        if (second % 10 == 0) {
+            espnow_timesync_log(TAG);
+#if TELEMETRY_MODE
+            telemetry_stats_t tstats;
+            telemetry_get_stats(&tstats);
+            ESP_LOGI(TAG, "Telemetri: %lu kayıt gönderildi, %lu düştü", (unsigned long)tstats.sent, (unsigned long)tstats.dropped);
+#endif
+        }
+
+        prev = cur;
+
+#if SOAK_MODE || RX_BENCH_MODE
+        int64_t now = esp_timer_get_time();
+#endif
+#if SOAK_MODE
+        if (last_soak_us != 0 && soak_stats_add((uint32_t)((now - last_soak_us) / 1000),
+                                                (uint64_t)recv_delta * ESP_NOW_DATA_LEN, recv_delta, lost_delta)) {
+            soak_stats_log_minute(TAG);
+            if (++soak_minutes % SOAK_SUMMARY_EVERY_MIN == 0) {
+                soak_stats_log_summary(TAG);
+            }
+        }
+        last_soak_us = now;
+        if (seq_started) {
+            soak_stats_set_seq(highest);
+        }
+#endif
+#if RX_BENCH_MODE
+        if (now - phase_start_us >= RX_BENCH_PHASE_S * 1000000LL) {
+            rx_phase_result_t *r = &phase_results[phase_index];
+            r->mode = rx_mode;
+            r->received = cur.received - phase_start.received;
+            r->lost = cur.lost - phase_start.lost;
+            r->ring_dropped = rx_ring.dropped_full - phase_ring_dropped;
+            r->ring_high_watermark = espnow_rx_ring_take_high_watermark(&rx_ring);
+            r->duration_s = (now - phase_start_us) / 1000000.0;
+
+            if (++phase_index == 2) {
+                print_rx_bench(phase_results, 2);
+                phase_index = 0;
+            }
+
+            // Modu değiştir; halkada kalan paketleri işçi task işlemeye devam eder
+            rx_mode = (rx_mode == RX_MODE_INLINE) ? RX_MODE_RING : RX_MODE_INLINE;
+            ESP_LOGW(TAG, "Alım işleme modu: %s", rx_mode_names[rx_mode]);
+            phase_start = cur;
+            phase_ring_dropped = rx_ring.dropped_full;
+            phase_start_us = now;
+        }
+#endif
+    }
+}
+
 static void esp_now_init_func(void) {
     ESP_ERROR_CHECK(esp_now_init());
     ESP_ERROR_CHECK(esp_now_register_recv_cb(esp_now_recv_cb));
@@ -74,6 +413,9 @@ static void esp_now_init_func(void) {
     ESP_ERROR_CHECK(esp_now_add_peer(peer));
     free(peer);
 
+    latency_hist_reset(&owd_hist);
+    ESP_ERROR_CHECK(espnow_timesync_start_client(broadcast_mac, TIMESYNC_PERIOD_MS)); // gönderici sunucu olarak yanıtlar
+
     ESP_LOGW(ESPNOW_TAG, "ESP-NOW baslatildi. Dinlemede.");
 }
 
@@ -95,7 +437,28 @@ void app_main(void) {
         return;
     }
     ESP_ERROR_CHECK(ret);
+#if SOAK_MODE
+    ESP_ERROR_CHECK(soak_stats_init(SOAK_CHECKPOINT_S, SOAK_CLEAR_ON_BOOT));
+    soak_stats_log_summary(TAG);   // önceki açılışlardan taşınan durum
+    const soak_checkpoint_t *ckpt = soak_stats_get();
+    if (ckpt->seq_valid) {
+        espnow_bench_seq_resume(&seq_tracker, ckpt->highest_seq);  // callback kaydından önce, kilit gerekmez
+        ESP_LOGW(TAG, "Sıra numarası takibi %lu'den devam ediyor", (unsigned long)ckpt->highest_seq);
+    }
+    ack_completed = true;           // alıcı resetlendiyse gönderici ACK istemeden göndermeye devam eder
+#endif
+#if TELEMETRY_MODE
+    const telemetry_config_t telemetry_cfg = TELEMETRY_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(telemetry_init(&telemetry_cfg));
+#endif
     
+    /* Alım halkası ve işçi task'ı callback kaydedilmeden önce hazır olmalı; işçi
+       app_main'den yüksek öncelikli olduğu için halka task'tan önce kurulur */
+    TaskHandle_t worker = NULL;
+    ESP_ERROR_CHECK(espnow_rx_ring_init(&rx_ring, RX_RING_SLOTS, ESP_NOW_DATA_LEN, NULL));
+    xTaskCreate(esp_now_rx_worker_task, "esp_now_rx_worker", 4096, NULL, 5, &worker);
+    espnow_rx_ring_set_consumer(&rx_ring, worker);
+
     /* WiFi ve ESP-NOW başlatma */
     wifi_init();
     esp_now_init_func();
@@ -108,4 +471,5 @@ void app_main(void) {
              mac[0], mac[1], mac[2],
              mac[3], mac[4], mac[5]);
     ESP_LOGW("MAC", "Bu cihazin (dinleyici) mac adresi: %s", macStr);
+    xTaskCreate(esp_now_stats_task, "esp_now_stats_task", 4096, NULL, 5, NULL); // saniyelik rapor task'ını başlat
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "nvs_flash.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
@@ -18,18 +19,57 @@
 #include "esp_log.h"
 #include "esp_now.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
+#include "espnow_timesync.h"
+#include "traffic_gen.h"
 
 #define ESP_NOW_DATA_LEN 1024
+#define SEND_INTERVAL_MS 10     // 0: sabit bekleme yok, her paket bir önceki paketin send_cb'sinden hemen sonra gönderilir
+#define LOG_EVERY_N_SEND 100    // yüksek paket hızında UART'ı tıkamamak için her N denemede bir log
+
+/**
+ * Hız kontrollü gönderim. 1 olduğunda SEND_INTERVAL_MS yerine traffic_gen
+ * kullanılır: varışlar esp_timer ile mikrosaniye çözünürlükte planlanır,
+ * böylece tick süresinin (10 ms) altındaki aralıklar ve gerçek trafik
+ * şekilleri (poisson, burst) üretilebilir. TRAFFIC_RATE_PPS 0 ise hız
+ * TRAFFIC_RATE_BPS'ten hesaplanır. Her TRAFFIC_REPORT_MS'de istenen ve
+ * gerçekleşen hız ile planlanan varıştan gönderime kadar geçen sürenin
+ * yüzdelikleri yazdırılır. Wi-Fi TX kuyruğu dolduğunda paket atlanır ve
+ * sayılır; sıra numarası yalnızca gönderilen paketlerde ilerler.
+ */
+#define TRAFFIC_GEN_MODE        0
+#define TRAFFIC_MODE            TRAFFIC_CONSTANT    // TRAFFIC_CONSTANT / TRAFFIC_POISSON / TRAFFIC_BURST
+#define TRAFFIC_RATE_PPS        500
+#define TRAFFIC_RATE_BPS        0
+#define TRAFFIC_BURST_LEN       8
+#define TRAFFIC_BUCKET_DEPTH    16
+#define TRAFFIC_REPORT_MS       5000
 uint8_t stress_buf[ESP_NOW_DATA_LEN];
 bool returned_ack = false;
 
+/**
+ * Her chunk'ın başına yazılan başlık. Alıcı sıra numarasından kayıp, tekrar
+ * ve sırasız gelen paketleri; gönderim zamanından da varış jitter'ını hesaplar.
+ * Alıcıdaki counter_hdr_t ile aynı olmalıdır.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t seq;
+    int64_t send_time_us;
+} counter_hdr_t;
+
 static const char *ESPNOW_TAG = "ESP_NOW";
 
+static SemaphoreHandle_t send_done_sem = NULL;
+
 static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xF0, 0x9E, 0x9E, 0x20, 0x9A, 0x68}; //ESP32-S3'ün mac adresi
 //static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xCC, 0x7B, 0x5C, 0xF7, 0xB8, 0xF8}; //beyaz kablolu esp32'nin mac adresi
 //static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}; //broadcast mac
 
 static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
+    // Saat senkronizasyonu yanıtları da buraya düşer; düşük hızda (4 Hz) olduğundan tempoyu bozmaz
+    if (send_done_sem != NULL) {
+        xSemaphoreGive(send_done_sem);
+    }
     // char macStr[18];
     // snprintf(macStr, sizeof(macStr), "%02x:%02x:%02x:%02x:%02x:%02x",
     //          mac_addr[0], mac_addr[1], mac_addr[2],
@@ -46,6 +86,9 @@ static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t
     // ESP_LOGI(ESPNOW_TAG, "Gelen veri (%d byte) MAC %s:", len, macStr);
     // ESP_LOG_BUFFER_HEXDUMP(ESPNOW_TAG, data, len, ESP_LOG_INFO);
 
+    if (espnow_timesync_on_recv(recv_info, data, len)) { // alıcının saat senkronizasyonu isteklerine yanıt verir
+        return;
+    }
     if (len == 1 && data[0] == 0x02) {
         ESP_LOGI(ESPNOW_TAG, "ACK alındı!");
         returned_ack = true;
@@ -66,21 +109,71 @@ static void esp_now_send_ack() {
 
 static void esp_now_send_task() {
     ESP_LOGW(ESPNOW_TAG, "ESP-NOW veri gönderme taskı başladı.");
+    send_done_sem = xSemaphoreCreateBinary();
     static int success_counter = 0, fail_counter = 0, try_counter = 0;
     
+    counter_hdr_t hdr = {0};
+#if TRAFFIC_GEN_MODE
+    static traffic_gen_report_t gen_report;
+    uint32_t queue_full = 0;
+    traffic_gen_config_t gen_cfg = TRAFFIC_GEN_CONFIG_DEFAULT();
+    gen_cfg.mode = TRAFFIC_MODE;
+    gen_cfg.rate_pps = TRAFFIC_RATE_PPS;
+    gen_cfg.rate_bps = TRAFFIC_RATE_BPS;
+    gen_cfg.frame_len = ESP_NOW_DATA_LEN;
+    gen_cfg.burst_len = TRAFFIC_BURST_LEN;
+    gen_cfg.bucket_depth = TRAFFIC_BUCKET_DEPTH;
+    ESP_ERROR_CHECK(traffic_gen_start(&gen_cfg));
+    int64_t last_gen_report_us = esp_timer_get_time();
+#endif
+
     while(1) {
+#if TRAFFIC_GEN_MODE
+        if (!traffic_gen_wait(pdMS_TO_TICKS(TRAFFIC_REPORT_MS), NULL)) {
+            continue;
+        }
+#endif
+        hdr.seq = success_counter; // kuyruk dolu olduğu için atlanan paketler alıcıda kayıp görünmesin
+        hdr.send_time_us = esp_timer_get_time();
+        memcpy(stress_buf, &hdr, sizeof(hdr));
+
         esp_err_t result = esp_now_send(broadcast_mac, (uint8_t *)&stress_buf, sizeof(stress_buf)); //önceden belirlenen MAC adresine gelen veriyi gönder
         try_counter++;
         if (result == ESP_OK) {
             success_counter++;
+#if TRAFFIC_GEN_MODE
+            traffic_gen_mark_sent();
+#endif
         }
+#if TRAFFIC_GEN_MODE
+        else if (result == ESP_ERR_ESPNOW_NO_MEM) {
+            queue_full++; // Wi-Fi TX kuyruğu istenen hıza yetişemiyor
+        }
+#endif
         else {
             ESP_LOGE(ESPNOW_TAG, "Veri gönderim hatası: %s", esp_err_to_name(result));
             fail_counter++;
             break;
         }
-        ESP_LOGW(ESPNOW_TAG, "total try: %d", try_counter);
-        vTaskDelay(pdMS_TO_TICKS(10));  //100 ms'ten 10 ms'e düşürdükten birkaç dakika sonra alıcı ESP32'de ciddi sıcaklık artışı gözlendi
+        if (try_counter % LOG_EVERY_N_SEND == 0) {
+            ESP_LOGW(ESPNOW_TAG, "total try: %d", try_counter);
+        }
+#if TRAFFIC_GEN_MODE
+        int64_t now = esp_timer_get_time();
+        if (now - last_gen_report_us >= TRAFFIC_REPORT_MS * 1000LL) {
+            traffic_gen_get_report(&gen_report, true);
+            traffic_gen_log_report(&gen_report, ESPNOW_TAG);
+            if (queue_full > 0) {
+                ESP_LOGW(ESPNOW_TAG, "TX kuyruğu dolu olduğu için atlanan: %lu", (unsigned long)queue_full);
+                queue_full = 0;
+            }
+            last_gen_report_us = now;
+        }
+#elif SEND_INTERVAL_MS > 0
+        vTaskDelay(pdMS_TO_TICKS(SEND_INTERVAL_MS));  //100 ms'ten 10 ms'e düşürdükten birkaç dakika sonra alıcı ESP32'de ciddi sıcaklık artışı gözlendi
+#else
+        xSemaphoreTake(send_done_sem, pdMS_TO_TICKS(100)); // alıcının işleme kapasitesini zorlamak için sadece send_cb beklenir
+#endif
     }
     ESP_LOGW(ESPNOW_TAG, "total try: %d, success: %d, fail: %d", try_counter, success_counter, fail_counter);
     vTaskDelete(NULL);
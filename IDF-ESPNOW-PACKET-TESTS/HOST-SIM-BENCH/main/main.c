@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_now.h"
+#include "espnow_sim.h"
+#include "espnow_bench.h"
+#include "espnow_stream.h"
+#include "espnow_msg_types.h"
+
+/**
+ * Kartsız throughput testi. IDF linux hedefinde derlenir; esp_now.h espnow_sim'den
+ * gelir ve iki süreç 127.0.0.1 üzerinden simüle edilen radyoyla konuşur. Düğüm 0
+ * gönderici, düğüm 1 alıcıdır (ESPNOW_SIM_NODE); kayıp, gecikme ve bant genişliği
+ * ESPNOW_SIM_* ortam değişkenleriyle verilir (bkz. espnow_sim.h, run_bench.sh).
+ *
+ * Gönderici önce WINDOW_DEPTHS'teki her derinlik için ROUND_MS süren bir
+ * espnow_bench pencereli turu koşar ve tur sonunda ROUND_END ile kaç çerçeve
+ * gönderdiğini ve kaçının send_cb'sinin başarılı geldiğini bildirir. Alıcı
+ * sıra numaralarından yaptığı kayıp hesabını bununla karşılaştırıp ROUND_REPORT
+ * ile döner. Ardından STREAM_BYTES'lık desen espnow_stream ile gönderilir; alıcı
+ * deseni doğrular ve sonucu aynı akış üzerinden geri yazar.
+ *
+ * Kayıp hesabı tutmazsa, akış verisi bozuk ya da eksik gelirse veya karşı taraf
+ * cevap vermezse süreç 1 ile çıkar; regresyon testi olarak çalıştırılabilir.
+ */
+#define SENDER_NODE         0
+#define RECEIVER_NODE       1
+
+#define PACKET_SIZE         1024
+#define DATA_MARKER         ESPNOW_MSG_DATA_MARKER  // ACK isteğiyle ve kontrol kodlarıyla karışmasın diye sabit
+#define WINDOW_DEPTHS       {1, 2, 4, 8, 16}
+#define ROUND_MS            2000
+#define SEND_CB_TIMEOUT_MS  100
+#define ROUND_END_TRIES     50      // ROUND_REPORT gelmezse 100 ms arayla tekrar
+
+#define STREAM_BYTES        (256 * 1024)
+#define STREAM_WRITE_CHUNK  4096
+#define STREAM_TIMEOUT_S    60
+#define IDLE_TIMEOUT_S      30      // alıcı bu kadar süre hiçbir şey almazsa vazgeçer
+#define LINGER_MS           1000    // gönderici çıkmadan önce akışın son ACK'lerini bekler
+
+#define ROUND_END           ESPNOW_MSG_ROUND_END
+#define ROUND_REPORT        ESPNOW_MSG_ROUND_REPORT
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t round;
+    uint32_t first_seq;
+    uint32_t packet_count;      // esp_now_send'in kabul ettiği çerçeveler
+    uint32_t cb_success;        // send_cb'si başarılı gelenler
+} round_end_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t round;
+    uint32_t unique;            // tekrarlar hariç alınan çerçeveler
+    uint32_t duplicates;
+    uint32_t corrupt;
+    uint32_t seq_lost;          // yalnızca sıra numaralarından hesaplanan kayıp
+    uint32_t rx_dropped;        // simülasyonun alıcı kuyruğunda düşenler
+    uint32_t longest_burst;     // pencereden çıkarken kaybı kesinleşen en uzun dizi
+    uint8_t pass;
+} round_report_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t bytes;
+    uint32_t mismatches;
+    uint32_t rounds_failed;
+} stream_result_t;
+
+static const char *TAG = "HOST_BENCH";
+
+static uint8_t peer_mac[ESP_NOW_ETH_ALEN];
+static volatile bool returned_ack = false;
+static volatile int64_t last_rx_us = 0;
+
+/* gönderici */
+static SemaphoreHandle_t report_sem = NULL;
+static round_report_t last_report;
+
+/* alıcı: recv_cb (sim task) dışında dokunulmaz */
+static bench_seq_tracker_t round_seq;
+static round_report_t sent_report;
+static bool report_valid = false;
+static uint32_t rx_dropped_base = 0;
+static uint32_t rounds_failed = 0;
+
+/* BUTTON testlerindeki desenle aynı; segment boyutu 256'nın katı olmadığı için kayan veri yakalanır */
+static inline uint8_t stream_pattern(uint64_t offset) {
+    return (uint8_t)(offset ^ (offset >> 8) ^ (offset >> 16));
+}
+
+static void finish(int failures) {
+    espnow_sim_stats_t sim;
+    espnow_sim_get_stats(&sim);
+    ESP_LOGI(TAG, "Radyo: %lu çerçeve, %lu deneme, %lu başarısız, %lu kayıp deneme, kuyruk dolu %lu | alınan %lu, alıcıda düşen %lu",
+             (unsigned long)sim.tx_frames, (unsigned long)sim.tx_attempts, (unsigned long)sim.tx_failed,
+             (unsigned long)sim.tx_lost, (unsigned long)sim.tx_queue_full, (unsigned long)sim.rx_frames,
+             (unsigned long)sim.rx_dropped);
+    if (failures == 0) {
+        ESP_LOGI(TAG, "SONUÇ: GEÇTİ");
+    }
+    else {
+        ESP_LOGE(TAG, "SONUÇ: %d kontrol başarısız", failures);
+    }
+    fflush(stdout);
+    exit(failures == 0 ? 0 : 1);
+}
+
+static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
+    espnow_bench_on_send(status);   // yalnızca pencereli tur sırasında
+    espnow_stream_on_send(status);  // akış, gönderimden önce eski bildirimleri temizler
+}
+
+static void handle_round_end(const round_end_t *msg) {
+    if (!report_valid || msg->round != sent_report.round) {
+        espnow_sim_stats_t sim;
+        espnow_sim_get_stats(&sim);
+        round_report_t *r = &sent_report;
+        r->type = ROUND_REPORT;
+        r->round = msg->round;
+        r->unique = round_seq.stats.received;
+        r->duplicates = round_seq.stats.duplicates;
+        r->corrupt = round_seq.stats.corrupt;
+        r->seq_lost = espnow_bench_seq_lost(&round_seq);
+        r->rx_dropped = sim.rx_dropped - rx_dropped_base;
+        r->longest_burst = round_seq.stats.longest_burst;
+
+        /**
+         * Simülasyonda unicast çerçeve ancak send_cb'si başarılıysa alıcıya ulaşır;
+         * ulaşıp teslim kuyruğunda düşenler dışında her biri sayılmış olmalı.
+         * Sıra numarasından hesaplanan kayıp, turun başında ve sonunda kaybolanları
+         * göremez, gerçek kayıptan fazla olamaz.
+         */
+        uint32_t lost = msg->packet_count > r->unique ? msg->packet_count - r->unique : 0;
+        r->pass = r->unique + r->rx_dropped == msg->cb_success && r->unique <= msg->packet_count &&
+                  r->duplicates == 0 && r->corrupt == 0 && r->seq_lost <= lost;
+        if (!r->pass) {
+            rounds_failed++;
+        }
+        report_valid = true;
+        rx_dropped_base = sim.rx_dropped;
+        espnow_bench_seq_reset(&round_seq);
+
+        ESP_LOGI(TAG, "Tur %u: gönderilen %lu, ACK'lenen %lu, alınan %lu, kayıp %lu (sıra numarasından %lu), en uzun kesin kayıp %lu, bozuk %lu, tekrar %lu, düşen %lu -> %s",
+                 msg->round, (unsigned long)msg->packet_count, (unsigned long)msg->cb_success, (unsigned long)r->unique,
+                 (unsigned long)lost, (unsigned long)r->seq_lost, (unsigned long)r->longest_burst, (unsigned long)r->corrupt,
+                 (unsigned long)r->duplicates, (unsigned long)r->rx_dropped, r->pass ? "tutarlı" : "TUTARSIZ");
+    }
+    esp_now_send(peer_mac, (const uint8_t *)&sent_report, sizeof(sent_report)); // tekrarlanan ROUND_END'e aynı rapor
+}
+
+static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    last_rx_us = esp_timer_get_time();
+    if (espnow_stream_on_recv(recv_info, data, len)) {
+        return;
+    }
+    if (espnow_bench_seq_on_frame(&round_seq, DATA_MARKER, PACKET_SIZE, data, len)) {
+        return;
+    }
+    if (len == 1 && data[0] == 0x01) {
+        uint8_t reply = 0x02;
+        esp_now_send(peer_mac, &reply, 1);
+    }
+    else if (len == 1 && data[0] == 0x02) {
+        returned_ack = true;
+    }
+    else if (len == sizeof(round_end_t) && data[0] == ROUND_END) {
+        handle_round_end((const round_end_t *)data);
+    }
+    else if (len == sizeof(round_report_t) && data[0] == ROUND_REPORT && report_sem != NULL) {
+        memcpy(&last_report, data, sizeof(last_report));
+        xSemaphoreGive(report_sem);
+    }
+}
+
+static bool exchange_round_end(uint8_t round, uint32_t first_seq, const bench_window_result_t *res, round_report_t *out) {
+    round_end_t msg = {
+        .type = ROUND_END,
+        .round = round,
+        .first_seq = first_seq,
+        .packet_count = res->packet_count,
+        .cb_success = res->cb_success,
+    };
+    xSemaphoreTake(report_sem, 0);
+    for (int i = 0; i < ROUND_END_TRIES; i++) {
+        esp_now_send(peer_mac, (const uint8_t *)&msg, sizeof(msg));
+        if (xSemaphoreTake(report_sem, pdMS_TO_TICKS(100)) == pdTRUE && last_report.round == round) {
+            *out = last_report;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int run_window_sweep(void) {
+    static const int window_depths[] = WINDOW_DEPTHS;
+    const int round_count = sizeof(window_depths) / sizeof(window_depths[0]);
+    static bench_window_result_t results[sizeof(window_depths) / sizeof(window_depths[0])];
+    int failures = 0;
+    uint32_t seq = 0;
+
+    for (int i = 0; i < round_count; i++) {
+        bench_window_config_t config = {
+            .peer_addr = peer_mac,
+            .marker = DATA_MARKER,
+            .frame_len = PACKET_SIZE,
+            .depth = window_depths[i],
+            .duration_ms = ROUND_MS,
+            .send_cb_timeout_ms = SEND_CB_TIMEOUT_MS,
+            .first_seq = seq,
+        };
+        ESP_LOGW(TAG, "Tur %d/%d: pencere derinliği %d", i + 1, round_count, window_depths[i]);
+        if (espnow_bench_window_round(&config, &results[i]) != ESP_OK) {
+            failures++;
+        }
+        seq = results[i].next_seq;
+
+        round_report_t report;
+        if (!exchange_round_end(i, config.first_seq, &results[i], &report)) {
+            ESP_LOGE(TAG, "Tur %d: alıcıdan rapor gelmedi", i + 1);
+            failures++;
+            continue;
+        }
+        ESP_LOGI(TAG, "Gönderilen: %lu, ACK'lenen: %lu, alıcıda sayılan: %lu, sıra numarasından kayıp: %lu -> %s",
+                 (unsigned long)results[i].packet_count, (unsigned long)results[i].cb_success, (unsigned long)report.unique,
+                 (unsigned long)report.seq_lost, report.pass ? "tutarlı" : "TUTARSIZ");
+        failures += !report.pass;
+    }
+
+    int saturation_depth = espnow_bench_saturation_depth(results, round_count);
+    printf("---\n");
+    ESP_LOGI(TAG, "PENCERE TARAMASI TAMAMLANDI");
+    espnow_bench_print_window_table(results, round_count);
+    if (saturation_depth > 0) {
+        ESP_LOGW(TAG, "TX kuyruğu doyma noktası: pencere derinliği %d", saturation_depth);
+    }
+    printf("---\n");
+    return failures;
+}
+
+static int run_stream_phase(void) {
+    static uint8_t chunk[STREAM_WRITE_CHUNK];
+    int64_t start_us = esp_timer_get_time();
+    TickType_t timeout = pdMS_TO_TICKS(STREAM_TIMEOUT_S * 1000);
+
+    for (uint64_t offset = 0; offset < STREAM_BYTES; offset += STREAM_WRITE_CHUNK) {
+        for (int i = 0; i < STREAM_WRITE_CHUNK; i++) {
+            chunk[i] = stream_pattern(offset + i);
+        }
+        size_t written = 0;
+        while (written < STREAM_WRITE_CHUNK) {
+            size_t n = espnow_stream_write(chunk + written, STREAM_WRITE_CHUNK - written, timeout);
+            if (n == 0) {
+                ESP_LOGE(TAG, "Akışa %d s içinde yazılamadı", STREAM_TIMEOUT_S);
+                return 1;
+            }
+            written += n;
+        }
+    }
+    if (espnow_stream_flush(timeout) != ESP_OK) {
+        ESP_LOGE(TAG, "Akış %d s içinde boşaltılamadı", STREAM_TIMEOUT_S);
+        return 1;
+    }
+    double duration_s = (esp_timer_get_time() - start_us) / 1000000.0;
+
+    stream_result_t result;
+    size_t got = 0;
+    while (got < sizeof(result)) {
+        size_t n = espnow_stream_read((uint8_t *)&result + got, sizeof(result) - got, pdMS_TO_TICKS(5000));
+        if (n == 0) {
+            ESP_LOGE(TAG, "Alıcıdan akış sonucu gelmedi");
+            return 1;
+        }
+        got += n;
+    }
+
+    printf("---\n");
+    ESP_LOGI(TAG, "GÜVENİLİR AKIŞ: %d byte, %.2f s, %.2f KB/s", STREAM_BYTES, duration_s, STREAM_BYTES / 1024.0 / duration_s);
+    ESP_LOGI(TAG, "Alıcı: %lu byte, hatalı byte: %lu", (unsigned long)result.bytes, (unsigned long)result.mismatches);
+    espnow_stream_log_stats(TAG);
+    printf("---\n");
+    return result.bytes != STREAM_BYTES || result.mismatches != 0;
+}
+
+static void sender_task() {
+    while (!returned_ack) { //ack dönene kadar saniyede 2 kere sorgu at
+        uint8_t request = 0x01;
+        esp_now_send(peer_mac, &request, 1);
+        vTaskDelay(pdMS_TO_TICKS(500));
+    }
+    ESP_LOGW(TAG, "Alıcı hazır.");
+
+    int failures = run_window_sweep();
+    failures += run_stream_phase();
+    vTaskDelay(pdMS_TO_TICKS(LINGER_MS)); // alıcının sonuç segmenti için ACK'imizi alabilmesi için
+    finish(failures);
+}
+
+static void receiver_task() {
+    static uint8_t buf[STREAM_WRITE_CHUNK];
+    stream_result_t result = {0};
+    last_rx_us = esp_timer_get_time();
+
+    while (result.bytes < STREAM_BYTES) {
+        size_t n = espnow_stream_read(buf, sizeof(buf), pdMS_TO_TICKS(1000));
+        for (size_t i = 0; i < n; i++) {
+            if (buf[i] != stream_pattern(result.bytes + i)) {
+                result.mismatches++;
+            }
+        }
+        result.bytes += n;
+        if (esp_timer_get_time() - last_rx_us > IDLE_TIMEOUT_S * 1000000LL) {
+            ESP_LOGE(TAG, "%d s boyunca göndericiden bir şey gelmedi", IDLE_TIMEOUT_S);
+            finish(1);
+        }
+    }
+    result.rounds_failed = rounds_failed;
+    ESP_LOGI(TAG, "Akış: %lu byte alındı, hatalı byte: %lu", (unsigned long)result.bytes, (unsigned long)result.mismatches);
+
+    // Sonucun ulaşıp ulaşmadığına gönderici karar verir; gönderici çıktıysa son ACK gelmeyebilir
+    espnow_stream_write(&result, sizeof(result), pdMS_TO_TICKS(1000));
+    if (espnow_stream_flush(pdMS_TO_TICKS(LINGER_MS * 5)) != ESP_OK) {
+        ESP_LOGW(TAG, "Akış sonucunun ACK'i gelmedi");
+    }
+    finish(rounds_failed + (result.mismatches != 0));
+}
+
+static void esp_now_init_func(void) {
+    ESP_ERROR_CHECK(esp_now_init());
+    ESP_ERROR_CHECK(esp_now_register_send_cb(esp_now_send_cb));
+
+    esp_now_peer_info_t peer = {
+        .channel = 0,
+        .ifidx = WIFI_IF_STA,
+        .encrypt = false,
+    };
+    memcpy(peer.peer_addr, peer_mac, ESP_NOW_ETH_ALEN);
+    ESP_ERROR_CHECK(esp_now_add_peer(&peer));
+
+    ESP_ERROR_CHECK(espnow_stream_init(peer_mac)); // recv_cb kaydından önce
+    ESP_ERROR_CHECK(esp_now_register_recv_cb(esp_now_recv_cb));
+}
+
+void app_main(void) {
+    espnow_sim_config_t sim_config;
+    espnow_sim_config_from_env(&sim_config);
+    ESP_ERROR_CHECK(espnow_sim_init(&sim_config));
+    espnow_sim_log_config(TAG);
+
+    bool is_sender = sim_config.node_id == SENDER_NODE;
+    espnow_sim_node_mac(is_sender ? RECEIVER_NODE : SENDER_NODE, peer_mac);
+    report_sem = xSemaphoreCreateBinary();
+    espnow_bench_seq_reset(&round_seq);
+
+    esp_now_init_func();
+    ESP_LOGW(TAG, "Düğüm %u: %s", sim_config.node_id, is_sender ? "gönderici" : "alıcı");
+    if (is_sender) {
+        xTaskCreate(sender_task, "sender_task", 8192, NULL, 5, NULL);
+    }
+    else {
+        xTaskCreate(receiver_task, "receiver_task", 8192, NULL, 5, NULL);
+    }
+}
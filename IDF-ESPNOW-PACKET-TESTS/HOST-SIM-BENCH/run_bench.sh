@@ -0,0 +1,21 @@
+#!/bin/sh
+# Alıcıyı (düğüm 1) ve göndericiyi (düğüm 0) aynı simülasyon ayarlarıyla iki süreç
+# olarak çalıştırır; biri başarısız olursa 1 ile çıkar.
+# Örnek: ESPNOW_SIM_LOSS=10 ESPNOW_SIM_LATENCY_US=2000 ESPNOW_SIM_KBPS=2000 ./run_bench.sh
+cd "$(dirname "$0")" || exit 1
+
+ELF=build/HOST-SIM-BENCH.elf
+if [ ! -x "$ELF" ]; then
+    idf.py --preview set-target linux && idf.py build || exit 1
+fi
+
+ESPNOW_SIM_NODE=1 timeout 300 "$ELF" > build/receiver.log 2>&1 &
+RX_PID=$!
+ESPNOW_SIM_NODE=0 timeout 300 "$ELF"
+TX_STATUS=$?
+wait $RX_PID
+RX_STATUS=$?
+
+echo "--- alıcı (build/receiver.log)"
+grep -E "Tur|Akış|Radyo|SONUÇ" build/receiver.log
+[ $TX_STATUS -eq 0 ] && [ $RX_STATUS -eq 0 ]
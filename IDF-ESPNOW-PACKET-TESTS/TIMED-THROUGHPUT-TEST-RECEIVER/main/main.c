@@ -11,15 +11,61 @@
 #include "esp_wifi.h"
 #include "esp_now.h"
 #include "esp_timer.h"
+#include "frame_check.h"
+#include "espnow_chan_survey.h"
+#include "cpu_idle.h"
+#include "espnow_secure.h"
 
 #define WIFI_CHANNEL 1
 #define TEST_DURATION_S 10
 #define PACKET_SIZE 1024
+#define CPU_IDLE_CALIBRATION_MS 500
+
+/**
+ * Kanal taraması (göndericideki CHAN_SURVEY_MODE ile birlikte). Gönderici
+ * isteyince bu cihaz da kanalları ölçer ve gönderici en sessiz kanalı seçerse
+ * onunla birlikte o kanala geçer; WIFI_CHANNEL yalnızca buluşma kanalıdır.
+ */
+#define CHAN_SURVEY_MODE    0
+
+/**
+ * Dinleyici task'ının çekirdeği ve önceliği. Paketler Wi-Fi task'ı (0. çekirdek,
+ * öncelik 23) içinden çağrılan recv_cb'de sayılır; bu task yalnızca tur sonunu
+ * bekleyip raporu yazar.
+ */
+#define RECV_TASK_CORE      tskNO_AFFINITY
+#define RECV_TASK_PRIORITY  5
+
+/**
+ * Alıcı tarafı uygulama yükü. RX_LOAD_PRIORITY 0'dan büyükse RX_LOAD_CORE'a
+ * sabitlenen bir task her RX_LOAD_PERIOD_MS'in %RX_LOAD_DUTY_PCT'i boyunca
+ * CPU'yu meşgul eder ve her tur raporuna çekirdek başına CPU yükü eklenir.
+ * Göndericideki AFFINITY_MATRIX_MODE ile birlikte yükün alıcıda nereye
+ * konabileceğini görmek için kullanılır.
+ */
+#define RX_LOAD_PRIORITY    0
+#define RX_LOAD_CORE        1
+#define RX_LOAD_DUTY_PCT    50
+#define RX_LOAD_PERIOD_MS   20
+
+/**
+ * ESP-NOW şifrelemesi (göndericideki ESPNOW_ENCRYPT ve ENCRYPT_COMPARE_MODE ile
+ * birlikte). Anahtarlar göndericiyle aynı olmalıdır. ENCRYPT_COMPARE_MODE 1
+ * olduğunda gönderici turlar arasında peer'ın modunu bu cihazla birlikte
+ * değiştirir; her tur raporuna peer'ın modu ve çekirdek başına CPU yükü eklenir.
+ */
+#define ESPNOW_ENCRYPT          0
+#define ESPNOW_PMK              "pmk1234567890123"  // ESP_NOW_KEY_LEN (16) karakter
+#define ESPNOW_LMK              "lmk1234567890123"
+#define ENCRYPT_COMPARE_MODE    0
+
+#define RX_CPU_REPORT       (RX_LOAD_PRIORITY > 0 || ENCRYPT_COMPARE_MODE)
 
 static const char *TAG = "RECEIVER";
 static const char *ESPNOW_TAG = "ESP_NOW";
 
-static size_t total_received_bytes = 0;
+static size_t total_received_bytes = 0;          // yalnızca CRC'si tutan paketler
+static frame_check_stats_t frame_check;         // tur başında sıfırlanır
 static int64_t start_time_us = 0;
 static int64_t end_time_us = 0;
 static bool ack_completed = false;
@@ -38,6 +84,16 @@ static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t statu
 }
 
 static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+#if ESPNOW_ENCRYPT || ENCRYPT_COMPARE_MODE
+    if (espnow_secure_on_recv(recv_info, data, len)) {
+        return;
+    }
+#endif
+#if CHAN_SURVEY_MODE
+    if (espnow_chan_survey_on_recv(recv_info, data, len)) {
+        return;
+    }
+#endif
     if (!ack_completed && len == 1 && data[0] == 0x01) {
         ESP_LOGI(ESPNOW_TAG, "ACK isteği alındı, yanıt gönderiliyor...");
         uint8_t ack = 0x02;
@@ -46,13 +102,23 @@ static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t
         start_time_us = esp_timer_get_time();
     }
 
-    if (ack_completed && len == PACKET_SIZE) {
+    if (ack_completed && len == PACKET_SIZE && frame_check_verify(&frame_check, data, len)) {
         total_received_bytes += len;
     }
 }
 
 static void esp_now_recv_task() {
+#if RX_CPU_REPORT
+    bool round_started = false;
+    cpu_idle_sample_t idle;
+#endif
     while (1) {
+#if RX_CPU_REPORT
+        if (ack_completed && !round_started) {
+            cpu_idle_sample(&idle); // ölçüm penceresini tur başlangıcına hizala
+            round_started = true;
+        }
+#endif
         int64_t now = esp_timer_get_time();
         if (ack_completed && (now - start_time_us) >= (TEST_DURATION_S + 0.05) * 1000000) {  // verici ESP32'nin paket gönderiği süreyi tam kapsayabilmek için gönderim süresinden 0.05 saniye daha fazla dinleme yapıyor
             end_time_us = now;
@@ -64,7 +130,22 @@ static void esp_now_recv_task() {
             ESP_LOGI(TAG, "Toplam alınan veri: %d byte (%d paket)", total_received_bytes, total_received_bytes / 1024);
             ESP_LOGI(TAG, "Süre: %.2f saniye", duration_s);
             ESP_LOGI(TAG, "Throughput: %.2f KB/s", throughput);
-            break;
+            ESP_LOGI(TAG, "Bozuk paket (CRC): %lu / %lu, paket başına kontrol: %.1f us", (unsigned long)frame_check.corrupt,
+                     (unsigned long)frame_check.checked, frame_check.checked > 0 ? (double)frame_check.check_us / frame_check.checked : 0.0);
+#if ESPNOW_ENCRYPT || ENCRYPT_COMPARE_MODE
+            ESP_LOGI(TAG, "Peer modu: %s", espnow_secure_is_encrypted(broadcast_mac) ? "şifreli (CCMP)" : "şifresiz");
+#endif
+#if RX_CPU_REPORT
+            cpu_idle_sample(&idle);
+            cpu_idle_log(&idle, TAG);
+            round_started = false;
+#endif
+
+            // Pencereli göndericinin bir sonraki turu için yeni bir ACK isteği beklenir
+            total_received_bytes = 0;
+            memset(&frame_check, 0, sizeof(frame_check));
+            ack_completed = false;
+            ESP_LOGW(ESPNOW_TAG, "Yeni tur için ACK isteği bekleniyor.");
         }
         vTaskDelay(pdMS_TO_TICKS(10));
     }
@@ -93,7 +174,20 @@ static void esp_now_init_func(void) {
     peer->ifidx = WIFI_IF_STA;  // Karşıdaki cihaz değil, bu cihazın hangi wifi arayüzü ile veri göndereceği (Claude: Hedef cihaza hangi arayüz üzerinden (STA/AP) ulaşacağınız)
     peer->encrypt = false;      // Cihazlar arası veri şifrelemesi olacak mı?
     memcpy(peer->peer_addr, broadcast_mac, ESP_NOW_ETH_ALEN);
+#if ESPNOW_ENCRYPT || ENCRYPT_COMPARE_MODE
+    ESP_ERROR_CHECK(espnow_secure_init((const uint8_t *)ESPNOW_PMK, (const uint8_t *)ESPNOW_LMK));
+    espnow_secure_allow_downgrade(ENCRYPT_COMPARE_MODE); // yalnızca karşılaştırma koşusunda CCMP'den çıkılabilir
+    espnow_secure_peer_t secure_peer = {
+        .peer_addr = peer->peer_addr,
+        .channel = peer->channel,
+        .ifidx = peer->ifidx,
+        .encrypt = ESPNOW_ENCRYPT,
+        .allow_plaintext = false,   // şifreli ölçüm istenirken sessizce şifresiz ölçülmesin
+    };
+    ESP_ERROR_CHECK(espnow_secure_add_peer(&secure_peer, NULL)); // şifreli peer sınırı burada kontrol edilir
+#else
     ESP_ERROR_CHECK(esp_now_add_peer(peer));
+#endif
     free(peer);
 
     ESP_LOGW(ESPNOW_TAG, "ESP-NOW baslatildi. Dinlemede.");
@@ -113,8 +207,14 @@ static void wifi_init(void) {
 
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init()); // NVS başlatma
+#if RX_CPU_REPORT
+    ESP_ERROR_CHECK(cpu_idle_init(CPU_IDLE_CALIBRATION_MS)); // Wi-Fi yükü başlamadan %100 boşta hızını ölç
+#endif
 
     /* WiFi ve ESP-NOW başlatma */
+#if CHAN_SURVEY_MODE
+    ESP_ERROR_CHECK(espnow_chan_survey_init()); // recv_cb kaydından önce
+#endif
     wifi_init();
     esp_now_init_func();
 
@@ -126,5 +226,9 @@ void app_main(void) {
              mac[0], mac[1], mac[2],
              mac[3], mac[4], mac[5]);
     ESP_LOGW("MAC", "Bu cihazin (dinleyici) mac adresi: %s", macStr);
-    xTaskCreate(esp_now_recv_task, "esp_now_recv_task", 4096, NULL, 5, NULL); // dinleyici task'ını başlat
+#if RX_LOAD_PRIORITY > 0
+    ESP_ERROR_CHECK(cpu_load_start(RX_LOAD_CORE, RX_LOAD_PRIORITY, RX_LOAD_DUTY_PCT, RX_LOAD_PERIOD_MS));
+#endif
+    xTaskCreatePinnedToCore(esp_now_recv_task, "esp_now_recv_task", 4096, NULL, RECV_TASK_PRIORITY, NULL,
+                            RECV_TASK_CORE); // dinleyici task'ını başlat
 }
\ No newline at end of file
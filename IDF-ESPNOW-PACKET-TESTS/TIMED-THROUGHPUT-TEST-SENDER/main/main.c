@@ -3,6 +3,7 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_event.h"
 #include "esp_system.h"
@@ -11,10 +12,99 @@
 #include "esp_wifi.h"
 #include "esp_now.h"
 #include "esp_timer.h"
+#include "esp_random.h"
+#include "frame_check.h"
+#include "espnow_msg_types.h"
+#include "espnow_chan_survey.h"
+#include "espnow_bench.h"
+#include "cpu_idle.h"
+#include "latency_hist.h"
+#include "espnow_secure.h"
 
 #define WIFI_CHANNEL 1
 #define TEST_DURATION_S 10
 #define PACKET_SIZE 1024
+#define CPU_IDLE_CALIBRATION_MS 500
+
+/**
+ * Pencereli (pipelined) gönderim modu. 1 olduğunda gönderici her paketten sonra
+ * send_cb'yi ve 2 ms'lik vTaskDelay'i beklemez; WINDOW_DEPTHS listesindeki her
+ * pencere derinliği için aynı anda o kadar paketi havada tutar ve her derinlik
+ * TEST_DURATION_S boyunca ayrı bir tur olarak koşturulur.
+ * 0 olduğunda eski stop-and-wait gönderici kullanılır.
+ */
+#define PIPELINED_MODE      1
+#define WINDOW_DEPTHS       {1, 2, 4, 8, 12, 16, 24}
+#define SEND_CB_TIMEOUT_MS  100  // bu sürede send_cb gelmezse cb_timeout sayılır; slot geç send_cb'ye ya da tur sonuna kadar tutulur
+
+/**
+ * Kanal taraması. 1 olduğunda test başlamadan önce espnow_chan_survey ile iki
+ * cihaz tüm kanalları birlikte ölçer (pasif tarama + CHAN_SURVEY_DWELL_MS
+ * promiscuous dinleme); en sessiz kanal WIFI_CHANNEL'dan en az
+ * CHAN_SURVEY_MIN_GAIN_PCT daha sessizse iki taraf oraya geçer. WIFI_CHANNEL
+ * bu durumda yalnızca buluşma kanalıdır. Alıcıda da CHAN_SURVEY_MODE açılmalıdır.
+ */
+#define CHAN_SURVEY_MODE            0
+#define CHAN_SURVEY_DWELL_MS        300
+#define CHAN_SURVEY_MIN_GAIN_PCT    20
+#define CHAN_SURVEY_PEER_WAIT_S     10      // alıcının açılmasını bekleme süresi
+
+/**
+ * Gönderici task'ının çekirdeği ve önceliği. Wi-Fi task'ı 0. çekirdeğe
+ * sabitlidir ve 23 öncelikle çalışır; ESP-NOW send_cb/recv_cb'leri de o task
+ * içinden çağrılır. tskNO_AFFINITY çekirdek seçimini zamanlayıcıya bırakır.
+ */
+#define SENDER_TASK_CORE        tskNO_AFFINITY
+#define SENDER_TASK_PRIORITY    5
+
+/**
+ * Çekirdek/öncelik matrisi. 1 olduğunda PIPELINED_MODE yerine AFFINITY_CASES
+ * listesindeki her yerleşim için ayrı bir pencereli tur (AFFINITY_WINDOW_DEPTH,
+ * TEST_DURATION_S) koşturulur. Her durumda gönderici task'ı verilen çekirdeğe ve
+ * önceliğe sabitlenir; yük önceliği 0'dan büyükse uygulama yükünü taklit eden
+ * bir task da verilen çekirdekte her AFFINITY_LOAD_PERIOD_MS'in
+ * %AFFINITY_LOAD_DUTY_PCT'i boyunca CPU'yu meşgul eder. Sonda her durum için
+ * throughput, çekirdek başına CPU yükü ve esp_now_send'den send_cb'ye geçen
+ * sürenin yüzdelikleri tablo olarak yazdırılır. Tek çekirdekli hedeflerde
+ * 1. çekirdeği kullanan durumlar atlanır.
+ */
+#define AFFINITY_MATRIX_MODE    0
+#define AFFINITY_WINDOW_DEPTH   4
+#define AFFINITY_LOAD_DUTY_PCT  50
+#define AFFINITY_LOAD_PERIOD_MS 20
+#define AFFINITY_CASES {                                                  \
+    /* gönderici {çekirdek, öncelik}, yük {çekirdek, öncelik (0: yük yok)} */ \
+    {{tskNO_AFFINITY, 5},   {0, 0}},                                      \
+    {{0, 5},                {0, 0}},                                      \
+    {{1, 5},                {0, 0}},                                      \
+    {{0, 24},               {0, 0}},    /* Wi-Fi task'ının üstünde */     \
+    {{0, 5},                {0, 10}},                                     \
+    {{1, 5},                {0, 10}},                                     \
+    {{0, 5},                {1, 10}},                                     \
+    {{1, 5},                {1, 10}},                                     \
+    {{1, 5},                {0, 24}},   /* yük radyoyu bekletir */        \
+}
+
+/**
+ * ESP-NOW şifrelemesi (CCMP). ESPNOW_ENCRYPT 1 olduğunda alıcı peer'ı
+ * ESPNOW_PMK ve ESPNOW_LMK ile şifreli eklenir; alıcıda da aynı anahtarlarla
+ * açılmalıdır. Şifreli peer sayısı CONFIG_ESP_WIFI_ESPNOW_MAX_ENCRYPT_NUM ile
+ * sınırlıdır; sınır doluysa gönderici başlamaz.
+ *
+ * ENCRYPT_COMPARE_MODE 1 olduğunda (AFFINITY_MATRIX_MODE kapalıyken)
+ * ENCRYPT_COMPARE_PAIRS kez birer şifresiz ve şifreli tur sırayla
+ * ENCRYPT_COMPARE_DEPTH derinlikte, TEST_DURATION_S boyunca koşturulur; turlar
+ * arasında alıcıyla birlikte mod değiştirilir (alıcıda ENCRYPT_COMPARE_MODE da
+ * açılmalıdır). Her tur için goodput, send -> send_cb süresi (TX kuyruğu +
+ * hava + MAC ACK) ve çekirdek başına CPU yükü ölçülür; sonda iki modun
+ * ortalamaları ve farkları yazdırılır.
+ */
+#define ESPNOW_ENCRYPT          0
+#define ESPNOW_PMK              "pmk1234567890123"  // ESP_NOW_KEY_LEN (16) karakter
+#define ESPNOW_LMK              "lmk1234567890123"
+#define ENCRYPT_COMPARE_MODE    0
+#define ENCRYPT_COMPARE_DEPTH   4
+#define ENCRYPT_COMPARE_PAIRS   3
 
 static const char *TAG = "SENDER";
 static const char *ESPNOW_TAG = "ESP_NOW";
@@ -27,9 +117,20 @@ static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xCC, 0x7B, 0x5C, 0xF8, 0xDE,
 
 static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
     send_done = true;
+    espnow_bench_on_send(status);   // pencereli turda slot açar, tur dışında bir şey yapmaz
 }
 
 static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+#if ESPNOW_ENCRYPT || ENCRYPT_COMPARE_MODE
+    if (espnow_secure_on_recv(recv_info, data, len)) {
+        return;
+    }
+#endif
+#if CHAN_SURVEY_MODE
+    if (espnow_chan_survey_on_recv(recv_info, data, len)) {
+        return;
+    }
+#endif
     if (len == 1 && data[0] == 0x02) {
         ESP_LOGW(ESPNOW_TAG, "ACK alındı!");
         returned_ack = true;
@@ -40,7 +141,9 @@ static void esp_now_send_task() {
     ESP_LOGW(ESPNOW_TAG, "ESP-NOW veri gönderme taskı başladı.");
 
     uint8_t payload[PACKET_SIZE];
-    memset(payload, 0xAA, PACKET_SIZE); // dummy data
+    payload[0] = ESPNOW_MSG_DATA_MARKER;    // ilk bayt ACK isteğiyle karışmasın diye sabit
+    frame_check_fill(payload, 1, PACKET_SIZE, esp_random()); // PRBS dolgu + CRC32, alıcı bozuk paketleri sayar
+    frame_check_seal(payload, PACKET_SIZE);
 
     int64_t start_time = esp_timer_get_time();
     int64_t now = start_time;
@@ -78,6 +181,25 @@ static void esp_now_send_task() {
     vTaskDelete(NULL);
 }
 
+#if CHAN_SURVEY_MODE
+static void run_channel_survey(void) {
+    static chan_survey_result_t result;
+    chan_survey_config_t config = {
+        .peer_addr = broadcast_mac,
+        .dwell_ms = CHAN_SURVEY_DWELL_MS,
+        .min_gain_pct = CHAN_SURVEY_MIN_GAIN_PCT,
+        .peer_wait_ms = CHAN_SURVEY_PEER_WAIT_S * 1000,
+    };
+    esp_err_t err = espnow_chan_survey_run(&config, &result);
+    if (result.best_channel != 0) { // iki tarafın ölçümü de alındı
+        espnow_chan_survey_print_results(&result);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(ESPNOW_TAG, "Kanal taraması tamamlanamadı (%s), kanal %u ile devam ediliyor.", esp_err_to_name(err), result.channel);
+    }
+}
+#endif
+
 static void esp_now_send_ack() {
     uint8_t data = 0x01;  // ACK isteği
 
@@ -90,6 +212,350 @@ static void esp_now_send_ack() {
     }
 }
 
+/* Alıcı bir önceki turun raporunu yazıp yeniden dinlemeye geçene kadar ACK iste */
+static void wait_for_receiver(void) {
+    returned_ack = false;
+    while (!returned_ack) {
+        esp_now_send_ack();
+        vTaskDelay(pdMS_TO_TICKS(500));
+    }
+}
+
+static void esp_now_pipelined_send_task() {
+    ESP_LOGW(ESPNOW_TAG, "ESP-NOW pencereli gönderme taskı başladı.");
+
+    static const int window_depths[] = WINDOW_DEPTHS;
+    const int round_count = sizeof(window_depths) / sizeof(window_depths[0]);
+    static bench_window_result_t results[sizeof(window_depths) / sizeof(window_depths[0])];
+
+    for (int i = 0; i < round_count; i++) {
+        if (i > 0) {
+            wait_for_receiver();
+        }
+
+        ESP_LOGW(TAG, "Tur %d/%d: pencere derinliği %d", i + 1, round_count, window_depths[i]);
+        bench_window_result_t *res = &results[i];
+        bench_window_config_t config = {
+            .peer_addr = broadcast_mac,
+            .marker = ESPNOW_MSG_DATA_MARKER,   // ilk bayt ACK isteğiyle karışmasın diye sabit
+            .frame_len = PACKET_SIZE,
+            .depth = window_depths[i],
+            .duration_ms = TEST_DURATION_S * 1000,
+            .send_cb_timeout_ms = SEND_CB_TIMEOUT_MS,
+        };
+        esp_err_t err = espnow_bench_window_round(&config, res); // sıra numaralı PRBS dolgu + CRC32, alıcı bozuk paketleri sayar
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Tur %d yarıda kaldı: %s", i + 1, esp_err_to_name(err));
+        }
+
+        ESP_LOGI(TAG, "Gönderilen: %lu paket, ACK'lenen: %lu, başarısız: %lu, kuyruk dolu: %lu, cb zaman aşımı: %lu",
+                 (unsigned long)res->packet_count, (unsigned long)res->cb_success, (unsigned long)res->cb_fail,
+                 (unsigned long)res->queue_full, (unsigned long)res->cb_timeout);
+        ESP_LOGI(TAG, "Süre: %.2f saniye, Throughput: %.2f KB/s", res->duration_s, res->throughput);
+    }
+
+    int saturation_depth = espnow_bench_saturation_depth(results, round_count);
+
+    printf("---\n");
+    ESP_LOGI(TAG, "PENCERE TARAMASI TAMAMLANDI");
+    espnow_bench_print_window_table(results, round_count);
+    if (saturation_depth > 0) {
+        ESP_LOGW(TAG, "TX kuyruğu doyma noktası: pencere derinliği %d", saturation_depth);
+    }
+    else {
+        ESP_LOGW(TAG, "Denenen derinliklerde TX kuyruğu doymadı, WINDOW_DEPTHS listesini büyütün.");
+    }
+    printf("---\n");
+
+    vTaskDelete(NULL);
+}
+
+#if AFFINITY_MATRIX_MODE
+typedef struct {
+    BaseType_t core;
+    UBaseType_t priority;
+} task_placement_t;
+
+typedef struct {
+    task_placement_t sender;
+    task_placement_t load;
+} affinity_case_t;
+
+typedef struct {
+    bench_window_result_t bench;
+    latency_summary_t cb_latency;
+    float busy_pct[CPU_IDLE_MAX_CORES];
+    bool skipped;
+} affinity_result_t;
+
+typedef struct {
+    const bench_window_config_t *config;
+    bench_window_result_t *result;
+    TaskHandle_t coordinator;
+} affinity_round_t;
+
+static void format_placement(char *out, size_t len, const task_placement_t *p) {
+    if (p->core == tskNO_AFFINITY) {
+        snprintf(out, len, "-/%u", (unsigned)p->priority);
+    }
+    else {
+        snprintf(out, len, "%d/%u", (int)p->core, (unsigned)p->priority);
+    }
+}
+
+static void affinity_round_task(void *arg) {
+    affinity_round_t *round = (affinity_round_t *)arg;
+    esp_err_t err = espnow_bench_window_round(round->config, round->result);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Yerleşim turu yarıda kaldı: %s", esp_err_to_name(err));
+    }
+    xTaskNotifyGive(round->coordinator);
+    vTaskDelete(NULL);
+}
+
+static void affinity_print_table(const affinity_case_t *cases, const affinity_result_t *results, int count) {
+    printf("%-5s | %-10s | %-10s | %9s | %9s | %11s", "durum", "gönderici", "yük", "KB/s", "başarısız", "kuyruk dolu");
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        printf(" | CPU%d %%", c);
+    }
+    printf(" | %8s | %8s | %8s\n", "cb p50", "cb p99", "cb maks");
+
+    for (int i = 0; i < count; i++) {
+        char sender[16];
+        char load[16];
+        format_placement(sender, sizeof(sender), &cases[i].sender);
+        if (cases[i].load.priority > 0) {
+            format_placement(load, sizeof(load), &cases[i].load);
+        }
+        else {
+            snprintf(load, sizeof(load), "yok");
+        }
+        if (results[i].skipped) {
+            printf("%-5d | %-10s | %-10s | atlandı\n", i + 1, sender, load);
+            continue;
+        }
+        const affinity_result_t *r = &results[i];
+        printf("%-5d | %-10s | %-10s | %9.2f | %9lu | %11lu", i + 1, sender, load, r->bench.throughput,
+               (unsigned long)r->bench.cb_fail, (unsigned long)r->bench.queue_full);
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            printf(" | %6.1f", r->busy_pct[c]);
+        }
+        printf(" | %8lu | %8lu | %8lu\n", (unsigned long)r->cb_latency.p50_us, (unsigned long)r->cb_latency.p99_us,
+               (unsigned long)r->cb_latency.max_us);
+    }
+    printf("(yerleşim: çekirdek/öncelik, '-' çekirdek seçimi zamanlayıcıda; CPU yükü yük task'ını da içerir; cb süreleri us)\n");
+}
+
+static void affinity_matrix_task() {
+    ESP_LOGW(ESPNOW_TAG, "ESP-NOW çekirdek/öncelik matrisi başladı.");
+
+    static const affinity_case_t cases[] = AFFINITY_CASES;
+    const int case_count = sizeof(cases) / sizeof(cases[0]);
+    static affinity_result_t results[sizeof(cases) / sizeof(cases[0])];
+    static latency_hist_t cb_hist;
+    bool first = true;
+
+    for (int i = 0; i < case_count; i++) {
+        const affinity_case_t *c = &cases[i];
+        affinity_result_t *res = &results[i];
+        if ((c->sender.core != tskNO_AFFINITY && c->sender.core >= portNUM_PROCESSORS) ||
+            (c->load.priority > 0 && c->load.core != tskNO_AFFINITY && c->load.core >= portNUM_PROCESSORS)) {
+            ESP_LOGW(TAG, "Durum %d/%d atlandı: bu hedefte %d çekirdek var", i + 1, case_count, portNUM_PROCESSORS);
+            res->skipped = true;
+            continue;
+        }
+        if (!first) {
+            wait_for_receiver();
+        }
+        first = false;
+
+        char sender[16];
+        char load[16] = "yok";
+        format_placement(sender, sizeof(sender), &c->sender);
+        if (c->load.priority > 0) {
+            format_placement(load, sizeof(load), &c->load);
+        }
+        ESP_LOGW(TAG, "Durum %d/%d: gönderici %s, yük %s", i + 1, case_count, sender, load);
+
+        latency_hist_reset(&cb_hist);
+        bench_window_config_t config = {
+            .peer_addr = broadcast_mac,
+            .marker = ESPNOW_MSG_DATA_MARKER,   // ilk bayt ACK isteğiyle karışmasın diye sabit
+            .frame_len = PACKET_SIZE,
+            .depth = AFFINITY_WINDOW_DEPTH,
+            .duration_ms = TEST_DURATION_S * 1000,
+            .send_cb_timeout_ms = SEND_CB_TIMEOUT_MS,
+            .cb_latency = &cb_hist,
+        };
+        affinity_round_t round = {
+            .config = &config,
+            .result = &res->bench,
+            .coordinator = xTaskGetCurrentTaskHandle(),
+        };
+
+        cpu_idle_sample_t idle;
+        cpu_idle_sample(&idle); // ölçüm penceresini tur başlangıcına hizala
+        if (c->load.priority > 0) {
+            ESP_ERROR_CHECK(cpu_load_start(c->load.core, c->load.priority, AFFINITY_LOAD_DUTY_PCT,
+                                           AFFINITY_LOAD_PERIOD_MS));
+        }
+        xTaskCreatePinnedToCore(affinity_round_task, "affinity_round", 4096, &round, c->sender.priority, NULL,
+                                c->sender.core);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        cpu_idle_sample(&idle);
+        cpu_load_stop();
+
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            res->busy_pct[core] = 100.0f - idle.idle_pct[core];
+        }
+        latency_hist_summarize(&cb_hist, &res->cb_latency);
+        ESP_LOGI(TAG, "Throughput: %.2f KB/s, başarısız: %lu, kuyruk dolu: %lu, cb zaman aşımı: %lu",
+                 res->bench.throughput, (unsigned long)res->bench.cb_fail, (unsigned long)res->bench.queue_full,
+                 (unsigned long)res->bench.cb_timeout);
+        cpu_idle_log(&idle, TAG);
+        latency_hist_log_summary(&cb_hist, TAG, "send -> send_cb:");
+    }
+
+    printf("---\n");
+    ESP_LOGI(TAG, "ÇEKİRDEK/ÖNCELİK MATRİSİ TAMAMLANDI (pencere derinliği %d)", AFFINITY_WINDOW_DEPTH);
+    affinity_print_table(cases, results, case_count);
+    printf("---\n");
+
+    vTaskDelete(NULL);
+}
+#endif
+
+#if ENCRYPT_COMPARE_MODE && !AFFINITY_MATRIX_MODE
+typedef struct {
+    bool encrypted;
+    bench_window_result_t bench;
+    latency_summary_t cb_latency;
+    float busy_pct[CPU_IDLE_MAX_CORES];
+} encrypt_round_t;
+
+typedef struct {
+    int rounds;
+    double throughput;
+    double p50_us;
+    double p99_us;
+    double busy_pct[CPU_IDLE_MAX_CORES];
+} encrypt_average_t;
+
+static void encrypt_average(const encrypt_round_t *rounds, int count, bool encrypted, encrypt_average_t *out) {
+    memset(out, 0, sizeof(*out));
+    for (int i = 0; i < count; i++) {
+        const encrypt_round_t *r = &rounds[i];
+        if (r->encrypted != encrypted) {
+            continue;
+        }
+        out->rounds++;
+        out->throughput += r->bench.throughput;
+        out->p50_us += r->cb_latency.p50_us;
+        out->p99_us += r->cb_latency.p99_us;
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            out->busy_pct[c] += r->busy_pct[c];
+        }
+    }
+    if (out->rounds > 0) {
+        out->throughput /= out->rounds;
+        out->p50_us /= out->rounds;
+        out->p99_us /= out->rounds;
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            out->busy_pct[c] /= out->rounds;
+        }
+    }
+}
+
+static void encrypt_print_table(const encrypt_round_t *rounds, int count) {
+    printf("%-3s | %-8s | %9s | %9s | %11s", "tur", "şifre", "KB/s", "başarısız", "kuyruk dolu");
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        printf(" | CPU%d %%", c);
+    }
+    printf(" | %8s | %8s | %8s\n", "cb p50", "cb p99", "cb maks");
+    for (int i = 0; i < count; i++) {
+        const encrypt_round_t *r = &rounds[i];
+        printf("%-3d | %-8s | %9.2f | %9lu | %11lu", i + 1, r->encrypted ? "CCMP" : "yok", r->bench.throughput,
+               (unsigned long)r->bench.cb_fail, (unsigned long)r->bench.queue_full);
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            printf(" | %6.1f", r->busy_pct[c]);
+        }
+        printf(" | %8lu | %8lu | %8lu\n", (unsigned long)r->cb_latency.p50_us, (unsigned long)r->cb_latency.p99_us,
+               (unsigned long)r->cb_latency.max_us);
+    }
+
+    encrypt_average_t plain;
+    encrypt_average_t enc;
+    encrypt_average(rounds, count, false, &plain);
+    encrypt_average(rounds, count, true, &enc);
+    if (plain.rounds == 0 || enc.rounds == 0) {
+        return;
+    }
+    printf("ortalama şifresiz: %.2f KB/s, cb p50 %.0f us, p99 %.0f us\n", plain.throughput, plain.p50_us, plain.p99_us);
+    printf("ortalama CCMP    : %.2f KB/s, cb p50 %.0f us, p99 %.0f us\n", enc.throughput, enc.p50_us, enc.p99_us);
+    printf("fark: goodput %+.1f%%, cb p50 %+.0f us, cb p99 %+.0f us", plain.throughput > 0 ? (enc.throughput / plain.throughput - 1) * 100.0 : 0.0,
+           enc.p50_us - plain.p50_us, enc.p99_us - plain.p99_us);
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        printf(", CPU%d %+.1f puan", c, enc.busy_pct[c] - plain.busy_pct[c]);
+    }
+    printf("\n");
+}
+
+static void encrypt_compare_task() {
+    ESP_LOGW(ESPNOW_TAG, "ESP-NOW şifreli/şifresiz karşılaştırması başladı.");
+
+    static encrypt_round_t rounds[ENCRYPT_COMPARE_PAIRS * 2];
+    const int round_count = ENCRYPT_COMPARE_PAIRS * 2;
+    static latency_hist_t cb_hist;
+
+    for (int i = 0; i < round_count; i++) {
+        encrypt_round_t *r = &rounds[i];
+        r->encrypted = ((i % 2) != 0) != ESPNOW_ENCRYPT; // ilk tur başlangıç modunda, ACK zaten alındı
+        if (i > 0) {
+            if (espnow_secure_switch(broadcast_mac, r->encrypted, 5000) != ESP_OK) {
+                ESP_LOGE(TAG, "Alıcı %s moda geçmedi, karşılaştırma durduruldu.", r->encrypted ? "şifreli" : "şifresiz");
+                break;
+            }
+            wait_for_receiver(); // ACK yeni modda gelir, veri yolu doğrulanır
+        }
+
+        ESP_LOGW(TAG, "Tur %d/%d: %s", i + 1, round_count, r->encrypted ? "şifreli (CCMP)" : "şifresiz");
+        latency_hist_reset(&cb_hist);
+        bench_window_config_t config = {
+            .peer_addr = broadcast_mac,
+            .marker = ESPNOW_MSG_DATA_MARKER,   // ilk bayt ACK isteğiyle karışmasın diye sabit
+            .frame_len = PACKET_SIZE,
+            .depth = ENCRYPT_COMPARE_DEPTH,
+            .duration_ms = TEST_DURATION_S * 1000,
+            .send_cb_timeout_ms = SEND_CB_TIMEOUT_MS,
+            .cb_latency = &cb_hist,
+        };
+        cpu_idle_sample_t idle;
+        cpu_idle_sample(&idle); // ölçüm penceresini tur başlangıcına hizala
+        esp_err_t err = espnow_bench_window_round(&config, &r->bench);
+        cpu_idle_sample(&idle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Tur %d yarıda kaldı: %s", i + 1, esp_err_to_name(err));
+        }
+
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            r->busy_pct[c] = 100.0f - idle.idle_pct[c];
+        }
+        latency_hist_summarize(&cb_hist, &r->cb_latency);
+        ESP_LOGI(TAG, "Throughput: %.2f KB/s, başarısız: %lu, kuyruk dolu: %lu", r->bench.throughput,
+                 (unsigned long)r->bench.cb_fail, (unsigned long)r->bench.queue_full);
+        cpu_idle_log(&idle, TAG);
+        latency_hist_log_summary(&cb_hist, TAG, "send -> send_cb:");
+    }
+
+    printf("---\n");
+    ESP_LOGI(TAG, "ŞİFRELİ/ŞİFRESİZ KARŞILAŞTIRMA TAMAMLANDI (pencere derinliği %d, %d B)", ENCRYPT_COMPARE_DEPTH, PACKET_SIZE);
+    encrypt_print_table(rounds, round_count);
+    printf("---\n");
+
+    vTaskDelete(NULL);
+}
+#endif
+
 static void esp_now_init_func(void) {
     ESP_ERROR_CHECK(esp_now_init());
     ESP_ERROR_CHECK(esp_now_register_send_cb(esp_now_send_cb));
@@ -112,16 +578,43 @@ static void esp_now_init_func(void) {
     peer->ifidx = WIFI_IF_STA;  // Karşıdaki cihaz değil, bu cihazın hangi wifi arayüzü ile veri göndereceği (Claude: Hedef cihaza hangi arayüz üzerinden (STA/AP) ulaşacağınız)
     peer->encrypt = false;      // Cihazlar arası veri şifrelemesi olacak mı?
     memcpy(peer->peer_addr, broadcast_mac, ESP_NOW_ETH_ALEN);
+#if ESPNOW_ENCRYPT || ENCRYPT_COMPARE_MODE
+    ESP_ERROR_CHECK(espnow_secure_init((const uint8_t *)ESPNOW_PMK, (const uint8_t *)ESPNOW_LMK));
+    espnow_secure_peer_t secure_peer = {
+        .peer_addr = peer->peer_addr,
+        .channel = peer->channel,
+        .ifidx = peer->ifidx,
+        .encrypt = ESPNOW_ENCRYPT,
+        .allow_plaintext = false,   // şifreli ölçüm istenirken sessizce şifresiz ölçülmesin
+    };
+    ESP_ERROR_CHECK(espnow_secure_add_peer(&secure_peer, NULL)); // şifreli peer sınırı burada kontrol edilir
+#else
     ESP_ERROR_CHECK(esp_now_add_peer(peer));
+#endif
     free(peer);
 
     ESP_LOGW(ESPNOW_TAG, "ESP-NOW başlatıldı.");
+#if CHAN_SURVEY_MODE
+    run_channel_survey();
+#endif
 
     while (!returned_ack) { //ack dönene kadar saniyede 2 kere sorgu at
         esp_now_send_ack();
         vTaskDelay(pdMS_TO_TICKS(500));
     }
-    xTaskCreate(esp_now_send_task, "esp_now_send_task", 4096, NULL, 5, NULL);
+#if AFFINITY_MATRIX_MODE
+    // Yönetici task çoğunlukla bekler; yük task'ları altında kalmasın diye en yüksek öncelikte
+    xTaskCreate(affinity_matrix_task, "affinity_matrix_task", 4096, NULL, configMAX_PRIORITIES - 1, NULL);
+#elif ENCRYPT_COMPARE_MODE
+    xTaskCreatePinnedToCore(encrypt_compare_task, "encrypt_compare_task", 4096, NULL, SENDER_TASK_PRIORITY, NULL,
+                            SENDER_TASK_CORE);
+#elif PIPELINED_MODE
+    xTaskCreatePinnedToCore(esp_now_pipelined_send_task, "esp_now_pipelined_send_task", 4096, NULL,
+                            SENDER_TASK_PRIORITY, NULL, SENDER_TASK_CORE);
+#else
+    xTaskCreatePinnedToCore(esp_now_send_task, "esp_now_send_task", 4096, NULL, SENDER_TASK_PRIORITY, NULL,
+                            SENDER_TASK_CORE);
+#endif
 }
 
 static void wifi_init(void) {
@@ -138,6 +631,9 @@ static void wifi_init(void) {
 
 void app_main(void) {
     ESP_ERROR_CHECK(nvs_flash_init()); // NVS başlatma
+#if AFFINITY_MATRIX_MODE || ENCRYPT_COMPARE_MODE
+    ESP_ERROR_CHECK(cpu_idle_init(CPU_IDLE_CALIBRATION_MS)); // Wi-Fi yükü başlamadan %100 boşta hızını ölç
+#endif
 
     wifi_init(); // WiFi başlatma
 
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_freertos_hooks.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "cpu_idle.h"
+
+static const char *TAG = "CPU_IDLE";
+
+static volatile uint32_t idle_counts[CPU_IDLE_MAX_CORES];  // yalnızca kendi çekirdeğinin hook'u yazar
+
+static double full_idle_per_us[CPU_IDLE_MAX_CORES];       // kalibrasyonda ölçülen %100 boşta sayaç hızı
+static uint32_t last_counts[CPU_IDLE_MAX_CORES];
+static int64_t last_sample_us = 0;
+
+/* cpu_load_start/stop durumu */
+static TaskHandle_t load_task = NULL;
+static SemaphoreHandle_t load_done = NULL;      // yük task'ı çıkarken verir
+static volatile bool load_stop = false;
+static int64_t load_busy_us = 0;
+static TickType_t load_idle_ticks = 0;
+
+static bool idle_hook_core0(void) {
+    idle_counts[0]++;
+    return false;   // uyuma, sayaç boşta süreyle orantılı artsın
+}
+
+#if CPU_IDLE_MAX_CORES > 1
+static bool idle_hook_core1(void) {
+    idle_counts[1]++;
+    return false;
+}
+#endif
+
+static void snapshot(uint32_t counts[CPU_IDLE_MAX_CORES]) {
+    for (int core = 0; core < CPU_IDLE_MAX_CORES; core++) {
+        counts[core] = idle_counts[core];
+    }
+}
+
+esp_err_t cpu_idle_init(uint32_t calibrate_ms) {
+    esp_err_t err = esp_register_freertos_idle_hook_for_cpu(idle_hook_core0, 0);
+#if CPU_IDLE_MAX_CORES > 1
+    if (err == ESP_OK) {
+        err = esp_register_freertos_idle_hook_for_cpu(idle_hook_core1, 1);
+    }
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Idle hook kaydı başarısız: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    uint32_t start_counts[CPU_IDLE_MAX_CORES];
+    snapshot(start_counts);
+    int64_t start_us = esp_timer_get_time();
+    vTaskDelay(pdMS_TO_TICKS(calibrate_ms));
+    snapshot(last_counts);
+    last_sample_us = esp_timer_get_time();
+
+    double elapsed_us = (double)(last_sample_us - start_us);
+    for (int core = 0; core < CPU_IDLE_MAX_CORES; core++) {
+        full_idle_per_us[core] = (last_counts[core] - start_counts[core]) / elapsed_us;
+        ESP_LOGI(TAG, "Çekirdek %d kalibrasyonu: %.3f sayım/us", core, full_idle_per_us[core]);
+    }
+    return ESP_OK;
+}
+
+void cpu_idle_sample(cpu_idle_sample_t *out) {
+    uint32_t counts[CPU_IDLE_MAX_CORES];
+    snapshot(counts);
+    int64_t now_us = esp_timer_get_time();
+    double elapsed_us = (double)(now_us - last_sample_us);
+
+    memset(out, 0, sizeof(*out));
+    out->period_ms = (uint32_t)(elapsed_us / 1000.0);
+    for (int core = 0; core < CPU_IDLE_MAX_CORES; core++) {
+        double expected = full_idle_per_us[core] * elapsed_us;
+        float pct = expected > 0 ? (float)((counts[core] - last_counts[core]) / expected * 100.0) : 0.0f;
+        out->idle_pct[core] = pct > 100.0f ? 100.0f : pct;
+        last_counts[core] = counts[core];
+    }
+    last_sample_us = now_us;
+}
+
+void cpu_idle_log(const cpu_idle_sample_t *sample, const char *tag) {
+    char line[64];
+    int pos = 0;
+    for (int core = 0; core < CPU_IDLE_MAX_CORES && pos < (int)sizeof(line); core++) {
+        pos += snprintf(line + pos, sizeof(line) - pos, "%sçekirdek %d %%%.1f", core ? ", " : "", core, sample->idle_pct[core]);
+    }
+    ESP_LOGI(tag, "CPU boşta (%lu ms): %s", (unsigned long)sample->period_ms, line);
+}
+
+/* Uygulama yükü: periyodun ilk kısmında meşgul döngü, kalanında uyku */
+static void load_task_fn(void *arg) {
+    while (!load_stop) {
+        int64_t start = esp_timer_get_time();
+        while (esp_timer_get_time() - start < load_busy_us) {
+        }
+        vTaskDelay(load_idle_ticks > 0 ? load_idle_ticks : 1); // idle task'ı (ve task WDT'yi) besle
+    }
+    xSemaphoreGive(load_done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t cpu_load_start(BaseType_t core, UBaseType_t priority, uint32_t duty_pct, uint32_t period_ms) {
+    if (load_task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (duty_pct > 100 || period_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (load_done == NULL) {
+        load_done = xSemaphoreCreateBinary();
+        if (load_done == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    load_busy_us = period_ms * 1000LL * duty_pct / 100;
+    load_idle_ticks = pdMS_TO_TICKS(period_ms * (100 - duty_pct) / 100);
+    load_stop = false;
+    if (xTaskCreatePinnedToCore(load_task_fn, "cpu_load", 2048, NULL, priority, &load_task, core) != pdPASS) {
+        load_task = NULL;
+        ESP_LOGE(TAG, "Yük task'ı oluşturulamadı");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void cpu_load_stop(void) {
+    if (load_task == NULL) {
+        return;
+    }
+    load_stop = true;
+    xSemaphoreTake(load_done, portMAX_DELAY);
+    load_task = NULL;
+}
@@ -0,0 +1,54 @@
+/**
+ * Çekirdek başına boşta (idle) süre ölçümü.
+ *
+ * Her çekirdeğin idle task'ına bir hook kaydedilir; hook idle task her döndüğünde
+ * bir sayacı artırır ve false döndürerek çekirdeğin WAITI ile uyumasını engeller.
+ * Böylece sayaç çekirdeğin boşta geçirdiği süreyle orantılı artar. cpu_idle_init()
+ * yükün olmadığı bir anda (Wi-Fi başlatılmadan önce) sayacın %100 boşta hızını
+ * kalibre eder; sonraki ölçümler bu hıza oranlanır.
+ *
+ * Run-time stats (CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS) gerektirmez, ancak
+ * ölçüm açıkken çekirdekler uyumadığı için güç tüketimi artar.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CPU_IDLE_MAX_CORES  portNUM_PROCESSORS
+
+typedef struct {
+    float idle_pct[CPU_IDLE_MAX_CORES];   // son örnekten bu yana çekirdek başına boşta yüzdesi
+    uint32_t period_ms;                   // ölçüm penceresinin uzunluğu
+} cpu_idle_sample_t;
+
+/**
+ * Hook'ları kaydeder ve calibrate_ms boyunca çağıran task'ı bekleterek %100
+ * boşta sayaç hızını ölçer. Sistem boştayken, bir kez çağrılmalıdır.
+ */
+esp_err_t cpu_idle_init(uint32_t calibrate_ms);
+
+/* Bir önceki çağrıdan (ilk çağrıda kalibrasyon sonundan) bu yana geçen pencereyi ölçer. Tek bir task çağırmalıdır. */
+void cpu_idle_sample(cpu_idle_sample_t *out);
+
+void cpu_idle_log(const cpu_idle_sample_t *sample, const char *tag);
+
+/**
+ * Uygulama yükünü taklit eden bir task başlatır: core'a (tskNO_AFFINITY olabilir)
+ * ve priority önceliğine sabitlenen task her period_ms'in %duty_pct'i boyunca
+ * meşgul döngüde kalır, kalanında uyur. Aynı anda tek bir yük task'ı çalışır.
+ */
+esp_err_t cpu_load_start(BaseType_t core, UBaseType_t priority, uint32_t duty_pct, uint32_t period_ms);
+
+/* Yük task'ını durdurur ve task silinene kadar bekler. Yük yoksa bir şey yapmaz. */
+void cpu_load_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,399 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "frame_check.h"
+#include "espnow_bench.h"
+
+static const char *TAG = "ESPNOW_BENCH";
+
+/**
+ * Havadaki çerçevelerin gönderim zamanları. ESP-NOW send_cb'leri gönderim
+ * sırasıyla gelir; her send_cb en eskisini alır. send_cb esp_now_send dönmeden
+ * gelebileceği için zaman gönderimden önce eklenir, gönderim reddedilirse geri alınır.
+ * Pencere doluluğu da bu sayaçtan okunur; slot yalnızca gerçekten gelen bir
+ * send_cb ile açılır, böylece geç kalan send_cb'ler havadaki çerçeve sayısını
+ * depth'in üstüne çıkaramaz.
+ */
+static portMUX_TYPE inflight_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t inflight_us[BENCH_MAX_INFLIGHT];
+static int inflight_head = 0;
+static int inflight_count = 0;
+static int stale_count = 0;                 // önceki turlardan send_cb'si hâlâ gelmemiş çerçeveler
+static uint32_t cb_success_count = 0;
+static uint32_t cb_fail_count = 0;
+static latency_hist_t *cb_latency = NULL;
+
+/* Her send_cb verir; tur koşarken slot açıldığını ya da TX kuyruğunda yer olduğunu bildirir. Silinmez. */
+static SemaphoreHandle_t slot_sem = NULL;
+
+static void inflight_push(int64_t t) {
+    portENTER_CRITICAL(&inflight_lock);
+    inflight_us[(inflight_head + inflight_count) % BENCH_MAX_INFLIGHT] = t;
+    inflight_count++;
+    portEXIT_CRITICAL(&inflight_lock);
+}
+
+static void inflight_drop_newest(void) {
+    portENTER_CRITICAL(&inflight_lock);
+    if (inflight_count > 0) {
+        inflight_count--;
+    }
+    portEXIT_CRITICAL(&inflight_lock);
+}
+
+static int inflight_pending(void) {
+    portENTER_CRITICAL(&inflight_lock);
+    int n = inflight_count;
+    portEXIT_CRITICAL(&inflight_lock);
+    return n;
+}
+
+void espnow_bench_on_send(esp_now_send_status_t status) {
+    int64_t sent_us = 0;
+    latency_hist_t *hist = NULL;
+    bool counted = false;
+
+    portENTER_CRITICAL(&inflight_lock);
+    if (stale_count > 0) {
+        stale_count--;      // önceki turun geç gelen send_cb'si, bu tura sayılmaz
+        portEXIT_CRITICAL(&inflight_lock);
+        xSemaphoreGive(slot_sem); // tur başındaki boşaltma beklemesini uyandırır
+        return;
+    }
+    else if (inflight_count > 0) {
+        sent_us = inflight_us[inflight_head];
+        inflight_head = (inflight_head + 1) % BENCH_MAX_INFLIGHT;
+        inflight_count--;
+        if (status == ESP_NOW_SEND_SUCCESS) {
+            cb_success_count++;
+        }
+        else {
+            cb_fail_count++;
+        }
+        hist = cb_latency;
+        counted = true;
+    }
+    portEXIT_CRITICAL(&inflight_lock);
+
+    if (!counted) {
+        return;     // tur dışında ya da başka bir gönderimin send_cb'si
+    }
+    if (hist != NULL) {
+        latency_hist_record(hist, (uint32_t)(esp_timer_get_time() - sent_us));
+    }
+    xSemaphoreGive(slot_sem); // send_cb Wi-Fi task'ında çalışır, ISR değil
+}
+
+/**
+ * Önceki turlardan gelmemiş send_cb'leri bir tam send_cb_timeout_ms boyunca
+ * bekler, gelmeyenleri kayıp kabul edip sayacı sıfırlar. Aksi halde hiç
+ * gelmeyen bir send_cb bu turun ilk send_cb'lerini yutar ve açılmayan slotlar
+ * sonraki tüm turların penceresini kalıcı olarak daraltır.
+ */
+static void drain_stale(uint32_t timeout_ms) {
+    portENTER_CRITICAL(&inflight_lock);
+    int stale = stale_count;
+    portEXIT_CRITICAL(&inflight_lock);
+    if (stale == 0) {
+        return;
+    }
+
+    int64_t deadline = esp_timer_get_time() + timeout_ms * 1000LL;
+    while (stale > 0) {
+        int64_t left_us = deadline - esp_timer_get_time();
+        if (left_us <= 0) {
+            break;
+        }
+        xSemaphoreTake(slot_sem, pdMS_TO_TICKS(left_us / 1000) + 1);
+        portENTER_CRITICAL(&inflight_lock);
+        stale = stale_count;
+        portEXIT_CRITICAL(&inflight_lock);
+    }
+
+    if (stale > 0) {
+        ESP_LOGW(TAG, "%d çerçevenin send_cb'si %lu ms içinde gelmedi, kayıp sayıldı", stale, (unsigned long)timeout_ms);
+        portENTER_CRITICAL(&inflight_lock);
+        stale_count = 0;
+        portEXIT_CRITICAL(&inflight_lock);
+    }
+}
+
+esp_err_t espnow_bench_window_round(const bench_window_config_t *cfg, bench_window_result_t *res) {
+    static uint8_t frame[ESP_NOW_MAX_DATA_LEN_V2];
+    if (cfg->frame_len < BENCH_MIN_FRAME_LEN || cfg->frame_len > sizeof(frame) || cfg->depth <= 0 ||
+        cfg->depth > BENCH_MAX_INFLIGHT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (slot_sem == NULL) {
+        slot_sem = xSemaphoreCreateBinary();
+        if (slot_sem == NULL) {
+            ESP_LOGE(TAG, "Pencere semaforu oluşturulamadı");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    drain_stale(cfg->send_cb_timeout_ms);
+    memset(res, 0, sizeof(bench_window_result_t));
+    res->window_depth = cfg->depth;
+    res->next_seq = cfg->first_seq;
+
+    frame[0] = cfg->marker;
+    frame_check_fill(frame, BENCH_SEQ_OFFSET + sizeof(uint32_t), cfg->frame_len, cfg->first_seq ^ 0x9E3779B9);
+
+    portENTER_CRITICAL(&inflight_lock);
+    cb_success_count = 0;
+    cb_fail_count = 0;
+    inflight_head = 0;
+    inflight_count = 0;
+    cb_latency = cfg->cb_latency;
+    portEXIT_CRITICAL(&inflight_lock);
+    xSemaphoreTake(slot_sem, 0);    // önceki turdan kalan bildirimi temizle
+
+    esp_err_t result = ESP_OK;
+    int64_t start_time = esp_timer_get_time();
+    int64_t now = start_time;
+
+    while ((now - start_time) < cfg->duration_ms * 1000LL) {
+        // Pencerede boş slot yoksa havadaki çerçevelerden birinin send_cb'sini bekle
+        if (inflight_pending() >= cfg->depth) {
+            if (xSemaphoreTake(slot_sem, pdMS_TO_TICKS(cfg->send_cb_timeout_ms)) != pdTRUE) {
+                res->cb_timeout++; // slot geri alınmaz; send_cb gelene ya da süre bitene kadar beklenir
+            }
+            now = esp_timer_get_time();
+            continue;
+        }
+
+        memcpy(frame + BENCH_SEQ_OFFSET, &res->next_seq, sizeof(uint32_t));
+        frame_check_seal(frame, cfg->frame_len);
+
+        esp_err_t err;
+        while (1) {
+            xSemaphoreTake(slot_sem, 0); // gönderimden önceki bildirimleri temizle
+            inflight_push(esp_timer_get_time());
+            err = esp_now_send(cfg->peer_addr, frame, cfg->frame_len);
+            if (err != ESP_OK) {
+                inflight_drop_newest();
+            }
+            if (err != ESP_ERR_ESPNOW_NO_MEM) {
+                break;
+            }
+            // Wi-Fi TX kuyruğu dolu: sabit bir uyku yerine bir sonraki send_cb'yi bekle
+            res->queue_full++;
+            xSemaphoreTake(slot_sem, pdMS_TO_TICKS(cfg->send_cb_timeout_ms));
+        }
+        now = esp_timer_get_time();
+
+        if (err == ESP_OK) {
+            res->packet_count++;
+            res->next_seq++;
+        }
+        else {
+            ESP_LOGE(TAG, "ESP-NOW Gönderim hatası: %s", esp_err_to_name(err));
+            result = err;
+            break;
+        }
+    }
+
+    // Havadaki tüm çerçevelerin send_cb'si gelene kadar bekle
+    while (inflight_pending() > 0) {
+        if (xSemaphoreTake(slot_sem, pdMS_TO_TICKS(cfg->send_cb_timeout_ms)) != pdTRUE) {
+            res->cb_timeout++;
+            break;
+        }
+    }
+    now = esp_timer_get_time();
+
+    // Gelmeyen send_cb'ler sonraki turda gelirse o turun çerçevelerine sayılmasın
+    portENTER_CRITICAL(&inflight_lock);
+    stale_count += inflight_count;
+    inflight_count = 0;
+    cb_latency = NULL;
+    res->cb_success = cb_success_count;
+    res->cb_fail = cb_fail_count;
+    portEXIT_CRITICAL(&inflight_lock);
+
+    res->duration_s = (now - start_time) / 1000000.0;
+    res->throughput = (res->cb_success * (cfg->frame_len / 1024.0)) / res->duration_s;
+    return result;
+}
+
+int espnow_bench_saturation_depth(const bench_window_result_t *results, int count) {
+    for (int i = 0; i < count; i++) {
+        if (results[i].queue_full > 0) {
+            return results[i].window_depth;
+        }
+        if (i > 0 && results[i].throughput < results[i - 1].throughput * 1.02) {
+            return results[i - 1].window_depth;
+        }
+    }
+    return -1;
+}
+
+void espnow_bench_print_window_table(const bench_window_result_t *results, int count) {
+    printf("derinlik | gönderilen |    ack |  fail | kuyruk dolu | cb timeout |    KB/s | x(derinlik=%d)\n", results[0].window_depth);
+    for (int i = 0; i < count; i++) {
+        printf("%8d | %10lu | %6lu | %5lu | %11lu | %10lu | %7.2f | %.2f\n",
+               results[i].window_depth, (unsigned long)results[i].packet_count, (unsigned long)results[i].cb_success,
+               (unsigned long)results[i].cb_fail, (unsigned long)results[i].queue_full, (unsigned long)results[i].cb_timeout,
+               results[i].throughput, results[0].throughput > 0 ? results[i].throughput / results[0].throughput : 0.0);
+    }
+}
+
+void espnow_bench_seq_reset(bench_seq_tracker_t *t) {
+    memset(t, 0, sizeof(*t));
+}
+
+static inline bool seq_bit_get(const bench_seq_tracker_t *t, uint32_t seq) {
+    uint32_t idx = seq % BENCH_SEQ_WINDOW;
+    return (t->bitmap[idx / 32] >> (idx % 32)) & 1;
+}
+
+static inline void seq_bit_set(bench_seq_tracker_t *t, uint32_t seq, bool value) {
+    uint32_t idx = seq % BENCH_SEQ_WINDOW;
+    if (value) {
+        t->bitmap[idx / 32] |= (1u << (idx % 32));
+    }
+    else {
+        t->bitmap[idx / 32] &= ~(1u << (idx % 32));
+    }
+}
+
+static void seq_burst_add(bench_seq_tracker_t *t, uint32_t count) {
+    t->current_burst += count;
+    if (t->current_burst > t->stats.longest_burst) {
+        t->stats.longest_burst = t->current_burst;
+    }
+}
+
+/* İstatistikleri koruyarak pencereyi first_seq'ten yeniden başlatır */
+static void seq_start(bench_seq_tracker_t *t, uint32_t first_seq, int64_t transit_us) {
+    bench_seq_stats_t kept = t->stats;
+    memset(t, 0, sizeof(*t));
+    t->stats = kept;
+    t->started = true;
+    t->base_seq = first_seq;
+    t->highest_seq = first_seq;
+    t->last_transit_us = transit_us;
+    t->transit_valid = true;
+    seq_bit_set(t, first_seq, true);
+    t->stats.received++;
+}
+
+void espnow_bench_seq_resume(bench_seq_tracker_t *t, uint32_t last_seq) {
+    memset(t, 0, sizeof(*t));
+    t->started = true;
+    t->base_seq = last_seq;
+    t->highest_seq = last_seq;
+    seq_bit_set(t, last_seq, true);
+}
+
+/* Pencerenin tabanını new_base'e ilerletir; geride kalan numaralar için kayıp kesinleşir */
+static void seq_window_slide(bench_seq_tracker_t *t, uint32_t new_base) {
+    uint32_t window_end = t->base_seq + BENCH_SEQ_WINDOW;
+    if (new_base > window_end) {
+        // Tüm pencereyi aşan boşluk: pencere dışındaki numaraların hiçbiri alınmadı
+        for (uint32_t s = t->base_seq; s < window_end; s++) {
+            if (seq_bit_get(t, s)) {
+                t->current_burst = 0;
+            }
+            else {
+                seq_burst_add(t, 1);
+            }
+        }
+        seq_burst_add(t, new_base - window_end);
+        memset(t->bitmap, 0, sizeof(t->bitmap));
+    }
+    else {
+        for (uint32_t s = t->base_seq; s < new_base; s++) {
+            if (seq_bit_get(t, s)) {
+                t->current_burst = 0;
+            }
+            else {
+                seq_burst_add(t, 1);
+            }
+            seq_bit_set(t, s, false);
+        }
+    }
+    t->base_seq = new_base;
+}
+
+void espnow_bench_seq_record(bench_seq_tracker_t *t, uint32_t seq, int64_t send_time_us, int64_t recv_time_us) {
+    bench_seq_stats_t *st = &t->stats;
+    int64_t transit_us = recv_time_us - send_time_us;
+
+    if (!t->started) {
+        seq_start(t, seq, transit_us);
+        return;
+    }
+
+    if (seq > t->highest_seq) {
+        // Aradaki numaralar geçici olarak kayıp; pencere gerekiyorsa ileri kayar
+        st->lost += seq - t->highest_seq - 1;
+        if (seq - t->base_seq >= BENCH_SEQ_WINDOW) {
+            seq_window_slide(t, seq - BENCH_SEQ_WINDOW + 1);
+        }
+        t->highest_seq = seq;
+        seq_bit_set(t, seq, true);
+    }
+    else if (seq < t->base_seq) {
+        if (t->highest_seq - seq > 4 * BENCH_SEQ_WINDOW) {
+            // Gönderici yeniden başladı (sıra numarası başa döndü)
+            st->restarts++;
+            seq_start(t, seq, transit_us);
+            return;
+        }
+        st->too_old++; // kaybı çoktan kesinleşmiş numara, sayımı değiştirmez
+        return;
+    }
+    else {
+        if (seq_bit_get(t, seq)) {
+            st->duplicates++;
+            return;
+        }
+        // Daha önce geçici kayıp sayılmış bir numara geç geldi
+        uint32_t depth = t->highest_seq - seq;
+        seq_bit_set(t, seq, true);
+        st->reordered++;
+        if (st->lost > 0) {
+            st->lost--;
+        }
+        if (depth > st->max_reorder_depth) {
+            st->max_reorder_depth = depth;
+        }
+    }
+
+    st->received++;
+
+    /* RFC 3550 jitter: J += (|D| - J) / 16, iki cihazın saat farkı D içinde sadeleşir */
+    int64_t d = transit_us - t->last_transit_us;
+    t->last_transit_us = transit_us;
+    if (!t->transit_valid) {
+        t->transit_valid = true;
+        return;
+    }
+    if (d < 0) {
+        d = -d;
+    }
+    st->jitter_us += ((double)d - st->jitter_us) / 16.0;
+}
+
+bool espnow_bench_seq_on_frame(bench_seq_tracker_t *t, uint8_t marker, size_t frame_len, const uint8_t *data, int len) {
+    if (len != (int)frame_len || len < BENCH_MIN_FRAME_LEN || data[0] != marker) {
+        return false;
+    }
+    if (!frame_check_verify(NULL, data, len)) {
+        t->stats.corrupt++;
+        return true;
+    }
+    uint32_t seq;
+    memcpy(&seq, data + BENCH_SEQ_OFFSET, sizeof(seq));
+    t->stats.bytes += len;
+    espnow_bench_seq_record(t, seq, 0, 0);
+    return true;
+}
+
+uint32_t espnow_bench_seq_lost(const bench_seq_tracker_t *t) {
+    return t->stats.lost;
+}
@@ -0,0 +1,144 @@
+/**
+ * Throughput testlerinin karttan bağımsız ölçüm mantığı.
+ *
+ * Yalnızca esp_now_send / send_cb / recv_cb'ye dayanır, Wi-Fi, GPIO ya da
+ * özel Wi-Fi API'si kullanmaz; aynı kod kartta esp_wifi ile, host'ta
+ * (IDF linux hedefi) espnow_sim ile derlenir.
+ *
+ * Gönderici tarafı pencereli (pipelined) turdur: aynı anda en fazla depth
+ * çerçeve havada tutulur, her send_cb bir slot açar, TX kuyruğu doluysa
+ * (ESP_ERR_ESPNOW_NO_MEM) sabit uyku yerine bir sonraki send_cb beklenir.
+ * Her çerçevenin ilk baytı çağıranın işaretidir, ardından 32 bitlik sıra
+ * numarası, PRBS dolgu ve CRC32 (frame_check) gelir; çerçeve her gönderimde
+ * yeniden mühürlenir.
+ *
+ * Alıcı tarafı sıra numarası takibidir (bench_seq_tracker_t). Son
+ * BENCH_SEQ_WINDOW sıra numarasının alınıp alınmadığı bitmap'te tutulur. En
+ * yüksek numaranın ötesine atlayan bir çerçeve aradaki numaraları geçici olarak
+ * kayıp sayar; bu numaralar sonradan gelirse sırasız (reorder) olarak
+ * işaretlenir ve kayıptan düşülür. Bir numara pencereden çıkarken hâlâ
+ * alınmamışsa kaybı kesinleşir ve kayıp patlaması (burst) uzunluğu bu noktada
+ * hesaplanır. espnow_bench_seq_on_frame bu çerçeve biçimini çözer, CRC'si
+ * tutmayanları ayrıca sayar ve hesaba katmaz; kendi çerçeve biçimi olan
+ * projeler espnow_bench_seq_record'u doğrudan çağırır.
+ *
+ * Projeler send_cb'lerinden espnow_bench_on_send'i çağırır. Aynı anda tek bir
+ * tur koşar.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_now.h"
+#include "latency_hist.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BENCH_SEQ_OFFSET    1       // işaret baytından sonra
+#define BENCH_MIN_FRAME_LEN (BENCH_SEQ_OFFSET + 4 + 4)  // işaret + sıra numarası + CRC32
+#define BENCH_SEQ_WINDOW    256     // kayıp kararı verilmeden önce sırasız çerçeve için beklenen pencere (32'nin katı)
+#define BENCH_MAX_INFLIGHT  64      // en büyük pencere derinliği (havadaki çerçevelerin gönderim zamanları tutulur)
+
+typedef struct {
+    const uint8_t *peer_addr;
+    uint8_t marker;                     // çerçevenin ilk baytı, kontrol kodlarıyla karışmayacak bir değer
+    size_t frame_len;                   // BENCH_MIN_FRAME_LEN .. ESP_NOW_MAX_DATA_LEN_V2
+    int depth;                          // havadaki en fazla çerçeve, en fazla BENCH_MAX_INFLIGHT
+    uint32_t duration_ms;
+    uint32_t send_cb_timeout_ms;        // slot beklemesi bu sürede bitmezse cb_timeout sayılır, slot geri alınmaz
+    uint32_t first_seq;                 // turun ilk sıra numarası; dönen next_seq bir sonraki tura verilebilir
+    latency_hist_t *cb_latency;         // NULL değilse esp_now_send'den send_cb'ye geçen süre yazılır (sıfırlanmaz)
+} bench_window_config_t;
+
+typedef struct {
+    int window_depth;
+    uint32_t packet_count;              // esp_now_send'in ESP_OK döndüğü çerçeve sayısı
+    uint32_t cb_success;                // MAC katmanında ACK'lenen çerçeve sayısı
+    uint32_t cb_fail;
+    uint32_t queue_full;                // Wi-Fi TX kuyruğu dolu (ESP_ERR_ESPNOW_NO_MEM) dönüş sayısı
+    uint32_t cb_timeout;                // send_cb_timeout_ms içinde send_cb gelmeyen bekleme sayısı
+    uint32_t next_seq;
+    double duration_s;
+    double throughput;                  // ACK'lenen çerçeveler üzerinden KB/s
+} bench_window_result_t;
+
+typedef struct {
+    uint32_t received;                  // tekrarlar hariç
+    uint32_t lost;                      // geçici + kesin kayıplar (sırasız gelenler düşülmüş)
+    uint32_t duplicates;
+    uint32_t reordered;
+    uint32_t too_old;                   // pencerenin gerisinde kalan, karar verilemeyen çerçeveler
+    uint32_t max_reorder_depth;         // en yüksek numaradan kaç çerçeve geriden gelindiği
+    uint32_t longest_burst;             // art arda kesin kaybolan en uzun çerçeve dizisi
+    uint32_t restarts;                  // göndericinin sıra numarasını sıfırladığı durumlar
+    uint32_t corrupt;                   // espnow_bench_seq_on_frame: CRC'si tutmayan çerçeveler
+    uint64_t bytes;                     // espnow_bench_seq_on_frame: CRC'si tutan çerçevelerin baytları
+    double jitter_us;                   // RFC 3550 varış jitter tahmini
+} bench_seq_stats_t;
+
+typedef struct {
+    bool started;
+    uint32_t base_seq;                  // pencerenin en eski numarası; bunun gerisi karara bağlanmıştır
+    uint32_t highest_seq;
+    uint32_t bitmap[BENCH_SEQ_WINDOW / 32];
+    uint32_t current_burst;
+    int64_t last_transit_us;
+    bool transit_valid;                 // espnow_bench_seq_resume'dan sonraki ilk çerçeveye kadar false
+    bench_seq_stats_t stats;
+} bench_seq_tracker_t;
+
+/**
+ * cfg'ye göre bir pencereli tur koşturur ve sonucu res'e yazar. cfg->peer_addr
+ * peer olarak eklenmiş olmalıdır. Tur bitince havadaki tüm çerçevelerin
+ * send_cb'si beklenir; send_cb_timeout_ms içinde gelmeyenler sonraki turda
+ * gelirse o tura sayılmaz. Sonraki tur başlamadan bunlar bir send_cb_timeout_ms
+ * daha beklenir, yine gelmeyenler kayıp sayılıp unutulur.
+ */
+esp_err_t espnow_bench_window_round(const bench_window_config_t *cfg, bench_window_result_t *res);
+
+/* send_cb'den çağrılır; tur koşmuyorsa bir şey yapmaz */
+void espnow_bench_on_send(esp_now_send_status_t status);
+
+/**
+ * Doyma noktası: TX kuyruğunun ilk kez dolduğu derinlik ya da pencereyi
+ * büyütmenin throughput'u %2'den az artırdığı ilk derinlik. Bulunamazsa -1.
+ */
+int espnow_bench_saturation_depth(const bench_window_result_t *results, int count);
+
+void espnow_bench_print_window_table(const bench_window_result_t *results, int count);
+
+/* İstatistikler dahil her şeyi sıfırlar */
+void espnow_bench_seq_reset(bench_seq_tracker_t *t);
+
+/**
+ * İstatistikleri sıfırlayıp takibi last_seq alınmış gibi başlatır. Alıcı
+ * yeniden başladığında kaydedilmiş en yüksek numarayla çağrılır; aradaki
+ * numaralar (kart kapalıyken gönderilenler) ilk çerçevede kayıp sayılır.
+ */
+void espnow_bench_seq_resume(bench_seq_tracker_t *t, uint32_t last_seq);
+
+/**
+ * seq numaralı çerçevenin alındığını kaydeder. Zaman damgaları yalnızca jitter
+ * için kullanılır; iki cihazın saat farkı jitter hesabında sadeleşir, bilinmiyorsa
+ * ikisi de 0 verilebilir. Kilit içermez; çağıran erişimi korumalıdır.
+ */
+void espnow_bench_seq_record(bench_seq_tracker_t *t, uint32_t seq, int64_t send_time_us, int64_t recv_time_us);
+
+/**
+ * Bu bileşenin çerçeve biçimini çözüp espnow_bench_seq_record'a verir. Çerçeve
+ * marker ile başlıyor ve frame_len uzunluğundaysa true döner (CRC'si tutmasa
+ * bile); başka bir çerçeveyse false.
+ */
+bool espnow_bench_seq_on_frame(bench_seq_tracker_t *t, uint8_t marker, size_t frame_len, const uint8_t *data, int len);
+
+/* Turun son çerçeveleri kaybolduysa onlar sayılmaz */
+uint32_t espnow_bench_seq_lost(const bench_seq_tracker_t *t);
+
+#ifdef __cplusplus
+}
+#endif
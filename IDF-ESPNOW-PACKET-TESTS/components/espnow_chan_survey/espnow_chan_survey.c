@@ -0,0 +1,466 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_wifi.h"
+#include "espnow_chan_survey.h"
+
+#define CHAN_CTRL_RETRIES       20
+#define CHAN_CTRL_TIMEOUT_MS    50
+#define CHAN_SETTLE_MS          30      // kanaldan ayrılmadan önce onay paketinin havaya çıkması için
+#define CHAN_SCAN_PASSIVE_MS    120     // pasif taramada kanal başına beacon bekleme süresi
+#define CHAN_REPORT_MARGIN_MS   3000    // karşı tarafın taramayı bizden geç bitirmesine tanınan pay
+#define CHAN_MAX_APS            32
+
+static const char *TAG = "CHAN_SURVEY";
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t token;          // aynı başlatıcı isteğinin tekrarlarını ayırt eder
+    uint8_t channel;        // CHAN_SWITCH: yeni kanal
+    uint16_t dwell_ms;      // CHAN_SURVEY_START: kanal başına dinleme süresi
+} chan_ctrl_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;           // CHAN_SURVEY_REPORT
+    uint8_t token;
+    uint8_t first_channel;
+    uint8_t count;
+    chan_survey_channel_t ch[CHAN_SURVEY_MAX_CHANNELS];
+} chan_report_t;
+
+/* Başlatıcı durumu */
+static SemaphoreHandle_t reply_sem = NULL;
+static volatile uint8_t awaited_type = 0;
+static volatile uint8_t awaited_token = 0;
+static chan_report_t reply;                 // en büyük yanıt; diğer yanıtlar yalnızca ilk baytları kullanır
+
+/* Karşı taraf durumu */
+static QueueHandle_t work_queue = NULL;
+static SemaphoreHandle_t confirm_sem = NULL;
+static chan_report_t survey_report;         // son taramanın sonucu, survey_ready iken sabit
+static volatile bool survey_ready = false;
+static int16_t last_survey_token = -1;
+static int16_t last_switch_token = -1;
+
+/* Promiscuous sayaçları; tarama sırasında yalnızca o anki kanal için */
+static volatile uint32_t promisc_frames = 0;
+static volatile uint32_t promisc_bytes = 0;
+static volatile int32_t promisc_nf_sum = 0;
+
+static void promisc_cb(void *buf, wifi_promiscuous_pkt_type_t type) {
+    const wifi_promiscuous_pkt_t *pkt = buf;
+    promisc_frames++;
+    promisc_bytes += pkt->rx_ctrl.sig_len;
+    promisc_nf_sum += pkt->rx_ctrl.noise_floor;
+}
+
+static uint8_t current_channel(void) {
+    uint8_t primary = 0;
+    wifi_second_chan_t second;
+    esp_wifi_get_channel(&primary, &second);
+    return primary;
+}
+
+/* Kanalı değiştirir; kanalı sabit verilmiş (0 olmayan) unicast peer'ları da yeni kanala taşır */
+static esp_err_t set_home_channel(uint8_t channel) {
+    esp_err_t err = esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+    if (err != ESP_OK) {
+        return err;
+    }
+    esp_now_peer_info_t peer;
+    bool from_head = true;
+    while (esp_now_fetch_peer(from_head, &peer) == ESP_OK) {
+        from_head = false;
+        if (peer.channel != 0 && peer.channel != channel) {
+            peer.channel = channel;
+            esp_now_mod_peer(&peer);
+        }
+    }
+    return ESP_OK;
+}
+
+/* Bu cihazın tarafında tüm kanalları ölçer ve hata olsa da promiscuous modu kapatıp ev kanalına döner */
+static esp_err_t survey_local(uint16_t dwell_ms, uint8_t home, chan_report_t *out) {
+    static wifi_ap_record_t aps[CHAN_MAX_APS];
+    wifi_country_t country;
+    esp_err_t err = esp_wifi_get_country(&country);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->first_channel = country.schan;
+    out->count = country.nchan > CHAN_SURVEY_MAX_CHANNELS ? CHAN_SURVEY_MAX_CHANNELS : country.nchan;
+    for (int i = 0; i < out->count; i++) {
+        out->ch[i].ap_rssi_max = -128;
+    }
+
+    wifi_scan_config_t scan_cfg = {
+        .show_hidden = true,
+        .scan_type = WIFI_SCAN_TYPE_PASSIVE,        // probe request göndermez, karşı tarafın ölçümünü bozmaz
+        .scan_time.passive = CHAN_SCAN_PASSIVE_MS,
+    };
+    err = esp_wifi_scan_start(&scan_cfg, true);
+    if (err == ESP_OK) {
+        uint16_t n = CHAN_MAX_APS;
+        esp_wifi_scan_get_ap_records(&n, aps);
+        esp_wifi_clear_ap_list();   // tabloya sığmayanlar
+        for (int i = 0; i < n; i++) {
+            int idx = aps[i].primary - out->first_channel;
+            if (idx < 0 || idx >= out->count) {
+                continue;
+            }
+            chan_survey_channel_t *c = &out->ch[idx];
+            c->aps++;
+            if (aps[i].rssi > c->ap_rssi_max) {
+                c->ap_rssi_max = aps[i].rssi;
+            }
+        }
+    }
+    else {
+        ESP_LOGW(TAG, "Wi-Fi taraması başlatılamadı: %s", esp_err_to_name(err));
+    }
+
+    wifi_promiscuous_filter_t filter = {
+        .filter_mask = WIFI_PROMIS_FILTER_MASK_ALL,
+    };
+    err = esp_wifi_set_promiscuous_filter(&filter);
+    if (err == ESP_OK) {
+        err = esp_wifi_set_promiscuous_rx_cb(promisc_cb);
+    }
+    if (err == ESP_OK) {
+        err = esp_wifi_set_promiscuous(true);
+    }
+    for (int i = 0; err == ESP_OK && i < out->count; i++) {
+        err = esp_wifi_set_channel(out->first_channel + i, WIFI_SECOND_CHAN_NONE);
+        if (err != ESP_OK) {
+            break;
+        }
+        promisc_frames = 0;
+        promisc_bytes = 0;
+        promisc_nf_sum = 0;
+        vTaskDelay(pdMS_TO_TICKS(dwell_ms));
+
+        uint32_t frames = promisc_frames;
+        chan_survey_channel_t *c = &out->ch[i];
+        c->frames = frames > UINT16_MAX ? UINT16_MAX : frames;
+        c->bytes = promisc_bytes;
+        c->noise_floor = frames > 0 ? (int8_t)(promisc_nf_sum / (int32_t)frames) : 0;
+    }
+
+    esp_err_t off_err = esp_wifi_set_promiscuous(false);
+    esp_err_t home_err = esp_wifi_set_channel(home, WIFI_SECOND_CHAN_NONE);
+    if (err == ESP_OK) {
+        err = off_err != ESP_OK ? off_err : home_err;
+    }
+    return err;
+}
+
+static bool send_and_wait(const uint8_t *peer_addr, const chan_ctrl_t *msg, uint8_t expect_type) {
+    for (int attempt = 0; attempt < CHAN_CTRL_RETRIES; attempt++) {
+        awaited_type = expect_type;
+        awaited_token = msg->token;
+        xSemaphoreTake(reply_sem, 0);
+
+        esp_err_t err = esp_now_send(peer_addr, (const uint8_t *)msg, sizeof(chan_ctrl_t));
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Kontrol paketi gönderilemedi: %s", esp_err_to_name(err));
+        }
+        if (xSemaphoreTake(reply_sem, pdMS_TO_TICKS(CHAN_CTRL_TIMEOUT_MS)) == pdTRUE) {
+            awaited_type = 0;
+            return true;
+        }
+    }
+    awaited_type = 0;
+    return false;
+}
+
+/* send_and_wait'i timeout_ms dolana kadar tekrarlar */
+static bool send_and_wait_until(const uint8_t *peer_addr, const chan_ctrl_t *msg, uint8_t expect_type, uint32_t timeout_ms) {
+    int64_t deadline_us = esp_timer_get_time() + timeout_ms * 1000LL;
+    do {
+        if (send_and_wait(peer_addr, msg, expect_type)) {
+            return true;
+        }
+    } while (esp_timer_get_time() < deadline_us);
+    return false;
+}
+
+/* ±2 kanal içindeki AP'ler, uzaklıkla azalan ağırlıkla (örtüşen 20 MHz kanallar) */
+static float ap_overlap(const chan_survey_channel_t *ch, int count, int idx) {
+    float sum = 0;
+    for (int d = -2; d <= 2; d++) {
+        int j = idx + d;
+        if (j >= 0 && j < count) {
+            sum += ch[j].aps * (3 - (d < 0 ? -d : d)) / 3.0f;
+        }
+    }
+    return sum;
+}
+
+static void compute_scores(chan_survey_result_t *res) {
+    float dwell_s = res->dwell_ms / 1000.0f;
+    for (int i = 0; i < res->count; i++) {
+        float fps_local = res->local[i].frames / dwell_s;
+        float fps_peer = res->peer[i].frames / dwell_s;
+        float ap_local = ap_overlap(res->local, res->count, i);
+        float ap_peer = ap_overlap(res->peer, res->count, i);
+        // Bağlantıyı daha meşgul olan uç sınırlar
+        res->score[i] = (fps_local > fps_peer ? fps_local : fps_peer) +
+                        CHAN_SURVEY_AP_WEIGHT * (ap_local > ap_peer ? ap_local : ap_peer);
+    }
+
+    int home_idx = res->home_channel - res->first_channel;
+    int best = home_idx >= 0 && home_idx < res->count ? home_idx : 0;   // eşitlikte ev kanalı kalır
+    for (int i = 0; i < res->count; i++) {
+        if (res->score[i] < res->score[best]) {
+            best = i;
+        }
+    }
+    res->best_channel = res->first_channel + best;
+}
+
+esp_err_t espnow_chan_survey_run(const chan_survey_config_t *config, chan_survey_result_t *result) {
+    static uint8_t token = 0;
+    static chan_report_t local;
+
+    if (reply_sem == NULL) {
+        reply_sem = xSemaphoreCreateBinary();
+        token = (uint8_t)esp_random();  // yeniden başlatmadan sonra karşı tarafın eski token'ıyla karışmasın
+    }
+    if (reply_sem == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (config->dwell_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(result, 0, sizeof(*result));
+    result->dwell_ms = config->dwell_ms;
+    result->home_channel = current_channel();
+    result->channel = result->home_channel;
+
+    chan_ctrl_t msg = {
+        .type = CHAN_SURVEY_START,
+        .token = ++token,
+        .dwell_ms = config->dwell_ms,
+    };
+    ESP_LOGW(TAG, "Karşı tarafla kanal taraması başlatılıyor (ev kanalı %u)...", result->home_channel);
+    if (!send_and_wait_until(config->peer_addr, &msg, CHAN_SURVEY_ACK, config->peer_wait_ms)) {
+        ESP_LOGE(TAG, "Karşı taraf taramayı onaylamadı, kanal %u'de kalınıyor.", result->home_channel);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(CHAN_SETTLE_MS));
+    esp_err_t err = survey_local(config->dwell_ms, result->home_channel, &local);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Kanal taraması yapılamadı: %s", esp_err_to_name(err));
+        return err;
+    }
+    result->first_channel = local.first_channel;
+    result->count = local.count;
+    memcpy(result->local, local.ch, sizeof(result->local));
+
+    msg.type = CHAN_SURVEY_REPORT_REQ;
+    if (!send_and_wait_until(config->peer_addr, &msg, CHAN_SURVEY_REPORT, CHAN_REPORT_MARGIN_MS) ||
+        reply.first_channel != result->first_channel || reply.count != result->count) {
+        ESP_LOGE(TAG, "Karşı taraftan uyumlu tarama raporu alınamadı, kanal %u'de kalınıyor.", result->home_channel);
+        return ESP_ERR_TIMEOUT;
+    }
+    memcpy(result->peer, reply.ch, sizeof(result->peer));
+    compute_scores(result);
+
+    int home_idx = result->home_channel - result->first_channel;
+    float home_score = home_idx >= 0 && home_idx < result->count ? result->score[home_idx] : 0.0f;
+    float best_score = result->score[result->best_channel - result->first_channel];
+    if (result->best_channel == result->home_channel || best_score >= home_score * (100 - config->min_gain_pct) / 100.0f) {
+        ESP_LOGI(TAG, "Ev kanalı %u yeterince sessiz, kanal değişmiyor.", result->home_channel);
+        return ESP_OK;
+    }
+
+    msg.type = CHAN_SWITCH;
+    msg.channel = result->best_channel;
+    if (!send_and_wait(config->peer_addr, &msg, CHAN_SWITCH_ACK)) {
+        ESP_LOGE(TAG, "Karşı taraf kanal değişimini onaylamadı, kanal %u'de kalınıyor.", result->home_channel);
+        return ESP_ERR_TIMEOUT;
+    }
+    vTaskDelay(pdMS_TO_TICKS(CHAN_SETTLE_MS));
+    err = set_home_channel(result->best_channel);
+    if (err != ESP_OK) {
+        // Karşı taraf CHAN_CONFIRM gelmeyince kendiliğinden eski kanala döner
+        ESP_LOGE(TAG, "Kanal %u'e geçilemedi: %s", result->best_channel, esp_err_to_name(err));
+        return err;
+    }
+
+    // CHAN_CTRL_RETRIES * CHAN_CTRL_TIMEOUT_MS, karşı tarafın CHAN_SURVEY_CONFIRM_MS'inden kısa
+    msg.type = CHAN_CONFIRM;
+    if (!send_and_wait(config->peer_addr, &msg, CHAN_CONFIRM_ACK)) {
+        err = set_home_channel(result->home_channel);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Kanal %u'e dönülemedi: %s", result->home_channel, esp_err_to_name(err));
+            return err;
+        }
+        ESP_LOGE(TAG, "Kanal %u'de karşı tarafa ulaşılamadı, kanal %u'e dönüldü.", result->best_channel, result->home_channel);
+        return ESP_ERR_TIMEOUT;
+    }
+    result->channel = result->best_channel;
+    result->switched = true;
+    ESP_LOGW(TAG, "İki taraf kanal %u'e geçti.", result->channel);
+    return ESP_OK;
+}
+
+void espnow_chan_survey_print_results(const chan_survey_result_t *res) {
+    float dwell_s = res->dwell_ms / 1000.0f;
+
+    printf("---\n");
+    ESP_LOGI(TAG, "KANAL TARAMASI (kanal başına %u ms, bu cihaz / karşı taraf)", res->dwell_ms);
+    printf("%5s | %15s | %15s | %7s | %11s | %11s | %7s\n",
+           "kanal", "çerçeve/s", "KB/s", "AP", "AP RSSI", "gürültü", "puan");
+    for (int i = 0; i < res->count; i++) {
+        const chan_survey_channel_t *l = &res->local[i];
+        const chan_survey_channel_t *p = &res->peer[i];
+        uint8_t channel = res->first_channel + i;
+        printf("%5u | %6.1f / %6.1f | %6.2f / %6.2f | %3u/%3u | %4d / %4d | %4d / %4d | %7.1f%s%s\n",
+               channel, l->frames / dwell_s, p->frames / dwell_s, l->bytes / 1024.0f / dwell_s, p->bytes / 1024.0f / dwell_s,
+               l->aps, p->aps, l->aps > 0 ? l->ap_rssi_max : 0, p->aps > 0 ? p->ap_rssi_max : 0, l->noise_floor, p->noise_floor,
+               res->score[i], channel == res->home_channel ? " <- ev" : "", channel == res->best_channel ? " <- en sessiz" : "");
+    }
+    ESP_LOGW(TAG, "Kullanılan kanal: %u%s", res->channel, res->switched ? " (değiştirildi)" : "");
+    printf("---\n");
+}
+
+static void reply_to(const uint8_t *dest, const void *msg, size_t len) {
+    if (!esp_now_is_peer_exist(dest)) {
+        esp_now_peer_info_t peer = {0};
+        peer.channel = 0;  // o anki kanal, kanal değişince de geçerli kalır
+        peer.ifidx = WIFI_IF_STA;
+        peer.encrypt = false;
+        memcpy(peer.peer_addr, dest, ESP_NOW_ETH_ALEN);
+        esp_now_add_peer(&peer);
+    }
+    esp_now_send(dest, (const uint8_t *)msg, len);
+}
+
+/* Tarama ve kanal değişimi saniyeler sürdüğü için recv_cb yerine burada yapılır */
+static void chan_survey_task(void *arg) {
+    chan_ctrl_t msg;
+    while (1) {
+        xQueueReceive(work_queue, &msg, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(CHAN_SETTLE_MS));
+        uint8_t home = current_channel();
+
+        if (msg.type == CHAN_SURVEY_START) {
+            ESP_LOGW(TAG, "Kanal taraması başlıyor (kanal başına %u ms)...", msg.dwell_ms);
+            esp_err_t err = survey_local(msg.dwell_ms, home, &survey_report);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Kanal taraması yapılamadı: %s", esp_err_to_name(err));
+                continue;   // rapor hazır olmaz, başlatıcı zaman aşımıyla vazgeçer
+            }
+            survey_report.type = CHAN_SURVEY_REPORT;
+            survey_report.token = msg.token;
+            survey_ready = true;
+            ESP_LOGI(TAG, "Kanal taraması bitti, kanal %u'e dönüldü.", home);
+            continue;
+        }
+
+        // CHAN_SWITCH
+        if (msg.channel == home) {
+            continue;
+        }
+        xSemaphoreTake(confirm_sem, 0);
+        esp_err_t err = set_home_channel(msg.channel);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Kanal %u'e geçilemedi: %s", msg.channel, esp_err_to_name(err));
+            continue;   // başlatıcının CHAN_CONFIRM'i gelmez, o da ev kanalına döner
+        }
+        if (xSemaphoreTake(confirm_sem, pdMS_TO_TICKS(CHAN_SURVEY_CONFIRM_MS)) == pdTRUE) {
+            ESP_LOGW(TAG, "Kanal %u'e geçildi.", msg.channel);
+        }
+        else if (set_home_channel(home) == ESP_OK) {
+            ESP_LOGE(TAG, "Kanal %u'de onay gelmedi, kanal %u'e dönüldü.", msg.channel, home);
+        }
+        else {
+            ESP_LOGE(TAG, "Kanal %u'de onay gelmedi, kanal %u'e de dönülemedi.", msg.channel, home);
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t espnow_chan_survey_init(void) {
+    if (work_queue != NULL) {
+        return ESP_OK;
+    }
+    work_queue = xQueueCreate(2, sizeof(chan_ctrl_t));
+    confirm_sem = xSemaphoreCreateBinary();
+    if (work_queue == NULL || confirm_sem == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(chan_survey_task, "chan_survey_task", 4096, NULL, 5, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool espnow_chan_survey_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (len < 2) {
+        return false;
+    }
+
+    switch (data[0]) {
+        case CHAN_SURVEY_START:
+        case CHAN_SURVEY_REPORT_REQ:
+        case CHAN_SWITCH:
+        case CHAN_CONFIRM: {
+            if (len != sizeof(chan_ctrl_t) || work_queue == NULL) {
+                return true;    // karşı taraf rolü başlatılmamış
+            }
+            chan_ctrl_t msg;
+            memcpy(&msg, data, sizeof(msg));
+
+            if (msg.type == CHAN_SURVEY_REPORT_REQ) {
+                if (survey_ready && msg.token == last_survey_token) {
+                    reply_to(recv_info->src_addr, &survey_report, sizeof(survey_report));
+                }
+                return true;    // tarama sürüyorsa yanıt yok, başlatıcı tekrar sorar
+            }
+            if (msg.type == CHAN_CONFIRM) {
+                xSemaphoreGive(confirm_sem);
+                msg.type = CHAN_CONFIRM_ACK;
+                reply_to(recv_info->src_addr, &msg, sizeof(msg));
+                return true;
+            }
+
+            // START ve SWITCH'in tekrarları yeniden onaylanır ama bir kez işlenir
+            int16_t *last = msg.type == CHAN_SURVEY_START ? &last_survey_token : &last_switch_token;
+            if (msg.token != *last) {
+                *last = msg.token;
+                if (msg.type == CHAN_SURVEY_START) {
+                    survey_ready = false;
+                }
+                xQueueSend(work_queue, &msg, 0);
+            }
+            chan_ctrl_t ack = msg;
+            ack.type = msg.type == CHAN_SURVEY_START ? CHAN_SURVEY_ACK : CHAN_SWITCH_ACK;
+            reply_to(recv_info->src_addr, &ack, sizeof(ack));
+            return true;
+        }
+        case CHAN_SURVEY_ACK:
+        case CHAN_SURVEY_REPORT:
+        case CHAN_SWITCH_ACK:
+        case CHAN_CONFIRM_ACK: {
+            if (data[0] == awaited_type && data[1] == awaited_token && len <= (int)sizeof(reply)) {
+                memcpy(&reply, data, len);
+                xSemaphoreGive(reply_sem);
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,103 @@
+/**
+ * Test öncesi kanal taraması ve iki cihazın birlikte kanal değiştirmesi.
+ *
+ * Projeler WIFI_CHANNEL ile sabit bir kanalda başlar. Başlatıcı (gönderici)
+ * espnow_chan_survey_run ile karşı tarafa taramayı başlatmasını söyler; iki
+ * cihaz aynı anda ev kanalından ayrılıp her kanalı kendi tarafında ölçer:
+ *  - pasif Wi-Fi taraması: kanal başına AP sayısı ve en güçlü AP'nin RSSI'ı,
+ *  - promiscuous dinleme: dwell_ms boyunca yakalanan çerçeve ve bayt sayısı,
+ *    çerçevelerin rx_ctrl'ündeki ortalama gürültü tabanı.
+ * İkisi de taramadayken ESP-NOW trafiği olmadığı için ölçüme kendi paketleri
+ * karışmaz. Ev kanalına dönüldüğünde başlatıcı karşı tarafın ölçümlerini
+ * ister ve kanal başına bir meşguliyet puanı hesaplar: iki taraftan kötü
+ * olanın çerçeve/s değeri + ±2 kanal içindeki AP'ler (uzaklıkla azalan
+ * ağırlıkla). En düşük puanlı kanal ev kanalından en az min_gain_pct daha
+ * sessizse iki taraf oraya geçer.
+ *
+ * Kanal değişimi onaylıdır: başlatıcı CHAN_SWITCH gönderir, karşı taraf
+ * onaylayıp yeni kanala geçer; başlatıcı da geçip yeni kanalda CHAN_CONFIRM
+ * ile karşı tarafa ulaşmayı dener. Yanıt gelmezse başlatıcı, onay gelmezse
+ * karşı taraf CHAN_SURVEY_CONFIRM_MS sonunda eski kanala döner; yani başarısız
+ * bir değişim iki tarafı da ev kanalında bırakır. Kanal değiştiğinde kanalı
+ * sabit (0 olmayan) ESP-NOW peer'larının kanalı da güncellenir.
+ *
+ * Karşı taraf (alıcı) espnow_chan_survey_init ile bir işçi task'ı başlatır;
+ * tarama ve kanal değişimi recv_cb yerine bu task'ta yapılır. Her iki taraf da
+ * recv_cb'sinin başında espnow_chan_survey_on_recv'i çağırır.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_now.h"
+#include "espnow_msg_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHAN_SURVEY_START       ESPNOW_MSG_CHAN_SURVEY_START
+#define CHAN_SURVEY_ACK         ESPNOW_MSG_CHAN_SURVEY_ACK
+#define CHAN_SURVEY_REPORT_REQ  ESPNOW_MSG_CHAN_SURVEY_REPORT_REQ
+#define CHAN_SURVEY_REPORT      ESPNOW_MSG_CHAN_SURVEY_REPORT
+#define CHAN_SWITCH             ESPNOW_MSG_CHAN_SWITCH
+#define CHAN_SWITCH_ACK         ESPNOW_MSG_CHAN_SWITCH_ACK
+#define CHAN_CONFIRM            ESPNOW_MSG_CHAN_CONFIRM
+#define CHAN_CONFIRM_ACK        ESPNOW_MSG_CHAN_CONFIRM_ACK
+
+#define CHAN_SURVEY_MAX_CHANNELS    14
+#define CHAN_SURVEY_CONFIRM_MS      2000    // karşı tarafın yeni kanalda onay bekleme süresi
+#define CHAN_SURVEY_AP_WEIGHT       20      // aynı kanaldaki bir AP kaç çerçeve/s sayılır
+
+typedef struct __attribute__((packed)) {
+    uint16_t frames;                    // dwell boyunca yakalanan çerçeveler
+    uint32_t bytes;
+    uint8_t aps;                        // birincil kanalı bu kanal olan AP'ler
+    int8_t ap_rssi_max;                 // en güçlü AP; AP yoksa -128
+    int8_t noise_floor;                 // ortalama gürültü tabanı (dBm); çerçeve yoksa 0
+} chan_survey_channel_t;
+
+typedef struct {
+    const uint8_t *peer_addr;           // karşı taraf (unicast)
+    uint16_t dwell_ms;                  // kanal başına promiscuous dinleme süresi
+    uint8_t min_gain_pct;               // ev kanalından en az bu kadar sessiz değilse kanal değişmez
+    uint32_t peer_wait_ms;              // karşı tarafın açılmasını bekleme süresi
+} chan_survey_config_t;
+
+typedef struct {
+    uint8_t first_channel;
+    uint8_t count;
+    uint16_t dwell_ms;
+    chan_survey_channel_t local[CHAN_SURVEY_MAX_CHANNELS];
+    chan_survey_channel_t peer[CHAN_SURVEY_MAX_CHANNELS];
+    float score[CHAN_SURVEY_MAX_CHANNELS];      // düşük = sessiz
+    uint8_t home_channel;               // tarama öncesi kanal
+    uint8_t best_channel;
+    uint8_t channel;                    // tarama sonunda kullanılan kanal
+    bool switched;
+} chan_survey_result_t;
+
+/* Karşı taraf: işçi task'ını başlatır. recv_cb kaydından önce çağrılır. Başlatıcı için gerekmez. */
+esp_err_t espnow_chan_survey_init(void);
+
+/**
+ * Başlatıcı tarafı: iki tarafta taramayı yapar, puanları hesaplar ve gerekirse
+ * iki tarafı birlikte en sessiz kanala geçirir. Bloklar (kanal sayısı x dwell_ms
+ * + tarama süresi kadar). Karşı taraf yanıt vermezse ESP_ERR_TIMEOUT döner,
+ * kanal değişmez; kanal değişimi başarısız olursa da ESP_ERR_TIMEOUT döner ve
+ * ev kanalına dönülür (sonuç yine doldurulur). Wi-Fi sürücüsü hatası
+ * (esp_wifi_set_channel vb.) olduğu gibi döner; promiscuous mod kapatılmış ve
+ * mümkünse ev kanalına dönülmüş olur.
+ */
+esp_err_t espnow_chan_survey_run(const chan_survey_config_t *config, chan_survey_result_t *result);
+
+void espnow_chan_survey_print_results(const chan_survey_result_t *result);
+
+/* Her iki tarafın recv_cb'sinden çağrılır; paket taramaya aitse true döner */
+bool espnow_chan_survey_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
+
+#ifdef __cplusplus
+}
+#endif
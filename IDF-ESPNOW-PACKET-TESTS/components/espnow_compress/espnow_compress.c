@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "espnow_compress.h"
+
+/* LZ4 blok formatı kuralları: son 5 bayt literal olmalı, son 12 bayt içinde eşleşme başlamaz */
+#define LZ4_MIN_MATCH       4
+#define LZ4_LAST_LITERALS   5
+#define LZ4_MF_LIMIT        12
+#define LZ4_MAX_OFFSET      65535
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t raw_len;
+} compress_hdr_t;
+
+_Static_assert(sizeof(compress_hdr_t) == COMPRESS_HEADER_LEN, "COMPRESS_HEADER_LEN compress_hdr_t ile uyuşmuyor");
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash32(uint32_t v) {
+    return (v * 2654435761U) >> (32 - COMPRESS_HASH_LOG);
+}
+
+/* 15 ve üzeri uzunluklar token'dan sonra 255'lik baytlarla devam eder */
+static uint8_t *write_length(uint8_t *op, const uint8_t *op_end, size_t len) {
+    while (len >= 255) {
+        if (op >= op_end) {
+            return NULL;
+        }
+        *op++ = 255;
+        len -= 255;
+    }
+    if (op >= op_end) {
+        return NULL;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/* literal + (varsa) eşleşme dizisi yazar; çıkış dolarsa NULL */
+static uint8_t *write_sequence(uint8_t *op, const uint8_t *op_end, const uint8_t *literals, size_t lit_len,
+                               uint16_t offset, size_t match_len) {
+    if (op >= op_end) {
+        return NULL;
+    }
+    uint8_t *token = op++;
+    *token = (uint8_t)((lit_len >= 15 ? 15 : lit_len) << 4);
+    if (lit_len >= 15 && (op = write_length(op, op_end, lit_len - 15)) == NULL) {
+        return NULL;
+    }
+    if ((size_t)(op_end - op) < lit_len) {
+        return NULL;
+    }
+    memcpy(op, literals, lit_len);
+    op += lit_len;
+
+    if (match_len == 0) {
+        return op;  // son dizi yalnızca literal
+    }
+    if (op_end - op < 2) {
+        return NULL;
+    }
+    *op++ = offset & 0xFF;
+    *op++ = offset >> 8;
+    size_t ml = match_len - LZ4_MIN_MATCH;
+    *token |= ml >= 15 ? 15 : ml;
+    if (ml >= 15 && (op = write_length(op, op_end, ml - 15)) == NULL) {
+        return NULL;
+    }
+    return op;
+}
+
+/* src'yi dst'ye sıkıştırır; sonuç dst_cap'e sığmazsa 0 döner */
+static size_t lz4_compress(uint16_t *table, const uint8_t *src, size_t len, uint8_t *dst, size_t dst_cap) {
+    uint8_t *op = dst;
+    const uint8_t *op_end = dst + dst_cap;
+    size_t ip = 0, anchor = 0;
+
+    if (len > LZ4_MF_LIMIT) {
+        memset(table, 0, COMPRESS_HASH_SIZE * sizeof(uint16_t));
+        size_t match_limit = len - LZ4_MF_LIMIT;
+        size_t match_end = len - LZ4_LAST_LITERALS;
+        ip = 1;     // tablo girdisi 0 "boş" demektir, 0. konum aday olarak tutulmaz
+
+        while (ip < match_limit) {
+            uint32_t seq = read32(src + ip);
+            uint32_t h = hash32(seq);
+            size_t ref = table[h];
+            table[h] = (uint16_t)ip;
+            if (ref == 0 || ip - ref > LZ4_MAX_OFFSET || read32(src + ref) != seq) {
+                ip++;
+                continue;
+            }
+            size_t match_len = LZ4_MIN_MATCH;
+            while (ip + match_len < match_end && src[ref + match_len] == src[ip + match_len]) {
+                match_len++;
+            }
+            op = write_sequence(op, op_end, src + anchor, ip - anchor, (uint16_t)(ip - ref), match_len);
+            if (op == NULL) {
+                return 0;
+            }
+            ip += match_len;
+            anchor = ip;
+        }
+    }
+    op = write_sequence(op, op_end, src + anchor, len - anchor, 0, 0);
+    return op != NULL ? (size_t)(op - dst) : 0;
+}
+
+/* -1: bozuk blok ya da dst_cap'e sığmıyor */
+static int lz4_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t dst_cap) {
+    const uint8_t *ip = src;
+    const uint8_t *ip_end = src + len;
+    uint8_t *op = dst;
+    uint8_t *op_end = dst + dst_cap;
+
+    while (ip < ip_end) {
+        uint8_t token = *ip++;
+        size_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= ip_end) {
+                    return -1;
+                }
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if ((size_t)(ip_end - ip) < lit_len || (size_t)(op_end - op) < lit_len) {
+            return -1;
+        }
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip == ip_end) {
+            break;  // son dizi
+        }
+
+        if (ip_end - ip < 2) {
+            return -1;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return -1;
+        }
+        size_t match_len = token & 0x0F;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= ip_end) {
+                    return -1;
+                }
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += LZ4_MIN_MATCH;
+        if ((size_t)(op_end - op) < match_len) {
+            return -1;
+        }
+        const uint8_t *ref = op - offset;
+        for (size_t i = 0; i < match_len; i++) {   // ofset uzunluktan kısa olabilir, bayt bayt kopyalanır
+            op[i] = ref[i];
+        }
+        op += match_len;
+    }
+    return (int)(op - dst);
+}
+
+void espnow_compress_init(compress_ctx_t *ctx, bool enabled) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->enabled = enabled;
+}
+
+size_t espnow_compress_frame(compress_ctx_t *ctx, const void *src, size_t len, uint8_t *frame, size_t frame_cap) {
+    if (len > COMPRESS_MAX_INPUT || frame_cap < COMPRESS_FRAME_BOUND(len)) {
+        return 0;
+    }
+    int64_t start_us = esp_timer_get_time();
+    compress_hdr_t hdr = {
+        .type = COMPRESS_LZ4,
+        .raw_len = (uint16_t)len,
+    };
+    size_t body = 0;
+    if (ctx->enabled && len > 0) {
+        /* Ham halinden küçük değilse sıkıştırmanın anlamı yok; sınır len - 1 */
+        body = lz4_compress(ctx->hash, src, len, frame + COMPRESS_HEADER_LEN, len - 1);
+    }
+    if (body == 0) {
+        hdr.type = COMPRESS_RAW;
+        memcpy(frame + COMPRESS_HEADER_LEN, src, len);
+        body = len;
+    }
+    memcpy(frame, &hdr, sizeof(hdr));
+
+    ctx->stats.frames++;
+    ctx->stats.compressed += hdr.type == COMPRESS_LZ4;
+    ctx->stats.raw_bytes += len;
+    ctx->stats.wire_bytes += COMPRESS_HEADER_LEN + body;
+    ctx->stats.cpu_us += esp_timer_get_time() - start_us;
+    return COMPRESS_HEADER_LEN + body;
+}
+
+int espnow_decompress_frame(compress_ctx_t *ctx, const uint8_t *frame, size_t len, uint8_t *dst, size_t dst_cap) {
+    if (!espnow_compress_is_frame(frame, len)) {
+        ctx->stats.errors++;
+        return -1;
+    }
+    int64_t start_us = esp_timer_get_time();
+    compress_hdr_t hdr;
+    memcpy(&hdr, frame, sizeof(hdr));
+    const uint8_t *body = frame + COMPRESS_HEADER_LEN;
+    size_t body_len = len - COMPRESS_HEADER_LEN;
+
+    int out = -1;
+    if (hdr.raw_len <= dst_cap) {
+        if (hdr.type == COMPRESS_RAW && body_len == hdr.raw_len) {
+            memcpy(dst, body, body_len);
+            out = body_len;
+        }
+        else if (hdr.type == COMPRESS_LZ4) {
+            out = lz4_decompress(body, body_len, dst, hdr.raw_len);
+            if (out != hdr.raw_len) {
+                out = -1;
+            }
+        }
+    }
+    if (out < 0) {
+        ctx->stats.errors++;
+        return -1;
+    }
+
+    ctx->stats.frames++;
+    ctx->stats.compressed += hdr.type == COMPRESS_LZ4;
+    ctx->stats.raw_bytes += out;
+    ctx->stats.wire_bytes += len;
+    ctx->stats.cpu_us += esp_timer_get_time() - start_us;
+    return out;
+}
+
+bool espnow_compress_is_frame(const uint8_t *data, size_t len) {
+    return len >= COMPRESS_HEADER_LEN && (data[0] == COMPRESS_RAW || data[0] == COMPRESS_LZ4);
+}
+
+void espnow_compress_log_stats(const compress_stats_t *s, const char *tag) {
+    double ratio = s->raw_bytes > 0 ? (double)s->wire_bytes / s->raw_bytes * 100.0 : 0.0;
+    double cpu_per_frame = s->frames > 0 ? (double)s->cpu_us / s->frames : 0.0;
+    ESP_LOGI(tag, "Sıkıştırma: %lu çerçeve (%lu LZ4), %llu -> %llu byte (%%%.1f), çerçeve başına %.1f us CPU, %lu bozuk",
+             (unsigned long)s->frames, (unsigned long)s->compressed, s->raw_bytes, s->wire_bytes, ratio, cpu_per_frame,
+             (unsigned long)s->errors);
+}
@@ -0,0 +1,78 @@
+/**
+ * ESP-NOW çerçeveleri için isteğe bağlı LZ4 sıkıştırma.
+ *
+ * Metin ve JSON telemetri gibi tekrar eden veriler esp_now_send'den önce LZ4
+ * blok formatında sıkıştırılır. Her çerçevenin başında 3 baytlık bir başlık
+ * vardır: tip (COMPRESS_RAW ya da COMPRESS_LZ4) ve sıkıştırılmamış uzunluk.
+ * Sıkıştırma çerçeveyi küçültmüyorsa (rastgele ya da zaten sıkıştırılmış veri)
+ * veri olduğu gibi COMPRESS_RAW ile gönderilir; yani en kötü durumda kayıp
+ * başlığın 3 baytı ve sıkıştırmayı denemenin CPU süresidir.
+ *
+ * Sıkıştırıcı açgözlü (greedy) eşleştirme yapar, 4 baytlık dizileri
+ * COMPRESS_HASH_SIZE girişlik bir hash tablosunda arar. Tablo ve istatistikler
+ * uygulamanın ayırdığı compress_ctx_t içindedir, çerçeve tamponlarını da
+ * uygulama verir; sıcak yolda malloc yapılmaz. Bir bağlam aynı anda tek
+ * task'tan kullanılır. Üretilen blok standart LZ4 çözücülerle de açılabilir.
+ *
+ * İstatistikler çerçeve başına CPU süresini (esp_timer) ve kazanılan baytı
+ * tutar; havada kazanılan süreyle karşılaştırılarak sıkıştırmanın hangi veri
+ * ve hızda kazandırdığı görülür.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "espnow_msg_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COMPRESS_RAW            ESPNOW_MSG_COMPRESS_RAW
+#define COMPRESS_LZ4            ESPNOW_MSG_COMPRESS_LZ4
+
+#define COMPRESS_HEADER_LEN     3       // tip + sıkıştırılmamış uzunluk
+#define COMPRESS_MAX_INPUT      65535   // LZ4 ofsetleri ve hash tablosu 16 bit
+#define COMPRESS_HASH_LOG       10
+#define COMPRESS_HASH_SIZE      (1 << COMPRESS_HASH_LOG)
+
+/* len baytlık verinin en kötü durumda (sıkıştırılamaz) kaplayacağı çerçeve boyutu */
+#define COMPRESS_FRAME_BOUND(len) (COMPRESS_HEADER_LEN + (len))
+
+typedef struct {
+    uint32_t frames;
+    uint32_t compressed;                // LZ4 ile giden / gelen çerçeveler (kalanı ham)
+    uint64_t raw_bytes;                 // sıkıştırılmamış veri
+    uint64_t wire_bytes;                // başlık dahil çerçeve baytı
+    uint64_t cpu_us;                    // sıkıştırma ya da açmada geçen toplam süre
+    uint32_t errors;                    // açılamayan bozuk çerçeveler
+} compress_stats_t;
+
+typedef struct {
+    bool enabled;                       // false: her çerçeve COMPRESS_RAW gider (karşılaştırma için)
+    uint16_t hash[COMPRESS_HASH_SIZE];
+    compress_stats_t stats;
+} compress_ctx_t;
+
+void espnow_compress_init(compress_ctx_t *ctx, bool enabled);
+
+/**
+ * src'yi başlıklı bir çerçeve olarak frame'e yazar ve çerçeve boyutunu döner.
+ * frame_cap en az COMPRESS_FRAME_BOUND(len) olmalıdır; değilse ya da len
+ * COMPRESS_MAX_INPUT'tan büyükse 0 döner.
+ */
+size_t espnow_compress_frame(compress_ctx_t *ctx, const void *src, size_t len, uint8_t *frame, size_t frame_cap);
+
+/* Çerçeveyi dst'ye açar ve veri uzunluğunu döner; bozuksa ya da dst'ye sığmıyorsa -1 */
+int espnow_decompress_frame(compress_ctx_t *ctx, const uint8_t *frame, size_t len, uint8_t *dst, size_t dst_cap);
+
+/* Verinin bu bileşenin başlığıyla başlayıp başlamadığı */
+bool espnow_compress_is_frame(const uint8_t *data, size_t len);
+
+void espnow_compress_log_stats(const compress_stats_t *stats, const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
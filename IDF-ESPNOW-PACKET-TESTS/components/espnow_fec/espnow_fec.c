@@ -0,0 +1,628 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "espnow_fec.h"
+
+#define FEC_GF_POLY         0x11D   // x^8 + x^4 + x^3 + x^2 + 1
+#define FEC_COUNT_UNKNOWN   0xFF    // grubun veri sayısı henüz parity'den ya da son veri işaretinden öğrenilmedi
+#define FEC_RESTART_GAP     1000    // bu kadar ileri atlayan grup numarası gönderici yeniden başladı sayılır
+
+static const char *TAG = "FEC";
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t group;
+    uint8_t index;          // 0..k-1 veri, k..k+m-1 parity
+    uint8_t k;
+    uint8_t m;
+    uint8_t data_count;     // parity ve grubun son veri çerçevesi: gruptaki veri çerçevesi sayısı (erken kapatılan grupta < k); diğer veri: 0
+    uint16_t shard_len;
+} fec_hdr_t;
+
+_Static_assert(sizeof(fec_hdr_t) == FEC_HEADER_LEN, "FEC_HEADER_LEN fec_hdr_t ile uyuşmuyor");
+
+typedef struct {
+    bool used;
+    uint16_t group;
+    uint8_t k;
+    uint8_t m;
+    uint8_t data_count;
+    uint16_t shard_len;
+    uint32_t present;       // bit i: parça i tamponda
+    uint32_t recovered;     // bit i: veri parçası i parity'den oluşturuldu
+} slot_t;
+
+typedef struct {
+    fec_stats_t s;
+    int64_t stint_start_us; // ayarın son kez etkin olmaya başladığı an
+    int64_t last_us;
+} setting_stats_t;
+
+/* GF(2^8) tabloları; exp tablosu mod 255 almamak için iki kat uzun */
+static uint8_t gf_exp[512];
+static uint8_t gf_log[256];
+static uint8_t fec_coef[FEC_MAX_M][FEC_MAX_K];
+static bool tables_ready = false;
+
+/* Alıcı tarafı: tamponlar başlangıçta ayrılır, yalnızca recv_cb (Wi-Fi task) yazar */
+static uint8_t shard_buf[FEC_RX_GROUPS][FEC_MAX_K + FEC_MAX_M][FEC_MAX_SHARD_LEN];
+static slot_t slots[FEC_RX_GROUPS];
+static fec_deliver_cb_t deliver_cb = NULL;
+static int current = -1;            // etkin ayarın settings indeksi
+static uint16_t newest_group = 0;
+static bool newest_valid = false;
+
+/* İstatistikler; recv_cb yazar, rapor task'ı get_stats ile okur */
+static portMUX_TYPE fec_lock = portMUX_INITIALIZER_UNLOCKED;
+static setting_stats_t settings[FEC_STATS_SETTINGS];
+static int setting_count = 0;
+static uint32_t late_frames = 0;    // kapatılmış gruplara ait çerçeveler
+static uint32_t duplicates = 0;
+static uint32_t malformed = 0;
+
+static uint8_t gf_mul(uint8_t a, uint8_t b) {
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+static uint8_t gf_inv(uint8_t a) {
+    return gf_exp[255 - gf_log[a]];
+}
+
+/* dst ^= c * src */
+static void gf_mul_add(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) {
+    if (c == 0) {
+        return;
+    }
+    if (c == 1) {
+        for (size_t i = 0; i < len; i++) {
+            dst[i] ^= src[i];
+        }
+        return;
+    }
+    int lc = gf_log[c];
+    for (size_t i = 0; i < len; i++) {
+        if (src[i] != 0) {
+            dst[i] ^= gf_exp[gf_log[src[i]] + lc];
+        }
+    }
+}
+
+/**
+ * Cauchy matrisi C[j][i] = 1 / (x_j + y_i), x_j = FEC_MAX_K + j, y_i = i. Her
+ * sütun C[0][i]'ye bölünerek ilk satır 1'lere çekilir; satır/sütun ölçeklemesi
+ * kare alt matrislerin tersinirliğini bozmaz. Katsayılar k'dan bağımsızdır,
+ * her k için matrisin ilk k sütunu kullanılır.
+ */
+static void fec_tables_init(void) {
+    if (tables_ready) {
+        return;
+    }
+    uint16_t x = 1;
+    for (int i = 0; i < 255; i++) {
+        gf_exp[i] = (uint8_t)x;
+        gf_log[x] = (uint8_t)i;
+        x <<= 1;
+        if (x & 0x100) {
+            x ^= FEC_GF_POLY;
+        }
+    }
+    for (int i = 255; i < 512; i++) {
+        gf_exp[i] = gf_exp[i - 255];
+    }
+    for (int j = 0; j < FEC_MAX_M; j++) {
+        for (int i = 0; i < FEC_MAX_K; i++) {
+            uint8_t x0 = FEC_MAX_K ^ i;
+            uint8_t xj = (FEC_MAX_K + j) ^ i;
+            fec_coef[j][i] = gf_mul(gf_inv(xj), x0);
+        }
+    }
+    tables_ready = true;
+}
+
+/* Gönderici */
+
+static void encoder_next_group(fec_encoder_t *enc) {
+    enc->group++;
+    enc->data_count = 0;
+    enc->parity_next = enc->m;
+    enc->closed = false;
+    for (int j = 0; j < enc->m; j++) {
+        memset(enc->parity[j], 0, enc->shard_len);
+    }
+}
+
+esp_err_t espnow_fec_encoder_init(fec_encoder_t *enc, uint8_t k, uint8_t m, uint16_t max_payload) {
+    if (k == 0 || k > FEC_MAX_K || m > FEC_MAX_M || max_payload == 0 || max_payload > FEC_MAX_PAYLOAD) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    fec_tables_init();
+    memset(enc, 0, sizeof(*enc));
+    enc->k = k;
+    enc->m = m;
+    enc->shard_len = FEC_LEN_PREFIX + max_payload;
+    enc->parity_next = m;
+    return ESP_OK;
+}
+
+static size_t encode_data(fec_encoder_t *enc, const void *payload, size_t len, uint8_t *frame, bool last) {
+    if (enc->closed || FEC_LEN_PREFIX + len > enc->shard_len) {
+        return 0;
+    }
+    uint8_t index = enc->data_count;
+    fec_hdr_t hdr = {
+        .type = FEC_DATA,
+        .group = enc->group,
+        .index = index,
+        .k = enc->k,
+        .m = enc->m,
+        .data_count = last ? index + 1 : 0,
+        .shard_len = enc->shard_len,
+    };
+    memcpy(frame, &hdr, sizeof(hdr));
+
+    uint8_t *shard = frame + FEC_HEADER_LEN;
+    shard[0] = len & 0xFF;
+    shard[1] = len >> 8;
+    memcpy(shard + FEC_LEN_PREFIX, payload, len);
+    size_t used = FEC_LEN_PREFIX + len;  // dolgu sıfır olduğundan parity'ye katkısı yok
+    for (int j = 0; j < enc->m; j++) {
+        gf_mul_add(enc->parity[j], shard, fec_coef[j][index], used);
+    }
+
+    enc->data_count++;
+    enc->data_frames++;
+    if (last || enc->data_count == enc->k) {
+        espnow_fec_close_group(enc);
+    }
+    return FEC_HEADER_LEN + used;
+}
+
+size_t espnow_fec_encode_data(fec_encoder_t *enc, const void *payload, size_t len, uint8_t *frame) {
+    return encode_data(enc, payload, len, frame, false);
+}
+
+size_t espnow_fec_encode_last(fec_encoder_t *enc, const void *payload, size_t len, uint8_t *frame) {
+    return encode_data(enc, payload, len, frame, true);
+}
+
+void espnow_fec_close_group(fec_encoder_t *enc) {
+    if (enc->closed || enc->data_count == 0) {
+        return;
+    }
+    if (enc->m == 0) {
+        encoder_next_group(enc);
+        return;
+    }
+    enc->closed = true;
+    enc->parity_next = 0;
+}
+
+size_t espnow_fec_next_parity(fec_encoder_t *enc, uint8_t *frame) {
+    if (!enc->closed) {
+        return 0;
+    }
+    fec_hdr_t hdr = {
+        .type = FEC_PARITY,
+        .group = enc->group,
+        .index = enc->k + enc->parity_next,
+        .k = enc->k,
+        .m = enc->m,
+        .data_count = enc->data_count,
+        .shard_len = enc->shard_len,
+    };
+    memcpy(frame, &hdr, sizeof(hdr));
+    memcpy(frame + FEC_HEADER_LEN, enc->parity[enc->parity_next], enc->shard_len);
+
+    enc->parity_next++;
+    enc->parity_frames++;
+    if (enc->parity_next == enc->m) {
+        encoder_next_group(enc);
+    }
+    return FEC_HEADER_LEN + enc->shard_len;
+}
+
+/* Alıcı */
+
+static int setting_index(uint8_t k, uint8_t m) {
+    for (int i = 0; i < setting_count; i++) {
+        if (settings[i].s.k == k && settings[i].s.m == m) {
+            return i;
+        }
+    }
+    if (setting_count == FEC_STATS_SETTINGS) {
+        return -1;
+    }
+    setting_stats_t *st = &settings[setting_count];
+    memset(st, 0, sizeof(*st));
+    st->s.k = k;
+    st->s.m = m;
+    return setting_count++;
+}
+
+static int popcount32(uint32_t v) {
+    int n = 0;
+    while (v) {
+        v &= v - 1;
+        n++;
+    }
+    return n;
+}
+
+/* Grubu kapatıp sayar ve slotu boşaltır */
+static void slot_finalize(slot_t *slot) {
+    if (!slot->used) {
+        return;
+    }
+    uint8_t count = slot->data_count;
+    if (count == FEC_COUNT_UNKNOWN) {
+        count = slot->k;    // kısa gruplar son veri çerçevesinde işaretlenir, işaret gelmediyse grup tamdır
+    }
+    uint32_t data_mask = (1UL << count) - 1;
+    int recovered = popcount32(slot->recovered & data_mask);
+    int received = popcount32(slot->present & data_mask) - recovered;
+
+    if (current >= 0) {
+        portENTER_CRITICAL(&fec_lock);
+        fec_stats_t *s = &settings[current].s;
+        s->groups++;
+        s->expected += count;
+        s->received += received;
+        s->recovered += recovered;
+        if (received + recovered < count) {
+            s->unrecoverable++;
+        }
+        portEXIT_CRITICAL(&fec_lock);
+    }
+    slot->used = false;
+}
+
+static void finalize_all(void) {
+    for (int i = 0; i < FEC_RX_GROUPS; i++) {
+        slot_finalize(&slots[i]);
+    }
+}
+
+static void count_malformed(void) {
+    portENTER_CRITICAL(&fec_lock);
+    malformed++;
+    portEXIT_CRITICAL(&fec_lock);
+}
+
+static void deliver_shard(const slot_t *slot, const uint8_t *shard, uint8_t index, bool recovered) {
+    uint16_t len = shard[0] | (shard[1] << 8);
+    if (FEC_LEN_PREFIX + len > slot->shard_len) {
+        count_malformed();
+        return;
+    }
+    if (current >= 0) {
+        portENTER_CRITICAL(&fec_lock);
+        settings[current].s.bytes += len;
+        portEXIT_CRITICAL(&fec_lock);
+    }
+    if (deliver_cb != NULL) {
+        deliver_cb(shard + FEC_LEN_PREFIX, len, slot->group, index, recovered);
+    }
+}
+
+/* n x n matrisi GF(2^8)'de Gauss-Jordan ile tersine çevirir; tekilse false */
+static bool gf_invert(uint8_t a[FEC_MAX_M][FEC_MAX_M], uint8_t inv[FEC_MAX_M][FEC_MAX_M], int n) {
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            inv[r][c] = r == c;
+        }
+    }
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        while (pivot < n && a[pivot][col] == 0) {
+            pivot++;
+        }
+        if (pivot == n) {
+            return false;
+        }
+        if (pivot != col) {
+            for (int c = 0; c < n; c++) {
+                uint8_t t = a[col][c];
+                a[col][c] = a[pivot][c];
+                a[pivot][c] = t;
+                t = inv[col][c];
+                inv[col][c] = inv[pivot][c];
+                inv[pivot][c] = t;
+            }
+        }
+        uint8_t scale = gf_inv(a[col][col]);
+        for (int c = 0; c < n; c++) {
+            a[col][c] = gf_mul(a[col][c], scale);
+            inv[col][c] = gf_mul(inv[col][c], scale);
+        }
+        for (int r = 0; r < n; r++) {
+            uint8_t f = a[r][col];
+            if (r == col || f == 0) {
+                continue;
+            }
+            for (int c = 0; c < n; c++) {
+                a[r][c] ^= gf_mul(f, a[col][c]);
+                inv[r][c] ^= gf_mul(f, inv[col][c]);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Eksik veri parçası sayısı kadar parity geldiyse eksikleri oluşturup teslim
+ * eder. Parity tamponları yerinde sendroma çevrilir (alınan veri parçalarının
+ * katkısı çıkarılır); kalan sistem eksik parçaların katsayı matrisinin tersiyle
+ * çözülür.
+ */
+static void slot_try_decode(int si) {
+    slot_t *slot = &slots[si];
+    if (slot->data_count == FEC_COUNT_UNKNOWN) {
+        return;
+    }
+    uint8_t erased[FEC_MAX_M];
+    int ne = 0;
+    for (int i = 0; i < slot->data_count; i++) {
+        if (!(slot->present & (1UL << i))) {
+            if (ne == slot->m) {
+                return;
+            }
+            erased[ne++] = i;
+        }
+    }
+    if (ne == 0) {
+        return;
+    }
+    uint8_t rows[FEC_MAX_M];
+    int nr = 0;
+    for (int j = 0; j < slot->m && nr < ne; j++) {
+        if (slot->present & (1UL << (slot->k + j))) {
+            rows[nr++] = j;
+        }
+    }
+    if (nr < ne) {
+        return;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    uint8_t (*shards)[FEC_MAX_SHARD_LEN] = shard_buf[si];
+    for (int r = 0; r < ne; r++) {
+        uint8_t *syn = shards[slot->k + rows[r]];
+        for (int i = 0; i < slot->data_count; i++) {
+            if (slot->present & (1UL << i)) {
+                gf_mul_add(syn, shards[i], fec_coef[rows[r]][i], slot->shard_len);
+            }
+        }
+    }
+
+    uint8_t a[FEC_MAX_M][FEC_MAX_M], inv[FEC_MAX_M][FEC_MAX_M];
+    for (int r = 0; r < ne; r++) {
+        for (int c = 0; c < ne; c++) {
+            a[r][c] = fec_coef[rows[r]][erased[c]];
+        }
+    }
+    if (!gf_invert(a, inv, ne)) {
+        ESP_LOGE(TAG, "Grup %u: katsayı matrisi tekil", slot->group); // Cauchy matrisinde olmamalı
+        return;
+    }
+    for (int c = 0; c < ne; c++) {
+        uint8_t *out = shards[erased[c]];
+        memset(out, 0, slot->shard_len);
+        for (int r = 0; r < ne; r++) {
+            gf_mul_add(out, shards[slot->k + rows[r]], inv[c][r], slot->shard_len);
+        }
+        slot->present |= 1UL << erased[c];
+        slot->recovered |= 1UL << erased[c];
+    }
+    uint32_t decode_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    if (current >= 0) {
+        portENTER_CRITICAL(&fec_lock);
+        if (decode_us > settings[current].s.decode_max_us) {
+            settings[current].s.decode_max_us = decode_us;
+        }
+        portEXIT_CRITICAL(&fec_lock);
+    }
+    for (int c = 0; c < ne; c++) {
+        deliver_shard(slot, shards[erased[c]], erased[c], true);
+    }
+}
+
+/* Ayar değiştiyse açık grupları eski ayara sayar ve yeni ayarın süresini başlatır */
+static void switch_setting(uint8_t k, uint8_t m, int64_t now_us) {
+    if (current >= 0 && settings[current].s.k == k && settings[current].s.m == m) {
+        return;
+    }
+    finalize_all();
+    newest_valid = false;
+
+    portENTER_CRITICAL(&fec_lock);
+    if (current >= 0) {
+        settings[current].s.active_us += settings[current].last_us - settings[current].stint_start_us;
+    }
+    current = setting_index(k, m);
+    if (current >= 0) {
+        settings[current].stint_start_us = now_us;
+        settings[current].last_us = now_us;
+    }
+    portEXIT_CRITICAL(&fec_lock);
+
+    if (current < 0) {
+        ESP_LOGW(TAG, "K=%u M=%u için istatistik yeri yok (FEC_STATS_SETTINGS)", k, m);
+    }
+}
+
+/* Grubun slotunu bulur ya da açar; grup kapatılmışsa -1 */
+static int slot_for_group(const fec_hdr_t *hdr) {
+    for (int i = 0; i < FEC_RX_GROUPS; i++) {
+        if (slots[i].used && slots[i].group == hdr->group) {
+            return i;
+        }
+    }
+
+    int16_t ahead = newest_valid ? (int16_t)(hdr->group - newest_group) : 1;
+    if (ahead <= 0 && -ahead < FEC_RESTART_GAP) {
+        return -1;
+    }
+    if (ahead > 1 && ahead < FEC_RESTART_GAP && current >= 0) {
+        /* Arada hiç çerçevesi gelmeyen gruplar */
+        uint32_t missing = ahead - 1;
+        portENTER_CRITICAL(&fec_lock);
+        fec_stats_t *s = &settings[current].s;
+        s->groups += missing;
+        s->lost_groups += missing;
+        s->unrecoverable += missing;
+        s->expected += missing * hdr->k;
+        portEXIT_CRITICAL(&fec_lock);
+    }
+    newest_group = hdr->group;
+    newest_valid = true;
+
+    int si = -1;
+    for (int i = 0; i < FEC_RX_GROUPS; i++) {
+        if (!slots[i].used) {
+            si = i;
+            break;
+        }
+        if (si < 0 || (int16_t)(slots[i].group - slots[si].group) < 0) {
+            si = i;
+        }
+    }
+    slot_finalize(&slots[si]);
+
+    slot_t *slot = &slots[si];
+    slot->used = true;
+    slot->group = hdr->group;
+    slot->k = hdr->k;
+    slot->m = hdr->m;
+    slot->data_count = FEC_COUNT_UNKNOWN;
+    slot->shard_len = hdr->shard_len;
+    slot->present = 0;
+    slot->recovered = 0;
+    return si;
+}
+
+esp_err_t espnow_fec_decoder_init(fec_deliver_cb_t deliver) {
+    fec_tables_init();
+    deliver_cb = deliver;
+    memset(slots, 0, sizeof(slots));
+    current = -1;
+    newest_valid = false;
+
+    portENTER_CRITICAL(&fec_lock);
+    setting_count = 0;
+    late_frames = 0;
+    duplicates = 0;
+    malformed = 0;
+    portEXIT_CRITICAL(&fec_lock);
+    return ESP_OK;
+}
+
+bool espnow_fec_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (len < 1 || (data[0] != FEC_DATA && data[0] != FEC_PARITY)) {
+        return false;
+    }
+    fec_hdr_t hdr;
+    if (len < FEC_HEADER_LEN + FEC_LEN_PREFIX) {
+        count_malformed();
+        return true;
+    }
+    memcpy(&hdr, data, sizeof(hdr));
+    size_t shard_bytes = len - FEC_HEADER_LEN;
+    bool parity = hdr.type == FEC_PARITY;
+    if (hdr.k == 0 || hdr.k > FEC_MAX_K || hdr.m > FEC_MAX_M || hdr.shard_len > FEC_MAX_SHARD_LEN ||
+        hdr.index >= hdr.k + hdr.m || parity != (hdr.index >= hdr.k) || shard_bytes > hdr.shard_len ||
+        (parity && (shard_bytes != hdr.shard_len || hdr.data_count == 0 || hdr.data_count > hdr.k)) ||
+        (!parity && hdr.data_count != 0 && hdr.data_count != hdr.index + 1)) {
+        count_malformed();
+        return true;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    switch_setting(hdr.k, hdr.m, now_us);
+    if (current >= 0) {
+        portENTER_CRITICAL(&fec_lock);
+        settings[current].last_us = now_us;
+        if (parity) {
+            settings[current].s.parity_received++;
+        }
+        portEXIT_CRITICAL(&fec_lock);
+    }
+
+    int si = slot_for_group(&hdr);
+    if (si < 0) {
+        portENTER_CRITICAL(&fec_lock);
+        late_frames++;
+        portEXIT_CRITICAL(&fec_lock);
+        return true;
+    }
+    slot_t *slot = &slots[si];
+    if (hdr.shard_len != slot->shard_len) {
+        count_malformed();
+        return true;
+    }
+    if (slot->present & (1UL << hdr.index)) {
+        portENTER_CRITICAL(&fec_lock);
+        duplicates++;
+        portEXIT_CRITICAL(&fec_lock);
+        return true;
+    }
+
+    uint8_t *shard = shard_buf[si][hdr.index];
+    memcpy(shard, data + FEC_HEADER_LEN, shard_bytes);
+    memset(shard + shard_bytes, 0, slot->shard_len - shard_bytes);
+    slot->present |= 1UL << hdr.index;
+
+    if (hdr.data_count != 0) {
+        slot->data_count = hdr.data_count;  // parity ya da grubun son veri çerçevesi
+    }
+    if (!parity) {
+        deliver_shard(slot, shard, hdr.index, false);
+    }
+    slot_try_decode(si);
+    return true;
+}
+
+int espnow_fec_get_stats(fec_stats_t *out, int max) {
+    portENTER_CRITICAL(&fec_lock);
+    int n = setting_count < max ? setting_count : max;
+    for (int i = 0; i < n; i++) {
+        out[i] = settings[i].s;
+        if (i == current) {
+            out[i].active_us += settings[i].last_us - settings[i].stint_start_us;
+        }
+    }
+    portEXIT_CRITICAL(&fec_lock);
+    return n;
+}
+
+void espnow_fec_print_stats(const char *tag) {
+    fec_stats_t st[FEC_STATS_SETTINGS];
+    int n = espnow_fec_get_stats(st, FEC_STATS_SETTINGS);
+
+    portENTER_CRITICAL(&fec_lock);
+    uint32_t late = late_frames, dup = duplicates, bad = malformed;
+    portEXIT_CRITICAL(&fec_lock);
+
+    ESP_LOGI(tag, "FEC: %d ayar, %lu geç, %lu tekrar, %lu bozuk çerçeve", n, (unsigned long)late, (unsigned long)dup,
+             (unsigned long)bad);
+    printf("%-7s | %7s | %6s | %11s | %10s | %13s | %13s | %9s | %10s\n", "K+M", "ek yük", "grup", "ham kayıp %",
+           "kurtarılan", "kalan kayıp %", "kurtarılamayan", "KB/s", "çözme (us)");
+    for (int i = 0; i < n; i++) {
+        const fec_stats_t *s = &st[i];
+        uint32_t got = s->received + s->recovered;
+        double raw_loss = s->expected > 0 ? (s->expected - s->received) * 100.0 / s->expected : 0.0;
+        double residual = s->expected > 0 && s->expected > got ? (s->expected - got) * 100.0 / s->expected : 0.0;
+        double goodput = s->active_us > 0 ? s->bytes / 1024.0 / (s->active_us / 1000000.0) : 0.0;
+        char km[8];
+        snprintf(km, sizeof(km), "%u+%u", s->k, s->m);
+
+        printf("%-7s | %6.1f%% | %6lu | %11.2f | %10lu | %13.3f | %13lu | %9.2f | %10lu\n", km, s->m * 100.0 / s->k,
+               (unsigned long)s->groups, raw_loss, (unsigned long)s->recovered, residual, (unsigned long)s->unrecoverable,
+               goodput, (unsigned long)s->decode_max_us);
+    }
+}
@@ -0,0 +1,134 @@
+/**
+ * Broadcast ESP-NOW akışları için ileri hata düzeltme (FEC).
+ *
+ * Broadcast çerçevelerde MAC ACK'i ve yeniden deneme yoktur, havada kaybolan
+ * çerçeve kaybolmuş olarak kalır; alıcı sayısı arttıkça alıcı başına tekrar
+ * isteği (ARQ) de ölçeklenmez. Bu katman ardışık K veri çerçevesini bir grupta
+ * toplar ve gruba M parity çerçevesi ekler. Alıcı grubun K + M çerçevesinden
+ * herhangi K tanesini aldıysa eksik veri çerçevelerini tekrar istemeden yeniden
+ * oluşturur.
+ *
+ * Kod GF(2^8) üzerinde sistematik Reed-Solomon'dur (Cauchy matrisi): veri
+ * çerçeveleri olduğu gibi gider, parity j = toplam C[j][i] * veri i. Matrisin
+ * ilk satırı 1'lere ölçeklenmiştir, yani M = 1 düz XOR parity'dir. Her parça
+ * (shard) 2 baytlık yük uzunluğu + yük + sıfır dolgudan oluşur; kısa veri
+ * çerçeveleri dolgu olmadan gönderilir, alıcı dolguyu kendisi ekler.
+ *
+ * Gönderici veri çerçevelerini gönderirken parity'yi artımlı biriktirir; grup
+ * dolunca (ya da espnow_fec_encode_last / espnow_fec_close_group ile erken
+ * kapatılınca) parity çerçeveleri espnow_fec_next_parity ile alınıp gönderilir.
+ * Erken kapatılan grupta eksik veri indeksleri sıfır parça sayılır. Alıcı
+ * grubun veri sayısını parity başlığından ya da espnow_fec_encode_last'in
+ * işaretlediği son veri çerçevesinden öğrenir; ikisi de gelmezse grup tam (K)
+ * sayılır.
+ *
+ * Alıcı tek bir göndericiyi dinler. Veri çerçeveleri geldiği anda teslim edilir,
+ * kurtarılanlar grup çözülebilir hale geldiği anda. FEC_RX_GROUPS grup aynı anda
+ * açık tutulur; yeni bir grup eski grubun yerini aldığında eski grup kapatılıp
+ * sayılır, hiç çerçevesi gelmeyen gruplar grup numarasındaki boşluktan bulunur.
+ * İstatistikler (K, M) ayarı başına tutulur, böylece gönderici ayarları sırayla
+ * değiştirirken tek tabloda ham kayıp, kalan kayıp ve etkin goodput karşılaştırılır.
+ * Teslim callback'i ve çözme işlemi recv_cb içinde (Wi-Fi task'ında) çalışır;
+ * en uzun çözme süresi tabloda raporlanır.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_now.h"
+#include "espnow_msg_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FEC_DATA                ESPNOW_MSG_FEC_DATA
+#define FEC_PARITY              ESPNOW_MSG_FEC_PARITY
+
+#define FEC_HEADER_LEN          9       // fec_hdr_t, paketli
+#define FEC_LEN_PREFIX          2       // her parçanın başındaki yük uzunluğu
+#define FEC_MAX_K               16
+#define FEC_MAX_M               4
+#define FEC_MAX_SHARD_LEN       1024    // alıcı tamponu: FEC_RX_GROUPS * (K + M) * bu boyut
+#define FEC_MAX_PAYLOAD         (FEC_MAX_SHARD_LEN - FEC_LEN_PREFIX)
+#define FEC_RX_GROUPS           2       // aynı anda açık tutulan grup sayısı
+#define FEC_STATS_SETTINGS      8       // istatistik tutulan farklı (K, M) ayarı sayısı
+
+/* payload_len baytlık yük taşıyan veri çerçevesinin boyutu */
+#define FEC_FRAME_LEN(payload_len) (FEC_HEADER_LEN + FEC_LEN_PREFIX + (payload_len))
+
+typedef struct {
+    uint8_t k;
+    uint8_t m;
+    uint16_t shard_len;                 // FEC_LEN_PREFIX + en büyük yük
+    uint16_t group;
+    uint8_t data_count;                 // bu grupta gönderilen veri çerçevesi
+    uint8_t parity_next;                // sıradaki parity indeksi; m ise bekleyen parity yok
+    bool closed;                        // grup kapandı, parity'ler gönderiliyor
+    uint32_t data_frames;               // toplam
+    uint32_t parity_frames;
+    uint8_t parity[FEC_MAX_M][FEC_MAX_SHARD_LEN];
+} fec_encoder_t;
+
+typedef struct {
+    uint8_t k;
+    uint8_t m;
+    uint32_t groups;                    // kapatılan gruplar (tamamen kaybolanlar dahil)
+    uint32_t lost_groups;               // hiç çerçevesi gelmeyen gruplar
+    uint32_t unrecoverable;             // kapatıldığında hâlâ eksik verisi olan gruplar
+    uint32_t expected;                  // kapatılan gruplarda gönderilen veri çerçevesi
+    uint32_t received;                  // doğrudan alınan veri çerçevesi
+    uint32_t recovered;                 // parity'den yeniden oluşturulan veri çerçevesi
+    uint32_t parity_received;
+    uint64_t bytes;                     // uygulamaya teslim edilen yük baytı (kurtarılanlar dahil)
+    int64_t active_us;                  // bu ayarla çerçeve alınan toplam süre
+    uint32_t decode_max_us;
+} fec_stats_t;
+
+/* Alıcıya teslim edilen her veri çerçevesi için çağrılır; recovered: parity'den oluşturuldu */
+typedef void (*fec_deliver_cb_t)(const uint8_t *payload, size_t len, uint16_t group, uint8_t index, bool recovered);
+
+/**
+ * Göndericiyi k veri + m parity'lik gruplar ve en fazla max_payload baytlık yük
+ * için hazırlar. m = 0 FEC'siz karşılaştırma içindir. Grup numarası 0'dan başlar.
+ */
+esp_err_t espnow_fec_encoder_init(fec_encoder_t *enc, uint8_t k, uint8_t m, uint16_t max_payload);
+
+/**
+ * payload'ı sıradaki veri çerçevesi olarak frame'e yazar (en az
+ * FEC_FRAME_LEN(max_payload) bayt) ve çerçeve boyutunu döner. Bekleyen parity
+ * varsa ya da len max_payload'dan büyükse 0 döner.
+ */
+size_t espnow_fec_encode_data(fec_encoder_t *enc, const void *payload, size_t len, uint8_t *frame);
+
+/* Kapanmış grubun sıradaki parity çerçevesini frame'e yazar; bekleyen parity yoksa 0 döner */
+size_t espnow_fec_next_parity(fec_encoder_t *enc, uint8_t *frame);
+
+/**
+ * espnow_fec_encode_data gibi, ancak çerçeveyi grubun son veri çerçevesi olarak
+ * işaretler ve grubu kapatır (ör. test aşaması biterken). K+0 ayarında ya da
+ * parity'lerin hepsi kaybolduğunda alıcı kısa grubu bu işaretten tanır.
+ */
+size_t espnow_fec_encode_last(fec_encoder_t *enc, const void *payload, size_t len, uint8_t *frame);
+
+/* Dolmamış grubu erken kapatır (ör. test aşaması biterken); parity'ler espnow_fec_next_parity ile alınır */
+void espnow_fec_close_group(fec_encoder_t *enc);
+
+/* Alıcı tarafı: durumu ve istatistikleri sıfırlar. recv_cb kaydından önce çağrılır. */
+esp_err_t espnow_fec_decoder_init(fec_deliver_cb_t deliver);
+
+/* Alıcı recv_cb'sinin başında çağrılır; FEC çerçevesiyse işler ve true döner */
+bool espnow_fec_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
+
+/* (K, M) ayarı başına istatistikleri out'a kopyalar, ayar sayısını döner */
+int espnow_fec_get_stats(fec_stats_t *out, int max);
+
+/* Ayar başına ham kayıp, kurtarılan, kalan kayıp ve etkin goodput tablosu */
+void espnow_fec_print_stats(const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
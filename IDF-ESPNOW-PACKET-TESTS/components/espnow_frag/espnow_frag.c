@@ -0,0 +1,319 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "espnow_frag.h"
+
+#define FRAG_RECENT     4       // geç gelen tekrarları ayıklamak için hatırlanan tamamlanmış mesaj sayısı
+
+static const char *TAG = "FRAG";
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t msg_id;
+    uint16_t index;
+    uint16_t count;
+    uint16_t frag_size;     // son parça hariç her parçanın yük boyutu; parçanın tampondaki yeri index * frag_size
+    uint32_t total_len;
+} frag_hdr_t;
+
+_Static_assert(sizeof(frag_hdr_t) == FRAG_HEADER_LEN, "FRAG_HEADER_LEN frag_hdr_t ile uyuşmuyor");
+
+typedef enum {
+    SLOT_FREE,
+    SLOT_ASSEMBLING,        // yalnızca recv_cb (Wi-Fi task) yazar
+    SLOT_READY,             // kuyrukta ya da uygulamada, espnow_frag_release bekliyor
+} slot_state_t;
+
+typedef struct {
+    slot_state_t state;
+    uint8_t src[ESP_NOW_ETH_ALEN];
+    uint16_t msg_id;
+    uint16_t count;
+    uint16_t frag_size;
+    uint32_t total_len;
+    uint16_t received;
+    uint32_t bitmap[FRAG_MAX_FRAGMENTS / 32];
+    int64_t first_us;
+    int64_t last_us;
+} slot_t;
+
+typedef struct {
+    uint8_t src[ESP_NOW_ETH_ALEN];
+    uint16_t msg_id;
+    bool valid;
+} recent_t;
+
+/* Alıcı tarafı: tamponlar başlangıçta ayrılır, çalışma sırasında malloc yapılmaz */
+static uint8_t slot_buf[FRAG_SLOTS][FRAG_MAX_MSG_LEN];
+static slot_t slots[FRAG_SLOTS];
+static recent_t recent[FRAG_RECENT];
+static int recent_head = 0;
+static QueueHandle_t ready_queue = NULL;
+
+/* Slot durumları ve istatistikler; recv_cb yazar, uygulama task'ı release ve get_stats ile erişir */
+static portMUX_TYPE frag_lock = portMUX_INITIALIZER_UNLOCKED;
+static frag_stats_t stats;
+
+/* Gönderici tarafı */
+static SemaphoreHandle_t send_sem = NULL;
+static SemaphoreHandle_t send_mutex = NULL;
+static volatile bool last_send_ok = false;
+static uint16_t next_msg_id = 0;
+static uint8_t frame_buf[FRAG_MAX_FRAME_LEN];
+
+esp_err_t espnow_frag_init(void) {
+    if (ready_queue == NULL) {
+        ready_queue = xQueueCreate(FRAG_SLOTS, sizeof(frag_msg_t)); // her hazır mesaj bir slot tuttuğu için kuyruk dolmaz
+        if (ready_queue == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    portENTER_CRITICAL(&frag_lock);
+    memset(slots, 0, sizeof(slots));
+    memset(recent, 0, sizeof(recent));
+    memset(&stats, 0, sizeof(stats));
+    portEXIT_CRITICAL(&frag_lock);
+    return ESP_OK;
+}
+
+void espnow_frag_on_send(esp_now_send_status_t status) {
+    if (send_sem == NULL) {
+        return;
+    }
+    last_send_ok = (status == ESP_NOW_SEND_SUCCESS);
+    xSemaphoreGive(send_sem);
+}
+
+/* Tek bir parçayı gönderir ve send_cb'sini bekler; başarısızsa FRAG_SEND_RETRIES kez tekrar dener */
+static esp_err_t send_frame(const uint8_t *peer_addr, size_t frame_len) {
+    for (int attempt = 0; attempt <= FRAG_SEND_RETRIES; attempt++) {
+        xSemaphoreTake(send_sem, 0); // önceki gönderimlerden kalmış bildirim
+        esp_err_t err = esp_now_send(peer_addr, frame_buf, frame_len);
+        if (err == ESP_ERR_ESPNOW_NO_MEM) {
+            vTaskDelay(1); // Wi-Fi kuyruğu dolu, başka bir task da gönderiyor
+            continue;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (xSemaphoreTake(send_sem, pdMS_TO_TICKS(FRAG_SEND_TIMEOUT_MS)) == pdTRUE && last_send_ok) {
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t espnow_frag_send(const uint8_t *peer_addr, const void *data, size_t len, size_t frame_len) {
+    if (data == NULL || len == 0 || len > FRAG_MAX_MSG_LEN || frame_len <= FRAG_HEADER_LEN || frame_len > FRAG_MAX_FRAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t frag_size = frame_len - FRAG_HEADER_LEN;
+    size_t count = (len + frag_size - 1) / frag_size;
+    if (count > FRAG_MAX_FRAGMENTS) {
+        ESP_LOGE(TAG, "%u byte'lık mesaj %u byte'lık parçalarla %d parçaya sığmıyor", len, frag_size, FRAG_MAX_FRAGMENTS);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (send_mutex == NULL) {
+        send_sem = xSemaphoreCreateBinary();
+        send_mutex = xSemaphoreCreateMutex();
+    }
+    xSemaphoreTake(send_mutex, portMAX_DELAY);
+
+    frag_hdr_t hdr = {
+        .type = FRAG_DATA,
+        .msg_id = next_msg_id++,
+        .count = count,
+        .frag_size = frag_size,
+        .total_len = len,
+    };
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; i < count && err == ESP_OK; i++) {
+        size_t offset = i * frag_size;
+        size_t chunk = (len - offset < frag_size) ? len - offset : frag_size;
+        hdr.index = i;
+        memcpy(frame_buf, &hdr, sizeof(hdr));
+        memcpy(frame_buf + sizeof(hdr), (const uint8_t *)data + offset, chunk);
+        err = send_frame(peer_addr, sizeof(hdr) + chunk);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Mesaj %u, parça %u/%u gönderilemedi: %s", hdr.msg_id, i + 1, count, esp_err_to_name(err));
+        }
+    }
+
+    xSemaphoreGive(send_mutex);
+    return err;
+}
+
+static bool recent_contains(const uint8_t *src, uint16_t msg_id) {
+    for (int i = 0; i < FRAG_RECENT; i++) {
+        if (recent[i].valid && recent[i].msg_id == msg_id && memcmp(recent[i].src, src, ESP_NOW_ETH_ALEN) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* frag_lock altında çağrılır */
+static void expire_slots(int64_t now) {
+    for (int i = 0; i < FRAG_SLOTS; i++) {
+        if (slots[i].state == SLOT_ASSEMBLING && now - slots[i].last_us > (int64_t)FRAG_TIMEOUT_MS * 1000) {
+            slots[i].state = SLOT_FREE;
+            stats.timeouts++;
+        }
+    }
+}
+
+/* Başlığın kendi içinde ve FRAG_MAX_MSG_LEN ile tutarlı olduğunu, payload_len'in indekse uyduğunu kontrol eder */
+static bool header_valid(const frag_hdr_t *hdr, int payload_len) {
+    if (hdr->count == 0 || hdr->count > FRAG_MAX_FRAGMENTS || hdr->index >= hdr->count || hdr->frag_size == 0) {
+        return false;
+    }
+    if (hdr->total_len == 0 || hdr->total_len > FRAG_MAX_MSG_LEN) {
+        return false;
+    }
+    uint32_t head_len = (uint32_t)(hdr->count - 1) * hdr->frag_size; // son parçadan önceki byte'lar
+    if (head_len >= hdr->total_len || hdr->total_len - head_len > hdr->frag_size) {
+        return false;
+    }
+    uint32_t expected = (hdr->index == hdr->count - 1) ? hdr->total_len - head_len : hdr->frag_size;
+    return (uint32_t)payload_len == expected;
+}
+
+bool espnow_frag_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (len < FRAG_HEADER_LEN || data[0] != FRAG_DATA) {
+        return false;
+    }
+    if (ready_queue == NULL) {
+        return true; // espnow_frag_init çağrılmamış; parçalar sessizce atılır
+    }
+
+    frag_hdr_t hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+    int payload_len = len - FRAG_HEADER_LEN;
+    const uint8_t *src = recv_info->src_addr;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&frag_lock);
+    if (!header_valid(&hdr, payload_len)) {
+        stats.malformed++;
+        portEXIT_CRITICAL(&frag_lock);
+        return true;
+    }
+    expire_slots(now);
+    if (recent_contains(src, hdr.msg_id)) {
+        stats.duplicates++; // tamamlanmış mesajın geç gelen tekrarı; yeni bir slot açmamalı
+        portEXIT_CRITICAL(&frag_lock);
+        return true;
+    }
+
+    slot_t *slot = NULL;
+    int s;
+    for (s = 0; s < FRAG_SLOTS; s++) {
+        if (slots[s].state == SLOT_ASSEMBLING && slots[s].msg_id == hdr.msg_id &&
+            memcmp(slots[s].src, src, ESP_NOW_ETH_ALEN) == 0) {
+            slot = &slots[s];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        for (s = 0; s < FRAG_SLOTS; s++) {
+            if (slots[s].state == SLOT_FREE) {
+                slot = &slots[s];
+                memset(slot, 0, sizeof(*slot));
+                slot->state = SLOT_ASSEMBLING;
+                memcpy(slot->src, src, ESP_NOW_ETH_ALEN);
+                slot->msg_id = hdr.msg_id;
+                slot->count = hdr.count;
+                slot->frag_size = hdr.frag_size;
+                slot->total_len = hdr.total_len;
+                slot->first_us = now;
+                break;
+            }
+        }
+    }
+    if (slot == NULL) {
+        stats.no_slot++;
+        portEXIT_CRITICAL(&frag_lock);
+        return true;
+    }
+    if (slot->count != hdr.count || slot->frag_size != hdr.frag_size || slot->total_len != hdr.total_len) {
+        stats.malformed++; // aynı kimlikle farklı geometri: gönderici yeniden başlamış olabilir, eski mesaj zaman aşımıyla düşer
+        portEXIT_CRITICAL(&frag_lock);
+        return true;
+    }
+    uint32_t bit = 1UL << (hdr.index % 32);
+    if (slot->bitmap[hdr.index / 32] & bit) {
+        stats.duplicates++;
+        portEXIT_CRITICAL(&frag_lock);
+        return true;
+    }
+    slot->bitmap[hdr.index / 32] |= bit;
+    slot->received++;
+    slot->last_us = now;
+    stats.fragments++;
+    bool complete = (slot->received == slot->count);
+    portEXIT_CRITICAL(&frag_lock);
+
+    // ASSEMBLING slotlara yalnızca bu task yazdığı için kopya kilit dışında yapılır
+    memcpy(slot_buf[s] + (size_t)hdr.index * hdr.frag_size, data + FRAG_HEADER_LEN, payload_len);
+
+    if (complete) {
+        frag_msg_t msg = {
+            .msg_id = slot->msg_id,
+            .data = slot_buf[s],
+            .len = slot->total_len,
+            .elapsed_us = now - slot->first_us,
+            .slot = s,
+        };
+        memcpy(msg.src_addr, slot->src, ESP_NOW_ETH_ALEN);
+
+        portENTER_CRITICAL(&frag_lock);
+        slot->state = SLOT_READY;
+        memcpy(recent[recent_head].src, slot->src, ESP_NOW_ETH_ALEN);
+        recent[recent_head].msg_id = slot->msg_id;
+        recent[recent_head].valid = true;
+        recent_head = (recent_head + 1) % FRAG_RECENT;
+        stats.messages++;
+        stats.bytes += slot->total_len;
+        portEXIT_CRITICAL(&frag_lock);
+
+        xQueueSend(ready_queue, &msg, 0);
+    }
+    return true;
+}
+
+bool espnow_frag_receive(frag_msg_t *msg, TickType_t timeout) {
+    if (ready_queue == NULL) {
+        return false;
+    }
+    return xQueueReceive(ready_queue, msg, timeout) == pdTRUE;
+}
+
+void espnow_frag_release(const frag_msg_t *msg) {
+    if (msg->slot < 0 || msg->slot >= FRAG_SLOTS) {
+        return;
+    }
+    portENTER_CRITICAL(&frag_lock);
+    if (slots[msg->slot].state == SLOT_READY) {
+        slots[msg->slot].state = SLOT_FREE;
+    }
+    portEXIT_CRITICAL(&frag_lock);
+}
+
+void espnow_frag_get_stats(frag_stats_t *out) {
+    portENTER_CRITICAL(&frag_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&frag_lock);
+}
+
+void espnow_frag_log_stats(const char *tag) {
+    frag_stats_t s;
+    espnow_frag_get_stats(&s);
+    ESP_LOGI(tag, "Parçalama: %lu mesaj (%lu byte), %lu parça, %lu tekrar, %lu zaman aşımı, %lu tampon yok, %lu bozuk",
+             s.messages, s.bytes, s.fragments, s.duplicates, s.timeouts, s.no_slot, s.malformed);
+}
@@ -0,0 +1,97 @@
+/**
+ * ESP-NOW üzerinden tek bir çerçeveye sığmayan mesajlar için parçalama ve
+ * yeniden birleştirme.
+ *
+ * Gönderici mesajı eşit boyutlu parçalara böler (sonuncusu kısa olabilir); her
+ * parçanın başına mesaj kimliği, parça indeksi, parça sayısı, parça boyutu ve
+ * toplam uzunluk yazılır. Parçalar sırayla gönderilir ve bir sonraki parça için
+ * send_cb beklenir; böylece Wi-Fi kuyruğu taşmaz (ESP_ERR_ESPNOW_NO_MEM).
+ *
+ * Alıcı parçaları önceden ayrılmış FRAG_SLOTS adet FRAG_MAX_MSG_LEN'lik
+ * tampondan birine (gönderen MAC + mesaj kimliği) doğrudan yerine kopyalar;
+ * hangi parçaların geldiği bir bitmap'te tutulur, tekrar gelen parçalar sayılıp
+ * atılır. Tamamlanan mesaj bir kuyruğa konur ve uygulama task'ı onu
+ * espnow_frag_receive ile alıp işi bitince espnow_frag_release ile tamponu geri
+ * verir; yani flash'a yazma gibi uzun işler Wi-Fi task'ını bloklamaz.
+ * FRAG_TIMEOUT_MS boyunca yeni parçası gelmeyen eksik mesajlar atılır. Zaman
+ * aşımı yeni bir parça geldiğinde kontrol edilir; trafik yokken bekleyen eksik
+ * mesaj yalnızca tamponunu tutar.
+ *
+ * Projeler kendi callback'lerinden espnow_frag_on_send ve espnow_frag_on_recv'i
+ * çağırır; on_recv true dönerse paket parçalama katmanına aittir.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_now.h"
+#include "espnow_msg_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAG_DATA               ESPNOW_MSG_FRAG_DATA
+
+#define FRAG_HEADER_LEN         13      // frag_hdr_t, paketli
+#define FRAG_MAX_FRAME_LEN      1470    // ESP-NOW v2'nin izin verdiği en büyük çerçeve
+#define FRAG_MAX_MSG_LEN        8192    // bir mesajın en büyük boyutu, alıcı tampon boyutu
+#define FRAG_MAX_FRAGMENTS      256     // bitmap boyutu; parça boyutu en az FRAG_MAX_MSG_LEN / 256 olur
+#define FRAG_SLOTS              2       // aynı anda birleştirilebilen mesaj sayısı
+#define FRAG_TIMEOUT_MS         1000    // bu süre boyunca parçası gelmeyen eksik mesaj atılır
+#define FRAG_SEND_RETRIES       3       // send_cb başarısız dönen parça bu kadar tekrar gönderilir
+#define FRAG_SEND_TIMEOUT_MS    100     // bir parçanın send_cb'si için bekleme süresi
+
+typedef struct {
+    uint8_t src_addr[ESP_NOW_ETH_ALEN];
+    uint16_t msg_id;
+    const uint8_t *data;                // espnow_frag_release çağrılana kadar geçerli
+    size_t len;
+    int64_t elapsed_us;                 // ilk parçadan son parçaya kadar geçen süre
+    int slot;
+} frag_msg_t;
+
+typedef struct {
+    uint32_t messages;                  // tamamlanan mesajlar
+    uint32_t bytes;                     // tamamlanan mesajlardaki toplam byte
+    uint32_t fragments;                 // kabul edilen parçalar
+    uint32_t duplicates;                // daha önce gelmiş parçalar ya da tamamlanmış mesajın parçaları
+    uint32_t timeouts;                  // zaman aşımıyla atılan eksik mesajlar
+    uint32_t no_slot;                   // boş tampon olmadığı için atılan parçalar
+    uint32_t malformed;                 // başlığı tutarsız ya da FRAG_MAX_MSG_LEN'den büyük mesaj parçaları
+} frag_stats_t;
+
+/* Alıcı tarafı: tamponları ve tamamlanan mesaj kuyruğunu hazırlar. recv_cb kaydından önce çağrılır. */
+esp_err_t espnow_frag_init(void);
+
+/**
+ * Gönderici tarafı: data'yı frame_len'lik (başlık dahil) çerçevelere bölüp
+ * peer_addr'e gönderir, tüm parçalar gidene kadar bloklar. peer_addr peer
+ * olarak eklenmiş olmalı, projenin send_cb'si espnow_frag_on_send'i çağırmalıdır.
+ * Her çağrı yeni bir mesaj kimliği kullanır; aynı anda tek mesaj gönderilir.
+ */
+esp_err_t espnow_frag_send(const uint8_t *peer_addr, const void *data, size_t len, size_t frame_len);
+
+/* Gönderici send_cb'sinden çağrılır */
+void espnow_frag_on_send(esp_now_send_status_t status);
+
+/* Alıcı recv_cb'sinin başında çağrılır; parça paketiyse işler ve true döner */
+bool espnow_frag_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
+
+/* Tamamlanan bir mesajı bekler; timeout dolarsa false döner */
+bool espnow_frag_receive(frag_msg_t *msg, TickType_t timeout);
+
+/* espnow_frag_receive ile alınan mesajın tamponunu yeni mesajlar için serbest bırakır */
+void espnow_frag_release(const frag_msg_t *msg);
+
+void espnow_frag_get_stats(frag_stats_t *out);
+
+void espnow_frag_log_stats(const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,117 @@
+/**
+ * ESP-NOW çerçevelerinin ilk baytındaki tip kodlarının tek kaydı.
+ *
+ * Testler ve bileşenler aynı kanalda birlikte çalışır; alıcı bir çerçeveyi ilk
+ * baytına bakarak ilgili bileşene yönlendirir. Bu yüzden her tip kodu burada
+ * tanımlanır, bileşen başlıkları kendi adlarını bu değerlere bağlar. Yeni bir
+ * kod eklenirken aşağıdaki sıra zincirine de eklenmelidir: kodlar artan sırada
+ * zincirlendiği için iki kodun çakışması derleme hatası verir.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Temel testler (ACK-DUAL, BUTTON, BROADCAST, COUNTER, TIMED); BROADCAST'in STRT_REQUEST'i 0x01'dir */
+#define ESPNOW_MSG_ACK_REQUEST              0x01
+#define ESPNOW_MSG_ACK_RESPONSE             0x02
+#define ESPNOW_MSG_STOP_REQUEST             0x03
+#define ESPNOW_MSG_CONT_REQUEST             0x04
+
+/* espnow_phy_sweep */
+#define ESPNOW_MSG_PHY_SWEEP_CELL_START     0x10
+#define ESPNOW_MSG_PHY_SWEEP_CELL_ACK       0x11
+#define ESPNOW_MSG_PHY_SWEEP_DATA           0x12
+#define ESPNOW_MSG_PHY_SWEEP_CELL_END       0x13
+#define ESPNOW_MSG_PHY_SWEEP_CELL_REPORT    0x14
+
+/* BROADCAST-THROUGHPUT-TEST fan-out modu */
+#define ESPNOW_MSG_FANOUT_WINDOW_END        0x20
+#define ESPNOW_MSG_FANOUT_REPORT            0x21
+
+/* espnow_timesync */
+#define ESPNOW_MSG_TIMESYNC_REQUEST         0x30
+#define ESPNOW_MSG_TIMESYNC_RESPONSE        0x31
+
+/* espnow_frag */
+#define ESPNOW_MSG_FRAG_DATA                0x40
+
+/* espnow_stream */
+#define ESPNOW_MSG_STREAM_DATA              0x50
+#define ESPNOW_MSG_STREAM_ACK               0x51
+#define ESPNOW_MSG_STREAM_PROBE             0x52
+
+/* espnow_fec */
+#define ESPNOW_MSG_FEC_DATA                 0x60
+#define ESPNOW_MSG_FEC_PARITY               0x61
+
+/* espnow_compress */
+#define ESPNOW_MSG_COMPRESS_RAW             0x70
+#define ESPNOW_MSG_COMPRESS_LZ4             0x71
+
+/* espnow_chan_survey */
+#define ESPNOW_MSG_CHAN_SURVEY_START        0x80
+#define ESPNOW_MSG_CHAN_SURVEY_ACK          0x81
+#define ESPNOW_MSG_CHAN_SURVEY_REPORT_REQ   0x82
+#define ESPNOW_MSG_CHAN_SURVEY_REPORT       0x83
+#define ESPNOW_MSG_CHAN_SWITCH              0x84
+#define ESPNOW_MSG_CHAN_SWITCH_ACK          0x85
+#define ESPNOW_MSG_CHAN_CONFIRM             0x86
+#define ESPNOW_MSG_CHAN_CONFIRM_ACK         0x87
+
+/* HOST-SIM-BENCH */
+#define ESPNOW_MSG_ROUND_END                0x90
+#define ESPNOW_MSG_ROUND_REPORT             0x91
+
+/* espnow_secure */
+#define ESPNOW_MSG_SECURE_SWITCH            0xA0
+#define ESPNOW_MSG_SECURE_SWITCH_ACK        0xA1
+
+/* Veri çerçevelerinin sabit ilk baytı (BROADCAST, BUTTON, TIMED, HOST-SIM-BENCH) */
+#define ESPNOW_MSG_DATA_MARKER              0xAA
+
+#ifdef __cplusplus
+#define ESPNOW_MSG_ORDER(a, b) static_assert((a) < (b), #a " < " #b)
+#else
+#define ESPNOW_MSG_ORDER(a, b) _Static_assert((a) < (b), #a " < " #b)
+#endif
+
+ESPNOW_MSG_ORDER(ESPNOW_MSG_ACK_REQUEST,              ESPNOW_MSG_ACK_RESPONSE);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_ACK_RESPONSE,             ESPNOW_MSG_STOP_REQUEST);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_STOP_REQUEST,             ESPNOW_MSG_CONT_REQUEST);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_CONT_REQUEST,             ESPNOW_MSG_PHY_SWEEP_CELL_START);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_PHY_SWEEP_CELL_START,     ESPNOW_MSG_PHY_SWEEP_CELL_ACK);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_PHY_SWEEP_CELL_ACK,       ESPNOW_MSG_PHY_SWEEP_DATA);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_PHY_SWEEP_DATA,           ESPNOW_MSG_PHY_SWEEP_CELL_END);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_PHY_SWEEP_CELL_END,       ESPNOW_MSG_PHY_SWEEP_CELL_REPORT);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_PHY_SWEEP_CELL_REPORT,    ESPNOW_MSG_FANOUT_WINDOW_END);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_FANOUT_WINDOW_END,        ESPNOW_MSG_FANOUT_REPORT);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_FANOUT_REPORT,            ESPNOW_MSG_TIMESYNC_REQUEST);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_TIMESYNC_REQUEST,         ESPNOW_MSG_TIMESYNC_RESPONSE);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_TIMESYNC_RESPONSE,        ESPNOW_MSG_FRAG_DATA);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_FRAG_DATA,                ESPNOW_MSG_STREAM_DATA);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_STREAM_DATA,              ESPNOW_MSG_STREAM_ACK);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_STREAM_ACK,               ESPNOW_MSG_STREAM_PROBE);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_STREAM_PROBE,             ESPNOW_MSG_FEC_DATA);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_FEC_DATA,                 ESPNOW_MSG_FEC_PARITY);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_FEC_PARITY,               ESPNOW_MSG_COMPRESS_RAW);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_COMPRESS_RAW,             ESPNOW_MSG_COMPRESS_LZ4);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_COMPRESS_LZ4,             ESPNOW_MSG_CHAN_SURVEY_START);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_CHAN_SURVEY_START,        ESPNOW_MSG_CHAN_SURVEY_ACK);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_CHAN_SURVEY_ACK,          ESPNOW_MSG_CHAN_SURVEY_REPORT_REQ);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_CHAN_SURVEY_REPORT_REQ,   ESPNOW_MSG_CHAN_SURVEY_REPORT);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_CHAN_SURVEY_REPORT,       ESPNOW_MSG_CHAN_SWITCH);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_CHAN_SWITCH,              ESPNOW_MSG_CHAN_SWITCH_ACK);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_CHAN_SWITCH_ACK,          ESPNOW_MSG_CHAN_CONFIRM);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_CHAN_CONFIRM,             ESPNOW_MSG_CHAN_CONFIRM_ACK);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_CHAN_CONFIRM_ACK,         ESPNOW_MSG_ROUND_END);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_ROUND_END,                ESPNOW_MSG_ROUND_REPORT);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_ROUND_REPORT,             ESPNOW_MSG_SECURE_SWITCH);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_SECURE_SWITCH,            ESPNOW_MSG_SECURE_SWITCH_ACK);
+ESPNOW_MSG_ORDER(ESPNOW_MSG_SECURE_SWITCH_ACK,        ESPNOW_MSG_DATA_MARKER);
+
+#ifdef __cplusplus
+}
+#endif
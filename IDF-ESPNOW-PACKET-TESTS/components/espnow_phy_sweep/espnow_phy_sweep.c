@@ -0,0 +1,600 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "soc/soc_caps.h"
+#include "espnow_phy_sweep.h"
+
+#define PHY_SWEEP_CTRL_RETRIES      20
+#define PHY_SWEEP_CTRL_TIMEOUT_MS   50
+#define PHY_SWEEP_DRAIN_MS          100     // veri fazından sonra havadaki paketlerin bitmesi için
+
+static const char *TAG = "PHY_SWEEP";
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t cell;
+    uint8_t phymode;
+    uint8_t rate;
+    uint16_t payload_len;   // CELL_START: hücrede gönderilecek veri paketlerinin boyutu
+    uint32_t value;         // CELL_END: gönderilen paket sayısı, CELL_REPORT: alınan paket sayısı
+    int8_t rssi;            // CELL_REPORT: hücre boyunca ortalama RSSI
+    uint8_t flags;          // PHY_SWEEP_FLAG_*
+    uint8_t run;            // tarama kimliği; yeni taramanın 0. hücresi önceki taramanınkiyle karışmaz
+} phy_sweep_ctrl_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t cell;
+    uint8_t run;            // phy_sweep_ctrl_t.run; önceki taramadan havada kalan paketler sayılmaz
+    uint32_t seq;
+} phy_sweep_data_hdr_t;
+
+/**
+ * Son alan nominal alıcı hassasiyetidir (dBm). Değerler ESP32 ailesi veri
+ * sayfalarındaki tipik değerlere yakındır; SGI için LGI değeri kullanılır.
+ * Marjın mutlak değeri modüle ve antene göre değişir, hücreler arası farkı
+ * daha anlamlıdır.
+ */
+#define CELL(mode, rate, name, sens) {WIFI_PHY_MODE_##mode, WIFI_PHY_RATE_##rate, name, 0, false, false, sens}
+#define ERSU_CELL(rate, dcm, name, sens) {WIFI_PHY_MODE_HE20, WIFI_PHY_RATE_##rate, name, 0, true, dcm, sens}
+
+const phy_sweep_cell_t phy_sweep_default_cells[] = {
+    CELL(11B, 1M_L, "11B 1M", -98),
+    CELL(11B, 2M_L, "11B 2M", -96),
+    CELL(11B, 5M_L, "11B 5.5M", -93),
+    CELL(11B, 11M_L, "11B 11M", -88),
+    CELL(11G, 6M, "11G 6M", -93),
+    CELL(11G, 12M, "11G 12M", -89),
+    CELL(11G, 24M, "11G 24M", -84),
+    CELL(11G, 36M, "11G 36M", -80),
+    CELL(11G, 48M, "11G 48M", -77),
+    CELL(11G, 54M, "11G 54M", -75),
+    CELL(HT20, MCS0_LGI, "HT20 MCS0 LGI", -92),
+    CELL(HT20, MCS1_LGI, "HT20 MCS1 LGI", -88),
+    CELL(HT20, MCS2_LGI, "HT20 MCS2 LGI", -85),
+    CELL(HT20, MCS3_LGI, "HT20 MCS3 LGI", -82),
+    CELL(HT20, MCS4_LGI, "HT20 MCS4 LGI", -79),
+    CELL(HT20, MCS5_LGI, "HT20 MCS5 LGI", -75),
+    CELL(HT20, MCS6_LGI, "HT20 MCS6 LGI", -73),
+    CELL(HT20, MCS7_LGI, "HT20 MCS7 LGI", -72),
+    CELL(HT20, MCS0_SGI, "HT20 MCS0 SGI", -92),
+    CELL(HT20, MCS1_SGI, "HT20 MCS1 SGI", -88),
+    CELL(HT20, MCS2_SGI, "HT20 MCS2 SGI", -85),
+    CELL(HT20, MCS3_SGI, "HT20 MCS3 SGI", -82),
+    CELL(HT20, MCS4_SGI, "HT20 MCS4 SGI", -79),
+    CELL(HT20, MCS5_SGI, "HT20 MCS5 SGI", -75),
+    CELL(HT20, MCS6_SGI, "HT20 MCS6 SGI", -73),
+    CELL(HT20, MCS7_SGI, "HT20 MCS7 SGI", -72),
+};
+const int phy_sweep_default_cell_count = sizeof(phy_sweep_default_cells) / sizeof(phy_sweep_default_cells[0]);
+
+/* Menzilden throughput'a doğru sıralı; son iki HT20 hücresi referans içindir */
+const phy_sweep_cell_t phy_sweep_range_cells[] = {
+    CELL(LR, LORA_250K, "LR 250K", -105),
+    CELL(LR, LORA_500K, "LR 500K", -102),
+#if SOC_WIFI_HE_SUPPORT
+    ERSU_CELL(MCS0_LGI, true, "HE ERSU MCS0 DCM", -99),
+    ERSU_CELL(MCS0_LGI, false, "HE ERSU MCS0", -96),
+    ERSU_CELL(MCS1_LGI, false, "HE ERSU MCS1", -93),
+    CELL(HE20, MCS0_LGI, "HE20 MCS0", -93),
+#endif
+    CELL(11B, 1M_L, "11B 1M", -98),
+    CELL(11B, 2M_L, "11B 2M", -96),
+    CELL(11G, 6M, "11G 6M", -93),
+    CELL(HT20, MCS0_LGI, "HT20 MCS0 LGI", -92),
+    CELL(HT20, MCS4_LGI, "HT20 MCS4 LGI", -79),
+    CELL(HT20, MCS7_LGI, "HT20 MCS7 LGI", -72),
+};
+const int phy_sweep_range_cell_count = sizeof(phy_sweep_range_cells) / sizeof(phy_sweep_range_cells[0]);
+
+/* Gönderici durumu */
+static SemaphoreHandle_t send_sem = NULL;   // veri fazında bir sonraki paketin gönderilebileceğini gösterir
+static SemaphoreHandle_t ctrl_sem = NULL;   // beklenen kontrol yanıtı geldi
+static volatile bool data_phase = false;
+static volatile uint32_t cb_ok = 0;
+static volatile uint32_t cb_fail = 0;
+static volatile uint8_t awaited_type = 0;
+static volatile uint8_t awaited_cell = 0;
+static volatile uint8_t awaited_run = 0;
+static phy_sweep_ctrl_t ctrl_reply;
+static uint8_t run_id = 0;
+
+/* Alıcı durumu */
+static int rx_active_run = -1;
+static int rx_active_cell = -1;
+static uint16_t rx_payload_len = 0;
+static uint32_t rx_received = 0;
+static uint32_t rx_len_mismatch = 0;    // anlaşılan boyuttan farklı gelen veri paketleri
+static int32_t rx_rssi_sum = 0;
+static bool rx_reported = false;
+static volatile bool lr_enabled = false;   // bu cihazda WIFI_PROTOCOL_LR açık
+
+static uint8_t cell_flags(const phy_sweep_cell_t *cell) {
+    return (cell->ersu ? PHY_SWEEP_FLAG_ERSU : 0) | (cell->dcm ? PHY_SWEEP_FLAG_DCM : 0);
+}
+
+static const phy_sweep_cell_t *find_cell(uint8_t phymode, uint8_t rate, uint8_t flags) {
+    static const phy_sweep_cell_t *const tables[] = {phy_sweep_default_cells, phy_sweep_range_cells};
+    const int counts[] = {phy_sweep_default_cell_count, phy_sweep_range_cell_count};
+    flags &= PHY_SWEEP_FLAG_ERSU | PHY_SWEEP_FLAG_DCM;
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < counts[t]; i++) {
+            const phy_sweep_cell_t *c = &tables[t][i];
+            if (c->phymode == phymode && c->rate == rate && cell_flags(c) == flags) {
+                return c;
+            }
+        }
+    }
+    return NULL;
+}
+
+static const char *cell_name(uint8_t phymode, uint8_t rate, uint8_t flags) {
+    const phy_sweep_cell_t *c = find_cell(phymode, rate, flags);
+    return c != NULL ? c->name : "?";
+}
+
+static esp_err_t set_peer_rate(const uint8_t *peer_addr, const phy_sweep_cell_t *cell) {
+    esp_now_rate_config_t rate_cfg = {0};
+    rate_cfg.phymode = cell->phymode;
+    rate_cfg.rate = cell->rate;
+    rate_cfg.ersu = cell->ersu;
+    rate_cfg.dcm = cell->dcm;
+    return esp_now_set_peer_rate_config(peer_addr, &rate_cfg);
+}
+
+static esp_err_t set_control_rate(const uint8_t *peer_addr) {
+    static const phy_sweep_cell_t control = CELL(11B, 1M_L, "11B 1M", -98);
+    return set_peer_rate(peer_addr, &control);
+}
+
+esp_err_t espnow_phy_sweep_enable_lr(wifi_interface_t ifx) {
+    uint8_t protocol = 0;
+    esp_err_t err = esp_wifi_get_protocol(ifx, &protocol);
+    if (err == ESP_OK && !(protocol & WIFI_PROTOCOL_LR)) {
+        err = esp_wifi_set_protocol(ifx, protocol | WIFI_PROTOCOL_LR);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "LR protokolü açılamadı: %s", esp_err_to_name(err));
+        return err;
+    }
+    lr_enabled = true;
+    ESP_LOGI(TAG, "LR protokolü açık (protokol listesi 0x%02x)", protocol | WIFI_PROTOCOL_LR);
+    return ESP_OK;
+}
+
+/* Alıcı tarafı: bu hücrenin çerçeveleri alınabilir mi */
+static bool cell_receivable(uint8_t phymode, uint8_t flags) {
+    if (phymode == WIFI_PHY_MODE_LR) {
+        return lr_enabled;
+    }
+#if !SOC_WIFI_HE_SUPPORT
+    if (phymode == WIFI_PHY_MODE_HE20 || (flags & PHY_SWEEP_FLAG_ERSU)) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+static bool send_ctrl_and_wait(const uint8_t *peer_addr, const phy_sweep_ctrl_t *msg, uint8_t expect_type, phy_sweep_ctrl_t *reply) {
+    for (int attempt = 0; attempt < PHY_SWEEP_CTRL_RETRIES; attempt++) {
+        awaited_type = expect_type;
+        awaited_cell = msg->cell;
+        awaited_run = msg->run;
+        xSemaphoreTake(ctrl_sem, 0);
+
+        esp_err_t err = esp_now_send(peer_addr, (const uint8_t *)msg, sizeof(phy_sweep_ctrl_t));
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Kontrol paketi gönderilemedi: %s", esp_err_to_name(err));
+        }
+        if (xSemaphoreTake(ctrl_sem, pdMS_TO_TICKS(PHY_SWEEP_CTRL_TIMEOUT_MS)) == pdTRUE) {
+            *reply = ctrl_reply;
+            awaited_type = 0;
+            return true;
+        }
+    }
+    awaited_type = 0;
+    return false;
+}
+
+static void run_data_phase(const phy_sweep_config_t *config, uint8_t cell_index, uint8_t *payload, phy_sweep_result_t *res) {
+    uint16_t payload_len = res->payload_len;
+    phy_sweep_data_hdr_t hdr = {
+        .type = PHY_SWEEP_DATA,
+        .cell = cell_index,
+        .run = run_id,
+        .seq = 0,
+    };
+
+    cb_ok = 0;
+    cb_fail = 0;
+    xSemaphoreGive(send_sem);
+    data_phase = true;
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t now = start_us;
+    while (now - start_us < config->cell_duration_ms * 1000LL) {
+        if (xSemaphoreTake(send_sem, pdMS_TO_TICKS(PHY_SWEEP_DRAIN_MS)) != pdTRUE) {
+            now = esp_timer_get_time(); // send_cb gelmedi, yeniden dene
+            continue;
+        }
+
+        hdr.seq++;
+        memcpy(payload, &hdr, sizeof(hdr));
+        esp_err_t err = esp_now_send(config->peer_addr, payload, payload_len);
+        if (err == ESP_OK) {
+            res->sent++;
+        }
+        else {
+            // TX kuyruğu dolu ya da geçici hata: paket gitmedi, send_cb gelmeyecek
+            xSemaphoreGive(send_sem);
+            vTaskDelay(1);
+        }
+        now = esp_timer_get_time();
+    }
+    res->duration_s = (now - start_us) / 1000000.0;
+
+    vTaskDelay(pdMS_TO_TICKS(PHY_SWEEP_DRAIN_MS));
+    data_phase = false;
+    res->cb_ok = cb_ok;
+    res->cb_fail = cb_fail;
+}
+
+esp_err_t espnow_phy_sweep_run(const phy_sweep_config_t *config, phy_sweep_result_t *results) {
+    if (config->cell_count > 255) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < config->cell_count; i++) {
+        uint16_t len = config->cells[i].payload_len ? config->cells[i].payload_len : config->payload_len;
+        if (len < sizeof(phy_sweep_data_hdr_t) || len > PHY_SWEEP_MAX_PAYLOAD) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+    if (send_sem == NULL) {
+        send_sem = xSemaphoreCreateBinary();
+        ctrl_sem = xSemaphoreCreateBinary();
+    }
+    uint8_t *payload = malloc(PHY_SWEEP_MAX_PAYLOAD);  // her hücre boyutuna yeten tek tampon
+    if (payload == NULL || send_sem == NULL || ctrl_sem == NULL) {
+        free(payload);
+        return ESP_ERR_NO_MEM;
+    }
+    memset(payload, 0xAA, PHY_SWEEP_MAX_PAYLOAD);
+
+    // Alıcı yeni kimliği görünce hücre durumunu sıfırlar; gönderici yeniden başlasa da aynı kimlik tekrarlanmasın
+    run_id = run_id == 0 ? (uint8_t)(esp_random() | 1) : (uint8_t)(run_id + 1);
+    esp_err_t result = ESP_OK;
+
+    for (int i = 0; i < config->cell_count; i++) {
+        phy_sweep_result_t *res = &results[i];
+        memset(res, 0, sizeof(phy_sweep_result_t));
+        res->cell = config->cells[i];
+        res->payload_len = res->cell.payload_len ? res->cell.payload_len : config->payload_len;
+
+        ESP_LOGW(TAG, "Hücre %d/%d: %s, %u byte", i + 1, config->cell_count, res->cell.name, res->payload_len);
+        result = set_control_rate(config->peer_addr);
+        if (result != ESP_OK) {
+            ESP_LOGE(TAG, "Kontrol hızı ayarlanamadı: %s", esp_err_to_name(result));
+            break;
+        }
+
+        phy_sweep_ctrl_t msg = {
+            .type = PHY_SWEEP_CELL_START,
+            .cell = (uint8_t)i,
+            .phymode = (uint8_t)res->cell.phymode,
+            .rate = (uint8_t)res->cell.rate,
+            .payload_len = res->payload_len,
+            .flags = cell_flags(&res->cell),
+            .run = run_id,
+        };
+        if (res->cell.phymode == WIFI_PHY_MODE_LR && !lr_enabled && espnow_phy_sweep_enable_lr(WIFI_IF_STA) != ESP_OK) {
+            ESP_LOGE(TAG, "LR açılamadı, hücre atlanıyor.");
+            continue;
+        }
+        phy_sweep_ctrl_t reply;
+        if (!send_ctrl_and_wait(config->peer_addr, &msg, PHY_SWEEP_CELL_ACK, &reply)) {
+            ESP_LOGE(TAG, "Alıcı hücre başlangıcını onaylamadı, hücre atlanıyor.");
+            continue;
+        }
+        if (reply.flags & PHY_SWEEP_FLAG_UNSUPPORTED) {
+            ESP_LOGE(TAG, "Alıcı bu hücreyi alamıyor (LR kapalı ya da ERSU desteklenmiyor), hücre atlanıyor.");
+            continue;
+        }
+
+        esp_err_t err = set_peer_rate(config->peer_addr, &res->cell);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Hız ayarlanamadı (%s), hücre atlanıyor.", esp_err_to_name(err));
+            continue;
+        }
+        run_data_phase(config, (uint8_t)i, payload, res);
+
+        result = set_control_rate(config->peer_addr);
+        if (result != ESP_OK) {
+            ESP_LOGE(TAG, "Kontrol hızı ayarlanamadı: %s", esp_err_to_name(result));
+            break;
+        }
+        msg.type = PHY_SWEEP_CELL_END;
+        msg.value = res->sent;
+        if (send_ctrl_and_wait(config->peer_addr, &msg, PHY_SWEEP_CELL_REPORT, &reply)) {
+            res->received = reply.value;
+            res->rssi_avg = reply.rssi;
+            res->report_ok = true;
+        }
+        else {
+            ESP_LOGE(TAG, "Alıcıdan hücre raporu alınamadı.");
+        }
+    }
+
+    free(payload);
+    return result;
+}
+
+void espnow_phy_sweep_make_size_cells(const uint16_t *sizes, int count, wifi_phy_mode_t phymode, wifi_phy_rate_t rate,
+                                      const char *rate_name, phy_sweep_cell_t *out) {
+    const phy_sweep_cell_t *known = find_cell(phymode, rate, 0);
+    for (int i = 0; i < count; i++) {
+        out[i].phymode = phymode;
+        out[i].rate = rate;
+        out[i].name = rate_name;
+        out[i].payload_len = sizes[i];
+        out[i].ersu = false;
+        out[i].dcm = false;
+        out[i].sensitivity_dbm = known != NULL ? known->sensitivity_dbm : 0;
+    }
+}
+
+static double result_goodput(const phy_sweep_result_t *r) {
+    return r->duration_s > 0 ? r->received * (r->payload_len / 1024.0) / r->duration_s : 0.0;
+}
+
+static double result_pps(const phy_sweep_result_t *r) {
+    return r->duration_s > 0 ? r->received / r->duration_s : 0.0;
+}
+
+static double result_loss(const phy_sweep_result_t *r) {
+    return r->sent > 0 ? (1.0 - (double)r->received / r->sent) * 100.0 : 0.0;
+}
+
+/* Hiç paket alınmadıysa RSSI ölçülemez */
+static bool result_margin(const phy_sweep_result_t *r, int *margin_db) {
+    if (!r->report_ok || r->received == 0 || r->cell.sensitivity_dbm == 0) {
+        return false;
+    }
+    *margin_db = r->rssi_avg - r->cell.sensitivity_dbm;
+    return true;
+}
+
+void espnow_phy_sweep_print_results(const phy_sweep_result_t *results, int count) {
+    int best = -1;
+    double best_goodput = 0;
+
+    printf("---\n");
+    ESP_LOGI(TAG, "TARAMA SONUÇLARI");
+    printf("%-16s | %5s | %8s | %8s | %7s | %9s | %8s | %12s | %5s | %7s\n",
+           "hücre", "boyut", "gönderilen", "alınan", "kayıp %", "cb hata %", "pps", "goodput KB/s", "RSSI", "marj dB");
+    for (int i = 0; i < count; i++) {
+        const phy_sweep_result_t *r = &results[i];
+        if (!r->report_ok) {
+            printf("%-16s | %5u | %8lu | %8s | %7s | %9s | %8s | %12s | %5s | %7s\n",
+                   r->cell.name, r->payload_len, (unsigned long)r->sent, "-", "-", "-", "-", "-", "-", "-");
+            continue;
+        }
+        uint32_t cb_total = r->cb_ok + r->cb_fail;
+        double cb_fail_pct = cb_total > 0 ? r->cb_fail * 100.0 / cb_total : 0.0;
+        double goodput = result_goodput(r);
+        int margin;
+        char margin_str[8] = "-";
+        if (result_margin(r, &margin)) {
+            snprintf(margin_str, sizeof(margin_str), "%d", margin);
+        }
+        printf("%-16s | %5u | %8lu | %8lu | %7.2f | %9.2f | %8.1f | %12.2f | %5d | %7s\n",
+               r->cell.name, r->payload_len, (unsigned long)r->sent, (unsigned long)r->received, result_loss(r), cb_fail_pct,
+               result_pps(r), goodput, r->rssi_avg, margin_str);
+        if (goodput > best_goodput) {
+            best_goodput = goodput;
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        ESP_LOGW(TAG, "En yüksek goodput: %s, %u byte (%.2f KB/s)", results[best].cell.name, results[best].payload_len, best_goodput);
+    }
+    printf("---\n");
+}
+
+void espnow_phy_sweep_print_range_tradeoff(const phy_sweep_result_t *results, int count) {
+    int ref = -1;
+    int ref_margin = 0;
+    for (int i = 0; i < count; i++) {
+        int margin;
+        if (result_margin(&results[i], &margin) && (ref < 0 || result_goodput(&results[i]) > result_goodput(&results[ref]))) {
+            ref = i;
+            ref_margin = margin;
+        }
+    }
+    if (ref < 0) {
+        ESP_LOGW(TAG, "Menzil karşılaştırması için RSSI'ı ölçülen hücre yok.");
+        return;
+    }
+    double ref_goodput = result_goodput(&results[ref]);
+
+    printf("---\n");
+    ESP_LOGI(TAG, "MENZİL / THROUGHPUT DENGESİ (referans: %s, %.2f KB/s, marj %d dB, yol kaybı üssü %.1f)",
+             results[ref].cell.name, ref_goodput, ref_margin, PHY_SWEEP_PATH_LOSS_EXP);
+    printf("%-16s | %12s | %7s | %7s | %10s | %11s | %12s\n",
+           "hücre", "goodput KB/s", "kayıp %", "marj dB", "ek marj dB", "goodput %", "menzil çarpanı");
+    for (int i = 0; i < count; i++) {
+        const phy_sweep_result_t *r = &results[i];
+        int margin;
+        if (!result_margin(r, &margin)) {
+            printf("%-16s | %12s | %7s | %7s | %10s | %11s | %12s\n", r->cell.name, "-", "-", "-", "-", "-", "-");
+            continue;
+        }
+        int extra = margin - ref_margin;
+        // Ek marj kadar yol kaybı d^n ile büyür: d2/d1 = 10^(ek / (10 n))
+        double range_factor = pow(10.0, extra / (10.0 * PHY_SWEEP_PATH_LOSS_EXP));
+        printf("%-16s | %12.2f | %7.2f | %7d | %+10d | %11.1f | %11.2fx\n", r->cell.name, result_goodput(r), result_loss(r),
+               margin, extra, ref_goodput > 0 ? result_goodput(r) * 100.0 / ref_goodput : 0.0, range_factor);
+    }
+    printf("(marj: ortalama RSSI - nominal hassasiyet; menzil çarpanı aynı kayıp oranında ulaşılabilecek uzaklık tahminidir)\n");
+    printf("---\n");
+}
+
+void espnow_phy_sweep_print_size_curve(const phy_sweep_result_t *results, int count) {
+    // 1/pps = T0 + L / R doğrusuna en küçük kareler ile oturt
+    double n = 0, sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+    for (int i = 0; i < count; i++) {
+        const phy_sweep_result_t *r = &results[i];
+        double pps = result_pps(r);
+        if (!r->report_ok || pps <= 0) {
+            continue;
+        }
+        double x = r->payload_len;
+        double y = 1000000.0 / pps; // paket başına us
+        n++;
+        sum_x += x;
+        sum_y += y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+    }
+
+    double denom = n * sum_xx - sum_x * sum_x;
+    if (n < 2 || denom == 0) {
+        ESP_LOGW(TAG, "Paket başı maliyet hesabı için en az iki farklı boyutta sonuç gerekli.");
+        return;
+    }
+    double slope_us_per_byte = (n * sum_xy - sum_x * sum_y) / denom;
+    double t0_us = (sum_y - slope_us_per_byte * sum_x) / n;
+
+    printf("---\n");
+    ESP_LOGI(TAG, "BOYUT EĞRİSİ: paket başına süre = %.1f us + %.3f us/byte", t0_us, slope_us_per_byte);
+    if (slope_us_per_byte > 0 && t0_us > 0) {
+        double rate_kbs = 1000000.0 / slope_us_per_byte / 1024.0;
+        double knee = t0_us / slope_us_per_byte;
+        ESP_LOGI(TAG, "Sabit paket maliyeti T0: %.1f us, asimptotik yük hızı: %.1f KB/s", t0_us, rate_kbs);
+        ESP_LOGI(TAG, "Sabit maliyet %.0f byte altında baskın (verim < %%50).", knee);
+    }
+    printf("%5s | %8s | %12s | %9s | %9s\n", "boyut", "pps", "goodput KB/s", "model us", "verim %");
+    for (int i = 0; i < count; i++) {
+        const phy_sweep_result_t *r = &results[i];
+        if (!r->report_ok) {
+            continue;
+        }
+        double model_us = t0_us + slope_us_per_byte * r->payload_len;
+        double efficiency = model_us > 0 ? slope_us_per_byte * r->payload_len / model_us * 100.0 : 0.0;
+        printf("%5u | %8.1f | %12.2f | %9.1f | %9.1f\n", r->payload_len, result_pps(r), result_goodput(r), model_us, efficiency);
+    }
+    printf("---\n");
+}
+
+void espnow_phy_sweep_on_send(esp_now_send_status_t status) {
+    if (!data_phase) {
+        return;
+    }
+    if (status == ESP_NOW_SEND_SUCCESS) {
+        cb_ok++;
+    }
+    else {
+        cb_fail++;
+    }
+    xSemaphoreGive(send_sem);
+}
+
+static void reply_to(const uint8_t *dest, const phy_sweep_ctrl_t *msg) {
+    if (!esp_now_is_peer_exist(dest)) {
+        esp_now_peer_info_t peer = {0};
+        peer.channel = 0;  // alıcının o anki kanalı
+        peer.ifidx = WIFI_IF_STA;
+        peer.encrypt = false;
+        memcpy(peer.peer_addr, dest, ESP_NOW_ETH_ALEN);
+        esp_now_add_peer(&peer);
+    }
+    esp_now_send(dest, (const uint8_t *)msg, sizeof(phy_sweep_ctrl_t));
+}
+
+bool espnow_phy_sweep_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (len < 1) {
+        return false;
+    }
+
+    switch (data[0]) {
+        case PHY_SWEEP_DATA: {
+            if (len < (int)sizeof(phy_sweep_data_hdr_t)) {
+                return true;
+            }
+            if (data[1] == rx_active_cell && data[2] == rx_active_run) {
+                if (len != rx_payload_len) {
+                    rx_len_mismatch++;
+                    return true;
+                }
+                rx_received++;
+                rx_rssi_sum += recv_info->rx_ctrl != NULL ? recv_info->rx_ctrl->rssi : 0;
+            }
+            return true;
+        }
+        case PHY_SWEEP_CELL_START:
+        case PHY_SWEEP_CELL_END: {
+            if (len != sizeof(phy_sweep_ctrl_t)) {
+                return true;
+            }
+            phy_sweep_ctrl_t msg;
+            memcpy(&msg, data, sizeof(msg));
+
+            if (msg.type == PHY_SWEEP_CELL_START) {
+                if (msg.run != rx_active_run) {
+                    rx_active_run = msg.run;    // yeni tarama
+                    rx_active_cell = -1;
+                }
+                if (msg.cell != rx_active_cell) { // tekrar gönderilen START sayaçları sıfırlamaz
+                    rx_active_cell = msg.cell;
+                    rx_payload_len = msg.payload_len;
+                    rx_received = 0;
+                    rx_len_mismatch = 0;
+                    rx_rssi_sum = 0;
+                    rx_reported = false;
+                    ESP_LOGW(TAG, "Hücre %u başlıyor: %s, %u byte", msg.cell, cell_name(msg.phymode, msg.rate, msg.flags),
+                             msg.payload_len);
+                }
+                msg.type = PHY_SWEEP_CELL_ACK;
+                if (!cell_receivable(msg.phymode, msg.flags)) {
+                    ESP_LOGW(TAG, "Hücre %u bu cihazda alınamaz (LR için espnow_phy_sweep_enable_lr gerekir).", msg.cell);
+                    msg.flags |= PHY_SWEEP_FLAG_UNSUPPORTED;
+                }
+            }
+            else {
+                if (msg.run != rx_active_run || msg.cell != rx_active_cell) {
+                    return true;
+                }
+                if (!rx_reported) {
+                    uint32_t sent = msg.value;
+                    ESP_LOGI(TAG, "Hücre %u (%s, %u byte): gönderilen %lu, alınan %lu, kayıp %%%.2f, RSSI %ld, boyut uyuşmazlığı %lu",
+                             msg.cell, cell_name(msg.phymode, msg.rate, msg.flags), rx_payload_len, (unsigned long)sent, (unsigned long)rx_received,
+                             sent > 0 ? (1.0 - (double)rx_received / sent) * 100.0 : 0.0,
+                             rx_received > 0 ? (long)(rx_rssi_sum / (int32_t)rx_received) : 0L, (unsigned long)rx_len_mismatch);
+                    rx_reported = true;
+                }
+                msg.type = PHY_SWEEP_CELL_REPORT;
+                msg.value = rx_received;
+                msg.rssi = rx_received > 0 ? (int8_t)(rx_rssi_sum / (int32_t)rx_received) : 0;
+            }
+            reply_to(recv_info->src_addr, &msg);
+            return true;
+        }
+        case PHY_SWEEP_CELL_ACK:
+        case PHY_SWEEP_CELL_REPORT: {
+            if (len == sizeof(phy_sweep_ctrl_t) && data[0] == awaited_type && data[1] == awaited_cell &&
+                ((const phy_sweep_ctrl_t *)data)->run == awaited_run) {
+                memcpy(&ctrl_reply, data, sizeof(ctrl_reply));
+                xSemaphoreGive(ctrl_sem);
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,142 @@
+/**
+ * ESP-NOW PHY mod / hız ve paket boyutu taraması.
+ *
+ * Gönderici, bir hücre matrisindeki (PHY modu + hız + paket boyutu, SGI/LGI
+ * hızın parçasıdır) her hücre için alıcıyla kontrol paketleri üzerinden anlaşır, peer hızını o
+ * hücreye ayarlar, sabit bir süre boyunca veri gönderir ve sonunda alıcıdan
+ * hücrenin alım raporunu ister. Kontrol paketleri her zaman en dayanıklı hız
+ * olan 11B 1 Mbps ile gönderilir; böylece kötü bir hücre anlaşmayı bozmaz.
+ * Paket boyutu da hücre başlangıcında anlaşıldığı için alıcının derleme
+ * zamanında sabit bir PACKET_SIZE beklemesine gerek kalmaz.
+ *
+ * Menzil profilleri (phy_sweep_range_cells) Wi-Fi Long Range (LR 250K/500K),
+ * en dayanıklı 11B/11G/HT20 hızları ve 802.11ax destekli hedeflerde HE20 ERSU
+ * (genişletilmiş menzil SU, isteğe bağlı DCM) hücrelerini içerir. LR çerçeveleri
+ * yalnızca protokol listesinde WIFI_PROTOCOL_LR olan arayüzlerde alınabildiği
+ * için alıcı espnow_phy_sweep_enable_lr'ı çağırmalıdır; gönderici LR hücresinden
+ * önce bunu kendisi yapar. Alıcı alamayacağı bir hücreyi (LR kapalı, ERSU
+ * desteklenmiyor) başlangıç onayında bildirir ve hücre atlanır.
+ *
+ * Her hücrede nominal bir alıcı hassasiyeti tutulur; raporlardaki RSSI marjı
+ * ortalama RSSI ile bu değer arasındaki farktır. Aynı yerde ölçülen iki hücrenin
+ * marj farkı, yavaş hücrenin ne kadar ek yol kaybını tolere edeceğini gösterir.
+ *
+ * Projeler kendi callback'lerinden espnow_phy_sweep_on_send ve
+ * espnow_phy_sweep_on_recv'i çağırır; on_recv true dönerse paket taramaya
+ * aittir ve projenin kendi sayımına katılmamalıdır.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+#include "esp_now.h"
+#include "espnow_msg_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PHY_SWEEP_CELL_START    ESPNOW_MSG_PHY_SWEEP_CELL_START
+#define PHY_SWEEP_CELL_ACK      ESPNOW_MSG_PHY_SWEEP_CELL_ACK
+#define PHY_SWEEP_DATA          ESPNOW_MSG_PHY_SWEEP_DATA
+#define PHY_SWEEP_CELL_END      ESPNOW_MSG_PHY_SWEEP_CELL_END
+#define PHY_SWEEP_CELL_REPORT   ESPNOW_MSG_PHY_SWEEP_CELL_REPORT
+
+/* phy_sweep_ctrl_t.flags */
+#define PHY_SWEEP_FLAG_ERSU         0x01    // CELL_START: hücre HE20 ERSU
+#define PHY_SWEEP_FLAG_DCM          0x02    // CELL_START: ERSU ile DCM
+#define PHY_SWEEP_FLAG_UNSUPPORTED  0x80    // CELL_ACK: alıcı bu hücrenin çerçevelerini alamaz
+
+/* Menzil tahmini için yol kaybı üssü: boş uzayda 2, iç mekânda tipik olarak 3-4 */
+#ifndef PHY_SWEEP_PATH_LOSS_EXP
+#define PHY_SWEEP_PATH_LOSS_EXP     2.0
+#endif
+
+typedef struct {
+    wifi_phy_mode_t phymode;
+    wifi_phy_rate_t rate;
+    const char *name;
+    uint16_t payload_len;               // 0: phy_sweep_config_t.payload_len kullanılır
+    bool ersu;                          // HE20 genişletilmiş menzil SU (yalnızca 802.11ax destekli hedefler)
+    bool dcm;                           // ERSU ile çift taşıyıcı modülasyonu
+    int8_t sensitivity_dbm;             // nominal alıcı hassasiyeti; 0 ise RSSI marjı hesaplanmaz
+} phy_sweep_cell_t;
+
+typedef struct {
+    const uint8_t *peer_addr;           // unicast alıcı ya da FF:FF:FF:FF:FF:FF
+    const phy_sweep_cell_t *cells;
+    int cell_count;
+    int cell_duration_ms;
+    uint16_t payload_len;               // hücrede boyut verilmemişse veri paketi boyutu (başlık dahil)
+} phy_sweep_config_t;
+
+typedef struct {
+    phy_sweep_cell_t cell;
+    uint16_t payload_len;               // bu hücrede kullanılan paket boyutu
+    uint32_t sent;                      // esp_now_send'in ESP_OK döndüğü paketler
+    uint32_t cb_ok;
+    uint32_t cb_fail;
+    uint32_t received;                  // alıcının raporladığı paketler
+    int8_t rssi_avg;
+    bool report_ok;                     // alıcıdan rapor alınamadıysa false
+    double duration_s;
+} phy_sweep_result_t;
+
+/* 11B, 11G ve HT20 MCS0-7 (LGI ve SGI) hızlarını içeren varsayılan matris */
+extern const phy_sweep_cell_t phy_sweep_default_cells[];
+extern const int phy_sweep_default_cell_count;
+
+/* LR, en dayanıklı 11B/11G/HT20 hızları ve (destekleniyorsa) HE20 ERSU'dan oluşan menzil profilleri */
+extern const phy_sweep_cell_t phy_sweep_range_cells[];
+extern const int phy_sweep_range_cell_count;
+
+/* ifx'in protokol listesine WIFI_PROTOCOL_LR'yi ekler; 11B/G/N çerçeveleri alınmaya devam eder */
+esp_err_t espnow_phy_sweep_enable_lr(wifi_interface_t ifx);
+
+/**
+ * Gönderici tarafı: tüm hücreleri sırayla koşturur, bloklar. results cell_count
+ * elemanlı olmalıdır. Kontrol hızı ayarlanamazsa tarama durur ve hata döner;
+ * o ana kadarki hücrelerin sonuçları results'ta kalır.
+ */
+esp_err_t espnow_phy_sweep_run(const phy_sweep_config_t *config, phy_sweep_result_t *results);
+
+/* ESP-NOW v2'nin izin verdiği en büyük boyut; en küçük boyut veri başlığıdır, run() ikisini de denetler */
+#define PHY_SWEEP_MAX_PAYLOAD   1470
+
+/**
+ * Aynı PHY modu ve hızda, sizes listesindeki her boyut için bir hücre üretir.
+ * out en az count elemanlı olmalıdır.
+ */
+void espnow_phy_sweep_make_size_cells(const uint16_t *sizes, int count, wifi_phy_mode_t phymode, wifi_phy_rate_t rate,
+                                      const char *rate_name, phy_sweep_cell_t *out);
+
+void espnow_phy_sweep_print_results(const phy_sweep_result_t *results, int count);
+
+/**
+ * Menzil/throughput dengesi: en yüksek goodput'lu hücre referans alınır ve her
+ * hücre için referansa göre ek RSSI marjı, goodput oranı ve bu marjın
+ * PHY_SWEEP_PATH_LOSS_EXP üssüyle karşılık geldiği menzil çarpanı yazdırılır.
+ */
+void espnow_phy_sweep_print_range_tradeoff(const phy_sweep_result_t *results, int count);
+
+/**
+ * Boyut taraması sonuçlarından paket başına sabit maliyeti çıkarır. Paket başına
+ * süre t(L) = T0 + L / R modeline (en küçük kareler) oturtulur: T0 sabit paket
+ * maliyeti (başlıklar, preamble, IFS, MAC ACK, yazılım), R ise yükün aktarıldığı
+ * asimptotik hızdır. L* = T0 * R boyutunda yük süresi sabit maliyete eşitlenir;
+ * bunun altındaki boyutlarda sabit maliyet baskındır.
+ */
+void espnow_phy_sweep_print_size_curve(const phy_sweep_result_t *results, int count);
+
+/* Gönderici send_cb'sinden çağrılır */
+void espnow_phy_sweep_on_send(esp_now_send_status_t status);
+
+/* Her iki tarafın recv_cb'sinden çağrılır; paket taramaya aitse true döner */
+bool espnow_phy_sweep_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "espnow_rate_ctrl.h"
+
+static const char *TAG = "RATE_CTRL";
+
+/* Yayın süresi modeli: ESP-NOW çerçeve başlıkları + sabit paket maliyeti (preamble, SIFS/DIFS, ACK, ort. backoff) */
+#define RATE_CTRL_FRAME_OVERHEAD_BYTES  50
+#define RATE_CTRL_DSSS_OVERHEAD_US      560     // 11B uzun preamble ve 1 Mbps ACK
+#define RATE_CTRL_OFDM_OVERHEAD_US      190
+
+#define RATE(mode, rate, name, mbps) {WIFI_PHY_MODE_##mode, WIFI_PHY_RATE_##rate, name, mbps}
+
+const rate_ctrl_rate_t rate_ctrl_default_rates[] = {
+    RATE(11B, 1M_L, "11B 1M", 1.0f),
+    RATE(11B, 11M_L, "11B 11M", 11.0f),
+    RATE(11G, 6M, "11G 6M", 6.0f),
+    RATE(11G, 12M, "11G 12M", 12.0f),
+    RATE(11G, 24M, "11G 24M", 24.0f),
+    RATE(HT20, MCS0_SGI, "HT20 MCS0 SGI", 7.2f),
+    RATE(HT20, MCS1_SGI, "HT20 MCS1 SGI", 14.4f),
+    RATE(HT20, MCS2_SGI, "HT20 MCS2 SGI", 21.7f),
+    RATE(HT20, MCS3_SGI, "HT20 MCS3 SGI", 28.9f),
+    RATE(HT20, MCS4_SGI, "HT20 MCS4 SGI", 43.3f),
+    RATE(HT20, MCS5_SGI, "HT20 MCS5 SGI", 57.8f),
+    RATE(HT20, MCS6_SGI, "HT20 MCS6 SGI", 65.0f),
+    RATE(HT20, MCS7_SGI, "HT20 MCS7 SGI", 72.2f),
+};
+const int rate_ctrl_default_rate_count = sizeof(rate_ctrl_default_rates) / sizeof(rate_ctrl_default_rates[0]);
+
+static double model_airtime_us(const rate_ctrl_rate_t *r, uint16_t payload_len) {
+    double overhead = r->phymode == WIFI_PHY_MODE_11B ? RATE_CTRL_DSSS_OVERHEAD_US : RATE_CTRL_OFDM_OVERHEAD_US;
+    return overhead + (payload_len + RATE_CTRL_FRAME_OVERHEAD_BYTES) * 8.0 / r->mbps;
+}
+
+double espnow_rate_ctrl_expected_kbs(const rate_ctrl_t *rc, int rate, double prob) {
+    return prob * rc->payload_len / rc->stats[rate].airtime_us * 1000000.0 / 1024.0;
+}
+
+static double current_expected_kbs(const rate_ctrl_t *rc, int rate) {
+    const rate_ctrl_stats_t *st = &rc->stats[rate];
+    return st->prob_valid ? espnow_rate_ctrl_expected_kbs(rc, rate, st->prob) : 0.0;
+}
+
+esp_err_t espnow_rate_ctrl_init(rate_ctrl_t *rc, const uint8_t *peer_addr, const rate_ctrl_rate_t *rates, int rate_count,
+                                uint16_t payload_len, int initial_rate) {
+    if (rate_count <= 0 || rate_count > RATE_CTRL_MAX_RATES || initial_rate < 0 || initial_rate >= rate_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(rc, 0, sizeof(*rc));
+    memcpy(rc->peer_addr, peer_addr, ESP_NOW_ETH_ALEN);
+    rc->rates = rates;
+    rc->rate_count = rate_count;
+    rc->payload_len = payload_len;
+    rc->best = initial_rate;
+    rc->max_prob = initial_rate;
+    rc->applied = -1;
+    rc->in_flight = -1;
+    rc->sample_cursor = esp_random() % rate_count;
+    rc->last_update_us = esp_timer_get_time();
+    for (int i = 0; i < rate_count; i++) {
+        rc->stats[i].airtime_us = model_airtime_us(&rates[i], payload_len);
+    }
+    return ESP_OK;
+}
+
+static void update_stats(rate_ctrl_t *rc) {
+    for (int i = 0; i < rc->rate_count; i++) {
+        rate_ctrl_stats_t *st = &rc->stats[i];
+        if (st->interval_attempts == 0) {
+            continue;
+        }
+        double cur = (double)st->interval_success / st->interval_attempts;
+        st->prob = st->prob_valid ? RATE_CTRL_EWMA_WEIGHT * st->prob + (1.0 - RATE_CTRL_EWMA_WEIGHT) * cur : cur;
+        st->prob_valid = true;
+        st->interval_attempts = 0;
+        st->interval_success = 0;
+    }
+
+    int best = rc->best, max_prob = rc->max_prob;
+    for (int i = 0; i < rc->rate_count; i++) {
+        if (!rc->stats[i].prob_valid) {
+            continue;
+        }
+        if (current_expected_kbs(rc, i) > current_expected_kbs(rc, best)) {
+            best = i;
+        }
+        if (rc->stats[i].prob > rc->stats[max_prob].prob ||
+            (rc->stats[i].prob == rc->stats[max_prob].prob && rc->rates[i].mbps > rc->rates[max_prob].mbps)) {
+            max_prob = i;
+        }
+    }
+    if (best != rc->best) {
+        rc->rate_changes++;
+        ESP_LOGD(TAG, "En iyi hız: %s -> %s", rc->rates[rc->best].name, rc->rates[best].name);
+    }
+    rc->best = best;
+    rc->max_prob = max_prob;
+}
+
+/* En iyi hızın beklenen goodput'unu geçebilecek bir sonraki hızı döndürür, yoksa -1 */
+static int pick_sample_rate(rate_ctrl_t *rc) {
+    double best_kbs = current_expected_kbs(rc, rc->best);
+    for (int n = 0; n < rc->rate_count; n++) {
+        int i = rc->sample_cursor;
+        rc->sample_cursor = (rc->sample_cursor + 1) % rc->rate_count;
+        if (i == rc->best) {
+            continue;
+        }
+        // Kusursuz koşulda bile en iyiyi geçemeyecek hızları örneklemek yayın süresi israfıdır
+        if (rc->stats[i].prob_valid && espnow_rate_ctrl_expected_kbs(rc, i, 1.0) <= best_kbs) {
+            continue;
+        }
+        return i;
+    }
+    return -1;
+}
+
+esp_err_t espnow_rate_ctrl_before_send(rate_ctrl_t *rc) {
+    int64_t now = esp_timer_get_time();
+    if (now - rc->last_update_us >= RATE_CTRL_UPDATE_MS * 1000LL) {
+        update_stats(rc);
+        rc->last_update_us = now;
+    }
+
+    int next = rc->best;
+    bool sample = false;
+    if (++rc->packet_counter % RATE_CTRL_SAMPLE_EVERY == 0) {
+        int candidate = pick_sample_rate(rc);
+        if (candidate >= 0) {
+            next = candidate;
+            sample = true;
+        }
+    }
+
+    if (next != rc->applied) {
+        esp_now_rate_config_t cfg = {
+            .phymode = rc->rates[next].phymode,
+            .rate = rc->rates[next].rate,
+            .ersu = false,
+        };
+        esp_err_t err = esp_now_set_peer_rate_config(rc->peer_addr, &cfg);
+        if (err != ESP_OK) {
+            rc->in_flight = -1;
+            return err;
+        }
+        rc->applied = next;
+    }
+    if (sample) {
+        rc->stats[next].samples++;
+    }
+    rc->in_flight = next;
+    return ESP_OK;
+}
+
+void espnow_rate_ctrl_cancel(rate_ctrl_t *rc) {
+    rc->in_flight = -1;
+}
+
+void espnow_rate_ctrl_on_send(rate_ctrl_t *rc, esp_now_send_status_t status) {
+    int rate = rc->in_flight;
+    if (rate < 0) {
+        return; // hız kontrolü dışında gönderilmiş bir paket (ör. kontrol paketi)
+    }
+    rc->in_flight = -1;
+    rate_ctrl_stats_t *st = &rc->stats[rate];
+    st->interval_attempts++;
+    st->attempts++;
+    if (status == ESP_NOW_SEND_SUCCESS) {
+        st->interval_success++;
+        st->success++;
+    }
+}
+
+void espnow_rate_ctrl_print(const rate_ctrl_t *rc, const char *tag) {
+    ESP_LOGI(tag, "HIZ KONTROLÜ: en iyi %s, en güvenilir %s, en iyi hız değişimi: %lu",
+             rc->rates[rc->best].name, rc->rates[rc->max_prob].name, (unsigned long)rc->rate_changes);
+    printf("%-14s | %8s | %8s | %7s | %7s | %12s | %12s\n", "hız", "deneme", "başarılı", "örnek", "olas. %", "beklenen KB/s", "ideal KB/s");
+    for (int i = 0; i < rc->rate_count; i++) {
+        const rate_ctrl_stats_t *st = &rc->stats[i];
+        if (st->attempts == 0) {
+            continue;
+        }
+        printf("%-14s | %8lu | %8lu | %7lu | %7.1f | %12.2f | %12.2f%s\n",
+               rc->rates[i].name, (unsigned long)st->attempts, (unsigned long)st->success, (unsigned long)st->samples,
+               st->prob * 100.0, current_expected_kbs(rc, i), espnow_rate_ctrl_expected_kbs(rc, i, 1.0),
+               i == rc->best ? "  <- en iyi" : "");
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * ESP-NOW unicast peer'ları için Minstrel benzeri uyarlamalı hız kontrolü.
+ *
+ * Her hız için send_cb'den gelen başarı/başarısızlık sayılır ve her
+ * RATE_CTRL_UPDATE_MS'de başarı olasılığı EWMA ile güncellenir. Beklenen
+ * goodput = olasılık * yük / yayın süresi (preamble, ACK ve IFS dahil basit bir
+ * model) ile hesaplanır ve en yüksek beklenen goodput'a sahip hız peer'a
+ * esp_now_set_peer_rate_config ile uygulanır. Paketlerin yaklaşık
+ * 1/RATE_CTRL_SAMPLE_EVERY'si, en iyi hızı geçebilecek (ideal goodput'u şu anki
+ * en iyinin beklenen goodput'undan yüksek) başka bir hızda örnek olarak gönderilir.
+ *
+ * ESP-NOW'da donanım yeniden denemeleri aynı hızla yapıldığından her send_cb
+ * durumu tek bir hıza aittir. Sonucun doğru hıza yazılabilmesi için aynı anda
+ * havada tek paket olmalıdır: espnow_rate_ctrl_before_send -> esp_now_send ->
+ * send_cb'den espnow_rate_ctrl_on_send -> sonraki paket.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_wifi.h"
+#include "esp_now.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RATE_CTRL_MAX_RATES     16
+#define RATE_CTRL_UPDATE_MS     100
+#define RATE_CTRL_SAMPLE_EVERY  10      // her N pakette bir örnekleme
+#define RATE_CTRL_EWMA_WEIGHT   0.75    // eski olasılığın ağırlığı
+
+typedef struct {
+    wifi_phy_mode_t phymode;
+    wifi_phy_rate_t rate;
+    const char *name;
+    float mbps;                 // nominal PHY hızı
+} rate_ctrl_rate_t;
+
+/* 11B 1M, 11B 11M, 11G 6/12/24M, HT20 MCS0-7 SGI; yavaştan hızlıya sıralı */
+extern const rate_ctrl_rate_t rate_ctrl_default_rates[];
+extern const int rate_ctrl_default_rate_count;
+
+typedef struct {
+    uint32_t interval_attempts;     // son güncellemeden bu yana
+    uint32_t interval_success;
+    uint32_t attempts;              // toplam
+    uint32_t success;
+    uint32_t samples;               // örnekleme amaçlı gönderimler
+    double prob;                    // EWMA başarı olasılığı
+    bool prob_valid;
+    double airtime_us;              // tek denemenin model yayın süresi
+} rate_ctrl_stats_t;
+
+typedef struct {
+    uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+    const rate_ctrl_rate_t *rates;
+    int rate_count;
+    uint16_t payload_len;
+    int best;                       // en yüksek beklenen goodput
+    int max_prob;                   // en yüksek başarı olasılığı
+    int applied;                    // peer'a en son uygulanan hız, -1: bilinmiyor
+    int in_flight;                  // havadaki paketin hızı, -1: yok
+    int sample_cursor;
+    uint32_t packet_counter;
+    uint32_t rate_changes;          // best'in değiştiği güncellemeler
+    int64_t last_update_us;
+    rate_ctrl_stats_t stats[RATE_CTRL_MAX_RATES];
+} rate_ctrl_t;
+
+/* initial_rate: ilk en iyi hız kabul edilen indeks (ör. testin sabit hızı) */
+esp_err_t espnow_rate_ctrl_init(rate_ctrl_t *rc, const uint8_t *peer_addr, const rate_ctrl_rate_t *rates, int rate_count,
+                                uint16_t payload_len, int initial_rate);
+
+/* Bir sonraki paketin hızını seçer ve gerekiyorsa peer'a uygular; esp_now_send'den hemen önce çağrılır */
+esp_err_t espnow_rate_ctrl_before_send(rate_ctrl_t *rc);
+
+/* Gönderim başarısız olup send_cb gelmeyecekse havadaki paket kaydını siler */
+void espnow_rate_ctrl_cancel(rate_ctrl_t *rc);
+
+/* send_cb'den çağrılır */
+void espnow_rate_ctrl_on_send(rate_ctrl_t *rc, esp_now_send_status_t status);
+
+/* rate'te olasılık prob ile beklenen goodput (KB/s) */
+double espnow_rate_ctrl_expected_kbs(const rate_ctrl_t *rc, int rate, double prob);
+
+void espnow_rate_ctrl_print(const rate_ctrl_t *rc, const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
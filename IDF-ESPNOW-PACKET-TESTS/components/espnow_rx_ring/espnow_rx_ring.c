@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "espnow_rx_ring.h"
+
+static const char *TAG = "RX_RING";
+
+esp_err_t espnow_rx_ring_init(espnow_rx_ring_t *ring, uint32_t slot_count, uint16_t max_frame_len, TaskHandle_t consumer) {
+    if (ring == NULL || slot_count == 0 || (slot_count & (slot_count - 1)) != 0 || max_frame_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(ring, 0, sizeof(espnow_rx_ring_t));
+    ring->slots = calloc(slot_count, sizeof(espnow_rx_slot_t));
+    ring->buffer = malloc((size_t)slot_count * max_frame_len);
+    if (ring->slots == NULL || ring->buffer == NULL) {
+        ESP_LOGE(TAG, "Halka için %lu byte ayrılamadı", (unsigned long)(slot_count * (max_frame_len + sizeof(espnow_rx_slot_t))));
+        espnow_rx_ring_deinit(ring);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (uint32_t i = 0; i < slot_count; i++) {
+        ring->slots[i].data = ring->buffer + (size_t)i * max_frame_len;
+    }
+    ring->slot_count = slot_count;
+    ring->max_frame_len = max_frame_len;
+    ring->consumer = consumer;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->watermark_reset, false);
+    return ESP_OK;
+}
+
+void espnow_rx_ring_set_consumer(espnow_rx_ring_t *ring, TaskHandle_t consumer) {
+    ring->consumer = consumer;
+}
+
+void espnow_rx_ring_deinit(espnow_rx_ring_t *ring) {
+    free(ring->slots);
+    free(ring->buffer);
+    ring->slots = NULL;
+    ring->buffer = NULL;
+    ring->slot_count = 0;
+}
+
+bool espnow_rx_ring_push(espnow_rx_ring_t *ring, const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (len <= 0 || len > ring->max_frame_len) {
+        ring->dropped_len++;
+        return false;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t used = head - tail;
+    if (used >= ring->slot_count) {
+        ring->dropped_full++;
+        return false;
+    }
+
+    espnow_rx_slot_t *slot = &ring->slots[head & (ring->slot_count - 1)];
+    slot->rx_time_us = esp_timer_get_time();
+    memcpy(slot->src_addr, recv_info->src_addr, ESP_NOW_ETH_ALEN);
+    slot->rssi = recv_info->rx_ctrl != NULL ? recv_info->rx_ctrl->rssi : 0;
+    slot->len = (uint16_t)len;
+    memcpy(slot->data, data, len);
+
+    // Slot içeriği tüketiciye head ilerlemeden önce görünür olmalı
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    ring->pushed++;
+    if (atomic_exchange_explicit(&ring->watermark_reset, false, memory_order_relaxed)) {
+        ring->high_watermark = 0;   // tüketici yeni bir ölçüm aralığı başlattı
+    }
+    if (used + 1 > ring->high_watermark) {
+        ring->high_watermark = used + 1;
+    }
+
+    /**
+     * Tüketici sadece halka boşken uyur; dolu halkada her pakette notification
+     * göndermeye gerek yok. Boşluk kararı için tail head yazıldıktan sonra
+     * yeniden okunur. head yazımı ile tail okuması arasındaki sıralamayı
+     * acquire/release sağlamaz (tüketicinin tail yazımı ve head okuması da
+     * aynı durumda); iki taraftaki seq_cst fence ile en az biri diğerinin
+     * yazımını görür, tüketici boş halkada uyurken paket kaçmaz.
+     */
+    atomic_thread_fence(memory_order_seq_cst);
+    tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (tail == head && ring->consumer != NULL) {
+        xTaskNotifyGive(ring->consumer);
+    }
+    return true;
+}
+
+espnow_rx_slot_t *espnow_rx_ring_peek(espnow_rx_ring_t *ring, TickType_t timeout) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);  // önceki release'in tail yazımı head okumasından önce (bkz. push)
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        if (timeout == 0 || ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+            return NULL;
+        }
+        head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (head == tail) {
+            return NULL;
+        }
+    }
+    return &ring->slots[tail & (ring->slot_count - 1)];
+}
+
+void espnow_rx_ring_release(espnow_rx_ring_t *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+uint32_t espnow_rx_ring_take_high_watermark(espnow_rx_ring_t *ring) {
+    uint32_t watermark = ring->high_watermark;
+    atomic_store_explicit(&ring->watermark_reset, true, memory_order_relaxed);
+    return watermark;
+}
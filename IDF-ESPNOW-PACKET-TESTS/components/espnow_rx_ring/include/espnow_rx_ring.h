@@ -0,0 +1,98 @@
+/**
+ * esp_now_recv_cb ile işçi (worker) task arasında kullanılan, kilitsiz,
+ * tek üreticili / tek tüketicili (SPSC) alım halkası.
+ *
+ * esp_now_recv_cb Wi-Fi task'ı içinde çalışır; callback içinde yapılan her
+ * hesaplama ve loglama Wi-Fi task'ını bekletir ve yüksek paket hızlarında
+ * alım kayıplarına neden olur. Bu halka ile callback sadece paketi önceden
+ * ayrılmış bir slota kopyalayıp döner, ayrıştırma ve istatistikler işçi
+ * task'ında yapılır.
+ *
+ * Üretici yalnızca esp_now_recv_cb, tüketici yalnızca tek bir işçi task'ı
+ * olmalıdır. Hot path'te heap ayırma yapılmaz.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "esp_now.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int64_t rx_time_us;                     // callback'e girildiği an
+    uint8_t src_addr[ESP_NOW_ETH_ALEN];
+    int8_t rssi;
+    uint16_t len;
+    uint8_t *data;                          // halkanın önceden ayrılmış tamponunu gösterir
+} espnow_rx_slot_t;
+
+typedef struct {
+    espnow_rx_slot_t *slots;
+    uint8_t *buffer;
+    uint32_t slot_count;                    // 2'nin kuvveti
+    uint16_t max_frame_len;
+    atomic_uint_fast32_t head;              // sadece üretici yazar
+    atomic_uint_fast32_t tail;              // sadece tüketici yazar
+    TaskHandle_t consumer;                  // halka boşken gelen paket bu task'ı uyandırır
+    uint32_t pushed;
+    uint32_t dropped_full;                  // halka dolu olduğu için atılan paketler
+    uint32_t dropped_len;                   // max_frame_len'den büyük paketler
+    uint32_t high_watermark;                // gözlenen en yüksek doluluk; sadece üretici yazar
+    atomic_bool watermark_reset;            // tüketici ister, üretici bir sonraki pakette sıfırlar
+} espnow_rx_ring_t;
+
+/**
+ * slot_count adet slotu ve her biri max_frame_len byte olan tamponları bir kez
+ * ayırır. slot_count 2'nin kuvveti olmalıdır. consumer NULL değilse halka boşken
+ * gelen her paket bu task'a task notification gönderir.
+ */
+esp_err_t espnow_rx_ring_init(espnow_rx_ring_t *ring, uint32_t slot_count, uint16_t max_frame_len, TaskHandle_t consumer);
+
+/**
+ * Halka boşken gelen paketlerin uyandıracağı task'ı ayarlar. Tüketici task
+ * halkayı kullanmadan önce halkanın hazır olması gerektiğinden halka
+ * consumer NULL ile kurulup task oluşturulduktan sonra burada bağlanabilir.
+ * Recv callback'i kaydedilmeden önce çağrılmalıdır.
+ */
+void espnow_rx_ring_set_consumer(espnow_rx_ring_t *ring, TaskHandle_t consumer);
+
+void espnow_rx_ring_deinit(espnow_rx_ring_t *ring);
+
+/**
+ * Üretici tarafı, esp_now_recv_cb içinden çağrılır. Paketi boş bir slota kopyalar.
+ * Halka doluysa ya da paket çok büyükse false döner ve ilgili sayaç artar.
+ */
+bool espnow_rx_ring_push(espnow_rx_ring_t *ring, const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
+
+/**
+ * Tüketici tarafı. Sıradaki dolu slotu döndürür; halka boşsa timeout kadar
+ * notification bekler, yine boşsa NULL döner. Slot ile iş bitince
+ * espnow_rx_ring_release çağrılmalıdır.
+ */
+espnow_rx_slot_t *espnow_rx_ring_peek(espnow_rx_ring_t *ring, TickType_t timeout);
+
+void espnow_rx_ring_release(espnow_rx_ring_t *ring);
+
+/**
+ * Tüketici tarafı. Son çağrıdan bu yana gözlenen en yüksek doluluğu döndürür
+ * ve yeni aralık için sıfırlanmasını ister; sıfırlamayı üretici bir sonraki
+ * pakette yapar, böylece high_watermark'a tek yazan üretici kalır.
+ */
+uint32_t espnow_rx_ring_take_high_watermark(espnow_rx_ring_t *ring);
+
+static inline uint32_t espnow_rx_ring_count(espnow_rx_ring_t *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) - atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,222 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "espnow_secure.h"
+
+static const char *TAG = "ESPNOW_SECURE";
+
+static const uint8_t broadcast_addr[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static uint8_t lmk[ESP_NOW_KEY_LEN];
+static bool initialized = false;
+static bool allow_downgrade = false;
+
+/* Başlatıcı durumu */
+static SemaphoreHandle_t switch_sem = NULL;
+static uint8_t switch_peer[ESP_NOW_ETH_ALEN];
+static volatile bool switch_waiting = false;
+static volatile uint8_t switch_reply = 0;
+
+static bool is_group_addr(const uint8_t *addr) {
+    return (addr[0] & 0x01) != 0;   // broadcast ve multicast adreslerde I/G biti 1
+}
+
+/* Şifreli peer eklenebilir mi; değilse nedenini yazar */
+static esp_err_t check_encrypt_allowed(const uint8_t *addr, bool already_encrypted) {
+    if (is_group_addr(addr)) {
+        ESP_LOGW(TAG, MACSTR " grup adresi, ESP-NOW broadcast/multicast çerçeveleri şifrelemez", MAC2STR(addr));
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!initialized) {
+        ESP_LOGE(TAG, "LMK ayarlanmadı, önce espnow_secure_init çağrılmalı");
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_now_peer_num_t num;
+    esp_err_t err = esp_now_get_peer_num(&num);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (!already_encrypted && num.encrypt_num >= ESP_NOW_MAX_ENCRYPT_PEER_NUM) {
+        ESP_LOGW(TAG, "Şifreli peer sınırı dolu (%d/%d), CONFIG_ESP_WIFI_ESPNOW_MAX_ENCRYPT_NUM artırılabilir",
+                 num.encrypt_num, ESP_NOW_MAX_ENCRYPT_PEER_NUM);
+        return ESP_ERR_ESPNOW_FULL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t espnow_secure_init(const uint8_t *pmk, const uint8_t *local_key) {
+    esp_err_t err = esp_now_set_pmk(pmk);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "PMK ayarlanamadı: %s", esp_err_to_name(err));
+        return err;
+    }
+    memcpy(lmk, local_key, ESP_NOW_KEY_LEN);
+    if (switch_sem == NULL) {
+        switch_sem = xSemaphoreCreateBinary();
+        if (switch_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    // Mod değişimi mesajları için; peer'ların moduna bağlı olmayan tek yol
+    if (!esp_now_is_peer_exist(broadcast_addr)) {
+        esp_now_peer_info_t peer = {0};
+        peer.channel = 0;   // o anki kanal, kanal değişince de geçerli kalır
+        peer.ifidx = WIFI_IF_STA;
+        peer.encrypt = false;
+        memcpy(peer.peer_addr, broadcast_addr, ESP_NOW_ETH_ALEN);
+        err = esp_now_add_peer(&peer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Broadcast peer eklenemedi: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+    initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t espnow_secure_set_encrypt(const uint8_t *peer_addr, bool encrypt) {
+    esp_now_peer_info_t peer;
+    esp_err_t err = esp_now_get_peer(peer_addr, &peer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (peer.encrypt == encrypt) {
+        return ESP_OK;
+    }
+    if (encrypt) {
+        err = check_encrypt_allowed(peer_addr, peer.encrypt);
+        if (err != ESP_OK) {
+            return err;
+        }
+        memcpy(peer.lmk, lmk, ESP_NOW_KEY_LEN);
+    }
+    peer.encrypt = encrypt;
+    err = esp_now_mod_peer(&peer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, MACSTR " peer modu değiştirilemedi: %s", MAC2STR(peer_addr), esp_err_to_name(err));
+    }
+    return err;
+}
+
+bool espnow_secure_is_encrypted(const uint8_t *peer_addr) {
+    esp_now_peer_info_t peer;
+    return esp_now_get_peer(peer_addr, &peer) == ESP_OK && peer.encrypt;
+}
+
+esp_err_t espnow_secure_add_peer(const espnow_secure_peer_t *cfg, bool *encrypted) {
+    bool encrypt = cfg->encrypt;
+    if (encrypt) {
+        bool exists_encrypted = espnow_secure_is_encrypted(cfg->peer_addr);
+        esp_err_t err = check_encrypt_allowed(cfg->peer_addr, exists_encrypted);
+        if (err != ESP_OK) {
+            if (!cfg->allow_plaintext) {
+                ESP_LOGE(TAG, MACSTR " şifreli eklenemedi: %s", MAC2STR(cfg->peer_addr), esp_err_to_name(err));
+                return err;
+            }
+            ESP_LOGW(TAG, MACSTR " şifresiz ekleniyor", MAC2STR(cfg->peer_addr));
+            encrypt = false;
+        }
+    }
+
+    esp_now_peer_info_t peer = {0};
+    peer.channel = cfg->channel;
+    peer.ifidx = cfg->ifidx;
+    peer.encrypt = encrypt;
+    if (encrypt) {
+        memcpy(peer.lmk, lmk, ESP_NOW_KEY_LEN);
+    }
+    memcpy(peer.peer_addr, cfg->peer_addr, ESP_NOW_ETH_ALEN);
+    esp_err_t err = esp_now_is_peer_exist(cfg->peer_addr) ? esp_now_mod_peer(&peer) : esp_now_add_peer(&peer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, MACSTR " peer eklenemedi: %s", MAC2STR(cfg->peer_addr), esp_err_to_name(err));
+        return err;
+    }
+    if (encrypted != NULL) {
+        *encrypted = encrypt;
+    }
+    ESP_LOGI(TAG, MACSTR " peer %s eklendi", MAC2STR(cfg->peer_addr), encrypt ? "şifreli" : "şifresiz");
+    return ESP_OK;
+}
+
+void espnow_secure_allow_downgrade(bool allow) {
+    allow_downgrade = allow;
+}
+
+esp_err_t espnow_secure_switch(const uint8_t *peer_addr, bool encrypt, uint32_t timeout_ms) {
+    if (switch_sem == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint8_t msg[2] = {ESPNOW_SECURE_SWITCH, encrypt};
+    bool leaving_ccmp = !encrypt && espnow_secure_is_encrypted(peer_addr);
+    memcpy(switch_peer, peer_addr, ESP_NOW_ETH_ALEN);
+    xSemaphoreTake(switch_sem, 0);
+    switch_waiting = true;
+
+    esp_err_t err = ESP_ERR_TIMEOUT;
+    for (uint32_t waited = 0; waited < timeout_ms; waited += ESPNOW_SECURE_RETRY_MS) {
+        if (leaving_ccmp) {
+            esp_now_send(peer_addr, msg, sizeof(msg));  // peer hâlâ şifreli, istek CCMP ile gider
+            if (waited > 0) {
+                // Kurtarma: önceki onay kaybolduysa karşı taraf zaten şifresizdir ve yalnızca onaylar
+                esp_now_send(broadcast_addr, msg, sizeof(msg));
+            }
+        }
+        else {
+            esp_now_send(broadcast_addr, msg, sizeof(msg));
+        }
+        if (xSemaphoreTake(switch_sem, pdMS_TO_TICKS(ESPNOW_SECURE_RETRY_MS)) == pdTRUE) {
+            err = (switch_reply == encrypt) ? ESP_OK : ESP_ERR_ESPNOW_FULL;
+            break;
+        }
+    }
+    switch_waiting = false;
+
+    if (err == ESP_ERR_ESPNOW_FULL) {
+        ESP_LOGE(TAG, "Karşı taraf %s moda geçemedi", encrypt ? "şifreli" : "şifresiz");
+        return err;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Mod değişimi onaylanmadı");
+        return err;
+    }
+    return espnow_secure_set_encrypt(peer_addr, encrypt);
+}
+
+bool espnow_secure_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (len != 2 || (data[0] != ESPNOW_SECURE_SWITCH && data[0] != ESPNOW_SECURE_SWITCH_ACK)) {
+        return false;
+    }
+    const uint8_t *src = recv_info->src_addr;
+
+    if (data[0] == ESPNOW_SECURE_SWITCH) {
+        if (!esp_now_is_peer_exist(src) || is_group_addr(src)) {
+            return true;    // tanımadığımız cihazların isteği uygulanmaz
+        }
+        bool encrypt = data[1] != 0;
+        if (!encrypt && espnow_secure_is_encrypted(src)) {
+            // Şifreli peer'dan gelen unicast çerçeveler ESP-NOW'a ancak CCMP ile çözülürse ulaşır;
+            // broadcast ile gelen istek ise kimliği doğrulanmamış, kaynağı taklit edilmiş olabilir
+            if (is_group_addr(recv_info->des_addr)) {
+                ESP_LOGW(TAG, MACSTR " için broadcast ile gelen şifresiz moda geçiş isteği yok sayıldı", MAC2STR(src));
+                return true;
+            }
+            if (!allow_downgrade) {
+                ESP_LOGW(TAG, MACSTR " şifresiz moda geçiş isteği reddedildi (ENCRYPT_COMPARE_MODE kapalı)", MAC2STR(src));
+                encrypt = true;     // mod değişmez, onayda şifreli kalındığı bildirilir
+            }
+        }
+        espnow_secure_set_encrypt(src, encrypt);
+        uint8_t reply[2] = {ESPNOW_SECURE_SWITCH_ACK, espnow_secure_is_encrypted(src)};
+        esp_now_send(broadcast_addr, reply, sizeof(reply));
+        ESP_LOGI(TAG, MACSTR " isteğiyle %s moda geçildi", MAC2STR(src), reply[1] ? "şifreli" : "şifresiz");
+        return true;
+    }
+
+    if (switch_waiting && memcmp(src, switch_peer, ESP_NOW_ETH_ALEN) == 0) {
+        switch_reply = data[1];
+        xSemaphoreGive(switch_sem);
+    }
+    return true;
+}
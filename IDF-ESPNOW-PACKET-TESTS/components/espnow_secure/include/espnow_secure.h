@@ -0,0 +1,80 @@
+/**
+ * ESP-NOW şifreli (CCMP) peer yönetimi ve iki tarafın birlikte şifre modu değiştirmesi.
+ *
+ * espnow_secure_init PMK'yı esp_now_set_pmk ile ayarlar ve peer'larda kullanılacak
+ * LMK'yı saklar; ikisi de ESP_NOW_KEY_LEN (16) bayttır ve iki cihazda aynı olmalıdır.
+ *
+ * espnow_secure_add_peer peer'ı istenen modda ekler (peer zaten varsa, ör. başka bir
+ * bileşen şifresiz eklediyse, esp_now_mod_peer ile günceller). Şifreli peer sayısı
+ * CONFIG_ESP_WIFI_ESPNOW_MAX_ENCRYPT_NUM ile sınırlıdır ve broadcast/multicast
+ * adresler şifrelenemez. Bu durumlarda allow_plaintext ise peer şifresiz eklenip
+ * uyarı yazılır, değilse ESP_ERR_ESPNOW_FULL / ESP_ERR_INVALID_ARG döner.
+ *
+ * Şifreli ve şifresiz ölçümleri aynı koşuda yan yana almak için başlatıcı
+ * (gönderici) turlar arasında espnow_secure_switch çağırır: başlatıcı
+ * ESPNOW_SECURE_SWITCH yollar, karşı taraf gönderen peer'ın modunu değiştirip
+ * ulaştığı modu ESPNOW_SECURE_SWITCH_ACK ile bildirir, başlatıcı onayı aldıktan
+ * sonra kendi peer'ını değiştirir. Onay kaybolursa tekrarlanan istek karşı tarafta
+ * aynı sonucu verir. Yalnızca kayıtlı bir peer'dan gelen istekler uygulanır.
+ *
+ * Şifresizden CCMP'ye geçiş isteği ve onaylar, modlar iki tarafta farklıyken de
+ * alınabilsin diye şifrelenemeyen broadcast adrese gönderilir. CCMP'den çıkış
+ * isteği ise peer'a o anki (şifreli) modunda unicast gönderilir; kaynak MAC adresi
+ * taklit edilebildiği için broadcast ile gelen çıkış istekleri uygulanmaz, yalnızca
+ * karşı taraf zaten şifresizse onaylanır (kaybolan onaydan sonra kurtarma).
+ * Şifreli unicast istekle bile CCMP'den çıkış, espnow_secure_allow_downgrade(true)
+ * çağrılmadıkça reddedilir; uygulamalar bunu yalnızca ENCRYPT_COMPARE_MODE
+ * derlemelerinde açar.
+ *
+ * Her iki taraf da recv_cb'sinin başında espnow_secure_on_recv'i çağırır.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_now.h"
+#include "esp_wifi.h"
+#include "espnow_msg_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESPNOW_SECURE_SWITCH        ESPNOW_MSG_SECURE_SWITCH        // [tip, şifreli]
+#define ESPNOW_SECURE_SWITCH_ACK    ESPNOW_MSG_SECURE_SWITCH_ACK    // [tip, karşı tarafın ulaştığı mod]
+
+#define ESPNOW_SECURE_RETRY_MS      200
+
+typedef struct {
+    const uint8_t *peer_addr;
+    uint8_t channel;                    // 0: o anki kanal
+    wifi_interface_t ifidx;
+    bool encrypt;
+    bool allow_plaintext;               // şifreli peer eklenemezse şifresiz eklenir
+} espnow_secure_peer_t;
+
+/* esp_now_init'ten sonra çağrılır; pmk ve lmk ESP_NOW_KEY_LEN bayt */
+esp_err_t espnow_secure_init(const uint8_t *pmk, const uint8_t *lmk);
+
+/* encrypted NULL olabilir; peer'ın sonunda şifreli olup olmadığını yazar */
+esp_err_t espnow_secure_add_peer(const espnow_secure_peer_t *peer, bool *encrypted);
+
+/* Yalnızca bu cihazdaki peer kaydını değiştirir */
+esp_err_t espnow_secure_set_encrypt(const uint8_t *peer_addr, bool encrypt);
+
+bool espnow_secure_is_encrypted(const uint8_t *peer_addr);
+
+/* Karşı taraftan gelen CCMP'den çıkış isteklerine izin verir; varsayılan kapalı */
+void espnow_secure_allow_downgrade(bool allow);
+
+/* Karşı tarafla birlikte moda geçer; timeout_ms içinde onay gelmezse ESP_ERR_TIMEOUT döner ve mod değişmez */
+esp_err_t espnow_secure_switch(const uint8_t *peer_addr, bool encrypt, uint32_t timeout_ms);
+
+/* Kontrol mesajıysa işleyip true döner */
+bool espnow_secure_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
+
+#ifdef __cplusplus
+}
+#endif
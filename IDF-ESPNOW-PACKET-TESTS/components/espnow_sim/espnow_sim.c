@@ -0,0 +1,548 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "espnow_sim.h"
+
+#define SIM_MAGIC           0x534E5345  // "ESNS"
+#define SIM_TASK_PRIO       23          // karttaki Wi-Fi task'ının önceliği
+#define SIM_SOCK_RCVBUF     (1 << 20)   // çekirdekte düşmemesi için; kayıp yalnızca modelden gelsin
+#define SIM_RSSI            -50
+#define SIM_CHANNEL         1
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t src[ESP_NOW_ETH_ALEN];
+    uint8_t dst[ESP_NOW_ETH_ALEN];
+    int64_t air_end_us;                 // son denemenin havada bittiği an (CLOCK_MONOTONIC, süreçler arası ortak)
+} sim_hdr_t;
+
+typedef struct {
+    uint8_t dst[ESP_NOW_ETH_ALEN];
+    uint16_t len;
+    esp_now_send_status_t status;
+    uint32_t deliver_mask;              // bit i: çerçeve i. düğüme ulaştı
+    int64_t done_us;
+    uint8_t data[ESP_NOW_MAX_DATA_LEN_V2];
+} tx_frame_t;
+
+typedef struct {
+    uint8_t src[ESP_NOW_ETH_ALEN];
+    uint8_t dst[ESP_NOW_ETH_ALEN];
+    uint16_t len;
+    int64_t deliver_us;
+    uint8_t data[ESP_NOW_MAX_DATA_LEN_V2];
+} rx_frame_t;
+
+static const char *TAG = "ESPNOW_SIM";
+static const uint8_t broadcast_addr[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static espnow_sim_config_t config;
+static bool sim_ready = false;
+static bool now_ready = false;
+static int sock = -1;
+static TaskHandle_t sim_task_handle = NULL;
+static esp_now_recv_cb_t recv_cb = NULL;
+static esp_now_send_cb_t send_cb = NULL;
+
+static esp_now_peer_info_t peers[ESP_NOW_MAX_TOTAL_PEER_NUM];
+static bool peer_used[ESP_NOW_MAX_TOTAL_PEER_NUM];
+static int fetch_index = 0;
+
+/* TX kuyruğu esp_now_send'i çağıran task'larla sim task'ı arasında paylaşılır, sim_lock ile korunur */
+static tx_frame_t tx_queue[ESPNOW_SIM_MAX_QUEUE];
+static int tx_head = 0;
+static int tx_count = 0;
+static int64_t air_free_us = 0;         // havanın boşalacağı an
+static unsigned int tx_rand;
+static espnow_sim_stats_t stats;
+static portMUX_TYPE sim_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Teslim kuyruğuna yalnızca sim task'ı dokunur */
+static rx_frame_t rx_queue[ESPNOW_SIM_RX_QUEUE];
+static int rx_head = 0;
+static int rx_count = 0;
+static int64_t rx_last_deliver_us = 0;
+static unsigned int rx_rand;
+
+static int64_t sim_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t env_u32(const char *name, uint32_t def) {
+    const char *v = getenv(name);
+    return v != NULL && *v != '\0' ? (uint32_t)strtoul(v, NULL, 0) : def;
+}
+
+void espnow_sim_config_from_env(espnow_sim_config_t *cfg) {
+    espnow_sim_config_t def = ESPNOW_SIM_CONFIG_DEFAULT();
+    *cfg = def;
+    cfg->node_id = env_u32("ESPNOW_SIM_NODE", def.node_id);
+    cfg->node_count = env_u32("ESPNOW_SIM_NODES", def.node_count);
+    cfg->base_port = env_u32("ESPNOW_SIM_PORT", def.base_port);
+    const char *loss = getenv("ESPNOW_SIM_LOSS");
+    if (loss != NULL && *loss != '\0') {
+        cfg->loss_pct = strtof(loss, NULL);
+    }
+    cfg->retries = env_u32("ESPNOW_SIM_RETRIES", def.retries);
+    cfg->latency_us = env_u32("ESPNOW_SIM_LATENCY_US", def.latency_us);
+    cfg->jitter_us = env_u32("ESPNOW_SIM_JITTER_US", def.jitter_us);
+    cfg->bandwidth_kbps = env_u32("ESPNOW_SIM_KBPS", def.bandwidth_kbps);
+    cfg->overhead_us = env_u32("ESPNOW_SIM_OVERHEAD_US", def.overhead_us);
+    cfg->tx_queue_len = env_u32("ESPNOW_SIM_QUEUE", def.tx_queue_len);
+    cfg->seed = env_u32("ESPNOW_SIM_SEED", def.seed);
+}
+
+void espnow_sim_node_mac(uint8_t node_id, uint8_t mac[ESP_NOW_ETH_ALEN]) {
+    const uint8_t base[ESP_NOW_ETH_ALEN] = {0x02, 0x00, 0x00, 0x00, 0x00, node_id};  // yerel yönetilen adres
+    memcpy(mac, base, ESP_NOW_ETH_ALEN);
+}
+
+void espnow_sim_get_mac(uint8_t mac[ESP_NOW_ETH_ALEN]) {
+    espnow_sim_node_mac(config.node_id, mac);
+}
+
+/* Simülasyondaki bir düğümün adresiyse düğüm numarası, değilse -1 */
+static int node_of(const uint8_t *mac) {
+    uint8_t node_mac[ESP_NOW_ETH_ALEN];
+    espnow_sim_node_mac(mac[5], node_mac);
+    if (memcmp(mac, node_mac, ESP_NOW_ETH_ALEN) != 0 || mac[5] >= config.node_count) {
+        return -1;
+    }
+    return mac[5];
+}
+
+esp_err_t espnow_sim_init(const espnow_sim_config_t *cfg) {
+    if (cfg->node_count > ESPNOW_SIM_MAX_NODES || cfg->node_id >= cfg->node_count ||
+        cfg->tx_queue_len == 0 || cfg->tx_queue_len > ESPNOW_SIM_MAX_QUEUE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sock >= 0) {
+        close(sock);
+    }
+    config = *cfg;
+    tx_rand = cfg->seed * 2654435761U + cfg->node_id;
+    rx_rand = tx_rand ^ 0x5A5A5A5A;
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "UDP soketi açılamadı: %s", strerror(errno));
+        return ESP_FAIL;
+    }
+    int rcvbuf = SIM_SOCK_RCVBUF;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(cfg->base_port + cfg->node_id),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ESP_LOGE(TAG, "Port %u bağlanamadı (%s), aynı düğüm numarasıyla başka süreç çalışıyor olabilir",
+                 cfg->base_port + cfg->node_id, strerror(errno));
+        close(sock);
+        sock = -1;
+        return ESP_FAIL;
+    }
+    sim_ready = true;
+    return ESP_OK;
+}
+
+void espnow_sim_log_config(const char *tag) {
+    ESP_LOGI(tag, "Simülasyon: düğüm %u/%u (port %u), kayıp %%%.1f, %u tekrar, gecikme %lu+%lu us, %lu kbps + %lu us, TX kuyruğu %u, seed %lu",
+             config.node_id, config.node_count, config.base_port + config.node_id, config.loss_pct, config.retries,
+             (unsigned long)config.latency_us, (unsigned long)config.jitter_us, (unsigned long)config.bandwidth_kbps,
+             (unsigned long)config.overhead_us, config.tx_queue_len, (unsigned long)config.seed);
+}
+
+void espnow_sim_get_stats(espnow_sim_stats_t *out) {
+    portENTER_CRITICAL(&sim_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&sim_lock);
+}
+
+static uint32_t airtime_us(size_t len) {
+    uint32_t t = config.overhead_us;
+    if (config.bandwidth_kbps > 0) {
+        t += (uint32_t)((uint64_t)len * 8 * 1000 / config.bandwidth_kbps);
+    }
+    return t;
+}
+
+static bool attempt_lost(void) {
+    return rand_r(&tx_rand) / (RAND_MAX + 1.0) * 100.0 < config.loss_pct;
+}
+
+static int find_peer(const uint8_t *addr) {
+    for (int i = 0; i < ESP_NOW_MAX_TOTAL_PEER_NUM; i++) {
+        if (peer_used[i] && memcmp(peers[i].peer_addr, addr, ESP_NOW_ETH_ALEN) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Havadaki süresi dolan çerçeveyi UDP ile ulaştığı düğümlere yollar */
+static void transmit(const tx_frame_t *f) {
+    static uint8_t buf[sizeof(sim_hdr_t) + ESP_NOW_MAX_DATA_LEN_V2];
+    sim_hdr_t hdr = {
+        .magic = SIM_MAGIC,
+        .air_end_us = f->done_us,
+    };
+    espnow_sim_get_mac(hdr.src);
+    memcpy(hdr.dst, f->dst, ESP_NOW_ETH_ALEN);
+    memcpy(buf, &hdr, sizeof(hdr));
+    memcpy(buf + sizeof(hdr), f->data, f->len);
+
+    for (int node = 0; node < config.node_count; node++) {
+        if (!(f->deliver_mask & (1U << node))) {
+            continue;
+        }
+        struct sockaddr_in addr = {
+            .sin_family = AF_INET,
+            .sin_port = htons(config.base_port + node),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        };
+        sendto(sock, buf, sizeof(hdr) + f->len, 0, (struct sockaddr *)&addr, sizeof(addr)); // karşı süreç yoksa çerçeve kaybolur
+    }
+}
+
+static void receive_pending(void) {
+    static uint8_t buf[sizeof(sim_hdr_t) + ESP_NOW_MAX_DATA_LEN_V2];
+    uint8_t own_mac[ESP_NOW_ETH_ALEN];
+    espnow_sim_get_mac(own_mac);
+
+    while (1) {
+        ssize_t n = recvfrom(sock, buf, sizeof(buf), MSG_DONTWAIT, NULL, NULL);
+        if (n < 0) {
+            break;
+        }
+        sim_hdr_t hdr;
+        if ((size_t)n <= sizeof(hdr)) {
+            continue;
+        }
+        memcpy(&hdr, buf, sizeof(hdr));
+        if (hdr.magic != SIM_MAGIC) {
+            continue;
+        }
+        if (memcmp(hdr.dst, own_mac, ESP_NOW_ETH_ALEN) != 0 && memcmp(hdr.dst, broadcast_addr, ESP_NOW_ETH_ALEN) != 0) {
+            portENTER_CRITICAL(&sim_lock);
+            stats.rx_foreign++;
+            portEXIT_CRITICAL(&sim_lock);
+            continue;
+        }
+        if (rx_count >= ESPNOW_SIM_RX_QUEUE) {
+            portENTER_CRITICAL(&sim_lock);
+            stats.rx_dropped++;
+            portEXIT_CRITICAL(&sim_lock);
+            continue;
+        }
+
+        int64_t deliver_us = hdr.air_end_us + config.latency_us;
+        if (config.jitter_us > 0) {
+            deliver_us += rand_r(&rx_rand) % (config.jitter_us + 1);
+        }
+        if (deliver_us < rx_last_deliver_us) {
+            deliver_us = rx_last_deliver_us;  // gecikme değişse de çerçeveler sırayla teslim edilir
+        }
+        rx_last_deliver_us = deliver_us;
+
+        rx_frame_t *f = &rx_queue[(rx_head + rx_count) % ESPNOW_SIM_RX_QUEUE];
+        memcpy(f->src, hdr.src, ESP_NOW_ETH_ALEN);
+        memcpy(f->dst, hdr.dst, ESP_NOW_ETH_ALEN);
+        f->len = n - sizeof(hdr);
+        f->deliver_us = deliver_us;
+        memcpy(f->data, buf + sizeof(hdr), f->len);
+        rx_count++;
+    }
+}
+
+static void deliver_due(int64_t now_us) {
+    while (rx_count > 0 && rx_queue[rx_head].deliver_us <= now_us) {
+        rx_frame_t *f = &rx_queue[rx_head];
+        wifi_pkt_rx_ctrl_t rx_ctrl = {
+            .rssi = SIM_RSSI,
+            .channel = SIM_CHANNEL,
+            .sig_len = f->len,
+            .timestamp = (uint32_t)now_us,
+        };
+        esp_now_recv_info_t info = {
+            .src_addr = f->src,
+            .des_addr = f->dst,
+            .rx_ctrl = &rx_ctrl,
+        };
+        if (recv_cb != NULL) {
+            recv_cb(&info, f->data, f->len);
+        }
+        portENTER_CRITICAL(&sim_lock);
+        stats.rx_frames++;
+        portEXIT_CRITICAL(&sim_lock);
+        rx_head = (rx_head + 1) % ESPNOW_SIM_RX_QUEUE;
+        rx_count--;
+    }
+}
+
+/* Karttaki Wi-Fi task'ının yerine: send_cb ve recv_cb buradan çağrılır */
+static void sim_task(void *arg) {
+    static tx_frame_t done;
+
+    while (1) {
+        int64_t now_us = sim_now_us();
+        while (1) {
+            bool have = false;
+            portENTER_CRITICAL(&sim_lock);
+            if (tx_count > 0 && tx_queue[tx_head].done_us <= now_us) {
+                memcpy(&done, &tx_queue[tx_head], sizeof(done));
+                tx_head = (tx_head + 1) % ESPNOW_SIM_MAX_QUEUE;
+                tx_count--;
+                have = true;
+            }
+            portEXIT_CRITICAL(&sim_lock);
+            if (!have) {
+                break;
+            }
+            transmit(&done);
+            if (send_cb != NULL) {
+                send_cb(done.dst, done.status);
+            }
+        }
+        receive_pending();
+        deliver_due(sim_now_us());
+        vTaskDelay(1);  // POSIX portunda aynı anda tek task koşar; beklemeden dönmek diğerlerini aç bırakır
+    }
+}
+
+esp_err_t esp_now_init(void) {
+    if (now_ready) {
+        return ESP_OK;
+    }
+    if (!sim_ready) {
+        espnow_sim_config_t cfg;
+        espnow_sim_config_from_env(&cfg);
+        esp_err_t err = espnow_sim_init(&cfg);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    tx_head = tx_count = 0;
+    rx_head = rx_count = 0;
+    memset(&stats, 0, sizeof(stats));
+    if (xTaskCreate(sim_task, "espnow_sim", 4096, NULL, SIM_TASK_PRIO, &sim_task_handle) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    now_ready = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_deinit(void) {
+    if (!now_ready) {
+        return ESP_OK;
+    }
+    vTaskDelete(sim_task_handle);
+    sim_task_handle = NULL;
+    recv_cb = NULL;
+    send_cb = NULL;
+    memset(peer_used, 0, sizeof(peer_used));
+    now_ready = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) {
+    if (!now_ready) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    recv_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_recv_cb(void) {
+    recv_cb = NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb) {
+    if (!now_ready) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    send_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_send_cb(void) {
+    send_cb = NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len) {
+    if (!now_ready) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (peer_addr == NULL || data == NULL || len == 0 || len > ESP_NOW_MAX_DATA_LEN_V2) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+    bool broadcast = memcmp(peer_addr, broadcast_addr, ESP_NOW_ETH_ALEN) == 0;
+
+    portENTER_CRITICAL(&sim_lock);
+    if (find_peer(peer_addr) < 0) {
+        portEXIT_CRITICAL(&sim_lock);
+        return ESP_ERR_ESPNOW_NOT_FOUND;
+    }
+    if (tx_count >= config.tx_queue_len) {
+        stats.tx_queue_full++;
+        portEXIT_CRITICAL(&sim_lock);
+        return ESP_ERR_ESPNOW_NO_MEM;
+    }
+
+    tx_frame_t *f = &tx_queue[(tx_head + tx_count) % ESPNOW_SIM_MAX_QUEUE];
+    memcpy(f->dst, peer_addr, ESP_NOW_ETH_ALEN);
+    memcpy(f->data, data, len);
+    f->len = len;
+    f->deliver_mask = 0;
+
+    int attempts = 0;
+    if (broadcast) {
+        attempts = 1;
+        f->status = ESP_NOW_SEND_SUCCESS;
+        for (int node = 0; node < config.node_count; node++) {
+            if (node == config.node_id) {
+                continue;
+            }
+            if (attempt_lost()) {
+                stats.tx_lost++;
+            }
+            else {
+                f->deliver_mask |= 1U << node;
+            }
+        }
+    }
+    else {
+        int dst = node_of(peer_addr);
+        f->status = ESP_NOW_SEND_FAIL;
+        while (attempts <= config.retries) {
+            attempts++;
+            // Simülasyonda olmayan bir adrese MAC ACK'i hiç gelmez
+            if (dst >= 0 && dst != config.node_id && !attempt_lost()) {
+                f->status = ESP_NOW_SEND_SUCCESS;
+                f->deliver_mask = 1U << dst;
+                break;
+            }
+            stats.tx_lost++;
+        }
+        if (f->status != ESP_NOW_SEND_SUCCESS) {
+            stats.tx_failed++;
+        }
+    }
+
+    int64_t now_us = sim_now_us();
+    int64_t start_us = air_free_us > now_us ? air_free_us : now_us;
+    f->done_us = start_us + (int64_t)attempts * airtime_us(len);
+    air_free_us = f->done_us;
+    stats.tx_frames++;
+    stats.tx_attempts += attempts;
+    tx_count++;
+    portEXIT_CRITICAL(&sim_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer) {
+    if (!now_ready) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (peer == NULL) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+    esp_err_t err = ESP_ERR_ESPNOW_FULL;
+    portENTER_CRITICAL(&sim_lock);
+    if (find_peer(peer->peer_addr) >= 0) {
+        err = ESP_ERR_ESPNOW_EXIST;
+    }
+    else {
+        for (int i = 0; i < ESP_NOW_MAX_TOTAL_PEER_NUM; i++) {
+            if (!peer_used[i]) {
+                peers[i] = *peer;
+                peer_used[i] = true;
+                err = ESP_OK;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&sim_lock);
+    return err;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr) {
+    if (peer_addr == NULL) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+    portENTER_CRITICAL(&sim_lock);
+    int i = find_peer(peer_addr);
+    if (i >= 0) {
+        peer_used[i] = false;
+    }
+    portEXIT_CRITICAL(&sim_lock);
+    return i >= 0 ? ESP_OK : ESP_ERR_ESPNOW_NOT_FOUND;
+}
+
+esp_err_t esp_now_mod_peer(const esp_now_peer_info_t *peer) {
+    if (peer == NULL) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+    portENTER_CRITICAL(&sim_lock);
+    int i = find_peer(peer->peer_addr);
+    if (i >= 0) {
+        peers[i] = *peer;
+    }
+    portEXIT_CRITICAL(&sim_lock);
+    return i >= 0 ? ESP_OK : ESP_ERR_ESPNOW_NOT_FOUND;
+}
+
+esp_err_t esp_now_get_peer(const uint8_t *peer_addr, esp_now_peer_info_t *peer) {
+    if (peer_addr == NULL || peer == NULL) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+    portENTER_CRITICAL(&sim_lock);
+    int i = find_peer(peer_addr);
+    if (i >= 0) {
+        *peer = peers[i];
+    }
+    portEXIT_CRITICAL(&sim_lock);
+    return i >= 0 ? ESP_OK : ESP_ERR_ESPNOW_NOT_FOUND;
+}
+
+/* Gerçek sürücü gibi yalnızca unicast peer'ları döner */
+esp_err_t esp_now_fetch_peer(bool from_head, esp_now_peer_info_t *peer) {
+    if (peer == NULL) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+    if (from_head) {
+        fetch_index = 0;
+    }
+    esp_err_t err = ESP_ERR_ESPNOW_NOT_FOUND;
+    portENTER_CRITICAL(&sim_lock);
+    while (fetch_index < ESP_NOW_MAX_TOTAL_PEER_NUM) {
+        int i = fetch_index++;
+        if (peer_used[i] && !(peers[i].peer_addr[0] & 0x01)) {
+            *peer = peers[i];
+            err = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&sim_lock);
+    return err;
+}
+
+bool esp_now_is_peer_exist(const uint8_t *peer_addr) {
+    portENTER_CRITICAL(&sim_lock);
+    bool exists = peer_addr != NULL && find_peer(peer_addr) >= 0;
+    portEXIT_CRITICAL(&sim_lock);
+    return exists;
+}
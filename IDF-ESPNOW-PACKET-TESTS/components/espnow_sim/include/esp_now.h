@@ -0,0 +1,88 @@
+/**
+ * Host derlemesi için esp_now.h. Yalnızca IDF linux hedefinde derlenir ve
+ * esp_wifi'daki esp_now.h'ın bu depodaki bileşenlerin kullandığı alt kümesini
+ * aynı isim ve imzalarla sunar; çerçeveler espnow_sim'in UDP üzerinden
+ * simüle ettiği radyoya gider (bkz. espnow_sim.h).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ERR_ESPNOW_BASE         (ESP_ERR_WIFI_BASE + 100)
+#define ESP_ERR_ESPNOW_NOT_INIT     (ESP_ERR_ESPNOW_BASE + 1)
+#define ESP_ERR_ESPNOW_ARG          (ESP_ERR_ESPNOW_BASE + 2)
+#define ESP_ERR_ESPNOW_NO_MEM       (ESP_ERR_ESPNOW_BASE + 3)
+#define ESP_ERR_ESPNOW_FULL         (ESP_ERR_ESPNOW_BASE + 4)
+#define ESP_ERR_ESPNOW_NOT_FOUND    (ESP_ERR_ESPNOW_BASE + 5)
+#define ESP_ERR_ESPNOW_INTERNAL     (ESP_ERR_ESPNOW_BASE + 6)
+#define ESP_ERR_ESPNOW_EXIST        (ESP_ERR_ESPNOW_BASE + 7)
+#define ESP_ERR_ESPNOW_IF           (ESP_ERR_ESPNOW_BASE + 8)
+
+#define ESP_NOW_ETH_ALEN            6
+#define ESP_NOW_KEY_LEN             16
+#define ESP_NOW_MAX_TOTAL_PEER_NUM  20
+#define ESP_NOW_MAX_DATA_LEN        250
+#define ESP_NOW_MAX_DATA_LEN_V2     1470
+
+typedef enum {
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP,
+} wifi_interface_t;
+
+/* Gerçek yapının bileşenlerin okuduğu alanları; simülasyon rssi, channel, sig_len ve timestamp'i doldurur */
+typedef struct {
+    signed rssi: 8;
+    unsigned rate: 5;
+    unsigned channel: 4;
+    signed noise_floor: 8;
+    unsigned sig_len: 12;
+    unsigned timestamp: 32;
+} wifi_pkt_rx_ctrl_t;
+
+typedef enum {
+    ESP_NOW_SEND_SUCCESS = 0,
+    ESP_NOW_SEND_FAIL,
+} esp_now_send_status_t;
+
+typedef struct {
+    uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+    uint8_t lmk[ESP_NOW_KEY_LEN];
+    uint8_t channel;
+    wifi_interface_t ifidx;
+    bool encrypt;                       // simülasyonda etkisiz, çerçeveler şifrelenmez
+    void *priv;
+} esp_now_peer_info_t;
+
+typedef struct {
+    uint8_t *src_addr;
+    uint8_t *des_addr;
+    wifi_pkt_rx_ctrl_t *rx_ctrl;
+} esp_now_recv_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const esp_now_recv_info_t *esp_now_info, const uint8_t *data, int data_len);
+typedef void (*esp_now_send_cb_t)(const uint8_t *mac_addr, esp_now_send_status_t status);
+
+esp_err_t esp_now_init(void);
+esp_err_t esp_now_deinit(void);
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+esp_err_t esp_now_unregister_recv_cb(void);
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb);
+esp_err_t esp_now_unregister_send_cb(void);
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer);
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr);
+esp_err_t esp_now_mod_peer(const esp_now_peer_info_t *peer);
+esp_err_t esp_now_get_peer(const uint8_t *peer_addr, esp_now_peer_info_t *peer);
+esp_err_t esp_now_fetch_peer(bool from_head, esp_now_peer_info_t *peer);
+bool esp_now_is_peer_exist(const uint8_t *peer_addr);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,110 @@
+/**
+ * ESP-NOW radyosunun host (IDF linux hedefi) simülasyonu.
+ *
+ * Bu bileşen yalnızca linux hedefinde derlenir ve esp_now.h'ı sağlar; böylece
+ * esp_now_send / send_cb / recv_cb üzerine kurulu bileşenler (espnow_stream,
+ * espnow_frag, espnow_fec, espnow_bench) iki kart olmadan iş istasyonunda
+ * çalışır. Her düğüm ayrı bir süreçtir ve 127.0.0.1 üzerinde base_port + node_id
+ * UDP portunu dinler; düğümün MAC adresi 02:00:00:00:00:<node_id>'dir.
+ *
+ * Radyo modeli:
+ *  - esp_now_send çerçeveyi tx_queue_len'lik TX kuyruğuna koyar; kuyruk doluysa
+ *    gerçek sürücü gibi ESP_ERR_ESPNOW_NO_MEM döner.
+ *  - Her deneme overhead_us + len * 8 / bandwidth_kbps kadar hava süresi tutar;
+ *    çerçeveler sırayla ve üst üste binmeden yayınlanır. Unicast çerçeve her
+ *    denemede loss_pct olasılıkla kaybolur ve en fazla retries kez yeniden
+ *    denenir; send_cb son denemenin bittiği anda SUCCESS ya da FAIL ile gelir.
+ *    Broadcast tek denemedir, kayıp her alıcı için ayrı çekilir ve send_cb her
+ *    zaman SUCCESS döner.
+ *  - Alıcı çerçeveyi latency_us + [0, jitter_us] sonra sırayla teslim eder;
+ *    teslim bekleyen kuyruk dolarsa çerçeve düşer (rx_dropped).
+ *  - send_cb ve recv_cb gerçek karttaki gibi tek bir "Wi-Fi" task'ından gelir.
+ *    Bu task her tick'te bir uyanır ve o ana kadar süresi dolan tüm olayları
+ *    işler: hava süresi toplamı doğru tutulur ama tek bir gidiş-dönüş en az bir
+ *    tick sürer (CONFIG_FREERTOS_HZ=1000 ile 1 ms).
+ *
+ * Her düğümün hava süresi ayrı hesaplanır; iki düğümün aynı anda gönderdiği
+ * çerçeveler çarpışmaz ve kanal paylaşımı modellenmez. Kayıp seed ile
+ * belirlenir, aynı seed ve aynı gönderim sırası aynı kayıpları üretir.
+ *
+ * Ayarlar ortam değişkenlerinden de okunabilir (espnow_sim_config_from_env):
+ * ESPNOW_SIM_NODE, ESPNOW_SIM_NODES, ESPNOW_SIM_PORT, ESPNOW_SIM_LOSS (yüzde),
+ * ESPNOW_SIM_RETRIES, ESPNOW_SIM_LATENCY_US, ESPNOW_SIM_JITTER_US,
+ * ESPNOW_SIM_KBPS, ESPNOW_SIM_OVERHEAD_US, ESPNOW_SIM_QUEUE, ESPNOW_SIM_SEED.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_now.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESPNOW_SIM_MAX_NODES    16
+#define ESPNOW_SIM_MAX_QUEUE    64      // tx_queue_len üst sınırı
+#define ESPNOW_SIM_RX_QUEUE     64      // alıcıda teslim bekleyen çerçeve sayısı
+
+typedef struct {
+    uint8_t node_id;
+    uint8_t node_count;                 // broadcast 0..node_count-1 düğümlerine (kendisi hariç) gider
+    uint16_t base_port;
+    float loss_pct;                     // deneme başına kayıp olasılığı
+    uint8_t retries;                    // unicast MAC yeniden deneme sayısı
+    uint32_t latency_us;                // yayılma + alıcıdaki işleme gecikmesi
+    uint32_t jitter_us;
+    uint32_t bandwidth_kbps;            // 0: hava süresi yalnızca overhead_us
+    uint32_t overhead_us;               // deneme başına preamble + SIFS + MAC ACK
+    uint16_t tx_queue_len;
+    uint32_t seed;
+} espnow_sim_config_t;
+
+#define ESPNOW_SIM_CONFIG_DEFAULT() {   \
+    .node_id = 0,                       \
+    .node_count = 2,                    \
+    .base_port = 47000,                 \
+    .loss_pct = 0.0f,                   \
+    .retries = 7,                       \
+    .latency_us = 500,                  \
+    .jitter_us = 0,                     \
+    .bandwidth_kbps = 1000,             \
+    .overhead_us = 300,                 \
+    .tx_queue_len = 16,                 \
+    .seed = 1,                          \
+}
+
+typedef struct {
+    uint32_t tx_frames;                 // esp_now_send'in kabul ettiği çerçeveler
+    uint32_t tx_attempts;               // yeniden denemeler dahil havaya çıkışlar
+    uint32_t tx_failed;                 // tüm denemeleri kaybolan unicast çerçeveler (send_cb FAIL)
+    uint32_t tx_lost;                   // kaybolan denemeler (broadcast'te alıcı başına)
+    uint32_t tx_queue_full;             // ESP_ERR_ESPNOW_NO_MEM dönüşleri
+    uint32_t rx_frames;                 // recv_cb'ye teslim edilen çerçeveler
+    uint32_t rx_dropped;                // teslim kuyruğu dolu olduğu için düşenler
+    uint32_t rx_foreign;                // başka düğüme gönderilmiş çerçeveler
+} espnow_sim_stats_t;
+
+/* ESPNOW_SIM_CONFIG_DEFAULT'u ortam değişkenlerindeki değerlerle doldurur */
+void espnow_sim_config_from_env(espnow_sim_config_t *cfg);
+
+/**
+ * Simülasyonu cfg ile hazırlar ve düğümün UDP soketini açar; esp_now_init'ten
+ * önce çağrılır. Çağrılmazsa esp_now_init ortam değişkenlerindeki ayarları kullanır.
+ */
+esp_err_t espnow_sim_init(const espnow_sim_config_t *cfg);
+
+/* node_id'li düğümün simülasyondaki MAC adresi */
+void espnow_sim_node_mac(uint8_t node_id, uint8_t mac[ESP_NOW_ETH_ALEN]);
+
+/* Bu düğümün MAC adresi (karttaki esp_wifi_get_mac yerine) */
+void espnow_sim_get_mac(uint8_t mac[ESP_NOW_ETH_ALEN]);
+
+void espnow_sim_get_stats(espnow_sim_stats_t *out);
+
+void espnow_sim_log_config(const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,626 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "espnow_stream.h"
+
+#define EVT_TX_PROGRESS BIT0    // kümülatif ACK ilerledi: write ve flush bekleyenleri
+#define EVT_RX_DATA     BIT1    // sıralı yeni veri geldi: read bekleyenleri
+
+static const char *TAG = "STREAM";
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t session;
+    uint32_t seq;
+} stream_data_hdr_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t session;       // ACK'lenen akışın (göndericinin) oturumu
+    uint32_t cum;           // sıradaki beklenen segment; bundan öncekilerin hepsi alındı
+    uint32_t sack;          // bit i: cum + 1 + i alındı
+    uint32_t win_end;       // gönderici bu sıra numarasına kadar (hariç) gönderebilir
+} stream_ack_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t session;
+} stream_probe_t;
+
+_Static_assert(sizeof(stream_data_hdr_t) == STREAM_HEADER_LEN, "STREAM_HEADER_LEN stream_data_hdr_t ile uyuşmuyor");
+_Static_assert(STREAM_WINDOW <= 32, "SACK bitmap'i 32 segment taşır");
+
+typedef struct {
+    uint16_t len;
+    bool sent;              // en az bir kez gönderildi
+    bool acked;             // SACK ile alındı; slot kümülatif ACK ile serbest kalır
+    bool retransmitted;     // Karn: tekrar gönderilen segmentten RTT ölçülmez
+    bool needs_retx;
+    int64_t last_sent_us;
+} tx_seg_t;
+
+static uint8_t peer_mac[ESP_NOW_ETH_ALEN];
+static EventGroupHandle_t stream_events = NULL;
+static TaskHandle_t tx_task_handle = NULL;
+static SemaphoreHandle_t send_sem = NULL;
+static volatile bool last_send_ok = false;
+static esp_timer_handle_t ack_timer = NULL;
+
+/* Tüm akış durumu; yazar/okur task'ları, gönderim task'ı, recv_cb (Wi-Fi task) ve ACK timer'ı erişir */
+static portMUX_TYPE stream_lock = portMUX_INITIALIZER_UNLOCKED;
+static stream_stats_t stats;
+
+/* Gönderim tarafı: [tx_base, tx_send_next) havada, [tx_send_next, tx_next) gönderilmeyi bekliyor, tx_next doldurulan segment */
+static uint16_t tx_session;
+static tx_seg_t tx_segs[STREAM_WINDOW];
+static uint8_t tx_buf[STREAM_WINDOW][STREAM_SEGMENT_LEN];
+static uint32_t tx_base = 0;
+static uint32_t tx_send_next = 0;
+static uint32_t tx_next = 0;
+static uint32_t peer_win_end = STREAM_WINDOW;
+static int64_t last_probe_us = 0;
+static int64_t last_ack_us = 0;
+static bool rtt_valid = false;
+static uint32_t rttvar_us = 0;
+static uint32_t rto_base_us = STREAM_INITIAL_RTO_MS * 1000;    // geri çekilme (backoff) uygulanmamış RTO
+static uint8_t frame_buf[STREAM_FRAME_LEN];
+
+/* Alım tarafı: [rx_read, rx_next) sıralı ve okunmayı bekliyor, rx_next ilk eksik segment */
+static bool rx_session_valid = false;
+static uint16_t rx_session;
+static uint8_t rx_buf[STREAM_WINDOW][STREAM_SEGMENT_LEN];
+static uint16_t rx_len[STREAM_WINDOW];
+static bool rx_present[STREAM_WINDOW];
+static uint32_t rx_read = 0;
+static uint32_t rx_read_off = 0;
+static uint32_t rx_next = 0;
+static uint32_t rx_unacked = 0;
+static uint32_t last_adv_win_end = STREAM_WINDOW;
+
+static inline bool seq_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+/* stream_lock altında: doldurulan segment varsa doluluğu, pencere doluysa 0 */
+static uint16_t fill_len(void) {
+    return (tx_next - tx_base < STREAM_WINDOW) ? tx_segs[tx_next % STREAM_WINDOW].len : 0;
+}
+
+/* stream_lock altında */
+static void rx_reset(uint16_t session) {
+    if (rx_session_valid) {
+        stats.session_resets++;
+    }
+    rx_session_valid = true;
+    rx_session = session;
+    memset(rx_present, 0, sizeof(rx_present));
+    rx_read = 0;
+    rx_read_off = 0;
+    rx_next = 0;
+    rx_unacked = 0;
+    last_adv_win_end = STREAM_WINDOW;
+}
+
+/* stream_lock altında */
+static void build_ack(stream_ack_t *ack) {
+    ack->type = STREAM_ACK;
+    ack->session = rx_session;
+    ack->cum = rx_next;
+    ack->sack = 0;
+    for (int i = 0; i < 32; i++) {
+        uint32_t seq = rx_next + 1 + i;
+        if (seq - rx_read >= STREAM_WINDOW) {
+            break;
+        }
+        if (rx_present[seq % STREAM_WINDOW]) {
+            ack->sack |= 1UL << i;
+        }
+    }
+    ack->win_end = rx_read + STREAM_WINDOW;
+    last_adv_win_end = ack->win_end;
+    rx_unacked = 0;
+    stats.acks_sent++;
+}
+
+static void send_ack(void) {
+    stream_ack_t ack;
+    portENTER_CRITICAL(&stream_lock);
+    if (!rx_session_valid) {
+        portEXIT_CRITICAL(&stream_lock);
+        return;
+    }
+    build_ack(&ack);
+    portEXIT_CRITICAL(&stream_lock);
+    esp_now_send(peer_mac, (const uint8_t *)&ack, sizeof(ack)); // kaybolursa sonraki ACK ya da göndericinin RTO'su telafi eder
+}
+
+static void ack_timer_cb(void *arg) {
+    portENTER_CRITICAL(&stream_lock);
+    bool pending = rx_unacked > 0;
+    portEXIT_CRITICAL(&stream_lock);
+    if (pending) {
+        send_ack();
+    }
+}
+
+/* stream_lock altında; RFC 6298 */
+static void rtt_sample(int64_t rtt) {
+    uint32_t r = rtt > 0 ? (uint32_t)rtt : 1;
+    if (!rtt_valid) {
+        stats.srtt_us = r;
+        rttvar_us = r / 2;
+        rtt_valid = true;
+    }
+    else {
+        uint32_t err = stats.srtt_us > r ? stats.srtt_us - r : r - stats.srtt_us;
+        rttvar_us = (3 * rttvar_us + err) / 4;
+        stats.srtt_us = (7 * stats.srtt_us + r) / 8;
+    }
+    uint32_t rto = stats.srtt_us + 4 * rttvar_us;
+    if (rto < STREAM_MIN_RTO_MS * 1000) {
+        rto = STREAM_MIN_RTO_MS * 1000;
+    }
+    if (rto > STREAM_MAX_RTO_MS * 1000) {
+        rto = STREAM_MAX_RTO_MS * 1000;
+    }
+    rto_base_us = rto;
+    stats.rto_us = rto;
+}
+
+static void on_ack(const stream_ack_t *ack) {
+    int64_t now = esp_timer_get_time();
+    int64_t newest_sent_us = -1; // yeni ACK'lenen, tekrar gönderilmemiş en son segmentin gönderim anı
+    bool progress = false;
+
+    portENTER_CRITICAL(&stream_lock);
+    stats.acks_received++;
+    last_ack_us = now;
+
+    if (seq_before(tx_base, ack->cum) && !seq_before(tx_send_next, ack->cum)) {
+        for (uint32_t seq = tx_base; seq != ack->cum; seq++) {
+            tx_seg_t *seg = &tx_segs[seq % STREAM_WINDOW];
+            if (!seg->acked && !seg->retransmitted && seg->last_sent_us > newest_sent_us) {
+                newest_sent_us = seg->last_sent_us;
+            }
+            stats.bytes_acked += seg->len;
+            memset(seg, 0, sizeof(*seg));
+        }
+        tx_base = ack->cum;
+        stats.rto_us = rto_base_us; // yeni veri ACK'lendi, bağlantı yaşıyor: geri çekilme sıfırlanır
+        progress = true;
+    }
+    for (int i = 0; i < 32; i++) {
+        uint32_t seq = ack->cum + 1 + i;
+        if (!(ack->sack & (1UL << i)) || seq_before(seq, tx_base) || !seq_before(seq, tx_send_next)) {
+            continue;
+        }
+        tx_seg_t *seg = &tx_segs[seq % STREAM_WINDOW];
+        if (!seg->acked) {
+            seg->acked = true;
+            seg->needs_retx = false;
+            if (!seg->retransmitted && seg->last_sent_us > newest_sent_us) {
+                newest_sent_us = seg->last_sent_us;
+            }
+        }
+    }
+    if (newest_sent_us >= 0) {
+        rtt_sample(now - newest_sent_us);
+    }
+
+    /* Kendisinden sonra gönderilmiş STREAM_DUP_THRESH segment alınmışsa bu segment kaybolmuştur */
+    for (uint32_t seq = tx_base; seq != tx_send_next; seq++) {
+        tx_seg_t *seg = &tx_segs[seq % STREAM_WINDOW];
+        if (seg->acked || seg->needs_retx || !seg->sent) {
+            continue;
+        }
+        int later = 0;
+        for (uint32_t other = tx_base; other != tx_send_next; other++) {
+            const tx_seg_t *o = &tx_segs[other % STREAM_WINDOW];
+            if (o->acked && o->last_sent_us > seg->last_sent_us) {
+                later++;
+            }
+        }
+        if (later >= STREAM_DUP_THRESH) {
+            seg->needs_retx = true;
+            stats.fast_retransmits++;
+        }
+    }
+
+    if (seq_before(peer_win_end, ack->win_end)) {
+        peer_win_end = ack->win_end;
+    }
+    portEXIT_CRITICAL(&stream_lock);
+
+    if (progress) {
+        xEventGroupSetBits(stream_events, EVT_TX_PROGRESS);
+    }
+    xTaskNotifyGive(tx_task_handle);
+}
+
+static void on_data(const stream_data_hdr_t *hdr, const uint8_t *payload, int payload_len) {
+    bool ack_now = false;
+    bool wake = false;
+
+    portENTER_CRITICAL(&stream_lock);
+    if (!rx_session_valid || hdr->session != rx_session) {
+        rx_reset(hdr->session); // gönderici yeniden başladı
+    }
+    if (seq_before(hdr->seq, rx_next)) {
+        stats.duplicates++; // ACK'i kaybolmuş olabilir, tekrar ACK'lenir
+        ack_now = true;
+    }
+    else if (hdr->seq - rx_read >= STREAM_WINDOW) {
+        stats.out_of_window++;
+        ack_now = true;
+    }
+    else if (rx_present[hdr->seq % STREAM_WINDOW]) {
+        stats.duplicates++;
+        ack_now = true;
+    }
+    else {
+        int slot = hdr->seq % STREAM_WINDOW;
+        memcpy(rx_buf[slot], payload, payload_len);
+        rx_len[slot] = payload_len;
+        rx_present[slot] = true;
+        stats.segments_received++;
+
+        if (hdr->seq == rx_next) {
+            uint32_t advanced = 0;
+            while (rx_next - rx_read < STREAM_WINDOW && rx_present[rx_next % STREAM_WINDOW]) {
+                rx_next++;
+                advanced++;
+            }
+            rx_unacked += advanced;
+            wake = true;
+            ack_now = advanced > 1 || rx_unacked >= STREAM_ACK_EVERY; // boşluk dolduysa gönderici hemen öğrenmeli
+        }
+        else {
+            stats.out_of_order++;
+            ack_now = true;
+        }
+    }
+    portEXIT_CRITICAL(&stream_lock);
+
+    if (ack_now) {
+        send_ack();
+    }
+    else {
+        esp_timer_start_once(ack_timer, STREAM_ACK_DELAY_MS * 1000); // zaten çalışıyorsa hata döner, sorun değil
+    }
+    if (wake) {
+        xEventGroupSetBits(stream_events, EVT_RX_DATA);
+    }
+}
+
+bool espnow_stream_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    if (len < 1 || (data[0] != STREAM_DATA && data[0] != STREAM_ACK && data[0] != STREAM_PROBE)) {
+        return false;
+    }
+    if (tx_task_handle == NULL || memcmp(recv_info->src_addr, peer_mac, ESP_NOW_ETH_ALEN) != 0) {
+        return true; // başlatılmamış ya da başka bir cihazın akışı
+    }
+
+    if (data[0] == STREAM_DATA && len > STREAM_HEADER_LEN && len <= STREAM_FRAME_LEN) {
+        stream_data_hdr_t hdr;
+        memcpy(&hdr, data, sizeof(hdr));
+        on_data(&hdr, data + STREAM_HEADER_LEN, len - STREAM_HEADER_LEN);
+    }
+    else if (data[0] == STREAM_ACK && len == sizeof(stream_ack_t)) {
+        stream_ack_t ack;
+        memcpy(&ack, data, sizeof(ack));
+        if (ack.session == tx_session) { // önceki oturumdan kalan ACK'ler yok sayılır
+            on_ack(&ack);
+        }
+    }
+    else if (data[0] == STREAM_PROBE && len == sizeof(stream_probe_t)) {
+        stream_probe_t probe;
+        memcpy(&probe, data, sizeof(probe));
+        portENTER_CRITICAL(&stream_lock);
+        if (!rx_session_valid || probe.session != rx_session) {
+            rx_reset(probe.session);
+        }
+        portEXIT_CRITICAL(&stream_lock);
+        send_ack();
+    }
+    return true;
+}
+
+void espnow_stream_on_send(esp_now_send_status_t status) {
+    if (send_sem == NULL) {
+        return;
+    }
+    last_send_ok = (status == ESP_NOW_SEND_SUCCESS);
+    xSemaphoreGive(send_sem);
+}
+
+/* Gönderilecek bir çerçeve seçip frame_buf'a yazar. Çerçeve uzunluğunu, gönderilecek bir şey yoksa 0 döner. */
+static int pick_frame(uint32_t *seq_out, bool *is_data) {
+    int64_t now = esp_timer_get_time();
+    int frame_len = 0;
+
+    portENTER_CRITICAL(&stream_lock);
+    bool expired = false;
+    for (uint32_t seq = tx_base; seq != tx_send_next; seq++) {
+        tx_seg_t *seg = &tx_segs[seq % STREAM_WINDOW];
+        if (!seg->acked && !seg->needs_retx && now - seg->last_sent_us >= stats.rto_us) {
+            seg->needs_retx = true;
+            expired = true;
+        }
+    }
+    if (expired) {
+        stats.rto_timeouts++;
+        stats.rto_us = stats.rto_us * 2 > STREAM_MAX_RTO_MS * 1000 ? STREAM_MAX_RTO_MS * 1000 : stats.rto_us * 2;
+    }
+
+    /* Önce kayıp segmentler, sonra pencerenin izin verdiği yeni segmentler */
+    uint32_t seq = tx_base;
+    while (seq != tx_send_next && !(tx_segs[seq % STREAM_WINDOW].needs_retx && !tx_segs[seq % STREAM_WINDOW].acked)) {
+        seq++;
+    }
+    bool retx = (seq != tx_send_next);
+    if (!retx && tx_send_next == tx_next && tx_base == tx_send_next && fill_len() > 0 && seq_before(tx_next, peer_win_end)) {
+        tx_next++; // havada veri yok: dolmamış segmenti beklemeden gönder
+    }
+    if (retx || (tx_send_next != tx_next && seq_before(tx_send_next, peer_win_end))) {
+        tx_seg_t *seg = &tx_segs[seq % STREAM_WINDOW];
+        stream_data_hdr_t hdr = {.type = STREAM_DATA, .session = tx_session, .seq = seq};
+        memcpy(frame_buf, &hdr, sizeof(hdr));
+        memcpy(frame_buf + sizeof(hdr), tx_buf[seq % STREAM_WINDOW], seg->len);
+        frame_len = sizeof(hdr) + seg->len;
+        if (retx) {
+            seg->retransmitted = true;
+            seg->needs_retx = false;
+            stats.retransmits++;
+        }
+        else {
+            tx_send_next++;
+            stats.segments_sent++;
+        }
+        seg->sent = true;
+        seg->last_sent_us = now;
+        *seq_out = seq;
+        *is_data = true;
+    }
+    else if (tx_base == tx_send_next && (tx_send_next != tx_next || fill_len() > 0) && !seq_before(tx_send_next, peer_win_end) &&
+             now - last_probe_us >= stats.rto_us && now - last_ack_us >= stats.rto_us) {
+        stream_probe_t probe = {.type = STREAM_PROBE, .session = tx_session}; // pencere RTO boyunca kapalı kaldı, güncellemesi kaybolmuş olabilir
+        memcpy(frame_buf, &probe, sizeof(probe));
+        frame_len = sizeof(probe);
+        last_probe_us = now;
+        stats.probes++;
+        *is_data = false;
+    }
+    portEXIT_CRITICAL(&stream_lock);
+    return frame_len;
+}
+
+/* Bir sonraki RTO ya da sonda zamanına kadar beklenecek tick */
+static TickType_t next_wait(void) {
+    int64_t now = esp_timer_get_time();
+    int64_t deadline = INT64_MAX;
+
+    portENTER_CRITICAL(&stream_lock);
+    for (uint32_t seq = tx_base; seq != tx_send_next; seq++) {
+        const tx_seg_t *seg = &tx_segs[seq % STREAM_WINDOW];
+        if (!seg->acked && seg->last_sent_us + stats.rto_us < deadline) {
+            deadline = seg->last_sent_us + stats.rto_us;
+        }
+    }
+    if (tx_base == tx_send_next && (tx_send_next != tx_next || fill_len() > 0)) {
+        deadline = (last_probe_us > last_ack_us ? last_probe_us : last_ack_us) + stats.rto_us;
+    }
+    portEXIT_CRITICAL(&stream_lock);
+
+    if (deadline == INT64_MAX) {
+        return portMAX_DELAY;
+    }
+    if (deadline <= now) {
+        return 0;
+    }
+    TickType_t ticks = pdMS_TO_TICKS((deadline - now + 999) / 1000);
+    return ticks > 0 ? ticks : 1;
+}
+
+/**
+ * Gönderim task'ı. Yeni veri, ACK ya da RTO/sonda zamanında uyanır ve
+ * gönderilecek çerçeve kalmayana kadar gönderir. Her çerçeve için send_cb
+ * beklenir; böylece Wi-Fi kuyruğu taşmaz ve başarısız çerçeve hemen kayıp
+ * işaretlenir.
+ */
+static void stream_tx_task() {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, next_wait());
+
+        uint32_t seq;
+        bool is_data = false;
+        int frame_len;
+        while ((frame_len = pick_frame(&seq, &is_data)) > 0) {
+            xSemaphoreTake(send_sem, 0); // ACK gönderimlerinden kalmış bildirim
+            esp_err_t err = esp_now_send(peer_mac, frame_buf, frame_len);
+            bool ok = false;
+            if (err == ESP_OK) {
+                ok = xSemaphoreTake(send_sem, pdMS_TO_TICKS(STREAM_SEND_TIMEOUT_MS)) == pdTRUE && last_send_ok;
+            }
+            else if (err == ESP_ERR_ESPNOW_NO_MEM) {
+                vTaskDelay(1);
+            }
+            else {
+                ESP_LOGE(TAG, "Gönderim hatası: %s", esp_err_to_name(err));
+                vTaskDelay(1);
+            }
+            if (!ok && is_data) {
+                portENTER_CRITICAL(&stream_lock);
+                stats.mac_failures++;
+                if (!seq_before(seq, tx_base) && seq_before(seq, tx_send_next) && !tx_segs[seq % STREAM_WINDOW].acked) {
+                    tx_segs[seq % STREAM_WINDOW].needs_retx = true;
+                }
+                portEXIT_CRITICAL(&stream_lock);
+            }
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t espnow_stream_init(const uint8_t *peer_addr) {
+    if (tx_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    memcpy(peer_mac, peer_addr, ESP_NOW_ETH_ALEN);
+    tx_session = esp_random() & 0xFFFF;
+    stats.rto_us = STREAM_INITIAL_RTO_MS * 1000;
+
+    stream_events = xEventGroupCreate();
+    send_sem = xSemaphoreCreateBinary();
+    if (stream_events == NULL || send_sem == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    const esp_timer_create_args_t ack_timer_args = {
+        .callback = ack_timer_cb,
+        .name = "stream_ack",
+    };
+    esp_err_t err = esp_timer_create(&ack_timer_args, &ack_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (xTaskCreate(stream_tx_task, "stream_tx_task", 4096, NULL, 5, &tx_task_handle) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Akış başlatıldı, oturum %04x, pencere %d x %d byte", tx_session, STREAM_WINDOW, STREAM_SEGMENT_LEN);
+    return ESP_OK;
+}
+
+size_t espnow_stream_write(const void *data, size_t len, TickType_t timeout) {
+    const uint8_t *src = data;
+    size_t written = 0;
+    TickType_t start = xTaskGetTickCount();
+
+    while (written < len) {
+        xEventGroupClearBits(stream_events, EVT_TX_PROGRESS);
+        portENTER_CRITICAL(&stream_lock);
+        size_t copied = 0;
+        while (written + copied < len && tx_next - tx_base < STREAM_WINDOW) {
+            int slot = tx_next % STREAM_WINDOW;
+            size_t n = STREAM_SEGMENT_LEN - tx_segs[slot].len;
+            if (n > len - written - copied) {
+                n = len - written - copied;
+            }
+            memcpy(tx_buf[slot] + tx_segs[slot].len, src + written + copied, n);
+            tx_segs[slot].len += n;
+            copied += n;
+            if (tx_segs[slot].len == STREAM_SEGMENT_LEN) {
+                tx_next++;
+            }
+        }
+        portEXIT_CRITICAL(&stream_lock);
+        written += copied;
+        xTaskNotifyGive(tx_task_handle);
+
+        if (written < len) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (timeout != portMAX_DELAY && elapsed >= timeout) {
+                break;
+            }
+            xEventGroupWaitBits(stream_events, EVT_TX_PROGRESS, pdFALSE, pdFALSE,
+                                timeout == portMAX_DELAY ? portMAX_DELAY : timeout - elapsed);
+        }
+    }
+    return written;
+}
+
+esp_err_t espnow_stream_flush(TickType_t timeout) {
+    TickType_t start = xTaskGetTickCount();
+
+    while (1) {
+        xEventGroupClearBits(stream_events, EVT_TX_PROGRESS);
+        portENTER_CRITICAL(&stream_lock);
+        if (fill_len() > 0) {
+            tx_next++; // dolmamış son segment de gönderilsin
+        }
+        bool done = (tx_base == tx_next);
+        portEXIT_CRITICAL(&stream_lock);
+        if (done) {
+            return ESP_OK;
+        }
+        xTaskNotifyGive(tx_task_handle);
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (timeout != portMAX_DELAY && elapsed >= timeout) {
+            return ESP_ERR_TIMEOUT;
+        }
+        xEventGroupWaitBits(stream_events, EVT_TX_PROGRESS, pdFALSE, pdFALSE,
+                            timeout == portMAX_DELAY ? portMAX_DELAY : timeout - elapsed);
+    }
+}
+
+size_t espnow_stream_read(void *buf, size_t len, TickType_t timeout) {
+    uint8_t *dst = buf;
+    TickType_t start = xTaskGetTickCount();
+
+    while (1) {
+        xEventGroupClearBits(stream_events, EVT_RX_DATA);
+        size_t got = 0;
+        bool freed = false;
+        portENTER_CRITICAL(&stream_lock);
+        while (got < len && rx_read != rx_next) {
+            int slot = rx_read % STREAM_WINDOW;
+            size_t n = rx_len[slot] - rx_read_off;
+            if (n > len - got) {
+                n = len - got;
+            }
+            memcpy(dst + got, rx_buf[slot] + rx_read_off, n);
+            got += n;
+            rx_read_off += n;
+            if (rx_read_off == rx_len[slot]) {
+                rx_present[slot] = false;
+                rx_read++;
+                rx_read_off = 0;
+                freed = true;
+            }
+        }
+        stats.bytes_read += got;
+        // Göndericinin bildiği pencere yarıdan azsa açılan yer hemen duyurulur
+        bool update = freed && last_adv_win_end - rx_next < STREAM_WINDOW / 2;
+        portEXIT_CRITICAL(&stream_lock);
+
+        if (update) {
+            send_ack();
+        }
+        if (got > 0) {
+            return got;
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (timeout != portMAX_DELAY && elapsed >= timeout) {
+            return 0;
+        }
+        xEventGroupWaitBits(stream_events, EVT_RX_DATA, pdFALSE, pdFALSE,
+                            timeout == portMAX_DELAY ? portMAX_DELAY : timeout - elapsed);
+    }
+}
+
+void espnow_stream_get_stats(stream_stats_t *out) {
+    portENTER_CRITICAL(&stream_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stream_lock);
+}
+
+void espnow_stream_log_stats(const char *tag) {
+    stream_stats_t s;
+    espnow_stream_get_stats(&s);
+    if (s.segments_sent > 0) {
+        ESP_LOGI(tag, "Akış gönderim: %llu byte ACK'li, %lu segment, %lu tekrar (%lu hızlı, %lu RTO olayı), %lu MAC hatası, %lu sonda, "
+                 "%lu ACK, SRTT %.2f ms, RTO %.2f ms",
+                 s.bytes_acked, s.segments_sent, s.retransmits, s.fast_retransmits, s.rto_timeouts, s.mac_failures, s.probes,
+                 s.acks_received, s.srtt_us / 1000.0, s.rto_us / 1000.0);
+    }
+    if (s.segments_received > 0) {
+        ESP_LOGI(tag, "Akış alım: %llu byte okundu, %lu segment, %lu tekrar, %lu sırasız, %lu pencere dışı, %lu ACK, %lu oturum sıfırlama",
+                 s.bytes_read, s.segments_received, s.duplicates, s.out_of_order, s.out_of_window, s.acks_sent, s.session_resets);
+    }
+}
@@ -0,0 +1,117 @@
+/**
+ * ESP-NOW üzerinde seçici tekrarlı (selective-repeat ARQ) güvenilir ve sıralı
+ * bayt akışı.
+ *
+ * MAC katmanının ACK'i (send_cb) yalnızca tek bir çerçevenin havada kaybolup
+ * kaybolmadığını söyler; alıcının kuyruğu dolduğunda düşen, send_cb'si
+ * başarısız dönen ya da gönderici yeniden başladığında yarım kalan veriyi
+ * kurtarmaz. Bu katman yazılan baytları STREAM_SEGMENT_LEN'lik segmentlere
+ * böler, her segmente sıra numarası verir ve alıcıdan gelen ACK'lerle teslimi
+ * uçtan uca doğrular:
+ *
+ *  - Alıcı ACK'i kümülatif sıra numarasını (sıradaki beklenen segment), onun
+ *    ötesindeki 32 segmentin alındı bitmap'ini (SACK) ve pencere sonunu taşır.
+ *  - Gönderici yalnızca kaybolan segmentleri tekrar gönderir. Kendisinden sonra
+ *    gönderilmiş STREAM_DUP_THRESH segment ACK'lenmiş ama kendisi ACK'lenmemiş
+ *    segment kayıp sayılır (hızlı tekrar); hiç ACK gelmezse RTT'den hesaplanan
+ *    RTO dolunca tekrar gönderilir (her zaman aşımında RTO ikiye katlanır).
+ *  - Akış kontrolü: alıcı, uygulamanın henüz okumadığı segmentleri pencerede
+ *    tutar ve okunmamış veri arttıkça pencere sonunu ilerletmez; gönderici
+ *    pencere sonunu geçemez. Pencere kapalıyken bekleyen veri varsa gönderici
+ *    RTO aralıklarıyla sonda (probe) göndererek pencere güncellemesini ister.
+ *
+ * Her iki taraf da aynı anda yazıp okuyabilir, tek bir peer ile tek bir akış
+ * vardır. Gönderici her init'te rastgele bir oturum kimliği seçer; alıcı yeni
+ * bir oturum gördüğünde alım durumunu sıfırlar (gönderici yeniden başladıysa
+ * yarım kalan veri atılır).
+ *
+ * Projeler kendi callback'lerinden espnow_stream_on_send ve espnow_stream_on_recv'i
+ * çağırır; on_recv true dönerse paket akışa aittir. ACK çerçevelerinin send_cb'si
+ * de on_send'e düşer; iki yönlü kullanımda send_cb durumu bazen yanlış çerçeveye
+ * atfedilebilir, bu durumda kayıp segment yine SACK/RTO ile kurtarılır.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_now.h"
+#include "espnow_msg_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAM_DATA             ESPNOW_MSG_STREAM_DATA
+#define STREAM_ACK              ESPNOW_MSG_STREAM_ACK
+#define STREAM_PROBE            ESPNOW_MSG_STREAM_PROBE
+
+#define STREAM_HEADER_LEN       7       // tip + oturum + sıra numarası
+#define STREAM_FRAME_LEN        1024    // throughput testlerinin PACKET_SIZE'ı ile aynı
+#define STREAM_SEGMENT_LEN      (STREAM_FRAME_LEN - STREAM_HEADER_LEN)
+#define STREAM_WINDOW           16      // her iki taraftaki segment tamponu sayısı (en fazla 32, SACK bitmap'i)
+#define STREAM_DUP_THRESH       3       // hızlı tekrar için kendisinden sonra gönderilip ACK'lenen segment sayısı
+#define STREAM_ACK_EVERY        2       // sıralı gelen her N segmentte bir ACK
+#define STREAM_ACK_DELAY_MS     5       // N'e ulaşılamazsa bekleyen ACK bu süre sonra gönderilir
+#define STREAM_INITIAL_RTO_MS   200
+#define STREAM_MIN_RTO_MS       20
+#define STREAM_MAX_RTO_MS       1000
+#define STREAM_SEND_TIMEOUT_MS  100     // bir çerçevenin send_cb'si için bekleme süresi
+
+typedef struct {
+    /* gönderici */
+    uint64_t bytes_acked;               // alıcının kümülatif ACK'lediği bayt
+    uint32_t segments_sent;             // ilk kez gönderilen segmentler
+    uint32_t retransmits;               // tüm tekrar gönderimler
+    uint32_t fast_retransmits;          // SACK ile kayıp sayılıp tekrar gönderilenler
+    uint32_t rto_timeouts;              // RTO dolması olayları
+    uint32_t mac_failures;              // send_cb'si başarısız dönen veri çerçeveleri
+    uint32_t probes;                    // pencere kapalıyken gönderilen sondalar
+    uint32_t acks_received;
+    uint32_t srtt_us;
+    uint32_t rto_us;
+    /* alıcı */
+    uint64_t bytes_read;                // uygulamanın okuduğu bayt
+    uint32_t segments_received;         // pencereye alınan yeni segmentler
+    uint32_t duplicates;
+    uint32_t out_of_order;              // beklenenden ileri sıra numarasıyla gelen segmentler
+    uint32_t out_of_window;             // pencere dışında kaldığı için atılan segmentler
+    uint32_t acks_sent;
+    uint32_t session_resets;            // yeni oturum görülüp sıfırlanan alım durumu
+} stream_stats_t;
+
+/**
+ * Akışı peer_addr ile başlatır ve gönderim task'ını oluşturur. peer_addr peer
+ * olarak eklenmiş olmalıdır; recv_cb kaydından önce çağrılır.
+ */
+esp_err_t espnow_stream_init(const uint8_t *peer_addr);
+
+/**
+ * data'yı gönderim penceresine kopyalar; pencere doluysa yer açılana ya da
+ * timeout dolana kadar bloklar. Kabul edilen bayt sayısını döner. Dolmamış son
+ * segment, havada veri yoksa hemen, aksi halde ACK'ler gelince gönderilir.
+ */
+size_t espnow_stream_write(const void *data, size_t len, TickType_t timeout);
+
+/* Yazılan tüm baytlar alıcı tarafından kümülatif ACK'lenene kadar bekler */
+esp_err_t espnow_stream_flush(TickType_t timeout);
+
+/* Sıralı veriden en fazla len bayt okur; veri yoksa timeout kadar bekler. Okunan bayt sayısını döner. */
+size_t espnow_stream_read(void *buf, size_t len, TickType_t timeout);
+
+/* send_cb'den çağrılır */
+void espnow_stream_on_send(esp_now_send_status_t status);
+
+/* recv_cb'nin başında çağrılır; akış paketiyse işler ve true döner */
+bool espnow_stream_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
+
+void espnow_stream_get_stats(stream_stats_t *out);
+
+void espnow_stream_log_stats(const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
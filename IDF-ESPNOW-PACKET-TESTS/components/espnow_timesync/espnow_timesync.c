@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "espnow_timesync.h"
+
+static const char *TAG = "TIMESYNC";
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t id;
+    int64_t t1;     // istemci: isteğin gönderim anı
+    int64_t t2;     // sunucu: isteğin geliş anı
+    int64_t t3;     // sunucu: yanıtın gönderim anı
+} timesync_msg_t;
+
+typedef struct {
+    int64_t local_us;   // örneğin yerel zamanı ((t1 + t4) / 2)
+    int64_t offset_us;
+} fit_point_t;
+
+static uint8_t server_mac[ESP_NOW_ETH_ALEN];
+static esp_timer_handle_t request_timer = NULL;
+static uint16_t next_id = 0;
+
+/* Bekleyen istek, filtre grubu ve yayınlanan doğru; timer task'ı ve recv_cb (Wi-Fi task) yazar, diğer task'lar okur */
+static portMUX_TYPE sync_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t outstanding_id = 0;
+static bool outstanding = false;
+static fit_point_t group_best;
+static uint32_t group_best_delay_us = UINT32_MAX;
+static int group_count = 0;
+
+/* offset(t) = offset_us + slope * (t - ref_us) */
+typedef struct {
+    double offset_us;
+    double slope;
+    int64_t ref_us;
+    double rms_us;
+} fit_t;
+
+static fit_t fit;               // yalnızca recv_cb yazar (sync_lock ile), diğer task'lar kilit altında kopyalar
+static timesync_state_t state;
+
+/**
+ * Doğrunun noktaları yalnızca recv_cb'de okunur ve yazılır, kilit gerekmez.
+ * Yazılımla emüle edilen double hesapları bu yüzden kritik bölümün dışında
+ * yapılır; kilit yalnızca sonuç yayınlanırken tutulur.
+ */
+static fit_point_t points[TIMESYNC_FIT_POINTS];
+static int point_count = 0;
+static int point_head = 0;
+
+static double offset_at(const fit_t *f, int64_t local_us) {
+    return f->offset_us + f->slope * (double)(local_us - f->ref_us);
+}
+
+static void refit(fit_t *out) {
+    double mean_x = 0, mean_y = 0;
+    for (int i = 0; i < point_count; i++) {
+        mean_x += (double)(points[i].local_us - points[0].local_us);
+        mean_y += (double)points[i].offset_us;
+    }
+    mean_x /= point_count;
+    mean_y /= point_count;
+
+    double sxx = 0, sxy = 0;
+    for (int i = 0; i < point_count; i++) {
+        double dx = (double)(points[i].local_us - points[0].local_us) - mean_x;
+        sxx += dx * dx;
+        sxy += dx * ((double)points[i].offset_us - mean_y);
+    }
+
+    out->ref_us = points[0].local_us + (int64_t)mean_x;
+    out->offset_us = mean_y;
+    out->slope = sxx > 0 ? sxy / sxx : 0.0;
+
+    double sq = 0;
+    for (int i = 0; i < point_count; i++) {
+        double r = (double)points[i].offset_us - offset_at(out, points[i].local_us);
+        sq += r * r;
+    }
+    out->rms_us = sqrt(sq / point_count);
+}
+
+/* recv_cb'den, sync_lock dışında çağrılır */
+static void add_fit_point(const fit_point_t *p, uint32_t delay_us) {
+    bool step = false;
+    if (point_count > 0 && fabs((double)p->offset_us - offset_at(&fit, p->local_us)) > TIMESYNC_STEP_US) {
+        // Sunucu yeniden başladı ya da saati sıçradı; eski noktalar artık geçersiz
+        point_count = 0;
+        point_head = 0;
+        step = true;
+    }
+    points[point_head] = *p;
+    point_head = (point_head + 1) % TIMESYNC_FIT_POINTS;
+    if (point_count < TIMESYNC_FIT_POINTS) {
+        point_count++;
+    }
+    fit_t next;
+    refit(&next);
+
+    portENTER_CRITICAL(&sync_lock);
+    fit = next;
+    if (step) {
+        state.steps++;
+    }
+    state.valid = true;
+    state.uncertainty_us = delay_us / 2;
+    state.residual_rms_us = next.rms_us;
+    state.drift_ppm = next.slope * 1e6;
+    state.fit_points = point_count;
+    portEXIT_CRITICAL(&sync_lock);
+}
+
+static void on_response(const timesync_msg_t *msg, int64_t t4) {
+    int64_t delay = (t4 - msg->t1) - (msg->t3 - msg->t2);
+    if (delay < 0) {
+        delay = 0;
+    }
+    fit_point_t sample = {
+        .local_us = msg->t1 + (t4 - msg->t1) / 2,
+        .offset_us = ((msg->t2 - msg->t1) + (msg->t3 - t4)) / 2,
+    };
+    fit_point_t best;
+    uint32_t best_delay_us = 0;
+    bool group_done = false;
+
+    portENTER_CRITICAL(&sync_lock);
+    if (!outstanding || msg->id != outstanding_id) {
+        portEXIT_CRITICAL(&sync_lock);
+        return; // zaman aşımına uğramış isteğin yanıtı
+    }
+    outstanding = false;
+    state.exchanges++;
+    if ((uint32_t)delay < group_best_delay_us) {
+        group_best_delay_us = (uint32_t)delay;
+        group_best = sample;
+    }
+    if (++group_count >= TIMESYNC_FILTER_N) {
+        best = group_best;
+        best_delay_us = group_best_delay_us;
+        group_done = true;
+        group_count = 0;
+        group_best_delay_us = UINT32_MAX;
+    }
+    portEXIT_CRITICAL(&sync_lock);
+
+    if (group_done) {
+        add_fit_point(&best, best_delay_us);
+    }
+}
+
+static void request_timer_cb(void *arg) {
+    timesync_msg_t msg = {
+        .type = TIMESYNC_REQUEST,
+        .id = ++next_id,
+    };
+    portENTER_CRITICAL(&sync_lock);
+    if (outstanding) {
+        state.lost++;
+    }
+    outstanding_id = msg.id;
+    outstanding = true;
+    portEXIT_CRITICAL(&sync_lock);
+
+    msg.t1 = esp_timer_get_time();
+    if (esp_now_send(server_mac, (const uint8_t *)&msg, sizeof(msg)) != ESP_OK) {
+        portENTER_CRITICAL(&sync_lock);
+        outstanding = false;
+        portEXIT_CRITICAL(&sync_lock);
+    }
+}
+
+esp_err_t espnow_timesync_start_client(const uint8_t *server_addr, uint32_t period_ms) {
+    if (request_timer != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    memcpy(server_mac, server_addr, ESP_NOW_ETH_ALEN);
+    const esp_timer_create_args_t args = {
+        .callback = request_timer_cb,
+        .name = "timesync",
+    };
+    esp_err_t err = esp_timer_create(&args, &request_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return esp_timer_start_periodic(request_timer, (uint64_t)period_ms * 1000);
+}
+
+bool espnow_timesync_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) {
+    int64_t now = esp_timer_get_time();
+    if (len != sizeof(timesync_msg_t) || (data[0] != TIMESYNC_REQUEST && data[0] != TIMESYNC_RESPONSE)) {
+        return false;
+    }
+    timesync_msg_t msg;
+    memcpy(&msg, data, sizeof(msg));
+
+    if (msg.type == TIMESYNC_RESPONSE) {
+        on_response(&msg, now);
+        return true;
+    }
+
+    if (!esp_now_is_peer_exist(recv_info->src_addr)) {
+        esp_now_peer_info_t peer = {0};
+        peer.channel = 0;  // o anki kanal
+        peer.ifidx = WIFI_IF_STA;
+        peer.encrypt = false;
+        memcpy(peer.peer_addr, recv_info->src_addr, ESP_NOW_ETH_ALEN);
+        esp_now_add_peer(&peer);
+    }
+    msg.type = TIMESYNC_RESPONSE;
+    msg.t2 = now;
+    msg.t3 = esp_timer_get_time();
+    esp_now_send(recv_info->src_addr, (const uint8_t *)&msg, sizeof(msg));
+    return true;
+}
+
+void espnow_timesync_get_state(timesync_state_t *out) {
+    fit_t f;
+    portENTER_CRITICAL(&sync_lock);
+    *out = state;
+    f = fit;
+    portEXIT_CRITICAL(&sync_lock);
+    out->offset_us = out->valid ? (int64_t)offset_at(&f, esp_timer_get_time()) : 0;
+}
+
+bool espnow_timesync_remote_to_local(int64_t remote_us, int64_t *local_us) {
+    fit_t f;
+    portENTER_CRITICAL(&sync_lock);
+    bool valid = state.valid;
+    f = fit;
+    portEXIT_CRITICAL(&sync_lock);
+    if (valid) {
+        // offset yerel zamana bağlı; önce sabit ofsetle yaklaşıp bir kez düzelt
+        int64_t guess = remote_us - (int64_t)f.offset_us;
+        *local_us = remote_us - (int64_t)offset_at(&f, guess);
+    }
+    return valid;
+}
+
+bool espnow_timesync_local_to_remote(int64_t local_us, int64_t *remote_us) {
+    fit_t f;
+    portENTER_CRITICAL(&sync_lock);
+    bool valid = state.valid;
+    f = fit;
+    portEXIT_CRITICAL(&sync_lock);
+    if (valid) {
+        *remote_us = local_us + (int64_t)offset_at(&f, local_us);
+    }
+    return valid;
+}
+
+void espnow_timesync_log(const char *tag) {
+    timesync_state_t s;
+    espnow_timesync_get_state(&s);
+    if (!s.valid) {
+        ESP_LOGW(tag, "Saat senkronizasyonu henüz yok (%lu değişim, %lu kayıp)", (unsigned long)s.exchanges, (unsigned long)s.lost);
+        return;
+    }
+    ESP_LOGI(tag, "Saat ofseti: %lld us, kayma: %.2f ppm, hizalama hatası <= %lu us (artık RMS %.1f us, %lu nokta), değişim: %lu, kayıp: %lu, sıçrama: %lu",
+             s.offset_us, s.drift_ppm, (unsigned long)s.uncertainty_us, s.residual_rms_us, (unsigned long)s.fit_points,
+             (unsigned long)s.exchanges, (unsigned long)s.lost, (unsigned long)s.steps);
+}
@@ -0,0 +1,80 @@
+/**
+ * ESP-NOW üzerinden NTP tarzı saat ofseti ve kayma (drift) tahmini.
+ *
+ * İstemci her TIMESYNC_PERIOD_MS'de sunucuya t1 (kendi saatiyle gönderim anı)
+ * içeren bir istek yollar. Sunucu isteğin geliş anını t2, yanıtın gönderim anını
+ * t3 olarak ekleyip geri gönderir, istemci yanıtın geliş anını t4 olarak alır:
+ *
+ *   ofset  = ((t2 - t1) + (t3 - t4)) / 2      (sunucu saati - istemci saati)
+ *   gecikme = (t4 - t1) - (t3 - t2)           (gidiş-dönüş, sunucudaki bekleme hariç)
+ *
+ * Ofsetin hatası en fazla gecikme / 2'dir (yol asimetrisi bilinemez). Bu yüzden
+ * her TIMESYNC_FILTER_N örnekten yalnızca gecikmesi en küçük olan tutulur; bu
+ * örnekler yerel zamana karşı en küçük kareler doğrusuna oturtularak ofset ve
+ * kayma (ppm) izlenir. Sunucunun saati sıçrarsa (yeniden başlama) doğru sıfırlanır.
+ *
+ * Her iki cihaz da kendi recv_cb'sinden espnow_timesync_on_recv'i çağırır; sunucu
+ * tarafında başka bir şey gerekmez. true dönen paketler senkronizasyona aittir.
+ * Zaman damgaları esp_timer_get_time() ile recv_cb/gönderim anında alınır; Wi-Fi
+ * task'ındaki kuyruk gecikmeleri gecikme ölçümüne, dolayısıyla belirsizliğe girer.
+ *
+ * Tek yön gecikme yalnızca çerçevesinde gönderim zamanı taşıyan testlerde
+ * raporlanır: COUNTER-TEST (alıcı istemci, gönderici sunucu) ve ACK-DUAL
+ * (gönderici istemci, alıcı sunucu). TIMED, BUTTON ve BROADCAST veri çerçeveleri
+ * yalnızca sıra numarası, PRBS dolgu ve CRC32 taşır; bunlarda tek yön gecikme
+ * için önce çerçeveye gönderim zamanı eklenmelidir.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_now.h"
+#include "espnow_msg_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMESYNC_REQUEST    ESPNOW_MSG_TIMESYNC_REQUEST
+#define TIMESYNC_RESPONSE   ESPNOW_MSG_TIMESYNC_RESPONSE
+
+#define TIMESYNC_FILTER_N   8       // en küçük gecikmeli örneğin seçildiği grup boyutu
+#define TIMESYNC_FIT_POINTS 16      // kayma doğrusuna oturtulan filtrelenmiş örnek sayısı
+#define TIMESYNC_STEP_US    10000   // tahminden bu kadar sapan örnek saat sıçraması sayılır
+
+typedef struct {
+    bool valid;                 // en az bir filtre grubu tamamlandı
+    int64_t offset_us;          // şu anki ofset tahmini (sunucu - yerel)
+    double drift_ppm;           // sunucu saatinin yerel saate göre kayması
+    uint32_t uncertainty_us;    // son filtrelenmiş örneğin gecikme / 2'si
+    double residual_rms_us;     // filtrelenmiş örneklerin doğrudan sapması
+    uint32_t fit_points;
+    uint32_t exchanges;         // tamamlanan istek/yanıt sayısı
+    uint32_t lost;              // yanıtı gelmeyen ya da geç gelen istekler
+    uint32_t steps;             // algılanan saat sıçramaları
+} timesync_state_t;
+
+/**
+ * İstemciyi başlatır; server_addr peer olarak eklenmiş olmalıdır. İstekler
+ * periyodik bir esp_timer'dan gönderilir, projenin send_cb'si bu gönderimler
+ * için de çağrılır.
+ */
+esp_err_t espnow_timesync_start_client(const uint8_t *server_addr, uint32_t period_ms);
+
+/* recv_cb'nin başında çağrılır; senkronizasyon paketiyse işler ve true döner */
+bool espnow_timesync_on_recv(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len);
+
+void espnow_timesync_get_state(timesync_state_t *out);
+
+/* Sunucu saatindeki bir zaman damgasını yerel saate çevirir; tahmin yoksa false */
+bool espnow_timesync_remote_to_local(int64_t remote_us, int64_t *local_us);
+
+bool espnow_timesync_local_to_remote(int64_t local_us, int64_t *remote_us);
+
+void espnow_timesync_log(const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,47 @@
+#include <string.h>
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "frame_check.h"
+
+uint32_t frame_check_crc32(const void *data, size_t len) {
+    return esp_rom_crc32_le(0, data, len);
+}
+
+void frame_check_fill(uint8_t *frame, size_t start, size_t len, uint32_t seed) {
+    uint32_t x = seed != 0 ? seed : 0x9E3779B9;  // xorshift 0 durumunda takılır
+    size_t end = len > FRAME_CHECK_CRC_LEN ? len - FRAME_CHECK_CRC_LEN : 0;
+    for (size_t i = start; i < end; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        frame[i] = (uint8_t)x;
+    }
+}
+
+void frame_check_seal(uint8_t *frame, size_t len) {
+    if (len < FRAME_CHECK_CRC_LEN) {
+        return;
+    }
+    uint32_t crc = frame_check_crc32(frame, len - FRAME_CHECK_CRC_LEN);
+    memcpy(frame + len - FRAME_CHECK_CRC_LEN, &crc, FRAME_CHECK_CRC_LEN);
+}
+
+bool frame_check_verify(frame_check_stats_t *stats, const uint8_t *frame, size_t len) {
+    if (len < FRAME_CHECK_CRC_LEN) {
+        if (stats != NULL) {
+            stats->checked++;
+            stats->corrupt++;
+        }
+        return false;
+    }
+    int64_t start_us = esp_timer_get_time();
+    uint32_t crc;
+    memcpy(&crc, frame + len - FRAME_CHECK_CRC_LEN, FRAME_CHECK_CRC_LEN);
+    bool ok = frame_check_crc32(frame, len - FRAME_CHECK_CRC_LEN) == crc;
+    if (stats != NULL) {
+        stats->checked++;
+        stats->corrupt += !ok;
+        stats->check_us += esp_timer_get_time() - start_us;
+    }
+    return ok;
+}
@@ -0,0 +1,48 @@
+/**
+ * Test çerçeveleri için yük bütünlüğü kontrolü.
+ *
+ * Radyonun kendi kontrollerinden geçen bit hataları yalnızca uzunluğa bakan
+ * alıcılarda fark edilmez. Gönderici çerçeveyi sabit bir dolgu yerine tohumlu
+ * bir sözde rastgele dizi (xorshift32 PRBS) ile doldurur ve son 4 bayta
+ * çerçevenin geri kalanının CRC32'sini yazar. Alıcı CRC'yi yeniden hesaplayıp
+ * karşılaştırır; tutmayan çerçeveler bozuk sayılır ve kayıpla birlikte raporlanır.
+ *
+ * CRC32 (IEEE 802.3, little-endian) ROM'daki esp_rom_crc32_le ile hesaplanır;
+ * tablo tabanlı ROM rutini recv_cb içinde tam hızda akışa yetişir ve RAM'de
+ * tablo tutmaz. Sıra numarası gibi çerçeve başına değişen alanlar
+ * frame_check_fill'den önce ya da sonra yazılabilir, yeter ki
+ * frame_check_seal en son çağrılsın.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_CHECK_CRC_LEN     4       // çerçevenin sonundaki CRC32
+
+typedef struct {
+    uint32_t checked;                   // kontrol edilen çerçeveler
+    uint32_t corrupt;                   // CRC'si tutmayan çerçeveler
+    uint64_t check_us;                  // kontrolde geçen toplam süre
+} frame_check_stats_t;
+
+uint32_t frame_check_crc32(const void *data, size_t len);
+
+/* frame[start, len - FRAME_CHECK_CRC_LEN) aralığını seed ile başlayan PRBS ile doldurur */
+void frame_check_fill(uint8_t *frame, size_t start, size_t len, uint32_t seed);
+
+/* İlk len - FRAME_CHECK_CRC_LEN baytın CRC32'sini son 4 bayta yazar */
+void frame_check_seal(uint8_t *frame, size_t len);
+
+/* CRC tutuyorsa true döner; stats NULL değilse sayaçları günceller */
+bool frame_check_verify(frame_check_stats_t *stats, const uint8_t *frame, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,76 @@
+/**
+ * Logaritmik kovalı gecikme histogramı.
+ *
+ * Değerler mikrosaniye cinsindendir. İlk LATENCY_HIST_SUB_BUCKETS değer birebir
+ * tutulur; daha büyük değerler için her ikinin kuvveti aralığı (oktav)
+ * LATENCY_HIST_SUB_BUCKETS eşit alt kovaya bölünür. Böylece 1 us ile ~33 s
+ * arasındaki her değer sabit bellekte ve en fazla ~%12 bağıl hatayla saklanır;
+ * kayıt işlemi birkaç bit işleminden ibarettir.
+ *
+ * Histogram kilit içermez; aynı histograma tek bir task yazmalı ya da çağıran
+ * taraf erişimi korumalıdır.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LATENCY_HIST_SUB_BUCKET_BITS    3
+#define LATENCY_HIST_SUB_BUCKETS        (1 << LATENCY_HIST_SUB_BUCKET_BITS)
+#define LATENCY_HIST_OCTAVES            22  // 8 << 22 us ≈ 33.5 s üst sınır
+#define LATENCY_HIST_BUCKETS            ((LATENCY_HIST_OCTAVES + 1) * LATENCY_HIST_SUB_BUCKETS)
+
+typedef struct {
+    uint32_t counts[LATENCY_HIST_BUCKETS];
+    uint32_t count;         // kaydedilen (zaman aşımına uğramayan) örnek sayısı
+    uint32_t timeouts;
+    uint32_t overflow;      // üst sınırı aşıp son kovaya yazılan örnekler
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+} latency_hist_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t timeouts;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t mean_us;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t p999_us;
+} latency_summary_t;
+
+void latency_hist_reset(latency_hist_t *hist);
+
+void latency_hist_record(latency_hist_t *hist, uint32_t value_us);
+
+void latency_hist_record_timeout(latency_hist_t *hist);
+
+/* src'deki örnekleri dst'ye ekler (ör. periyodik pencereyi kümülatif histograma katmak için) */
+void latency_hist_merge(latency_hist_t *dst, const latency_hist_t *src);
+
+/* percentile 0-100 arasıdır; örneğin 99.9. Kovanın orta noktası [min, max] aralığına kırpılarak döner. */
+uint32_t latency_hist_percentile(const latency_hist_t *hist, double percentile);
+
+void latency_hist_summarize(const latency_hist_t *hist, latency_summary_t *out);
+
+/* Tek satırlık özet: n, timeout, min, p50, p90, p99, p99.9, max, ortalama */
+void latency_hist_log_summary(const latency_hist_t *hist, const char *tag, const char *title);
+
+/* Boş olmayan kovaları alt sınır, üst sınır ve adet olarak yazdırır */
+void latency_hist_print_buckets(const latency_hist_t *hist);
+
+uint32_t latency_hist_bucket_lower(int index);
+
+uint32_t latency_hist_bucket_upper(int index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "latency_hist.h"
+
+static int bucket_index(uint32_t value) {
+    if (value < LATENCY_HIST_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int msb = 31 - __builtin_clz(value);
+    int shift = msb - LATENCY_HIST_SUB_BUCKET_BITS;
+    int index = (shift + 1) * LATENCY_HIST_SUB_BUCKETS + (int)((value >> shift) & (LATENCY_HIST_SUB_BUCKETS - 1));
+    return index;
+}
+
+uint32_t latency_hist_bucket_lower(int index) {
+    if (index < LATENCY_HIST_SUB_BUCKETS) {
+        return (uint32_t)index;
+    }
+    int shift = index / LATENCY_HIST_SUB_BUCKETS - 1;
+    int sub = index % LATENCY_HIST_SUB_BUCKETS;
+    return (uint32_t)(LATENCY_HIST_SUB_BUCKETS + sub) << shift;
+}
+
+uint32_t latency_hist_bucket_upper(int index) {
+    if (index < LATENCY_HIST_SUB_BUCKETS) {
+        return (uint32_t)index;
+    }
+    int shift = index / LATENCY_HIST_SUB_BUCKETS - 1;
+    return latency_hist_bucket_lower(index) + (1u << shift) - 1;
+}
+
+void latency_hist_reset(latency_hist_t *hist) {
+    memset(hist, 0, sizeof(latency_hist_t));
+    hist->min_us = UINT32_MAX;
+}
+
+void latency_hist_record(latency_hist_t *hist, uint32_t value_us) {
+    int index = bucket_index(value_us);
+    if (index >= LATENCY_HIST_BUCKETS) {
+        index = LATENCY_HIST_BUCKETS - 1;
+        hist->overflow++;
+    }
+    hist->counts[index]++;
+    hist->count++;
+    hist->sum_us += value_us;
+    if (value_us < hist->min_us) {
+        hist->min_us = value_us;
+    }
+    if (value_us > hist->max_us) {
+        hist->max_us = value_us;
+    }
+}
+
+void latency_hist_record_timeout(latency_hist_t *hist) {
+    hist->timeouts++;
+}
+
+void latency_hist_merge(latency_hist_t *dst, const latency_hist_t *src) {
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->count += src->count;
+    dst->timeouts += src->timeouts;
+    dst->overflow += src->overflow;
+    dst->sum_us += src->sum_us;
+    if (src->min_us < dst->min_us) {
+        dst->min_us = src->min_us;
+    }
+    if (src->max_us > dst->max_us) {
+        dst->max_us = src->max_us;
+    }
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, double percentile) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    // Sıralı örneklerde percentile'a karşılık gelen sıra (1 tabanlı, yukarı yuvarlanmış)
+    uint64_t rank = (uint64_t)((percentile / 100.0) * hist->count + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > hist->count) {
+        rank = hist->count;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint32_t lower = latency_hist_bucket_lower(i);
+            uint32_t value = lower + (latency_hist_bucket_upper(i) - lower) / 2;
+            if (value < hist->min_us) {
+                value = hist->min_us;
+            }
+            if (value > hist->max_us) {
+                value = hist->max_us;
+            }
+            return value;
+        }
+    }
+    return hist->max_us;
+}
+
+void latency_hist_summarize(const latency_hist_t *hist, latency_summary_t *out) {
+    memset(out, 0, sizeof(latency_summary_t));
+    out->count = hist->count;
+    out->timeouts = hist->timeouts;
+    if (hist->count == 0) {
+        return;
+    }
+    out->min_us = hist->min_us;
+    out->max_us = hist->max_us;
+    out->mean_us = (uint32_t)(hist->sum_us / hist->count);
+    out->p50_us = latency_hist_percentile(hist, 50.0);
+    out->p90_us = latency_hist_percentile(hist, 90.0);
+    out->p99_us = latency_hist_percentile(hist, 99.0);
+    out->p999_us = latency_hist_percentile(hist, 99.9);
+}
+
+void latency_hist_log_summary(const latency_hist_t *hist, const char *tag, const char *title) {
+    latency_summary_t s;
+    latency_hist_summarize(hist, &s);
+    ESP_LOGI(tag, "%s n=%lu timeout=%lu | min=%lu p50=%lu p90=%lu p99=%lu p99.9=%lu max=%lu ort=%lu us",
+             title, (unsigned long)s.count, (unsigned long)s.timeouts, (unsigned long)s.min_us,
+             (unsigned long)s.p50_us, (unsigned long)s.p90_us, (unsigned long)s.p99_us,
+             (unsigned long)s.p999_us, (unsigned long)s.max_us, (unsigned long)s.mean_us);
+}
+
+void latency_hist_print_buckets(const latency_hist_t *hist) {
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        if (hist->counts[i] == 0) {
+            continue;
+        }
+        printf("%8lu - %8lu us | %8lu | %6.2f%%\n",
+               (unsigned long)latency_hist_bucket_lower(i), (unsigned long)latency_hist_bucket_upper(i),
+               (unsigned long)hist->counts[i], hist->counts[i] * 100.0 / hist->count);
+    }
+}
@@ -0,0 +1,42 @@
+/**
+ * Sabit kapasiteli, MAC adresi anahtarlı hash tablosu.
+ *
+ * Tablo yalnızca anahtarları tutar ve her MAC'e 0..MAC_TABLE_CAPACITY-1 arasında
+ * sabit bir slot indeksi verir; değerler çağıranın aynı boyuttaki kendi dizisinde
+ * bu indeksle saklanır. Açık adresleme (doğrusal yoklama) kullanılır ve silme
+ * yoktur, bu yüzden bir MAC'in indeksi tablo sıfırlanana kadar değişmez. Bellek
+ * ayırmaz; recv_cb içinden çağrılabilir. Kilit içermez, erişimi çağıran korur.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAC_TABLE_CAPACITY  32      // ikinin kuvveti olmalı
+#define MAC_TABLE_MAC_LEN   6
+
+typedef struct {
+    uint8_t keys[MAC_TABLE_CAPACITY][MAC_TABLE_MAC_LEN];
+    bool used[MAC_TABLE_CAPACITY];
+    int count;
+} mac_table_t;
+
+void mac_table_reset(mac_table_t *table);
+
+/* MAC'in slot indeksini döndürür, yoksa -1 */
+int mac_table_find(const mac_table_t *table, const uint8_t *mac);
+
+/**
+ * MAC'in slot indeksini döndürür; yoksa ekler. *inserted yeni eklendiyse true
+ * olur (NULL verilebilir). Tablo doluysa -1 döner.
+ */
+int mac_table_insert(mac_table_t *table, const uint8_t *mac, bool *inserted);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+#include <string.h>
+#include "mac_table.h"
+
+_Static_assert((MAC_TABLE_CAPACITY & (MAC_TABLE_CAPACITY - 1)) == 0, "MAC_TABLE_CAPACITY ikinin kuvveti olmalı");
+
+static uint32_t mac_hash(const uint8_t *mac) {
+    // FNV-1a; üreticiye ait ilk 3 bayt çoğu zaman aynı olduğundan tüm baytlar karıştırılır
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < MAC_TABLE_MAC_LEN; i++) {
+        h ^= mac[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void mac_table_reset(mac_table_t *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+int mac_table_find(const mac_table_t *table, const uint8_t *mac) {
+    uint32_t slot = mac_hash(mac) & (MAC_TABLE_CAPACITY - 1);
+    for (int probe = 0; probe < MAC_TABLE_CAPACITY; probe++) {
+        if (!table->used[slot]) {
+            return -1;
+        }
+        if (memcmp(table->keys[slot], mac, MAC_TABLE_MAC_LEN) == 0) {
+            return (int)slot;
+        }
+        slot = (slot + 1) & (MAC_TABLE_CAPACITY - 1);
+    }
+    return -1;
+}
+
+int mac_table_insert(mac_table_t *table, const uint8_t *mac, bool *inserted) {
+    if (inserted != NULL) {
+        *inserted = false;
+    }
+    uint32_t slot = mac_hash(mac) & (MAC_TABLE_CAPACITY - 1);
+    for (int probe = 0; probe < MAC_TABLE_CAPACITY; probe++) {
+        if (!table->used[slot]) {
+            memcpy(table->keys[slot], mac, MAC_TABLE_MAC_LEN);
+            table->used[slot] = true;
+            table->count++;
+            if (inserted != NULL) {
+                *inserted = true;
+            }
+            return (int)slot;
+        }
+        if (memcmp(table->keys[slot], mac, MAC_TABLE_MAC_LEN) == 0) {
+            return (int)slot;
+        }
+        slot = (slot + 1) & (MAC_TABLE_CAPACITY - 1);
+    }
+    return -1;
+}
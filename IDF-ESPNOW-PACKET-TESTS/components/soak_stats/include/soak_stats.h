@@ -0,0 +1,118 @@
+/**
+ * Uzun süreli (günler) dayanıklılık testi istatistikleri.
+ *
+ * Ölçüm 1 sn, 1 dk ve 1 sa'lik kayan pencerelere toplanır. Her pencere
+ * kapandığında o pencerenin throughput'u ve kayıp oranı ile pencere türü
+ * başına en düşük, en yüksek ve EWMA değerleri güncellenir.
+ *
+ * Toplamlar, pencere istatistikleri ve reset geçmişi NVS'e checkpoint olarak
+ * yazılır; kart resetlense de test kaldığı yerden devam eder. Flash aşınmasını
+ * sınırlamak için checkpoint en fazla checkpoint_interval_s'de bir (ve her
+ * açılışta bir kez) yazılır; resetten önceki son checkpoint'ten sonraki ölçüm
+ * kaybolur. Açık (kapanmamış) pencereler checkpoint'e yazılmaz, resetten sonra
+ * baştan başlar.
+ *
+ * Alıcının en yüksek sıra numarası da checkpoint'e yazılır; resetten sonra
+ * kayıp hesabı bu numaradan devam eder ve kart kapalıyken gönderilen paketler
+ * kayıp sayılır. Son checkpoint'ten sonra alınan paketlerin sayımı da
+ * kaybolduğu için bu kayıp bir üst sınırdır.
+ *
+ * Her açılışta esp_reset_reason() okunur; reset nedeni sayaçları ve son
+ * SOAK_EVENT_LOG reset (test zamanıyla birlikte) checkpoint'te tutulur, böylece
+ * brown-out ve watchdog resetleri throughput zaman çizelgesinin yanında görülür.
+ *
+ * Fonksiyonlar tek bir task'tan çağrılmalıdır.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SOAK_STATS_VERSION      2
+#define SOAK_RESET_REASONS      16      // esp_reset_reason_t değer aralığı; fazlası ESP_RST_UNKNOWN sayılır
+#define SOAK_EVENT_LOG          8
+#define SOAK_EWMA_ALPHA         0.125f
+
+typedef enum {
+    SOAK_WIN_1S = 0,
+    SOAK_WIN_1M,
+    SOAK_WIN_1H,
+    SOAK_WIN_COUNT,
+} soak_window_id_t;
+
+/* Pencere türü başına, kapanan pencereler üzerinden */
+typedef struct {
+    uint32_t closed;
+    float min_kbps;
+    float max_kbps;
+    float ewma_kbps;
+    float last_kbps;
+    float min_loss_pct;
+    float max_loss_pct;
+    float ewma_loss_pct;
+    float last_loss_pct;
+} soak_window_stats_t;
+
+typedef struct {
+    uint64_t soak_ms;                   // resetin yakalandığı andaki test süresi (son checkpoint'e göre)
+    uint32_t boot;
+    uint8_t reason;                     // esp_reset_reason_t
+} soak_event_t;
+
+/* NVS'e olduğu gibi yazılır; düzen değişirse SOAK_STATS_VERSION artırılmalı */
+typedef struct {
+    uint32_t version;
+    uint32_t boots;
+    uint64_t soak_ms;                   // tüm açılışlardaki toplam ölçüm süresi
+    uint64_t bytes;
+    uint64_t received;
+    uint64_t lost;
+    uint32_t checkpoints;
+    uint32_t reset_counts[SOAK_RESET_REASONS];
+    soak_event_t events[SOAK_EVENT_LOG];
+    uint32_t event_count;               // toplam kaydedilen olay; son SOAK_EVENT_LOG tanesi tutulur
+    soak_window_stats_t windows[SOAK_WIN_COUNT];
+    uint32_t highest_seq;               // soak_stats_set_seq ile verilen son değer
+    bool seq_valid;
+} soak_checkpoint_t;
+
+/**
+ * Checkpoint'i NVS'ten yükler (yoksa veya sürüm farklıysa sıfırdan başlar),
+ * açılış sayısını ve reset nedenini kaydeder, checkpoint'i hemen yazar.
+ * nvs_flash_init() daha önce çağrılmış olmalıdır. clear true ise önceki test silinir.
+ */
+esp_err_t soak_stats_init(uint32_t checkpoint_interval_s, bool clear);
+
+/**
+ * period_ms süreli bir ölçüm aralığını ekler. lost negatif olabilir (geç gelen
+ * paketler önceki aralıkların kaybını düşürür). Kapanan pencereleri günceller ve
+ * aralık dolduysa checkpoint yazar. 1 dk'lık pencere kapandığında true döner.
+ */
+bool soak_stats_add(uint32_t period_ms, uint64_t bytes, uint32_t received, int32_t lost);
+
+/* Alıcının en yüksek sıra numarasını bir sonraki checkpoint'e yazılmak üzere kaydeder */
+void soak_stats_set_seq(uint32_t highest_seq);
+
+/* Checkpoint'i aralığı beklemeden yazar */
+esp_err_t soak_stats_checkpoint(void);
+
+const soak_checkpoint_t *soak_stats_get(void);
+
+const char *soak_stats_reset_reason_name(esp_reset_reason_t reason);
+
+/* Zaman çizelgesi satırı: test süresi, son 1 dk, açılış ve brown-out sayısı */
+void soak_stats_log_minute(const char *tag);
+
+/* Pencere tablosu ve reset geçmişi */
+void soak_stats_log_summary(const char *tag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "soak_stats.h"
+
+#define NVS_NAMESPACE   "soak"
+#define NVS_KEY         "ckpt"
+
+static const char *TAG = "SOAK";
+
+static const uint32_t window_ms[SOAK_WIN_COUNT] = {1000, 60 * 1000, 60 * 60 * 1000};
+static const char *window_names[SOAK_WIN_COUNT] = {"1 sn", "1 dk", "1 sa"};
+
+/* Açık pencere; checkpoint'e yazılmaz */
+typedef struct {
+    uint32_t elapsed_ms;
+    uint64_t bytes;
+    uint32_t received;
+    int64_t lost;
+} window_acc_t;
+
+static soak_checkpoint_t ckpt;
+static window_acc_t acc[SOAK_WIN_COUNT];
+static nvs_handle_t nvs = 0;
+static uint32_t interval_s = 0;
+static int64_t last_checkpoint_us = 0;
+static esp_reset_reason_t boot_reason = ESP_RST_UNKNOWN;
+
+const char *soak_stats_reset_reason_name(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON:   return "güç açılışı";
+        case ESP_RST_EXT:       return "harici pin";
+        case ESP_RST_SW:        return "yazılım";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:   return "kesme WDT";
+        case ESP_RST_TASK_WDT:  return "task WDT";
+        case ESP_RST_WDT:       return "diğer WDT";
+        case ESP_RST_DEEPSLEEP: return "deep sleep";
+        case ESP_RST_BROWNOUT:  return "brown-out";
+        case ESP_RST_SDIO:      return "SDIO";
+        default:                return "bilinmiyor";
+    }
+}
+
+static void format_soak_time(uint64_t ms, char *out, size_t len) {
+    uint64_t s = ms / 1000;
+    snprintf(out, len, "%lug %02lu:%02lu:%02lu", (unsigned long)(s / 86400), (unsigned long)(s / 3600 % 24),
+             (unsigned long)(s / 60 % 60), (unsigned long)(s % 60));
+}
+
+static void ckpt_reset(void) {
+    memset(&ckpt, 0, sizeof(ckpt));
+    ckpt.version = SOAK_STATS_VERSION;
+}
+
+esp_err_t soak_stats_checkpoint(void) {
+    esp_err_t err = nvs_set_blob(nvs, NVS_KEY, &ckpt, sizeof(ckpt));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Checkpoint yazılamadı: %s", esp_err_to_name(err));
+        return err;
+    }
+    ckpt.checkpoints++;     // bir sonraki yazımda kalıcı olur
+    last_checkpoint_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+esp_err_t soak_stats_init(uint32_t checkpoint_interval_s, bool clear) {
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS açılamadı: %s", esp_err_to_name(err));
+        return err;
+    }
+    interval_s = checkpoint_interval_s;
+    memset(acc, 0, sizeof(acc));
+
+    size_t len = sizeof(ckpt);
+    err = clear ? ESP_ERR_NOT_FOUND : nvs_get_blob(nvs, NVS_KEY, &ckpt, &len);
+    if (err != ESP_OK || len != sizeof(ckpt) || ckpt.version != SOAK_STATS_VERSION) {
+        if (err == ESP_OK) {
+            ESP_LOGW(TAG, "Checkpoint düzeni farklı (sürüm %lu), yeni test başlıyor", (unsigned long)ckpt.version);
+        }
+        ckpt_reset();
+    }
+
+    boot_reason = esp_reset_reason();
+    int reason_index = ((unsigned)boot_reason < SOAK_RESET_REASONS) ? boot_reason : ESP_RST_UNKNOWN;
+    ckpt.boots++;
+    ckpt.reset_counts[reason_index]++;
+    soak_event_t *ev = &ckpt.events[ckpt.event_count % SOAK_EVENT_LOG];
+    ev->soak_ms = ckpt.soak_ms;
+    ev->boot = ckpt.boots;
+    ev->reason = (uint8_t)reason_index;
+    ckpt.event_count++;
+
+    char when[24];
+    format_soak_time(ckpt.soak_ms, when, sizeof(when));
+    if (ckpt.boots == 1) {
+        ESP_LOGW(TAG, "Yeni dayanıklılık testi (reset nedeni: %s)", soak_stats_reset_reason_name(boot_reason));
+    }
+    else {
+        ESP_LOGW(TAG, "Test devam ediyor: açılış #%lu, test süresi %s, reset nedeni: %s%s",
+                 (unsigned long)ckpt.boots, when, soak_stats_reset_reason_name(boot_reason),
+                 boot_reason == ESP_RST_BROWNOUT ? " (BROWN-OUT)" : "");
+    }
+    return soak_stats_checkpoint();
+}
+
+static void window_close(soak_window_id_t id) {
+    window_acc_t *a = &acc[id];
+    soak_window_stats_t *w = &ckpt.windows[id];
+    uint32_t lost = a->lost > 0 ? (uint32_t)a->lost : 0;
+    float kbps = a->elapsed_ms > 0 ? (float)(a->bytes / 1024.0 / (a->elapsed_ms / 1000.0)) : 0.0f;
+    float loss_pct = (a->received + lost) > 0 ? lost * 100.0f / (a->received + lost) : 0.0f;
+
+    if (w->closed == 0) {
+        w->min_kbps = w->max_kbps = w->ewma_kbps = kbps;
+        w->min_loss_pct = w->max_loss_pct = w->ewma_loss_pct = loss_pct;
+    }
+    else {
+        w->min_kbps = kbps < w->min_kbps ? kbps : w->min_kbps;
+        w->max_kbps = kbps > w->max_kbps ? kbps : w->max_kbps;
+        w->ewma_kbps += SOAK_EWMA_ALPHA * (kbps - w->ewma_kbps);
+        w->min_loss_pct = loss_pct < w->min_loss_pct ? loss_pct : w->min_loss_pct;
+        w->max_loss_pct = loss_pct > w->max_loss_pct ? loss_pct : w->max_loss_pct;
+        w->ewma_loss_pct += SOAK_EWMA_ALPHA * (loss_pct - w->ewma_loss_pct);
+    }
+    w->last_kbps = kbps;
+    w->last_loss_pct = loss_pct;
+    w->closed++;
+    memset(a, 0, sizeof(*a));
+}
+
+bool soak_stats_add(uint32_t period_ms, uint64_t bytes, uint32_t received, int32_t lost) {
+    bool minute_closed = false;
+
+    ckpt.soak_ms += period_ms;
+    ckpt.bytes += bytes;
+    ckpt.received += received;
+    if (lost >= 0) {
+        ckpt.lost += lost;
+    }
+    else {
+        ckpt.lost -= (uint64_t)-lost > ckpt.lost ? ckpt.lost : (uint64_t)-lost;
+    }
+
+    for (int i = 0; i < SOAK_WIN_COUNT; i++) {
+        window_acc_t *a = &acc[i];
+        a->elapsed_ms += period_ms;
+        a->bytes += bytes;
+        a->received += received;
+        a->lost += lost;
+        // Örnekleme aralığındaki kaymayla pencere bir örnek gecikmesin diye yarım aralık tolerans
+        if (a->elapsed_ms + period_ms / 2 >= window_ms[i]) {
+            window_close(i);
+            minute_closed |= (i == SOAK_WIN_1M);
+        }
+    }
+
+    if (esp_timer_get_time() - last_checkpoint_us >= interval_s * 1000000LL) {
+        soak_stats_checkpoint();
+    }
+    return minute_closed;
+}
+
+void soak_stats_set_seq(uint32_t highest_seq) {
+    ckpt.highest_seq = highest_seq;
+    ckpt.seq_valid = true;
+}
+
+const soak_checkpoint_t *soak_stats_get(void) {
+    return &ckpt;
+}
+
+void soak_stats_log_minute(const char *tag) {
+    const soak_window_stats_t *m = &ckpt.windows[SOAK_WIN_1M];
+    const soak_window_stats_t *s = &ckpt.windows[SOAK_WIN_1S];
+    char when[24];
+    format_soak_time(ckpt.soak_ms, when, sizeof(when));
+    ESP_LOGI(tag, "[soak %s] 1 dk: %.2f KB/s (1 sn min %.2f / maks %.2f), kayıp %%%.3f | açılış %lu, brown-out %lu, son reset: %s",
+             when, m->last_kbps, s->min_kbps, s->max_kbps, m->last_loss_pct, (unsigned long)ckpt.boots,
+             (unsigned long)ckpt.reset_counts[ESP_RST_BROWNOUT], soak_stats_reset_reason_name(boot_reason));
+}
+
+void soak_stats_log_summary(const char *tag) {
+    char when[24];
+    format_soak_time(ckpt.soak_ms, when, sizeof(when));
+    uint64_t expected = ckpt.received + ckpt.lost;
+    printf("---\n");
+    ESP_LOGI(tag, "DAYANIKLILIK TESTİ: süre %s, alınan %llu paket (%llu KB), kayıp %llu (%%%.4f), checkpoint %lu",
+             when, (unsigned long long)ckpt.received, (unsigned long long)(ckpt.bytes / 1024), (unsigned long long)ckpt.lost, expected > 0 ? ckpt.lost * 100.0 / expected : 0.0,
+             (unsigned long)ckpt.checkpoints);
+    printf("%-7s | %8s | %9s | %9s | %9s | %9s | %8s | %8s | %8s\n",
+           "pencere", "kapanan", "son KB/s", "min KB/s", "maks KB/s", "EWMA KB/s", "min %", "maks %", "EWMA %");
+    for (int i = 0; i < SOAK_WIN_COUNT; i++) {
+        const soak_window_stats_t *w = &ckpt.windows[i];
+        printf("%-7s | %8lu | %9.2f | %9.2f | %9.2f | %9.2f | %8.3f | %8.3f | %8.3f\n",
+               window_names[i], (unsigned long)w->closed, w->last_kbps, w->min_kbps, w->max_kbps, w->ewma_kbps,
+               w->min_loss_pct, w->max_loss_pct, w->ewma_loss_pct);
+    }
+
+    printf("reset nedenleri:");
+    for (int i = 0; i < SOAK_RESET_REASONS; i++) {
+        if (ckpt.reset_counts[i] > 0) {
+            printf(" %s=%lu", soak_stats_reset_reason_name(i), (unsigned long)ckpt.reset_counts[i]);
+        }
+    }
+    printf("\n");
+    uint32_t first = ckpt.event_count > SOAK_EVENT_LOG ? ckpt.event_count - SOAK_EVENT_LOG : 0;
+    for (uint32_t i = first; i < ckpt.event_count; i++) {
+        const soak_event_t *ev = &ckpt.events[i % SOAK_EVENT_LOG];
+        format_soak_time(ev->soak_ms, when, sizeof(when));
+        printf("  açılış #%lu @ %s: %s\n", (unsigned long)ev->boot, when, soak_stats_reset_reason_name(ev->reason));
+    }
+    printf("---\n");
+}
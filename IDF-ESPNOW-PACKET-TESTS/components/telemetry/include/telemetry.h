@@ -0,0 +1,127 @@
+/**
+ * Ayrı bir UART üzerinden ikili istatistik akışı.
+ *
+ * ESP_LOGI ile yazılan metin raporlar konsol UART'ına yetişemediğinde rapor
+ * task'ını bloklar ve ölçümü bozar. Bu bileşen istatistikleri sabit düzenli
+ * (packed, little-endian) kayıtlar olarak ayrı bir UART'a yüksek baud hızıyla
+ * yazar. Her kaydın başında tip, sürüm, kayıt sırası ve esp_timer zaman damgası
+ * vardır; kaydın sonuna CRC32 eklenir, kayıt COBS ile kodlanıp 0x00 ile
+ * sonlandırılır. Böylece veri içinde 0x00 geçmez ve alıcı araç akışın ortasından
+ * bağlansa da bir sonraki 0x00'dan itibaren senkron olur.
+ *
+ * telemetry_send bloklamaz: kodlanmış kayıt UART sürücüsünün TX halka
+ * tamponuna sığmıyorsa düşürülür ve sayılır; host aracı düşen kayıtları sıra
+ * numarasındaki boşluktan da görür.
+ *
+ * Host tarafında tools/telemetry_decode.py akışı çözer, kayıtları yazdırır ve
+ * tip başına CSV'ye kaydeder. Kayıt düzeni değişirse TELEMETRY_VERSION
+ * artırılmalı ve araç güncellenmelidir.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/uart.h"
+#include "latency_hist.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_VERSION       1
+#define TELEMETRY_MAX_RECORD    800     // CRC hariç en büyük kayıt
+#define TELEMETRY_MAX_CORES     2
+#define TELEMETRY_CPU_UNKNOWN   0xFFFF
+
+/* Kayıt tipleri */
+#define TELEMETRY_REC_RX        0x01
+#define TELEMETRY_REC_LATENCY   0x02
+
+typedef struct {
+    uart_port_t uart_num;
+    int tx_pin;
+    int baud_rate;
+    int tx_buffer_size;                 // sürücünün TX halka tamponu; bir rapor periyodunun kayıtları sığmalı
+} telemetry_config_t;
+
+#define TELEMETRY_CONFIG_DEFAULT() {    \
+    .uart_num = UART_NUM_1,             \
+    .tx_pin = 17,                       \
+    .baud_rate = 2000000,               \
+    .tx_buffer_size = 8192,             \
+}
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t version;
+    uint16_t seq;                       // telemetry_send doldurur
+    uint64_t timestamp_us;              // telemetry_send doldurur
+} telemetry_hdr_t;
+
+/* Alıcı penceresi: sayaçlar test başından beri kümülatiftir, host farklardan hız hesaplar */
+typedef struct __attribute__((packed)) {
+    telemetry_hdr_t hdr;
+    uint32_t period_ms;                 // önceki kayıttan bu yana geçen süre
+    uint64_t rx_bytes;
+    uint32_t rx_frames;
+    uint32_t lost;                      // sıra numarasından kayıp, izlenmiyorsa 0
+    uint32_t duplicates;
+    uint32_t reordered;
+    uint32_t corrupt;                   // CRC'si tutmayan çerçeveler
+    uint32_t longest_gap;               // en uzun ardışık kayıp
+    uint32_t ring_dropped;              // uygulama kuyruğu dolu olduğu için düşenler
+    int16_t rssi_dbm;                   // pencere ortalaması, bilinmiyorsa 0
+    uint16_t cpu_idle_permille[TELEMETRY_MAX_CORES];    // TELEMETRY_CPU_UNKNOWN: ölçülmedi
+} telemetry_rx_t;
+
+/* latency_hist_t'nin tamamı; yüzdelikler host'ta kovalardan hesaplanır */
+typedef struct __attribute__((packed)) {
+    telemetry_hdr_t hdr;
+    uint8_t hist_id;                    // aynı projede birden fazla histogram varsa ayırt etmek için
+    uint8_t reserved;
+    uint32_t count;
+    uint32_t timeouts;
+    uint32_t overflow;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t counts[LATENCY_HIST_BUCKETS];
+} telemetry_latency_t;
+
+_Static_assert(sizeof(telemetry_latency_t) <= TELEMETRY_MAX_RECORD, "telemetry_latency_t TELEMETRY_MAX_RECORD'a sığmıyor");
+
+typedef struct {
+    uint32_t sent;
+    uint32_t dropped;                   // TX tamponu dolu olduğu için düşen kayıtlar
+    uint64_t bytes;                     // UART'a yazılan kodlanmış bayt
+} telemetry_stats_t;
+
+/* UART sürücüsünü yalnızca TX için kurar; konsol UART'ı (UART_NUM_0) kullanılmamalıdır */
+esp_err_t telemetry_init(const telemetry_config_t *config);
+
+/* Kaydı sıfırlar, tipini ve ölçülmemiş alanlarını ayarlar */
+void telemetry_rx_init(telemetry_rx_t *rec);
+
+/* cpu_idle_sample_t'nin yüzdelerini binde olarak yazar; cores TELEMETRY_MAX_CORES'tan büyükse fazlası atılır */
+void telemetry_rx_set_idle(telemetry_rx_t *rec, const float *idle_pct, int cores);
+
+/* Histogramı kayda kopyalar */
+void telemetry_fill_latency(telemetry_latency_t *rec, uint8_t hist_id, const latency_hist_t *hist);
+
+/**
+ * Kaydın başlığındaki sıra numarası ve zaman damgasını doldurup kaydı
+ * gönderir. len kaydın başlık dahil boyutudur. TX tamponu doluysa
+ * ESP_ERR_NO_MEM döner ve kayıt düşer; hiçbir durumda bloklamaz.
+ */
+esp_err_t telemetry_send(void *rec, size_t len);
+
+void telemetry_get_stats(telemetry_stats_t *out);
+
+/* src'yi COBS ile dst'ye kodlar (sonlandırıcı 0x00 hariç); dst en az len + len / 254 + 1 bayt olmalı */
+size_t telemetry_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,147 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "telemetry.h"
+
+#define COBS_BOUND(len)     ((len) + (len) / 254 + 1)
+#define FRAME_BUF_LEN       (COBS_BOUND(TELEMETRY_MAX_RECORD + 4) + 1)  // CRC32 + sonlandırıcı 0x00
+#define UART_RX_BUF_LEN     256     // bu UART'tan okunmaz; sürücü donanım FIFO'sundan büyük bir RX tamponu ister
+
+static const char *TAG = "TELEMETRY";
+
+static telemetry_config_t config;
+static SemaphoreHandle_t send_lock = NULL;  // kodlama tamponları ve sıra numarası
+static uint16_t next_seq = 0;
+static telemetry_stats_t stats;
+
+size_t telemetry_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t code_pos = 0;
+    size_t out = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            dst[code_pos] = code;
+            code_pos = out++;
+            code = 1;
+            continue;
+        }
+        dst[out++] = src[i];
+        if (++code == 0xFF) {   // 254 sıfırsız bayttan sonra yeni blok
+            dst[code_pos] = code;
+            code_pos = out++;
+            code = 1;
+        }
+    }
+    dst[code_pos] = code;
+    return out;
+}
+
+esp_err_t telemetry_init(const telemetry_config_t *cfg) {
+    if (cfg->uart_num == UART_NUM_0) {
+        return ESP_ERR_INVALID_ARG; // konsol UART'ı; loglarla karışır
+    }
+    config = *cfg;
+    send_lock = xSemaphoreCreateMutex();
+    if (send_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const uart_config_t uart_config = {
+        .baud_rate = cfg->baud_rate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    esp_err_t err = uart_driver_install(cfg->uart_num, UART_RX_BUF_LEN, cfg->tx_buffer_size, 0, NULL, 0);
+    if (err == ESP_OK) {
+        err = uart_param_config(cfg->uart_num, &uart_config);
+    }
+    if (err == ESP_OK) {
+        err = uart_set_pin(cfg->uart_num, cfg->tx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "UART%d kurulamadı: %s", cfg->uart_num, esp_err_to_name(err));
+        return err;
+    }
+
+    const uint8_t sync = 0x00;  // araç akışın ortasından bağlanırsa ilk kayıttan önce senkron olsun
+    uart_write_bytes(cfg->uart_num, &sync, 1);
+    ESP_LOGI(TAG, "İkili istatistik akışı: UART%d, TX GPIO %d, %d baud", cfg->uart_num, cfg->tx_pin, cfg->baud_rate);
+    return ESP_OK;
+}
+
+void telemetry_rx_init(telemetry_rx_t *rec) {
+    memset(rec, 0, sizeof(*rec));
+    rec->hdr.type = TELEMETRY_REC_RX;
+    for (int i = 0; i < TELEMETRY_MAX_CORES; i++) {
+        rec->cpu_idle_permille[i] = TELEMETRY_CPU_UNKNOWN;
+    }
+}
+
+void telemetry_rx_set_idle(telemetry_rx_t *rec, const float *idle_pct, int cores) {
+    for (int i = 0; i < cores && i < TELEMETRY_MAX_CORES; i++) {
+        rec->cpu_idle_permille[i] = (uint16_t)(idle_pct[i] * 10.0f + 0.5f);
+    }
+}
+
+void telemetry_fill_latency(telemetry_latency_t *rec, uint8_t hist_id, const latency_hist_t *hist) {
+    memset(rec, 0, sizeof(*rec));
+    rec->hdr.type = TELEMETRY_REC_LATENCY;
+    rec->hist_id = hist_id;
+    rec->count = hist->count;
+    rec->timeouts = hist->timeouts;
+    rec->overflow = hist->overflow;
+    rec->min_us = hist->count > 0 ? hist->min_us : 0;
+    rec->max_us = hist->max_us;
+    rec->sum_us = hist->sum_us;
+    memcpy(rec->counts, hist->counts, sizeof(rec->counts));
+}
+
+esp_err_t telemetry_send(void *rec, size_t len) {
+    static uint8_t raw[TELEMETRY_MAX_RECORD + 4];
+    static uint8_t frame[FRAME_BUF_LEN];
+    if (send_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (len < sizeof(telemetry_hdr_t) || len > TELEMETRY_MAX_RECORD) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(send_lock, portMAX_DELAY);
+    telemetry_hdr_t *hdr = rec;
+    hdr->version = TELEMETRY_VERSION;
+    hdr->seq = next_seq++;              // düşen kayıtlar da numara tüketir, host boşluktan görür
+    hdr->timestamp_us = esp_timer_get_time();
+
+    memcpy(raw, rec, len);
+    uint32_t crc = esp_rom_crc32_le(0, raw, len);
+    memcpy(raw + len, &crc, sizeof(crc));
+    size_t frame_len = telemetry_cobs_encode(raw, len + sizeof(crc), frame);
+    frame[frame_len++] = 0x00;
+
+    esp_err_t err = ESP_OK;
+    size_t free_space = 0;
+    uart_get_tx_buffer_free_size(config.uart_num, &free_space);
+    if (free_space < frame_len) {
+        stats.dropped++;
+        err = ESP_ERR_NO_MEM;
+    }
+    else {
+        uart_write_bytes(config.uart_num, frame, frame_len);   // tampona sığdığı için beklemeden döner
+        stats.sent++;
+        stats.bytes += frame_len;
+    }
+    xSemaphoreGive(send_lock);
+    return err;
+}
+
+void telemetry_get_stats(telemetry_stats_t *out) {
+    xSemaphoreTake(send_lock, portMAX_DELAY);
+    *out = stats;
+    xSemaphoreGive(send_lock);
+}
@@ -0,0 +1,104 @@
+/**
+ * Hız kontrollü trafik üreteci.
+ *
+ * vTaskDelay tick çözünürlüğüyle (100 Hz'de 10 ms) sınırlıdır; bu bileşen
+ * paket varışlarını esp_timer ile mikrosaniye çözünürlükte planlar ve bir token
+ * kovasına (token bucket) koyar. Gönderen task traffic_gen_wait() ile bir token
+ * bekler ve paketi gönderir; task geride kalırsa kova bucket_depth kadar paketi
+ * biriktirir, kova doluyken gelen varışlar düşürülür ve sayılır.
+ *
+ * Varış modları:
+ *  - TRAFFIC_CONSTANT: sabit aralık (1 / hız).
+ *  - TRAFFIC_POISSON: üstel dağılımlı aralıklar, ortalama hız aynı.
+ *  - TRAFFIC_BURST: burst_len paket aynı anda, burst'ler burst_len / hız aralıkla.
+ *
+ * Varışlar mutlak zamana göre planlandığı için timer gecikmesi hızda kayma
+ * yaratmaz; timer geç kalırsa vadesi geçen tüm varışlar tek seferde kovaya
+ * eklenir. Her token için planlanan varış ile gönderen task'ın token'ı aldığı an
+ * arasındaki gecikme histograma yazılır; raporda istenen ve gerçekleşen hız ile
+ * bu zamanlama jitter'ının yüzdelikleri verilir.
+ *
+ * Gerçekleşen hız, gönderen task'ın traffic_gen_mark_sent() ile bildirdiği ve
+ * radyonun kabul ettiği gönderimlerden hesaplanır; token alınıp TX kuyruğu dolu
+ * olduğu için atlanan paketler sayılmaz.
+ *
+ * Aynı anda tek bir üreteç çalışır; traffic_gen_wait(), traffic_gen_mark_sent()
+ * ve traffic_gen_get_report() yalnızca traffic_gen_start()'ı çağıran task'tan
+ * çağrılmalıdır. Token'lar bu task'ın bildirim sayacıyla (xTaskNotifyGive)
+ * iletildiğinden task bildirimleri başka bir amaçla kullanmamalıdır.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "latency_hist.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRAFFIC_GEN_MAX_DEPTH   64
+#define TRAFFIC_GEN_MIN_TIMER_US 50     // daha kısa aralıklarda varışlar bir sonraki timer'da toplu eklenir
+
+typedef enum {
+    TRAFFIC_CONSTANT = 0,
+    TRAFFIC_POISSON,
+    TRAFFIC_BURST,
+} traffic_mode_t;
+
+typedef struct {
+    traffic_mode_t mode;
+    double rate_pps;                    // 0 ise rate_bps ve frame_len'den hesaplanır
+    uint32_t rate_bps;
+    size_t frame_len;                   // bps hesabı ve rapor için
+    uint16_t burst_len;                 // yalnızca TRAFFIC_BURST
+    uint16_t bucket_depth;              // en fazla TRAFFIC_GEN_MAX_DEPTH
+} traffic_gen_config_t;
+
+#define TRAFFIC_GEN_CONFIG_DEFAULT() {  \
+    .mode = TRAFFIC_CONSTANT,           \
+    .rate_pps = 100,                    \
+    .rate_bps = 0,                      \
+    .frame_len = 1024,                  \
+    .burst_len = 8,                     \
+    .bucket_depth = 16,                 \
+}
+
+typedef struct {
+    double requested_pps;
+    double achieved_pps;                // traffic_gen_mark_sent ile bildirilen gönderim / süre
+    double achieved_kbps;               // achieved_pps * frame_len
+    double duration_s;
+    uint32_t arrivals;                  // planlanan varış
+    uint32_t taken;                     // task'ın aldığı token
+    uint32_t sent;                      // kabul edilen gönderim (traffic_gen_mark_sent)
+    uint32_t overflow;                  // kova dolu olduğu için düşen varış
+    uint32_t max_backlog;               // kovada görülen en fazla token
+    latency_hist_t lateness;            // planlanan varıştan token'ın alınmasına kadar geçen süre
+} traffic_gen_report_t;
+
+/* Çağıran task tüketici olur; ilk varış hemen planlanır */
+esp_err_t traffic_gen_start(const traffic_gen_config_t *config);
+
+/* Bir token bekler. Token alındıysa true döner; planlanan varış zamanı scheduled_us'e yazılır (NULL olabilir) */
+bool traffic_gen_wait(TickType_t timeout, int64_t *scheduled_us);
+
+/* traffic_gen_wait ile alınan token'ın paketi radyoya kabul edildiğinde çağrılır */
+void traffic_gen_mark_sent(void);
+
+void traffic_gen_stop(void);
+
+/* Başlangıçtan (veya son reset_window=true çağrısından) bu yana; reset_window ölçüm penceresini yeniden başlatır */
+void traffic_gen_get_report(traffic_gen_report_t *out, bool reset_window);
+
+void traffic_gen_log_report(const traffic_gen_report_t *report, const char *tag);
+
+const char *traffic_gen_mode_name(traffic_mode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
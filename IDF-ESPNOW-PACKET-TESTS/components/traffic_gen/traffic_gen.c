@@ -0,0 +1,212 @@
+#include <math.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "traffic_gen.h"
+
+static const char *TAG = "TRAFFIC_GEN";
+
+static traffic_gen_config_t config;
+static double interval_us = 0;          // ortalama varışlar arası süre
+static esp_timer_handle_t arrival_timer = NULL;
+static TaskHandle_t consumer = NULL;
+static volatile bool running = false;
+static portMUX_TYPE bucket_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Kova: her token'ın planlanan varış zamanı, bucket_lock ile korunur */
+static int64_t bucket[TRAFFIC_GEN_MAX_DEPTH];
+static int bucket_head = 0;
+static int bucket_count = 0;
+
+/* Varış planı; yalnızca timer callback'i (ve timer kurulmadan önce start) yazar, kilit gerekmez */
+static double next_due_us = 0;         // kesirli aralıklar birikip kaymasın diye double
+static int burst_pos = 0;
+
+/* Pencere sayaçları; lateness yalnızca tüketici task'ta yazılır */
+static uint32_t arrivals = 0;
+static uint32_t taken = 0;
+static uint32_t sent = 0;               // yalnızca tüketici task yazar ve okur
+static uint32_t overflow = 0;
+static uint32_t max_backlog = 0;
+static int64_t window_start_us = 0;
+static latency_hist_t lateness;
+
+const char *traffic_gen_mode_name(traffic_mode_t mode) {
+    switch (mode) {
+        case TRAFFIC_CONSTANT:  return "sabit";
+        case TRAFFIC_POISSON:   return "poisson";
+        case TRAFFIC_BURST:     return "burst";
+        default:                return "?";
+    }
+}
+
+static double next_interval_us(void) {
+    switch (config.mode) {
+        case TRAFFIC_POISSON: {
+            double u = (esp_random() + 1.0) / 4294967297.0;    // (0, 1]
+            return -log(u) * interval_us;
+        }
+        case TRAFFIC_BURST:
+            if (++burst_pos < config.burst_len) {
+                return 0;
+            }
+            burst_pos = 0;
+            return interval_us * config.burst_len;
+        default:
+            return interval_us;
+    }
+}
+
+static void arrival_timer_cb(void *arg) {
+    if (!running) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    int added = 0;
+
+    while (next_due_us <= now) {
+        portENTER_CRITICAL(&bucket_lock);
+        arrivals++;
+        if (bucket_count < config.bucket_depth) {
+            bucket[(bucket_head + bucket_count) % TRAFFIC_GEN_MAX_DEPTH] = (int64_t)next_due_us;
+            bucket_count++;
+            added++;
+            if ((uint32_t)bucket_count > max_backlog) {
+                max_backlog = bucket_count;
+            }
+        }
+        else {
+            overflow++;     // tüketici geride, kova dolu
+        }
+        portEXIT_CRITICAL(&bucket_lock);
+        next_due_us += next_interval_us();  // Poisson'daki log() kilit dışında
+    }
+    int64_t delay_us = (int64_t)next_due_us - now;
+
+    for (int i = 0; i < added; i++) {
+        xTaskNotifyGive(consumer);
+    }
+    esp_timer_start_once(arrival_timer, delay_us > TRAFFIC_GEN_MIN_TIMER_US ? delay_us : TRAFFIC_GEN_MIN_TIMER_US);
+}
+
+esp_err_t traffic_gen_start(const traffic_gen_config_t *cfg) {
+    if (running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    double pps = cfg->rate_pps;
+    if (pps <= 0 && cfg->rate_bps > 0 && cfg->frame_len > 0) {
+        pps = cfg->rate_bps / (cfg->frame_len * 8.0);
+    }
+    if (pps <= 0 || cfg->bucket_depth == 0 || cfg->bucket_depth > TRAFFIC_GEN_MAX_DEPTH ||
+        (cfg->mode == TRAFFIC_BURST && (cfg->burst_len == 0 || cfg->burst_len > cfg->bucket_depth))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (arrival_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = arrival_timer_cb,
+            .name = "traffic_gen",
+        };
+        esp_err_t err = esp_timer_create(&args, &arrival_timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    config = *cfg;
+    config.rate_pps = pps;
+    interval_us = 1000000.0 / pps;
+    consumer = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);    // önceki kullanımlardan kalan bildirimleri temizle
+
+    bucket_head = 0;
+    bucket_count = 0;
+    burst_pos = 0;
+    traffic_gen_get_report(NULL, true);
+    next_due_us = (double)esp_timer_get_time();
+    running = true;
+
+    ESP_LOGI(TAG, "Başladı: %s, %.1f pps (%.2f KB/s @ %u B), kova %u",
+             traffic_gen_mode_name(config.mode), pps, pps * config.frame_len / 1024.0, (unsigned)config.frame_len,
+             config.bucket_depth);
+    return esp_timer_start_once(arrival_timer, TRAFFIC_GEN_MIN_TIMER_US);
+}
+
+bool traffic_gen_wait(TickType_t timeout, int64_t *scheduled_us) {
+    if (ulTaskNotifyTake(pdFALSE, timeout) == 0) {
+        return false;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&bucket_lock);
+    if (bucket_count == 0) {
+        portEXIT_CRITICAL(&bucket_lock);
+        return false;   // stop sonrası kalan bildirim
+    }
+    int64_t due = bucket[bucket_head];
+    bucket_head = (bucket_head + 1) % TRAFFIC_GEN_MAX_DEPTH;
+    bucket_count--;
+    taken++;
+    portEXIT_CRITICAL(&bucket_lock);
+
+    latency_hist_record(&lateness, now > due ? (uint32_t)(now - due) : 0);
+    if (scheduled_us != NULL) {
+        *scheduled_us = due;
+    }
+    return true;
+}
+
+void traffic_gen_mark_sent(void) {
+    sent++;
+}
+
+void traffic_gen_stop(void) {
+    running = false;
+    if (arrival_timer != NULL) {
+        esp_timer_stop(arrival_timer);  // callback içindeyse zaten yeniden kurmaz
+    }
+    portENTER_CRITICAL(&bucket_lock);
+    bucket_count = 0;
+    portEXIT_CRITICAL(&bucket_lock);
+}
+
+void traffic_gen_get_report(traffic_gen_report_t *out, bool reset_window) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&bucket_lock);
+    if (out != NULL) {
+        out->requested_pps = config.rate_pps;
+        out->arrivals = arrivals;
+        out->taken = taken;
+        out->overflow = overflow;
+        out->max_backlog = max_backlog;
+        out->sent = sent;
+    }
+    if (reset_window) {
+        arrivals = 0;
+        taken = 0;
+        overflow = 0;
+        max_backlog = bucket_count;
+        sent = 0;
+    }
+    portEXIT_CRITICAL(&bucket_lock);
+
+    if (out != NULL) {
+        out->duration_s = (now - window_start_us) / 1000000.0;
+        out->achieved_pps = out->duration_s > 0 ? out->sent / out->duration_s : 0.0;
+        out->achieved_kbps = out->achieved_pps * config.frame_len / 1024.0;
+        out->lateness = lateness;
+    }
+    if (reset_window) {
+        latency_hist_reset(&lateness);
+        window_start_us = now;
+    }
+}
+
+void traffic_gen_log_report(const traffic_gen_report_t *r, const char *tag) {
+    ESP_LOGI(tag, "Trafik (%s): istenen %.1f pps, gerçekleşen %.1f pps (%%%.1f, %.2f KB/s), varış %lu, gönderilemeyen token %lu, kova taşması %lu, en fazla birikme %lu/%u",
+             traffic_gen_mode_name(config.mode), r->requested_pps, r->achieved_pps,
+             r->requested_pps > 0 ? r->achieved_pps * 100.0 / r->requested_pps : 0.0, r->achieved_kbps,
+             (unsigned long)r->arrivals, (unsigned long)(r->taken - r->sent), (unsigned long)r->overflow, (unsigned long)r->max_backlog, config.bucket_depth);
+    latency_hist_log_summary(&r->lateness, tag, "Zamanlama sapması:");
+}
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+components/telemetry'nin ikili istatistik akışını çözer.
+
+Kayıtlar COBS ile kodlanmış ve 0x00 ile sonlandırılmıştır; kaydın son 4 baytı
+CRC32'dir (little-endian). Çözülen kayıtlar ekrana yazılır ve tip başına
+<prefix>_rx.csv / <prefix>_latency.csv dosyalarına eklenir.
+
+    python3 telemetry_decode.py --port /dev/ttyUSB1 --baud 2000000 --csv run1
+    python3 telemetry_decode.py --file kayit.bin --csv run1
+
+--raw ile seri porttan okunan ham baytlar ayrıca dosyaya kaydedilir, sonra
+--file ile yeniden çözülebilir.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import zlib
+
+TELEMETRY_VERSION = 1
+REC_RX = 0x01
+REC_LATENCY = 0x02
+
+HDR = struct.Struct("<BBHQ")
+RX_BODY = struct.Struct("<IQIIIIIIIh2H")
+
+# latency_hist.h ile aynı olmalı
+SUB_BUCKET_BITS = 3
+SUB_BUCKETS = 1 << SUB_BUCKET_BITS
+OCTAVES = 22
+BUCKETS = (OCTAVES + 1) * SUB_BUCKETS
+LATENCY_BODY = struct.Struct("<BBIIIIIQ%dI" % BUCKETS)
+
+RX_FIELDS = ["seq", "timestamp_us", "period_ms", "rx_bytes", "rx_frames", "lost", "duplicates",
+             "reordered", "corrupt", "longest_gap", "ring_dropped", "rssi_dbm", "cpu0_idle", "cpu1_idle",
+             "kbps"]
+LATENCY_FIELDS = ["seq", "timestamp_us", "hist_id", "count", "timeouts", "overflow", "min_us", "max_us",
+                  "mean_us", "p50_us", "p90_us", "p99_us", "p999_us"]
+
+
+def bucket_lower(i):
+    if i < SUB_BUCKETS:
+        return i
+    octave = i >> SUB_BUCKET_BITS
+    sub = i & (SUB_BUCKETS - 1)
+    return (SUB_BUCKETS + sub) << (octave - 1)
+
+
+def bucket_upper(i):
+    if i < SUB_BUCKETS:
+        return i
+    return bucket_lower(i) + (1 << ((i >> SUB_BUCKET_BITS) - 1)) - 1
+
+
+def percentile(counts, total, min_us, max_us, pct):
+    """latency_hist_percentile ile aynı: kova orta noktası [min, max] aralığına kırpılır"""
+    if total == 0:
+        return 0
+    target = min(max(1, int(pct / 100.0 * total + 0.999999)), total)
+    seen = 0
+    for i, c in enumerate(counts):
+        seen += c
+        if seen >= target:
+            mid = bucket_lower(i) + (bucket_upper(i) - bucket_lower(i)) // 2
+            return min(max(mid, min_us), max_us)
+    return max_us
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Decoder:
+    def __init__(self, prefix):
+        self.buf = bytearray()
+        self.last_seq = None
+        self.prev_rx = None
+        self.records = 0
+        self.crc_errors = 0
+        self.seq_gaps = 0
+        self.rx_csv = self.latency_csv = None
+        if prefix:
+            self.rx_file = open(prefix + "_rx.csv", "w", newline="")
+            self.latency_file = open(prefix + "_latency.csv", "w", newline="")
+            self.rx_csv = csv.writer(self.rx_file)
+            self.rx_csv.writerow(RX_FIELDS)
+            self.latency_csv = csv.writer(self.latency_file)
+            self.latency_csv.writerow(LATENCY_FIELDS + ["b%d" % bucket_lower(i) for i in range(BUCKETS)])
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            end = self.buf.find(b"\x00")
+            if end < 0:
+                return
+            frame = bytes(self.buf[:end])
+            del self.buf[:end + 1]
+            if frame:
+                self.on_frame(frame)
+
+    def on_frame(self, frame):
+        raw = cobs_decode(frame)
+        if raw is None or len(raw) < HDR.size + 4:
+            self.crc_errors += 1
+            return
+        body, crc = raw[:-4], struct.unpack("<I", raw[-4:])[0]
+        if zlib.crc32(body) != crc:
+            self.crc_errors += 1
+            return
+        rtype, version, seq, ts = HDR.unpack_from(body)
+        if version != TELEMETRY_VERSION:
+            print("uyarı: kayıt sürümü %d, araç %d bekliyor" % (version, TELEMETRY_VERSION), file=sys.stderr)
+            return
+        if self.last_seq is not None:
+            gap = (seq - self.last_seq - 1) & 0xFFFF
+            if gap:
+                self.seq_gaps += gap
+                print("uyarı: %d kayıt kayıp (seq %d -> %d)" % (gap, self.last_seq, seq), file=sys.stderr)
+        self.last_seq = seq
+        self.records += 1
+
+        payload = body[HDR.size:]
+        if rtype == REC_RX and len(payload) >= RX_BODY.size:
+            self.on_rx(seq, ts, RX_BODY.unpack_from(payload))
+        elif rtype == REC_LATENCY and len(payload) >= LATENCY_BODY.size:
+            self.on_latency(seq, ts, LATENCY_BODY.unpack_from(payload))
+        else:
+            print("uyarı: bilinmeyen kayıt tipi 0x%02x (%d bayt)" % (rtype, len(body)), file=sys.stderr)
+
+    def on_rx(self, seq, ts, v):
+        period_ms, rx_bytes, rx_frames, lost, dup, reord, corrupt, gap, ring, rssi, idle0, idle1 = v
+        kbps = 0.0
+        if self.prev_rx is not None and ts > self.prev_rx[0] and rx_bytes >= self.prev_rx[1]:
+            kbps = (rx_bytes - self.prev_rx[1]) / 1024.0 / ((ts - self.prev_rx[0]) / 1e6)
+        self.prev_rx = (ts, rx_bytes)
+        idle = ["" if x == 0xFFFF else x / 10.0 for x in (idle0, idle1)]
+        print("[%10.3f s] RX #%d: %.2f KB/s, %d çerçeve, kayıp %d, tekrar %d, sırasız %d, bozuk %d, "
+              "en uzun boşluk %d, kuyruk düşen %d, RSSI %d dBm"
+              % (ts / 1e6, seq, kbps, rx_frames, lost, dup, reord, corrupt, gap, ring, rssi))
+        if self.rx_csv:
+            self.rx_csv.writerow([seq, ts, period_ms, rx_bytes, rx_frames, lost, dup, reord, corrupt, gap, ring,
+                                  rssi] + idle + ["%.2f" % kbps])
+            self.rx_file.flush()
+
+    def on_latency(self, seq, ts, v):
+        hist_id, _, count, timeouts, overflow, min_us, max_us, sum_us = v[:8]
+        counts = v[8:]
+        mean = sum_us // count if count else 0
+        p = [percentile(counts, count, min_us, max_us, q) for q in (50, 90, 99, 99.9)]
+        print("[%10.3f s] GECİKME #%d (hist %d): %d örnek, %d timeout, min %d / ort %d / p50 %d / p90 %d / "
+              "p99 %d / p99.9 %d / max %d us"
+              % (ts / 1e6, seq, hist_id, count, timeouts, min_us, mean, p[0], p[1], p[2], p[3], max_us))
+        if self.latency_csv:
+            self.latency_csv.writerow([seq, ts, hist_id, count, timeouts, overflow, min_us, max_us, mean] + p
+                                      + list(counts))
+            self.latency_file.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ESP-NOW test telemetri akışı çözücü")
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("--port", help="seri port, ör. /dev/ttyUSB1")
+    src.add_argument("--file", help="önceden kaydedilmiş ham akış")
+    parser.add_argument("--baud", type=int, default=2000000)
+    parser.add_argument("--csv", metavar="PREFIX", help="<PREFIX>_rx.csv ve <PREFIX>_latency.csv yaz")
+    parser.add_argument("--raw", metavar="FILE", help="seri porttan okunan ham baytları da kaydet")
+    args = parser.parse_args()
+
+    dec = Decoder(args.csv)
+    try:
+        if args.file:
+            with open(args.file, "rb") as f:
+                dec.feed(f.read())
+        else:
+            import serial
+            raw = open(args.raw, "wb") if args.raw else None
+            with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+                while True:
+                    data = port.read(4096)
+                    if data:
+                        if raw:
+                            raw.write(data)
+                        dec.feed(data)
+    except KeyboardInterrupt:
+        pass
+    print("%d kayıt, %d CRC/çerçeve hatası, %d kayıt sıra boşluğu" % (dec.records, dec.crc_errors, dec.seq_gaps),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -11,30 +11,68 @@
 #include "esp_netif.h"
 #include "freertos/task.h"
 #include "freertos/FreeRTOS.h"
+#include "espnow_frag.h"
+#include "espnow_compress.h"
 
 static const char *ESPNOW_TAG = "ESP_NOW";
 
-/* Gönderilecek - alınacak veri yapısı */
-typedef struct {
-    int id;
-    char message[100];
-} esp_now_data_t;
+#define STATS_EVERY_N_MSG 10    // her N mesajda bir parçalama istatistiklerini yazdır
+
+static compress_ctx_t compress_ctx;                     // yalnızca message_task kullanır
+static char message[FRAG_MAX_MSG_LEN + 1];              // açılmış mesaj, sıcak yolda malloc yok
 
 static void esp_now_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int len) { // ESP-NOW alım callback fonksiyonu
+    if (espnow_frag_on_recv(recv_info, data, len)) { // parça tampona kopyalanır, mesaj tamamlanınca message_task'a düşer
+        return;
+    }
+
     char macStr[18];
     snprintf(macStr, sizeof(macStr), "%02x:%02x:%02x:%02x:%02x:%02x",
              recv_info->src_addr[0], recv_info->src_addr[1], recv_info->src_addr[2],
              recv_info->src_addr[3], recv_info->src_addr[4], recv_info->src_addr[5]);
     ESP_LOGW(ESPNOW_TAG, "Veri alindi, gonderen MAC: %s, uzunluk: %d, gonderen RSSI: %d", macStr, len, recv_info->rx_ctrl->rssi);
-    
-    if (len == sizeof(esp_now_data_t)) {
-        esp_now_data_t *recv_data = (esp_now_data_t *)data;
-        ESP_LOGW(ESPNOW_TAG, "ID: %d, Mesaj: %s\n", 
-                 recv_data->id, recv_data->message);
+}
+
+/**
+ * Birleştirilen mesajları Wi-Fi task'ı dışında işleyen task. Mesaj tamponu
+ * espnow_frag_release çağrılana kadar bu task'a aittir; config/firmware
+ * gibi büyük verilerin flash'a yazılması da burada yapılabilir.
+ */
+static void esp_now_message_task() {
+    frag_msg_t msg;
+    while (1) {
+        if (!espnow_frag_receive(&msg, portMAX_DELAY)) {
+            continue;
+        }
+        /* Gönderici her mesajı espnow_compress başlığıyla yollar (sıkıştırılmış ya da ham) */
+        int len = espnow_decompress_frame(&compress_ctx, msg.data, msg.len, (uint8_t *)message, FRAG_MAX_MSG_LEN);
+        bool lz4 = msg.len > 0 && msg.data[0] == COMPRESS_LZ4;
+        espnow_frag_release(&msg);
+        if (len < 0) {
+            ESP_LOGE(ESPNOW_TAG, "Mesaj ID: %u açılamadı (%d byte)", msg.msg_id, msg.len);
+            continue;
+        }
+        message[len] = '\0';
+
+        double elapsed_s = msg.elapsed_us / 1000000.0;
+        ESP_LOGW(ESPNOW_TAG, "Mesaj ID: %u, %d byte (havada %d byte, %s), %.3f s (%.2f KB/s), Mesaj: %.*s\n",
+                 msg.msg_id, len, msg.len, lz4 ? "LZ4" : "ham", elapsed_s, elapsed_s > 0 ? len / 1024.0 / elapsed_s : 0.0,
+                 MIN(len, 200), message);
+
+        frag_stats_t stats;
+        espnow_frag_get_stats(&stats);
+        if (stats.messages % STATS_EVERY_N_MSG == 0) {
+            espnow_frag_log_stats(ESPNOW_TAG);
+            espnow_compress_log_stats(&compress_ctx.stats, ESPNOW_TAG);
+        }
     }
+    vTaskDelete(NULL);
 }
 
 static void esp_now_init_func(void) {
+    ESP_ERROR_CHECK(espnow_frag_init()); // recv_cb parça kopyalamadan önce tamponlar hazır olmalı
+    xTaskCreate(esp_now_message_task, "esp_now_message_task", 4096, NULL, 5, NULL);
+
     ESP_ERROR_CHECK(esp_now_init());
     ESP_ERROR_CHECK(esp_now_register_recv_cb(esp_now_recv_cb));
 
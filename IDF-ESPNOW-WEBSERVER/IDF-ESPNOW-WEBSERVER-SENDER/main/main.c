@@ -11,17 +11,39 @@
 #include "esp_log.h"
 #include "esp_now.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
 #include "esp_http_server.h"
+#include "espnow_frag.h"
+#include "espnow_compress.h"
 
 #define WIFI_SSID "ESPNOW-WEBSERVER"
 #define WIFI_PASS "51575570"
 
+/**
+ * Formdan gelen mesaj tek bir ESP-NOW çerçevesine sığmak zorunda değildir;
+ * espnow_frag mesajı FRAME_LEN'lik parçalara bölüp gönderir, alıcı birleştirir.
+ * FRAME_LEN ESP-NOW v1 sınırında tutuldu, böylece v1 alıcılarla da çalışır.
+ */
+#define MESSAGE_MAX_LEN (FRAG_MAX_MSG_LEN - COMPRESS_HEADER_LEN)
+#define FRAME_LEN       ESP_NOW_MAX_DATA_LEN
+
+/**
+ * Form verisi (metin/JSON) parçalanmadan önce espnow_compress ile LZ4'le
+ * sıkıştırılır; sıkıştırma kazandırmıyorsa mesaj ham gider. Mesajın başındaki
+ * başlık hangisi olduğunu söyler, alıcı her iki durumu da açar. 0 olduğunda
+ * mesajlar yine başlıkla ama her zaman ham gönderilir.
+ */
+#define COMPRESS_MODE   1
+
 static const char *WSERVER_TAG = "WEBSERVER";
 static const char *ESPNOW_TAG = "ESP_NOW";
 static const char *WIFI_TAG = "WIFI";
 
 static httpd_handle_t server = NULL;
 
+static compress_ctx_t compress_ctx;                     // yalnızca httpd task'ı kullanır
+static uint8_t compressed[FRAG_MAX_MSG_LEN];            // sıcak yolda malloc yok
+
 esp_event_handler_instance_t instance_any_id;
 esp_event_handler_instance_t instance_got_ip;
 
@@ -29,12 +51,6 @@ static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xF0, 0x9E, 0x9E, 0x20, 0x9A,
 //static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xCC, 0x7B, 0x5C, 0xF7, 0xB8, 0xF8}; //beyaz kablolu esp32'nin mac adresi
 //static uint8_t broadcast_mac[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}; //broadcast mac
 
-/* Gönderilecek - alınacak veri yapısı */
-typedef struct {
-    int id;
-    char message[100];
-} esp_now_data_t;
-
 /**
  * index.html dosyasını SPIFFS yerine programın bin dosyasına
  * gömerek kullanmak için başlangıç ve bitiş adreslerini tanımlama.
@@ -44,23 +60,31 @@ extern const uint8_t index_html_start[] asm("_binary_index_html_start");
 extern const uint8_t index_html_end[]   asm("_binary_index_html_end");
 
 static void esp_now_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) { // ESP-NOW gönderim callback fonksiyonu
+    espnow_frag_on_send(status); // bir sonraki parça bu bildirimi bekler
+    if (status == ESP_NOW_SEND_SUCCESS) {
+        return; // her parça için log basmamak için sadece başarısızlar yazdırılır
+    }
     char macStr[18];
     snprintf(macStr, sizeof(macStr), "%02x:%02x:%02x:%02x:%02x:%02x",
              mac_addr[0], mac_addr[1], mac_addr[2],
              mac_addr[3], mac_addr[4], mac_addr[5]);
-    ESP_LOGW(ESPNOW_TAG, "MAC: %s, Gönderim durumu: %s", macStr, status == ESP_NOW_SEND_SUCCESS ? "Başarılı" : "Başarısız");
+    ESP_LOGW(ESPNOW_TAG, "MAC: %s, Gönderim durumu: Başarısız", macStr);
 }
 
-static void esp_now_send_func(char* msg) {
-    esp_now_data_t send_data;
-    static int counter = 0;
-    
-    send_data.id = ++counter;
-    snprintf(send_data.message, sizeof(send_data.message), msg);
-    
-    esp_err_t result = esp_now_send(broadcast_mac, (uint8_t *)&send_data, sizeof(send_data)); //önceden belirlenen MAC adresine gelen veriyi gönder
+static void esp_now_send_func(const char *msg, size_t len) {
+    int64_t start_us = esp_timer_get_time();
+    size_t wire_len = espnow_compress_frame(&compress_ctx, msg, len, compressed, sizeof(compressed));
+    if (wire_len == 0) {
+        ESP_LOGE(ESPNOW_TAG, "Mesaj sıkıştırma tamponuna sığmadı: %d byte", len);
+        return;
+    }
+    esp_err_t result = espnow_frag_send(broadcast_mac, compressed, wire_len, FRAME_LEN); //önceden belirlenen MAC adresine gelen veriyi parçalayarak gönder
     if (result == ESP_OK) {
-        ESP_LOGW(ESPNOW_TAG, "Veri gönderildi: ID=%d, message: %s", send_data.id, send_data.message);
+        double elapsed_s = (esp_timer_get_time() - start_us) / 1000000.0;
+        ESP_LOGW(ESPNOW_TAG, "Veri gönderildi: %d byte (havada %d byte, %s), %d parça, %.3f s, message: %.64s%s", len, wire_len,
+                 compressed[0] == COMPRESS_LZ4 ? "LZ4" : "ham",
+                 (wire_len + FRAME_LEN - FRAG_HEADER_LEN - 1) / (FRAME_LEN - FRAG_HEADER_LEN), elapsed_s, msg, len > 64 ? "..." : "");
+        espnow_compress_log_stats(&compress_ctx.stats, ESPNOW_TAG);
     }
     else {
         ESP_LOGE(ESPNOW_TAG, "Veri gönderim hatası: %s", esp_err_to_name(result));
@@ -68,6 +92,7 @@ static void esp_now_send_func(char* msg) {
 }
 
 static void esp_now_init_func(void) {
+    espnow_compress_init(&compress_ctx, COMPRESS_MODE);
     ESP_ERROR_CHECK(esp_now_init());
     ESP_ERROR_CHECK(esp_now_register_send_cb(esp_now_send_cb));
     
@@ -101,16 +126,30 @@ esp_err_t index_handler(httpd_req_t *req) {
 }
 
 esp_err_t submit_post_handler(httpd_req_t *req) {
-    char content[100];
-    int ret = httpd_req_recv(req, content, MIN(req->content_len, sizeof(content) - 1)); //verinin uzunluğuna göre ya array size kadar ya da veri uzunluğu kadar oku
-    if (ret <= 0) {
+    static char content[MESSAGE_MAX_LEN + 1]; // httpd task'ının stack'ine sığmaz
+    size_t total = MIN(req->content_len, MESSAGE_MAX_LEN); //verinin uzunluğuna göre ya buffer size kadar ya da veri uzunluğu kadar oku
+    size_t received = 0;
+    while (received < total) { // büyük gövdeler birden fazla parçada gelir
+        int ret = httpd_req_recv(req, content + received, total - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret <= 0) {
+            return ESP_FAIL;
+        }
+        received += ret;
+    }
+    if (received == 0) {
         return ESP_FAIL;
     }
+    if (req->content_len > MESSAGE_MAX_LEN) {
+        ESP_LOGW(WSERVER_TAG, "Gelen veri %d byte, ilk %d byte gönderilecek", req->content_len, MESSAGE_MAX_LEN);
+    }
 
-    content[ret] = '\0'; // Null terminate
-    ESP_LOGI(WSERVER_TAG, "Gelen veri: %s", content);
+    content[received] = '\0'; // Null terminate
+    ESP_LOGI(WSERVER_TAG, "Gelen veri (%d byte): %.64s%s", received, content, received > 64 ? "..." : "");
 
-    esp_now_send_func(content); //gelen veriyi espnow ile gönder
+    esp_now_send_func(content, received); //gelen veriyi espnow ile gönder
 
     /* Formun yeniden doldurulabilmesi için HTTP 303 ile index'e otomatik yönlendirme */
     httpd_resp_set_status(req, "303 See Other");